@@ -4,11 +4,74 @@
 
 #include "alerts.h"
 
+// Shift points per gear (index 0 = 1st)
+static const uint16_t SHIFT_RPM_TABLE[GEAR_COUNT] = GEAR_SHIFT_RPM;
+static const uint16_t SHORT_SHIFT_RPM_TABLE[GEAR_COUNT] = GEAR_SHORT_SHIFT_RPM;
+
+// Coolant thresholds as raw bytes (config.h has them in °F)
+static const uint8_t WATER_WARNING_RAW = TEMP_F_TO_RAW(WATER_TEMP_WARNING);
+static const uint8_t WATER_CRITICAL_RAW = TEMP_F_TO_RAW(WATER_TEMP_CRITICAL);
+
+// Oil pressure threshold map (PSI), rows by oil temp, columns by RPM
+static const int16_t OIL_MAP_RPM_TABLE[] = OIL_MAP_RPM;
+static const int16_t OIL_MAP_TEMP_TABLE[] = OIL_MAP_TEMP_C;
+static const uint8_t OIL_MAP_RPM_POINTS = sizeof(OIL_MAP_RPM_TABLE) / sizeof(OIL_MAP_RPM_TABLE[0]);
+static const uint8_t OIL_MAP_TEMP_POINTS = sizeof(OIL_MAP_TEMP_TABLE) / sizeof(OIL_MAP_TEMP_TABLE[0]);
+static const uint8_t OIL_WARNING_MAP[][OIL_MAP_RPM_POINTS] = OIL_MAP_WARNING_PSI;
+static const uint8_t OIL_CRITICAL_MAP[][OIL_MAP_RPM_POINTS] = OIL_MAP_CRITICAL_PSI;
+
+static_assert(OIL_MAP_RPM_POINTS >= 2 && OIL_MAP_TEMP_POINTS >= 2, "Oil map needs two points per axis");
+static_assert(sizeof(OIL_WARNING_MAP) == OIL_MAP_TEMP_POINTS * OIL_MAP_RPM_POINTS,
+              "One OIL_MAP_WARNING_PSI row per OIL_MAP_TEMP_C point");
+static_assert(sizeof(OIL_CRITICAL_MAP) == OIL_MAP_TEMP_POINTS * OIL_MAP_RPM_POINTS,
+              "One OIL_MAP_CRITICAL_PSI row per OIL_MAP_TEMP_C point");
+
+// Segment of an ascending axis that x falls in, and how far along (Q8,
+// 0-256). Held at the ends.
+static uint8_t mapSegment(const int16_t* axis, uint8_t points, int32_t x, int32_t& frac) {
+    if (x <= axis[0]) {
+        frac = 0;
+        return 0;
+    }
+    if (x >= axis[points - 1]) {
+        frac = 256;
+        return points - 2;
+    }
+    uint8_t i = 0;
+    while (x >= axis[i + 1]) {
+        i++;
+    }
+    frac = ((x - axis[i]) << 8) / (axis[i + 1] - axis[i]);
+    return i;
+}
+
+// Bilinear interpolation in a threshold map, in 0.1 PSI
+static uint16_t oilMapLookup(const uint8_t map[][OIL_MAP_RPM_POINTS],
+                             uint8_t t, int32_t tFrac, uint8_t r, int32_t rFrac) {
+    int32_t low = map[t][r] * 256 + (map[t][r + 1] - map[t][r]) * rFrac;
+    int32_t high = map[t + 1][r] * 256 + (map[t + 1][r + 1] - map[t + 1][r]) * rFrac;
+    int32_t psiQ16 = low * 256 + (high - low) * tFrac;
+    return (uint16_t)((psiQ16 * 10 + 0x8000) >> 16);
+}
+
 AlertHandler::AlertHandler() {
     memset(&_state, 0, sizeof(AlertState_t));
     _buzzerEnabled = BUZZER_ENABLED;
     _buzzerSilenced = false;
     _silenceUntil = 0;
+    
+    _toneTimed = false;
+    _toneEnd = 0;
+    _warnBeeping = false;
+    _lastWarnBeep = 0;
+    
+    _gear = 0;
+    _shortShift = SHORT_SHIFT_ENABLED;
+    _shiftRpm = SHIFT_RPM;
+    _shiftWarnRpm = SHIFT_WARNING_RPM;
+    setGear(0);
+    
+    updateOilThresholds(0, OIL_MAP_DEFAULT_TEMP_C);
 }
 
 void AlertHandler::begin() {
@@ -25,35 +88,44 @@ void AlertHandler::begin() {
     Serial.println("Alert handler initialized");
     Serial.printf("Buzzer pin: GPIO%d, Enabled: %s\n", 
                   BUZZER_PIN, _buzzerEnabled ? "Yes" : "No");
+    Serial.printf("Shift points: %s\n", _shortShift ? "short-shift" : "normal");
     #endif
 }
 
-void AlertHandler::update(uint16_t rpm, int16_t waterTempF, float oilPressurePsi) {
+void AlertHandler::update(uint16_t rpm, uint8_t coolantRaw, float oilPressurePsi,
+                          int16_t oilTempC) {
+    uint32_t now = clockMillis();
+    
     // Update flash state for blinking
-    updateFlash();
+    updateFlash(now);
     
     // Check unsilence
-    if (_buzzerSilenced && millis() > _silenceUntil) {
+    if (_buzzerSilenced && now > _silenceUntil) {
         _buzzerSilenced = false;
     }
     
     // --- RPM / Shift Light ---
-    _state.shiftWarning = (rpm >= SHIFT_WARNING_RPM && rpm < SHIFT_RPM);
-    _state.shiftActive = (rpm >= SHIFT_RPM);
+    _state.shiftWarning = (rpm >= _shiftWarnRpm && rpm < _shiftRpm);
+    _state.shiftActive = (rpm >= _shiftRpm);
     
     // --- Water Temperature ---
-    _state.tempWarning = (waterTempF >= WATER_TEMP_WARNING && waterTempF < WATER_TEMP_CRITICAL);
-    _state.tempCritical = (waterTempF >= WATER_TEMP_CRITICAL);
+    // On the raw byte, so TEMP_UNIT_F can't move the thresholds
+    _state.tempWarning = (coolantRaw >= WATER_WARNING_RAW && coolantRaw < WATER_CRITICAL_RAW);
+    _state.tempCritical = (coolantRaw >= WATER_CRITICAL_RAW);
     
     // --- Oil Pressure ---
-    // Oil pressure alerts are triggered when BELOW threshold
-    _state.oilWarning = (oilPressurePsi < OIL_PRESSURE_WARNING && 
-                         oilPressurePsi >= OIL_PRESSURE_CRITICAL);
-    _state.oilCritical = (oilPressurePsi < OIL_PRESSURE_CRITICAL);
+    // Oil pressure alerts are triggered when BELOW the thresholds for
+    // this RPM and oil temp
+    if (rpm != _oilMapRpm || oilTempC != _oilMapTempC) {
+        updateOilThresholds(rpm, oilTempC);
+    }
+    float oilTenths = oilPressurePsi * 10.0f;
+    _state.oilWarning = (oilTenths < _oilWarnTenths && oilTenths >= _oilCritTenths);
+    _state.oilCritical = (oilTenths < _oilCritTenths);
     
-    // Only trigger oil alerts if engine is running (RPM > 500)
-    // to avoid false alerts at startup
-    if (rpm < 500) {
+    // Only trigger oil alerts if engine is running, to avoid false alerts
+    // at startup
+    if (rpm < OIL_ALERT_MIN_RPM) {
         _state.oilWarning = false;
         _state.oilCritical = false;
     }
@@ -74,7 +146,7 @@ void AlertHandler::update(uint16_t rpm, int16_t waterTempF, float oilPressurePsi
     }
     
     // Update buzzer
-    updateBuzzer();
+    updateBuzzer(now);
     
     #if DEBUG_ENABLED
     static AlertType_t lastAlert = ALERT_NONE;
@@ -89,15 +161,21 @@ void AlertHandler::update(uint16_t rpm, int16_t waterTempF, float oilPressurePsi
     #endif
 }
 
-void AlertHandler::updateFlash() {
-    uint32_t now = millis();
+void AlertHandler::updateFlash(uint32_t now) {
     if (now - _state.lastFlashTime >= ALERT_FLASH_MS) {
         _state.flashState = !_state.flashState;
         _state.lastFlashTime = now;
     }
 }
 
-void AlertHandler::updateBuzzer() {
+void AlertHandler::updateBuzzer(uint32_t now) {
+    // A timed beep runs out here rather than blocking in playTone()
+    if (_toneTimed && (int32_t)(now - _toneEnd) >= 0) {
+        stopTone();
+    }
+    
+    _warnBeeping = false;
+    
     if (!_buzzerEnabled || _buzzerSilenced) {
         stopTone();
         return;
@@ -128,10 +206,10 @@ void AlertHandler::updateBuzzer() {
     } else if ((_state.tempWarning || _state.oilWarning) && 
                (BUZZER_TEMP_ENABLED || BUZZER_OIL_ENABLED)) {
         // Warning - slower beep
-        static uint32_t lastWarnBeep = 0;
-        if (millis() - lastWarnBeep > 2000) {  // Beep every 2 seconds
+        _warnBeeping = true;
+        if (now - _lastWarnBeep > 2000) {  // Beep every 2 seconds
             playTone(BUZZER_WARNING_FREQ, 200);
-            lastWarnBeep = millis();
+            _lastWarnBeep = now;
         }
     } else {
         stopTone();
@@ -142,14 +220,14 @@ void AlertHandler::playTone(uint16_t frequency, uint32_t duration) {
     ledcChangeFrequency(0, frequency, 8);
     ledcWrite(0, 128);  // 50% duty cycle
     
-    if (duration > 0) {
-        delay(duration);
-        stopTone();
-    }
+    // Timed tones are stopped by updateBuzzer() once duration has passed
+    _toneTimed = (duration > 0);
+    _toneEnd = clockMillis() + duration;
 }
 
 void AlertHandler::stopTone() {
     ledcWrite(0, 0);
+    _toneTimed = false;
 }
 
 AlertState_t AlertHandler::getState() {
@@ -192,6 +270,35 @@ bool AlertHandler::getFlashState() {
     return _state.flashState;
 }
 
+void AlertHandler::setGear(uint8_t gear) {
+    _gear = gear;
+    
+    if (gear >= 1 && gear <= GEAR_COUNT) {
+        _shiftRpm = _shortShift ? SHORT_SHIFT_RPM_TABLE[gear - 1] : SHIFT_RPM_TABLE[gear - 1];
+    } else {
+        // Gear not known - fall back to the single configured shift point
+        _shiftRpm = SHIFT_RPM;
+    }
+    _shiftWarnRpm = _shiftRpm - (SHIFT_RPM - SHIFT_WARNING_RPM);
+}
+
+void AlertHandler::setShortShift(bool enabled) {
+    _shortShift = enabled;
+    setGear(_gear);
+}
+
+bool AlertHandler::isShortShift() {
+    return _shortShift;
+}
+
+uint16_t AlertHandler::getShiftRPM() {
+    return _shiftRpm;
+}
+
+uint16_t AlertHandler::getShiftWarningRPM() {
+    return _shiftWarnRpm;
+}
+
 RPMZone_t AlertHandler::getRPMZone(uint16_t rpm) {
     if (rpm >= RPM_ZONE_RED) {
         return RPM_ZONE_4_RED;
@@ -219,20 +326,39 @@ uint16_t AlertHandler::getRPMColor(uint16_t rpm) {
     }
 }
 
-uint16_t AlertHandler::getTempColor(int16_t tempF) {
-    if (tempF >= WATER_TEMP_CRITICAL) {
+uint16_t AlertHandler::getTempColor(int16_t temp) {
+    if (temp >= TEMP_F_TO_DISPLAY(WATER_TEMP_CRITICAL)) {
         return COLOR_TEMP_CRITICAL;
-    } else if (tempF >= WATER_TEMP_WARNING) {
+    } else if (temp >= TEMP_F_TO_DISPLAY(WATER_TEMP_WARNING)) {
         return COLOR_TEMP_WARNING;
     } else {
         return COLOR_TEMP_NORMAL;
     }
 }
 
+void AlertHandler::updateOilThresholds(uint16_t rpm, int16_t oilTempC) {
+    int32_t rFrac;
+    int32_t tFrac;
+    uint8_t r = mapSegment(OIL_MAP_RPM_TABLE, OIL_MAP_RPM_POINTS, rpm, rFrac);
+    uint8_t t = mapSegment(OIL_MAP_TEMP_TABLE, OIL_MAP_TEMP_POINTS, oilTempC, tFrac);
+    _oilWarnTenths = oilMapLookup(OIL_WARNING_MAP, t, tFrac, r, rFrac);
+    _oilCritTenths = oilMapLookup(OIL_CRITICAL_MAP, t, tFrac, r, rFrac);
+    _oilMapRpm = rpm;
+    _oilMapTempC = oilTempC;
+}
+
+float AlertHandler::getOilWarningPsi() {
+    return _oilWarnTenths / 10.0f;
+}
+
+float AlertHandler::getOilCriticalPsi() {
+    return _oilCritTenths / 10.0f;
+}
+
 uint16_t AlertHandler::getOilColor(float psi) {
-    if (psi < OIL_PRESSURE_CRITICAL) {
+    if (psi * 10.0f < _oilCritTenths) {
         return COLOR_OIL_CRITICAL;
-    } else if (psi < OIL_PRESSURE_WARNING) {
+    } else if (psi * 10.0f < _oilWarnTenths) {
         return COLOR_OIL_WARNING;
     } else {
         return COLOR_OIL_NORMAL;
@@ -248,10 +374,28 @@ void AlertHandler::setBuzzerEnabled(bool enabled) {
 
 void AlertHandler::silenceBuzzer() {
     _buzzerSilenced = true;
-    _silenceUntil = millis() + 30000;  // Silence for 30 seconds
+    _silenceUntil = clockMillis() + 30000;  // Silence for 30 seconds
     stopTone();
     
     #if DEBUG_ENABLED
     Serial.println("Buzzer silenced for 30 seconds");
     #endif
 }
+
+uint32_t AlertHandler::nextDeadline(uint32_t now) {
+    uint32_t next = now + CLOCK_IDLE_MS;
+    
+    clockSooner(next, _state.lastFlashTime + ALERT_FLASH_MS, now);
+    
+    if (_buzzerSilenced) {
+        clockSooner(next, _silenceUntil + 1, now);
+    }
+    if (_toneTimed) {
+        clockSooner(next, _toneEnd, now);
+    }
+    if (_warnBeeping) {
+        clockSooner(next, _lastWarnBeep + 2001, now);
+    }
+    
+    return next;
+}
@@ -9,6 +9,8 @@
 
 #include <Arduino.h>
 #include "config.h"
+#include "clock.h"
+#include "obd_units.h"
 
 // Alert types
 typedef enum {
@@ -50,8 +52,11 @@ public:
     // Initialize alerts and buzzer
     void begin();
     
-    // Update alerts based on current values
-    void update(uint16_t rpm, int16_t waterTempF, float oilPressurePsi);
+    // Update alerts based on current values. Oil pressure thresholds come
+    // from the RPM x oil temp map (OIL_MAP_* in config.h).
+    // Coolant is the raw SAE byte (°C + 40, 0 = not received yet).
+    void update(uint16_t rpm, uint8_t coolantRaw, float oilPressurePsi,
+                int16_t oilTempC = OIL_MAP_DEFAULT_TEMP_C);
     
     // Get alert state
     AlertState_t getState();
@@ -69,14 +74,25 @@ public:
     // Get flash state for blinking alerts
     bool getFlashState();
     
+    // Select the shift points for the current gear (GEAR_UNKNOWN = default)
+    void setGear(uint8_t gear);
+    void setShortShift(bool enabled);
+    bool isShortShift();
+    uint16_t getShiftRPM();
+    uint16_t getShiftWarningRPM();
+    
+    // Oil pressure thresholds in effect as of the last update()
+    float getOilWarningPsi();
+    float getOilCriticalPsi();
+    
     // Get RPM zone for progressive tachometer
     RPMZone_t getRPMZone(uint16_t rpm);
     
     // Get color for RPM value (returns RGB565)
     uint16_t getRPMColor(uint16_t rpm);
     
-    // Get color for temperature (returns RGB565)
-    uint16_t getTempColor(int16_t tempF);
+    // Get color for temperature in the display unit (returns RGB565)
+    uint16_t getTempColor(int16_t temp);
     
     // Get color for oil pressure (returns RGB565)
     uint16_t getOilColor(float psi);
@@ -85,17 +101,42 @@ public:
     void setBuzzerEnabled(bool enabled);
     void silenceBuzzer();  // Temporarily silence
     
+    // Next time update() changes anything with the inputs unchanged
+    uint32_t nextDeadline(uint32_t now);
+    
 private:
     AlertState_t _state;
     bool _buzzerEnabled;
     bool _buzzerSilenced;
     uint32_t _silenceUntil;
     
+    // Timed beep in progress (ended by updateBuzzer, not by waiting)
+    bool _toneTimed;
+    uint32_t _toneEnd;
+    bool _warnBeeping;          // Warning beep cadence running
+    uint32_t _lastWarnBeep;
+    
+    // Shift points in effect (per gear)
+    uint8_t _gear;
+    bool _shortShift;
+    uint16_t _shiftRpm;
+    uint16_t _shiftWarnRpm;
+    
+    // Oil pressure thresholds for _oilMapRpm / _oilMapTempC, 0.1 PSI
+    uint16_t _oilWarnTenths;
+    uint16_t _oilCritTenths;
+    uint16_t _oilMapRpm;
+    int16_t _oilMapTempC;
+    
+    // Look up both thresholds in the oil pressure map (only when the RPM or
+    // oil temp changed - update() runs every loop, CAN replies don't)
+    void updateOilThresholds(uint16_t rpm, int16_t oilTempC);
+    
     // Update flash state
-    void updateFlash();
+    void updateFlash(uint32_t now);
     
     // Update buzzer based on alerts
-    void updateBuzzer();
+    void updateBuzzer(uint32_t now);
     
     // Play buzzer tone
     void playTone(uint16_t frequency, uint32_t duration);
@@ -0,0 +1,323 @@
+/*
+ * gauge_bench.cpp - Host microbenchmarks for the gauge core
+ * 
+ * Times the per-sample hot paths on the build machine. Absolute numbers
+ * differ from the ESP32 (a 240 MHz in-order core), but relative changes
+ * and allocation counts carry over - use them to prove an optimisation
+ * before and after, e.g.:
+ * 
+ *   make -C arduino/canbus_gauge/bench run BENCH_OUT=before.json
+ */
+
+#include "microbench.h"
+
+#include "config.h"
+#include "sensors.h"
+#include "obd_pids.h"
+#include "obd_units.h"
+#include "can_handler.h"
+#include "alerts.h"
+#include "display_handler.h"
+#include "trend_aggregator.h"
+#include "tire_zones.h"
+#include "thermal_codec.h"
+
+// Display output is counted, not sent anywhere
+class NullSerial : public HardwareSerial {
+public:
+    NullSerial() : bytes(0) {}
+    size_t write(uint8_t c) override { bytes++; return 1; }
+    using Print::write;
+    uint64_t bytes;
+};
+
+// =============================================================================
+// SENSOR FILTERING
+// =============================================================================
+
+static void BM_MovingAverageAddFloat(benchmark::State& state) {
+    MovingAverage<float, OIL_SMOOTHING_SAMPLES> filter;
+    float value = 55.0f;
+    
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(filter.add(value));
+        value += 0.25f;
+    }
+}
+BENCHMARK(BM_MovingAverageAddFloat);
+
+static void BM_MovingAverageAddInt(benchmark::State& state) {
+    MovingAverage<int32_t, TEMP_SMOOTHING_SAMPLES> filter;
+    int32_t value = 190;
+    
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(filter.add(value));
+        value ^= 3;
+    }
+}
+BENCHMARK(BM_MovingAverageAddInt);
+
+// One DMA conversion into the AdcScan decimator: the scan task's cost per
+// sample. Four channels at 64x; ESP32 budget at 20 kHz is 50 us/sample.
+static void BM_AdcScanFeed(benchmark::State& state) {
+    static const AdcScanChannel_t channels[] = {
+        { 34, 6, 2.0f }, { 35, 6, 2.0f }, { 32, 6, 1.0f }, { 33, 6, 1.0f },
+    };
+    static AdcScan scan;
+    scan.begin(channels, 4);
+    const uint8_t adcChannel[4] = { 6, 7, 4, 5 };
+    
+    uint16_t raw = 1800;
+    int n = 0;
+    for (auto _ : state) {
+        scan.feed(adcChannel[n & 3], raw + (n & 7));
+        n++;
+    }
+    benchmark::DoNotOptimize(scan.volts(0));
+}
+BENCHMARK(BM_AdcScanFeed);
+
+// One sample into the per-minute trend block (no output: the period
+// never closes at a fixed timestamp)
+static void BM_TrendAdd(benchmark::State& state) {
+    static NullSerial serial;
+    static TrendAggregator trend(serial);
+    uint16_t rpm = 3000;
+    uint16_t oil = 550;
+    
+    for (auto _ : state) {
+        trend.add(rpm, oil, 190, 1000);
+        rpm = (rpm + 37) & 0x1FFF;
+        oil = (oil + 13) & 0x3FF;
+    }
+}
+BENCHMARK(BM_TrendAdd);
+
+// =============================================================================
+// OBD DECODE (processMessages -> parseResponse)
+// =============================================================================
+
+static void decodeBench(benchmark::State& state, const uint8_t* frame) {
+    CANHandler can(CAN_CS_PIN, CAN_INT_PIN);
+    can.begin();
+    
+    for (auto _ : state) {
+        hostCanReceive(OBD_RESPONSE_ID_MIN, 8, frame);
+        benchmark::DoNotOptimize(can.processMessages());
+    }
+}
+
+static void BM_DecodeRPM(benchmark::State& state) {
+    const uint8_t frame[8] = { 0x04, 0x41, PID_ENGINE_RPM, 0x1A, 0xF8, 0xCC, 0xCC, 0xCC };
+    decodeBench(state, frame);
+}
+BENCHMARK(BM_DecodeRPM);
+
+static void BM_DecodeSpeed(benchmark::State& state) {
+    const uint8_t frame[8] = { 0x03, 0x41, PID_VEHICLE_SPEED, 0x64, 0xCC, 0xCC, 0xCC, 0xCC };
+    decodeBench(state, frame);
+}
+BENCHMARK(BM_DecodeSpeed);
+
+static void BM_DecodeCoolant(benchmark::State& state) {
+    const uint8_t frame[8] = { 0x03, 0x41, PID_COOLANT_TEMP, 0x7B, 0xCC, 0xCC, 0xCC, 0xCC };
+    decodeBench(state, frame);
+}
+BENCHMARK(BM_DecodeCoolant);
+
+// Manufacturer DID through the same registry - should match the PIDs
+static void BM_DecodeDid(benchmark::State& state) {
+    const uint8_t frame[8] = { 0x04, 0x62, DID_OIL_TEMP >> 8, DID_OIL_TEMP & 0xFF, 0x82, 0xCC, 0xCC, 0xCC };
+    decodeBench(state, frame);
+}
+BENCHMARK(BM_DecodeDid);
+
+// Display-time conversion of every speed / coolant code
+static void BM_DecodeUnits(benchmark::State& state) {
+    uint8_t raw = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(obdSpeed(raw));
+        benchmark::DoNotOptimize(obdTemp(raw));
+        raw++;
+    }
+}
+BENCHMARK(BM_DecodeUnits);
+
+// =============================================================================
+// ALERT EVALUATION
+// =============================================================================
+
+static void BM_AlertUpdateNormal(benchmark::State& state) {
+    AlertHandler alerts;
+    alerts.begin();
+    uint16_t rpm = 3000;
+    
+    for (auto _ : state) {
+        alerts.update(rpm, TEMP_F_TO_RAW(190), 55.0f);
+        rpm ^= 1;
+    }
+}
+BENCHMARK(BM_AlertUpdateNormal);
+
+static void BM_AlertUpdateShift(benchmark::State& state) {
+    AlertHandler alerts;
+    alerts.begin();
+    uint16_t rpm = 6500;
+    
+    for (auto _ : state) {
+        alerts.update(rpm, TEMP_F_TO_RAW(190), 55.0f);
+        rpm ^= 1;
+    }
+}
+BENCHMARK(BM_AlertUpdateShift);
+
+// Oil pressure map lookup at a different cell every call
+static void BM_AlertUpdateOilSweep(benchmark::State& state) {
+    AlertHandler alerts;
+    alerts.begin();
+    uint16_t rpm = 800;
+    int16_t oilTempC = 60;
+    
+    for (auto _ : state) {
+        alerts.update(rpm, TEMP_F_TO_RAW(190), 45.0f, oilTempC);
+        rpm = (rpm < 7400) ? rpm + 137 : 800;
+        oilTempC = (oilTempC < 135) ? oilTempC + 3 : 60;
+    }
+}
+BENCHMARK(BM_AlertUpdateOilSweep);
+
+// =============================================================================
+// NEXTION COMMAND FORMATTING
+// =============================================================================
+
+static void BM_DisplaySetText(benchmark::State& state) {
+    NullSerial serial;
+    DisplayHandler display(serial);
+    uint8_t speed = 0;
+    
+    // setSpeed is one setText(int): speed_val.txt="NN" + terminator
+    for (auto _ : state) {
+        display.setSpeed(speed++);
+    }
+    state.SetBytesProcessed(serial.bytes);
+}
+BENCHMARK(BM_DisplaySetText);
+
+static void BM_DisplaySetRPM(benchmark::State& state) {
+    NullSerial serial;
+    DisplayHandler display(serial);
+    
+    // setColor is private - it is timed as part of one full gauge write:
+    // setText + setProgress + setColor
+    uint16_t rpm = 1000;
+    for (auto _ : state) {
+        display.setRPM(rpm, COLOR_RPM_GREEN);
+        rpm = (rpm + 37) % RPM_MAX;
+    }
+    state.SetBytesProcessed(serial.bytes);
+}
+BENCHMARK(BM_DisplaySetRPM);
+
+static void BM_DisplaySendCommandFormat(benchmark::State& state) {
+    NullSerial serial;
+    DisplayHandler display(serial);
+    int value = 0;
+    
+    for (auto _ : state) {
+        display.sendCommand("dim=%d", value++ & 0x7F);
+    }
+    state.SetBytesProcessed(serial.bytes);
+}
+BENCHMARK(BM_DisplaySendCommandFormat);
+
+// =============================================================================
+// MLX90641 TIRE ZONE REDUCTION (wheel.cpp)
+// =============================================================================
+
+#define MLX_WIDTH   16
+#define MLX_HEIGHT  12
+
+static void BM_TireZones(benchmark::State& state) {
+    float frame[MLX_WIDTH * MLX_HEIGHT];
+    for (int i = 0; i < MLX_WIDTH * MLX_HEIGHT; i++) {
+        frame[i] = 60.0f + (i % MLX_WIDTH) * 0.5f + (i / MLX_WIDTH) * 0.1f;
+    }
+    
+    // Same split as wheel.cpp setup()
+    int split1 = MLX_WIDTH / 3;
+    int split2 = 2 * (MLX_WIDTH / 3);
+    
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tireZoneAverage(frame, MLX_WIDTH, MLX_HEIGHT, 0, split1 - 1));
+        benchmark::DoNotOptimize(tireZoneAverage(frame, MLX_WIDTH, MLX_HEIGHT, split1, split2 - 1));
+        benchmark::DoNotOptimize(tireZoneAverage(frame, MLX_WIDTH, MLX_HEIGHT, split2, MLX_WIDTH - 1));
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed((int64_t)state.iterations() * sizeof(frame));
+}
+BENCHMARK(BM_TireZones);
+
+// Same reduction fused with the per-pixel filter; compare with TireZones
+static void BM_TireFilterZones(benchmark::State& state) {
+    static float frames[2][MLX_WIDTH * MLX_HEIGHT];
+    for (int i = 0; i < MLX_WIDTH * MLX_HEIGHT; i++) {
+        frames[0][i] = 60.0f + (i % MLX_WIDTH) * 0.5f + (i / MLX_WIDTH) * 0.1f;
+        frames[1][i] = frames[0][i] + ((i * 7) % 5 - 2) * 0.1f;
+    }
+    frames[1][40] = 250.0f; // One outlier per frame pair
+    
+    static TireFilter_t filter;
+    tireFilterInit(&filter, 2, 8.0f, 3);
+    tireFilterMaskPixel(&filter, 17);
+    
+    const int zoneEnd[3] = {MLX_WIDTH / 3 - 1, 2 * (MLX_WIDTH / 3) - 1, MLX_WIDTH - 1};
+    float frame[MLX_WIDTH * MLX_HEIGHT];
+    float zone[3];
+    int n = 0;
+    for (auto _ : state) {
+        memcpy(frame, frames[n], sizeof(frame)); // Filtered in place
+        tireFilterZones(&filter, frame, MLX_WIDTH, MLX_HEIGHT, zoneEnd, 3, zone);
+        benchmark::DoNotOptimize(zone);
+        benchmark::ClobberMemory();
+        n ^= 1;
+    }
+    state.SetBytesProcessed((int64_t)state.iterations() * sizeof(frame));
+}
+BENCHMARK(BM_TireFilterZones);
+
+// Drifting tire image with sensor noise; label reports bytes per frame
+// and the ratio against 192 raw floats, keyframes included.
+static void BM_ThermalEncode(benchmark::State& state) {
+    const int frames = 64;
+    static float sequence[frames][MLX_WIDTH * MLX_HEIGHT];
+    uint32_t seed = 1;
+    for (int n = 0; n < frames; n++) {
+        for (int i = 0; i < MLX_WIDTH * MLX_HEIGHT; i++) {
+            int row = i / MLX_WIDTH;
+            seed = seed * 1103515245 + 12345;
+            float noise = ((int)((seed >> 16) % 41) - 20) * 0.01f;
+            sequence[n][i] = 70.0f + (i % MLX_WIDTH) + 5.0f * sinf(n * 0.05f)
+                             - (row == 0 || row == MLX_HEIGHT - 1 ? 10.0f : 0.0f) + noise;
+        }
+    }
+    
+    ThermalEncoder_t encoder = {};
+    uint8_t packet[THERMAL_MAX_BYTES(MLX_WIDTH * MLX_HEIGHT)];
+    size_t totalBytes = 0;
+    int n = 0;
+    for (auto _ : state) {
+        totalBytes += thermalEncode(&encoder, sequence[n], MLX_WIDTH, MLX_HEIGHT, packet, sizeof(packet));
+        n = (n + 1) % frames;
+        benchmark::ClobberMemory();
+    }
+    
+    static char label[48];
+    double perFrame = (double)totalBytes / state.iterations();
+    snprintf(label, sizeof(label), "%.1f B/frame, %.1fx vs float",
+             perFrame, sizeof(sequence[0]) / perFrame);
+    state.SetLabel(label);
+    state.SetBytesProcessed((int64_t)state.iterations() * sizeof(sequence[0]));
+}
+BENCHMARK(BM_ThermalEncode);
+
+BENCHMARK_MAIN();
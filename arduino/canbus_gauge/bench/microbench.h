@@ -0,0 +1,391 @@
+/*
+ * microbench.h - Minimal Google Benchmark-style harness
+ *
+ * Header-only and dependency-free so the gauge benchmarks build with just
+ * a host compiler. The API is the subset of Google Benchmark we use, so
+ * gauge_bench.cpp also builds against the real library:
+ *
+ *   static void BM_Thing(benchmark::State& state) {
+ *       Thing thing;                        // setup, not timed
+ *       for (auto _ : state) {
+ *           benchmark::DoNotOptimize(thing.run());
+ *       }
+ *   }
+ *   BENCHMARK(BM_Thing);
+ *   BENCHMARK_MAIN();
+ *
+ * Each benchmark runs growing batches until one takes at least
+ * --benchmark_min_time seconds, then reports that batch. Heap
+ * allocations (operator new, plus malloc/calloc/realloc when linked with
+ * -Wl,--wrap and MICROBENCH_WRAP_MALLOC) made inside the timed loop are
+ * counted and reported per iteration.
+ *
+ * Options:
+ *   --benchmark_filter=<substring>   Only run matching benchmarks
+ *   --benchmark_min_time=<seconds>   Minimum batch time (default 0.5)
+ *   --benchmark_out=<file>           Also write results as JSON
+ *
+ * Include from exactly one translation unit (it defines operator new).
+ */
+
+#ifndef MICROBENCH_H
+#define MICROBENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace benchmark {
+
+// --- Allocation counting ---
+
+namespace internal {
+    static uint64_t allocCount = 0;
+    static uint64_t allocBytes = 0;
+    static bool counting = false;
+
+    inline void noteAlloc(size_t size) {
+        if (counting) {
+            allocCount++;
+            allocBytes += size;
+        }
+    }
+
+    inline double nowSeconds(clockid_t clock) {
+        struct timespec ts;
+        clock_gettime(clock, &ts);
+        return ts.tv_sec + ts.tv_nsec * 1e-9;
+    }
+}
+
+// --- Optimizer barriers ---
+
+template<typename T>
+inline void DoNotOptimize(T const& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+template<typename T>
+inline void DoNotOptimize(T& value) {
+    asm volatile("" : "+r,m"(value) : : "memory");
+}
+
+inline void ClobberMemory() {
+    asm volatile("" : : : "memory");
+}
+
+// --- State ---
+
+class State {
+public:
+    // Non-trivial destructor keeps "for (auto _ : state)" warning-free
+    struct Value { ~Value() {} };
+
+    class Iterator {
+    public:
+        Iterator(State* state, uint64_t remaining) : _state(state), _remaining(remaining) {}
+        Value operator*() const { return Value(); }
+        Iterator& operator++() { _remaining--; return *this; }
+        bool operator!=(const Iterator&) {
+            if (_remaining != 0) {
+                return true;
+            }
+            _state->stopTimer();
+            return false;
+        }
+    private:
+        State* _state;
+        uint64_t _remaining;
+    };
+
+    explicit State(uint64_t iterations)
+        : _iterations(iterations), _realTime(0), _cpuTime(0),
+          _allocs(0), _allocBytes(0), _bytes(0) {}
+
+    Iterator begin() {
+        startTimer();
+        return Iterator(this, _iterations);
+    }
+    Iterator end() { return Iterator(this, 0); }
+
+    uint64_t iterations() const { return _iterations; }
+    void SetBytesProcessed(int64_t bytes) { _bytes = bytes; }
+    void SetLabel(const char* label) { _label = label; }
+
+    // Results
+    double realTime() const { return _realTime; }
+    double cpuTime() const { return _cpuTime; }
+    uint64_t allocs() const { return _allocs; }
+    uint64_t allocBytes() const { return _allocBytes; }
+    int64_t bytesProcessed() const { return _bytes; }
+    const std::string& label() const { return _label; }
+
+private:
+    uint64_t _iterations;
+    double _realStart, _cpuStart;
+    double _realTime, _cpuTime;
+    uint64_t _allocStart, _allocBytesStart;
+    uint64_t _allocs, _allocBytes;
+    int64_t _bytes;
+    std::string _label;
+
+    void startTimer() {
+        _allocStart = internal::allocCount;
+        _allocBytesStart = internal::allocBytes;
+        internal::counting = true;
+        _cpuStart = internal::nowSeconds(CLOCK_PROCESS_CPUTIME_ID);
+        _realStart = internal::nowSeconds(CLOCK_MONOTONIC);
+    }
+
+    void stopTimer() {
+        double realEnd = internal::nowSeconds(CLOCK_MONOTONIC);
+        double cpuEnd = internal::nowSeconds(CLOCK_PROCESS_CPUTIME_ID);
+        internal::counting = false;
+        _realTime = realEnd - _realStart;
+        _cpuTime = cpuEnd - _cpuStart;
+        _allocs = internal::allocCount - _allocStart;
+        _allocBytes = internal::allocBytes - _allocBytesStart;
+    }
+};
+
+// --- Registry ---
+
+typedef void (*Function)(State&);
+
+namespace internal {
+    struct Benchmark {
+        const char* name;
+        Function fn;
+    };
+
+    inline std::vector<Benchmark>& registry() {
+        static std::vector<Benchmark> benchmarks;
+        return benchmarks;
+    }
+
+    struct Registration {
+        Registration(const char* name, Function fn) {
+            Benchmark b = { name, fn };
+            registry().push_back(b);
+        }
+    };
+
+    struct Result {
+        std::string name;
+        uint64_t iterations;
+        double realNs;          // Per iteration
+        double cpuNs;
+        double allocsPerIter;
+        double allocBytesPerIter;
+        double bytesPerSecond;  // 0 if not set
+        std::string label;
+    };
+
+    inline Result run(const Benchmark& b, double minTime) {
+        uint64_t iterations = 1;
+        for (;;) {
+            State state(iterations);
+            b.fn(state);
+
+            // Report once the batch is long enough to trust the clock
+            if (state.realTime() >= minTime || iterations >= (1ULL << 40)) {
+                Result r;
+                r.name = b.name;
+                r.iterations = iterations;
+                r.realNs = state.realTime() * 1e9 / iterations;
+                r.cpuNs = state.cpuTime() * 1e9 / iterations;
+                r.allocsPerIter = (double)state.allocs() / iterations;
+                r.allocBytesPerIter = (double)state.allocBytes() / iterations;
+                r.bytesPerSecond = (state.bytesProcessed() > 0 && state.realTime() > 0) ?
+                                   state.bytesProcessed() / state.realTime() : 0;
+                r.label = state.label();
+                return r;
+            }
+
+            // Aim straight for the target once there's a usable estimate
+            double scale = (state.realTime() > minTime / 100) ?
+                           minTime * 1.4 / state.realTime() : 10;
+            uint64_t next = (uint64_t)(iterations * scale);
+            iterations = (next > iterations) ? next : iterations * 2;
+        }
+    }
+
+    inline void writeJson(const char* path, const char* executable,
+                          const std::vector<Result>& results) {
+        FILE* f = fopen(path, "w");
+        if (f == NULL) {
+            fprintf(stderr, "cannot write %s\n", path);
+            return;
+        }
+
+        char host[64] = "unknown";
+        gethostname(host, sizeof(host) - 1);
+        char date[32];
+        time_t t = time(NULL);
+        strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime(&t));
+
+        fprintf(f, "{\n  \"context\": {\n");
+        fprintf(f, "    \"date\": \"%s\",\n", date);
+        fprintf(f, "    \"host_name\": \"%s\",\n", host);
+        fprintf(f, "    \"executable\": \"%s\",\n", executable);
+        fprintf(f, "    \"num_cpus\": %ld,\n", sysconf(_SC_NPROCESSORS_ONLN));
+        #ifdef NDEBUG
+        fprintf(f, "    \"library_build_type\": \"release\"\n");
+        #else
+        fprintf(f, "    \"library_build_type\": \"debug\"\n");
+        #endif
+        fprintf(f, "  },\n  \"benchmarks\": [\n");
+
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result& r = results[i];
+            fprintf(f, "    {\n");
+            fprintf(f, "      \"name\": \"%s\",\n", r.name.c_str());
+            fprintf(f, "      \"run_name\": \"%s\",\n", r.name.c_str());
+            fprintf(f, "      \"run_type\": \"iteration\",\n");
+            fprintf(f, "      \"iterations\": %llu,\n", (unsigned long long)r.iterations);
+            fprintf(f, "      \"real_time\": %.4f,\n", r.realNs);
+            fprintf(f, "      \"cpu_time\": %.4f,\n", r.cpuNs);
+            fprintf(f, "      \"time_unit\": \"ns\",\n");
+            if (r.bytesPerSecond > 0) {
+                fprintf(f, "      \"bytes_per_second\": %.1f,\n", r.bytesPerSecond);
+            }
+            if (!r.label.empty()) {
+                fprintf(f, "      \"label\": \"%s\",\n", r.label.c_str());
+            }
+            fprintf(f, "      \"allocs_per_iter\": %.4f,\n", r.allocsPerIter);
+            fprintf(f, "      \"alloc_bytes_per_iter\": %.4f\n", r.allocBytesPerIter);
+            fprintf(f, "    }%s\n", (i + 1 < results.size()) ? "," : "");
+        }
+
+        fprintf(f, "  ]\n}\n");
+        fclose(f);
+    }
+
+    inline int runAll(int argc, char** argv) {
+        const char* filter = NULL;
+        const char* outPath = NULL;
+        double minTime = 0.5;
+
+        for (int i = 1; i < argc; i++) {
+            if (strncmp(argv[i], "--benchmark_filter=", 19) == 0) {
+                filter = argv[i] + 19;
+            } else if (strncmp(argv[i], "--benchmark_min_time=", 21) == 0) {
+                minTime = atof(argv[i] + 21);
+            } else if (strncmp(argv[i], "--benchmark_out=", 16) == 0) {
+                outPath = argv[i] + 16;
+            } else {
+                fprintf(stderr, "usage: %s [--benchmark_filter=<substring>] "
+                        "[--benchmark_min_time=<seconds>] [--benchmark_out=<file.json>]\n", argv[0]);
+                return 1;
+            }
+        }
+
+        printf("%-40s %12s %12s %12s %10s\n", "Benchmark", "Time", "CPU", "Iterations", "Allocs/op");
+        printf("%s\n", std::string(90, '-').c_str());
+
+        std::vector<Result> results;
+        for (size_t i = 0; i < registry().size(); i++) {
+            const Benchmark& b = registry()[i];
+            if (filter != NULL && strstr(b.name, filter) == NULL) {
+                continue;
+            }
+
+            Result r = run(b, minTime);
+            results.push_back(r);
+            printf("%-40s %9.2f ns %9.2f ns %12llu %10.2f %s\n", r.name.c_str(),
+                   r.realNs, r.cpuNs, (unsigned long long)r.iterations,
+                   r.allocsPerIter, r.label.c_str());
+            fflush(stdout);
+        }
+
+        if (outPath != NULL) {
+            writeJson(outPath, argv[0], results);
+        }
+        return 0;
+    }
+}
+
+} // namespace benchmark
+
+// --- Heap hooks ---
+
+// With MICROBENCH_WRAP_MALLOC the malloc below is the counting wrapper
+void* operator new(size_t size) {
+    #ifndef MICROBENCH_WRAP_MALLOC
+    benchmark::internal::noteAlloc(size);
+    #endif
+    void* p = malloc(size);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t size) {
+    #ifndef MICROBENCH_WRAP_MALLOC
+    benchmark::internal::noteAlloc(size);
+    #endif
+    void* p = malloc(size);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    free(p);
+}
+
+#ifdef MICROBENCH_WRAP_MALLOC
+// Linked with -Wl,--wrap=malloc etc: calls from our objects (not from
+// inside libc) land here
+extern "C" {
+    void* __real_malloc(size_t size);
+    void* __real_calloc(size_t n, size_t size);
+    void* __real_realloc(void* p, size_t size);
+
+    void* __wrap_malloc(size_t size) {
+        benchmark::internal::noteAlloc(size);
+        return __real_malloc(size);
+    }
+
+    void* __wrap_calloc(size_t n, size_t size) {
+        benchmark::internal::noteAlloc(n * size);
+        return __real_calloc(n, size);
+    }
+
+    void* __wrap_realloc(void* p, size_t size) {
+        benchmark::internal::noteAlloc(size);
+        return __real_realloc(p, size);
+    }
+}
+#endif
+
+#define MICROBENCH_CONCAT2(a, b) a##b
+#define MICROBENCH_CONCAT(a, b) MICROBENCH_CONCAT2(a, b)
+
+#define BENCHMARK(fn) \
+    static ::benchmark::internal::Registration MICROBENCH_CONCAT(microbench_reg_, __LINE__)(#fn, fn)
+
+#define BENCHMARK_MAIN() \
+    int main(int argc, char** argv) { return ::benchmark::internal::runAll(argc, argv); }
+
+#endif // MICROBENCH_H
@@ -4,18 +4,28 @@
 
 #include "can_handler.h"
 
-CANHandler::CANHandler(uint8_t csPin, uint8_t intPin) {
+CANHandler::CANHandler(uint8_t csPin, uint8_t intPin) : _can(csPin) {
     _csPin = csPin;
     _intPin = intPin;
-    _can = new MCP_CAN(csPin);
     
     _connected = false;
     _newData = false;
+    _newMotion = false;
     _lastQueryTime = 0;
-    _currentPidIndex = 0;
+    _lastQuery = OBD_NO_REQUEST;
+    
+    for (uint8_t ecu = 0; ecu < OBD_ECU_COUNT; ecu++) {
+        _ecuRateQ8[ecu] = (uint16_t)((1000UL << 8) / CAN_POLL_MS);
+        _ecuDecreasedAt[ecu] = 0;
+    }
+    _ecuSeen = 0;
+    memset(_requests, 0, sizeof(_requests));
     
     _queryCount = 0;
     _responseCount = 0;
+    _negativeCount = 0;
+    _busyCount = 0;
+    _lastNrc = 0;
     _errorCount = 0;
     
     memset(&_obdData, 0, sizeof(OBDData_t));
@@ -26,9 +36,18 @@ bool CANHandler::begin() {
     // Initialize MCP2515 with specified speed
     // Try multiple times in case of startup issues
     for (int attempt = 0; attempt < 3; attempt++) {
-        if (_can->begin(MCP_ANY, CAN_SPEED, CAN_CLOCK) == CAN_OK) {
+        if (_can.begin(MCP_STDEXT, CAN_SPEED, CAN_CLOCK) == CAN_OK) {
+            // Accept only ECU replies, so other modules' broadcasts neither
+            // cost a read nor wake the engine-off light sleep. Standard
+            // IDs sit in bits 16-26 of the mask/filter word.
+            _can.init_Mask(0, 0, (unsigned long)OBD_RESPONSE_MASK << 16);
+            _can.init_Mask(1, 0, (unsigned long)OBD_RESPONSE_MASK << 16);
+            for (uint8_t filt = 0; filt < 6; filt++) {
+                _can.init_Filt(filt, 0, (unsigned long)OBD_RESPONSE_ID_MIN << 16);
+            }
+            
             // Set to normal mode
-            _can->setMode(MCP_NORMAL);
+            _can.setMode(MCP_NORMAL);
             
             // Set up interrupt pin
             pinMode(_intPin, INPUT);
@@ -41,7 +60,7 @@ bool CANHandler::begin() {
             
             return true;
         }
-        delay(100);
+        clockDelay(100);
     }
     
     strncpy(_lastError, "CAN init failed after 3 attempts", sizeof(_lastError));
@@ -61,24 +80,72 @@ bool CANHandler::queryPID(uint8_t pid) {
     return sendQuery(OBD_SERVICE_CURRENT_DATA, pid);
 }
 
-bool CANHandler::sendQuery(uint8_t service, uint8_t pid) {
+bool CANHandler::queryDID(uint16_t did) {
+    if (!_connected) {
+        return false;
+    }
+    
+    return sendQuery(OBD_SERVICE_READ_DID, did);
+}
+
+bool CANHandler::pollNext(uint32_t now) {
+    if (!_connected) {
+        return false;
+    }
+    
+    // Most overdue first; a request never sent counts as overdue since boot
+    uint8_t best = OBD_NO_REQUEST;
+    int32_t bestLate = -1;
+    for (uint8_t i = 0; i < NUM_QUERY_REQUESTS; i++) {
+        if (!requestReady(i, now)) {
+            continue;
+        }
+        int32_t late = _requests[i].sent
+            ? (int32_t)(now - _requests[i].lastSent - QUERY_LIST[i].periodMs)
+            : (int32_t)now;
+        if (late > bestLate) {
+            best = i;
+            bestLate = late;
+        }
+    }
+    
+    if (best == OBD_NO_REQUEST) {
+        return false;
+    }
+    return sendQuery(QUERY_LIST[best].service, QUERY_LIST[best].id);
+}
+
+bool CANHandler::sendQuery(uint8_t service, uint16_t id) {
     // OBD-II query format:
     // Byte 0: Number of additional bytes (2 for standard query)
     // Byte 1: Service (01 = current data)
     // Byte 2: PID
     // Bytes 3-7: Padding (0x55 or 0xCC per ISO 15765-2)
     
-    uint8_t txData[8] = {0x02, service, pid, 0xCC, 0xCC, 0xCC, 0xCC, 0xCC};
+    uint8_t txData[8] = {0x02, service, (uint8_t)id, 0xCC, 0xCC, 0xCC, 0xCC, 0xCC};
+    unsigned long txId = OBD_REQUEST_ID;
+    
+    // UDS ReadDataByIdentifier: 3 bytes, 16-bit DID, sent to the ECM itself
+    if (service == OBD_SERVICE_READ_DID) {
+        txData[0] = 0x03;
+        txData[2] = id >> 8;
+        txData[3] = id & 0xFF;
+        txId = UDS_REQUEST_ID;
+    }
     
-    // Send to broadcast address 0x7DF
-    byte result = _can->sendMsgBuf(OBD_REQUEST_ID, 0, 8, txData);
+    byte result = _can.sendMsgBuf(txId, 0, 8, txData);
     
     if (result == CAN_OK) {
         _queryCount++;
-        _lastQueryTime = millis();
+        _lastQueryTime = clockMillis();
+        _lastQuery = findRequest(service, id);
+        if (_lastQuery != OBD_NO_REQUEST) {
+            _requests[_lastQuery].lastSent = _lastQueryTime;
+            _requests[_lastQuery].sent = true;
+        }
         
         #if DEBUG_CAN_MESSAGES
-        Serial.printf("CAN TX: Service=0x%02X PID=0x%02X\n", service, pid);
+        Serial.printf("CAN TX: Service=0x%02X ID=0x%02X\n", service, id);
         #endif
         
         return true;
@@ -95,13 +162,13 @@ bool CANHandler::processMessages() {
     }
     
     // Check if there's a message waiting
-    if (digitalRead(_intPin) == LOW || _can->checkReceive() == CAN_MSGAVAIL) {
+    if (digitalRead(_intPin) == LOW || _can.checkReceive() == CAN_MSGAVAIL) {
         unsigned long rxId;
         uint8_t len;
         uint8_t rxBuf[8];
         
         // Read the message
-        _can->readMsgBuf(&rxId, &len, rxBuf);
+        _can.readMsgBuf(&rxId, &len, rxBuf);
         
         #if DEBUG_CAN_MESSAGES
         Serial.printf("CAN RX: ID=0x%03lX Len=%d Data=", rxId, len);
@@ -113,7 +180,18 @@ bool CANHandler::processMessages() {
         
         // Check if it's an OBD-II response (0x7E8-0x7EF)
         if (rxId >= OBD_RESPONSE_ID_MIN && rxId <= OBD_RESPONSE_ID_MAX) {
-            parseResponse(rxBuf, len);
+            uint8_t ecu = rxId - OBD_RESPONSE_ID_MIN;
+            _ecuSeen |= 1 << ecu;
+            
+            if (len >= 4 && rxBuf[1] == OBD_NEGATIVE_RESPONSE) {
+                handleNegative(ecu, rxBuf[2], rxBuf[3], clockMillis());
+                _negativeCount++;
+                return true;
+            }
+            
+            if (parseResponse(ecu, rxBuf, len)) {
+                rateIncrease(ecu);
+            }
             _responseCount++;
             return true;
         }
@@ -122,110 +200,192 @@ bool CANHandler::processMessages() {
     return false;
 }
 
-void CANHandler::parseResponse(uint8_t* data, uint8_t len) {
+bool CANHandler::parseResponse(uint8_t ecu, uint8_t* data, uint8_t len) {
     // OBD-II response format:
     // Byte 0: Number of additional bytes
-    // Byte 1: Service + 0x40 (e.g., 0x41 for service 0x01)
-    // Byte 2: PID
-    // Bytes 3+: Data
+    // Byte 1: Service + 0x40 (0x41 for service 01, 0x62 for service 22)
+    // Byte 2: PID (service 22: bytes 2-3, DID high and low)
+    // Then:   Data bytes A, B, ...
     
     if (len < 4) {
-        return; // Invalid response
+        return false; // Invalid response
     }
     
     uint8_t numBytes = data[0];
-    uint8_t service = data[1];
-    uint8_t pid = data[2];
+    uint8_t service = data[1] - OBD_POSITIVE_OFFSET;
+    uint16_t id;
+    uint8_t first;
     
-    // Verify it's a response to service 01
-    if (service != (OBD_SERVICE_CURRENT_DATA + 0x40)) {
-        return;
+    if (service == OBD_SERVICE_CURRENT_DATA) {
+        id = data[2];
+        first = 3;
+    } else if (service == OBD_SERVICE_READ_DID) {
+        id = calculateWord(data[2], data[3]);
+        first = 4;
+    } else {
+        return false;
     }
     
-    // Parse based on PID
-    switch (pid) {
-        case PID_ENGINE_RPM:
-            // Data bytes: A, B -> RPM = ((A * 256) + B) / 4
-            if (numBytes >= 4) {
-                _obdData.rpm = calculateRPM(data[3], data[4]);
-                _obdData.valid = true;
-                _newData = true;
-                
-                #if DEBUG_SENSOR_VALUES
-                Serial.printf("RPM: %d\n", _obdData.rpm);
-                #endif
-            }
-            break;
-            
-        case PID_VEHICLE_SPEED:
-            // Data byte: A -> Speed in km/h
-            if (numBytes >= 3) {
-                _obdData.speed_kmh = calculateSpeedKmh(data[3]);
-                _obdData.speed_mph = calculateSpeedMph(_obdData.speed_kmh);
-                _newData = true;
-                
-                #if DEBUG_SENSOR_VALUES
-                Serial.printf("Speed: %d km/h (%d mph)\n", _obdData.speed_kmh, _obdData.speed_mph);
-                #endif
-            }
-            break;
-            
-        case PID_COOLANT_TEMP:
-            // Data byte: A -> Temp = A - 40 (°C)
-            if (numBytes >= 3) {
-                _obdData.coolant_temp_c = calculateCoolantTempC(data[3]);
-                _obdData.coolant_temp_f = celsiusToFahrenheit(_obdData.coolant_temp_c);
-                _newData = true;
-                
-                #if DEBUG_SENSOR_VALUES
-                Serial.printf("Coolant Temp: %d°C (%d°F)\n", _obdData.coolant_temp_c, _obdData.coolant_temp_f);
-                #endif
-            }
-            break;
-            
-        case PID_THROTTLE_POSITION:
-            if (numBytes >= 3) {
-                _obdData.throttle_pos = calculateThrottlePos(data[3]);
-                _newData = true;
-            }
+    uint8_t index = findRequest(service, id);
+    if (index != OBD_NO_REQUEST) {
+        _requests[index].answeredBy |= 1 << ecu;
+        _requests[index].lastNrc = 0;
+        _requests[index].backoffMs = 0;
+    }
+    
+    const OBDSignal_t* signal = findSignal(service, id);
+    if (signal == NULL) {
+        return true; // Served, but nothing we decode
+    }
+    
+    uint8_t bytes = obdDecodeBytes(signal->decode);
+    if (numBytes < first - 1 + bytes || first + bytes > len) {
+        return true;
+    }
+    
+    const uint8_t* a = &data[first];
+    uint8_t* field = (uint8_t*)&_obdData + signal->offset;
+    uint16_t value;
+    
+    switch (signal->decode) {
+        case OBD_DECODE_FLAG:
+            value = (a[0] & signal->mask) ? 1 : 0;
+            *field = value;
             break;
             
-        case PID_ENGINE_LOAD:
-            if (numBytes >= 3) {
-                _obdData.engine_load = calculateEngineLoad(data[3]);
-                _newData = true;
-            }
+        case OBD_DECODE_WORD:
+            value = calculateWord(a[0], a[1]);
+            memcpy(field, &value, sizeof(value));
             break;
             
-        case PID_INTAKE_TEMP:
-            if (numBytes >= 3) {
-                _obdData.intake_temp_c = calculateIntakeTempC(data[3]);
-                _newData = true;
-            }
+        case OBD_DECODE_RPM:
+            value = calculateRPM(a[0], a[1]);
+            memcpy(field, &value, sizeof(value));
+            _obdData.valid = true;
             break;
             
-        case PID_OIL_TEMP:
-            if (numBytes >= 3) {
-                _obdData.oil_temp_c = calculateOilTempC(data[3]);
-                _obdData.oil_temp_f = celsiusToFahrenheit(_obdData.oil_temp_c);
-                _newData = true;
-            }
+        default:
+            value = a[0];
+            *field = value;
             break;
-            
-        case PID_CONTROL_MODULE_VOLTAGE:
-            if (numBytes >= 4) {
-                _obdData.battery_voltage = calculateVoltage(data[3], data[4]);
-                _newData = true;
-            }
+    }
+    _newData = true;
+    if (signal->offset == offsetof(OBDData_t, rpm) ||
+        signal->offset == offsetof(OBDData_t, speed_kmh)) {
+        _newMotion = true;
+    }
+    
+    #if DEBUG_SENSOR_VALUES
+    Serial.printf("OBD %04X: %u\n", id, value);
+    #endif
+    
+    return true;
+}
+
+const OBDSignal_t* CANHandler::findSignal(uint8_t service, uint16_t id) {
+    for (uint8_t i = 0; i < NUM_OBD_SIGNALS; i++) {
+        if (OBD_SIGNALS[i].id == id && OBD_SIGNALS[i].service == service) {
+            return &OBD_SIGNALS[i];
+        }
+    }
+    return NULL;
+}
+
+uint8_t CANHandler::findRequest(uint8_t service, uint16_t id) {
+    for (uint8_t i = 0; i < NUM_QUERY_REQUESTS; i++) {
+        if (QUERY_LIST[i].id == id && QUERY_LIST[i].service == service) {
+            return i;
+        }
+    }
+    return OBD_NO_REQUEST;
+}
+
+void CANHandler::handleNegative(uint8_t ecu, uint8_t service, uint8_t nrc, uint32_t now) {
+    _lastNrc = nrc;
+    
+    #if DEBUG_CAN_MESSAGES
+    Serial.printf("CAN NRC: ECU %d service 0x%02X NRC 0x%02X\n", ecu, service, nrc);
+    #endif
+    
+    if (nrc == NRC_RESPONSE_PENDING) {
+        return; // The real answer follows
+    }
+    
+    if (nrc == NRC_BUSY_REPEAT_REQUEST) {
+        // Multiplicative decrease, once per overload episode
+        _busyCount++;
+        if (now - _ecuDecreasedAt[ecu] >= OBD_RATE_HOLD_MS) {
+            _ecuDecreasedAt[ecu] = now;
+            uint16_t minQ8 = (uint16_t)OBD_RATE_MIN_HZ << 8;
+            _ecuRateQ8[ecu] = max((uint16_t)(_ecuRateQ8[ecu] / 2), minQ8);
+        }
+        return;
+    }
+    
+    // A definite refusal still means the ECU kept up
+    rateIncrease(ecu);
+    
+    if (_lastQuery == OBD_NO_REQUEST || QUERY_LIST[_lastQuery].service != service) {
+        return;
+    }
+    
+    RequestState_t* req = &_requests[_lastQuery];
+    if ((req->answeredBy & ~(1 << ecu)) != 0) {
+        return; // Another ECU answers this one
+    }
+    req->lastNrc = nrc;
+    
+    switch (nrc) {
+        case NRC_SERVICE_NOT_SUPPORTED:
+        case NRC_SUBFUNCTION_NOT_SUPP:
+        case NRC_REQUEST_OUT_OF_RANGE:
+            req->backoffMs = OBD_PID_UNSUPPORTED_MS;
             break;
             
-        case PID_RUN_TIME:
-            if (numBytes >= 4) {
-                _obdData.run_time = calculateRunTime(data[3], data[4]);
-                _newData = true;
+        default:
+            // Conditions not correct, general reject, ...: exponential backoff
+            if (req->backoffMs == 0) {
+                req->backoffMs = OBD_PID_BACKOFF_MIN_MS;
+            } else if (req->backoffMs < OBD_PID_BACKOFF_MAX_MS) {
+                req->backoffMs = min((uint32_t)req->backoffMs * 2, (uint32_t)OBD_PID_BACKOFF_MAX_MS);
             }
             break;
     }
+    req->retryAt = now + req->backoffMs;
+}
+
+void CANHandler::rateIncrease(uint8_t ecu) {
+    // Additive increase
+    uint16_t maxQ8 = (uint16_t)OBD_RATE_MAX_HZ << 8;
+    _ecuRateQ8[ecu] = min((uint16_t)(_ecuRateQ8[ecu] + OBD_RATE_STEP_Q8), maxQ8);
+}
+
+bool CANHandler::requestReady(uint8_t index, uint32_t now) {
+    const RequestState_t* req = &_requests[index];
+    return req->backoffMs == 0 || (int32_t)(now - req->retryAt) >= 0;
+}
+
+bool CANHandler::pidReady(uint8_t pid, uint32_t now) {
+    uint8_t index = findRequest(OBD_SERVICE_CURRENT_DATA, pid);
+    return index == OBD_NO_REQUEST || requestReady(index, now);
+}
+
+uint16_t CANHandler::getLearnedRateQ8() {
+    uint16_t rate = 0xFFFF;
+    for (uint8_t ecu = 0; ecu < OBD_ECU_COUNT; ecu++) {
+        if (_ecuSeen & (1 << ecu)) {
+            rate = min(rate, _ecuRateQ8[ecu]);
+        }
+    }
+    return (rate == 0xFFFF) ? _ecuRateQ8[0] : rate;
+}
+
+uint16_t CANHandler::getEcuRateQ8(uint8_t ecu) {
+    return (ecu < OBD_ECU_COUNT) ? _ecuRateQ8[ecu] : 0;
+}
+
+uint32_t CANHandler::getPollIntervalMs() {
+    return (1000UL << 8) / getLearnedRateQ8();
 }
 
 OBDData_t CANHandler::getData() {
@@ -236,8 +396,13 @@ bool CANHandler::hasNewData() {
     return _newData;
 }
 
+bool CANHandler::hasNewMotion() {
+    return _newMotion;
+}
+
 void CANHandler::clearNewDataFlag() {
     _newData = false;
+    _newMotion = false;
 }
 
 const char* CANHandler::getLastError() {
@@ -252,6 +417,18 @@ uint32_t CANHandler::getResponseCount() {
     return _responseCount;
 }
 
+uint32_t CANHandler::getNegativeCount() {
+    return _negativeCount;
+}
+
+uint32_t CANHandler::getBusyCount() {
+    return _busyCount;
+}
+
+uint8_t CANHandler::getLastNrc() {
+    return _lastNrc;
+}
+
 uint32_t CANHandler::getErrorCount() {
     return _errorCount;
 }
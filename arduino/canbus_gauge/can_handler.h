@@ -1,7 +1,16 @@
 /*
  * can_handler.h - CAN Bus communication handler for MCP2515
  * 
- * Handles OBD-II queries and responses via CAN bus.
+ * Handles OBD-II queries and responses via CAN bus: SAE service 01 PIDs
+ * (functional, 0x7DF) and UDS service 22 manufacturer DIDs (physical, to
+ * the ECM). Both are scheduled from QUERY_LIST and decoded through the
+ * OBD_SIGNALS registry in obd_pids.h.
+ *
+ * Negative responses (0x7F) are decoded rather than counted as replies.
+ * A busy ECU (NRC 0x21) slows the poll rate for everyone - see OBD REQUEST
+ * PACING in config.h - and a refused request is backed off on its own. The
+ * NRC frame names the service but not the PID/DID, so it is charged to the
+ * request sent last; at the poll rate only one query is ever outstanding.
  */
 
 #ifndef CAN_HANDLER_H
@@ -11,6 +20,20 @@
 #include <mcp_can.h>
 #include "config.h"
 #include "obd_pids.h"
+#include "clock.h"
+
+#define OBD_ECU_COUNT   (OBD_RESPONSE_ID_MAX - OBD_RESPONSE_ID_MIN + 1)
+#define OBD_NO_REQUEST  0xFF
+
+// Schedule and backoff state of one QUERY_LIST entry
+typedef struct {
+    uint32_t lastSent;
+    uint32_t retryAt;           // No query before this
+    uint16_t backoffMs;         // Current backoff (0 = none)
+    uint8_t lastNrc;            // 0 = none since the last positive reply
+    uint8_t answeredBy;         // Bit per ECU that has answered it positively
+    bool sent;
+} RequestState_t;
 
 class CANHandler {
 public:
@@ -22,8 +45,13 @@ public:
     // Check if CAN bus is connected
     bool isConnected();
     
-    // Query a specific PID
+    // Query a specific PID (service 01) or DID (service 22)
     bool queryPID(uint8_t pid);
+    bool queryDID(uint16_t did);
+    
+    // Send the most overdue QUERY_LIST request that isn't backed off.
+    // Returns false if nothing was due.
+    bool pollNext(uint32_t now);
     
     // Process incoming CAN messages (call frequently)
     bool processMessages();
@@ -34,41 +62,82 @@ public:
     // Check if new data is available
     bool hasNewData();
     
-    // Clear the new data flag
+    // Check if a fresh RPM or speed value arrived (other replies don't
+    // count - the gear estimator must not see one sample twice)
+    bool hasNewMotion();
+    
+    // Clear the new data flags
     void clearNewDataFlag();
     
     // Get last error message
     const char* getLastError();
     
+    // False while a QUERY_LIST PID is backed off after a negative response
+    bool pidReady(uint8_t pid, uint32_t now);
+    
+    // Poll interval for the learned request rate
+    uint32_t getPollIntervalMs();
+    
+    // Learned request rate (Hz, Q8): the slowest ECU heard from, or the
+    // starting rate before any reply
+    uint16_t getLearnedRateQ8();
+    uint16_t getEcuRateQ8(uint8_t ecu);
+    
     // Get statistics
     uint32_t getQueryCount();
-    uint32_t getResponseCount();
+    uint32_t getResponseCount();    // Positive (and unrecognised) replies
+    uint32_t getNegativeCount();    // 0x7F replies
+    uint32_t getBusyCount();        // ... of which busyRepeatRequest
+    uint8_t getLastNrc();
     uint32_t getErrorCount();
 
 private:
-    MCP_CAN* _can;
+    MCP_CAN _can;
     uint8_t _csPin;
     uint8_t _intPin;
     
     bool _connected;
     bool _newData;
+    bool _newMotion;
     OBDData_t _obdData;
     
     uint32_t _lastQueryTime;
-    uint8_t _currentPidIndex;
+    uint8_t _lastQuery;         // QUERY_LIST index, or OBD_NO_REQUEST
+    
+    // Request pacing
+    uint16_t _ecuRateQ8[OBD_ECU_COUNT];
+    uint32_t _ecuDecreasedAt[OBD_ECU_COUNT];
+    uint8_t _ecuSeen;           // Bit per ECU that has replied
+    RequestState_t _requests[NUM_QUERY_REQUESTS];
     
     // Statistics
     uint32_t _queryCount;
     uint32_t _responseCount;
+    uint32_t _negativeCount;
+    uint32_t _busyCount;
+    uint8_t _lastNrc;
     uint32_t _errorCount;
     
     char _lastError[64];
     
-    // Parse OBD-II response
-    void parseResponse(uint8_t* data, uint8_t len);
+    // Parse OBD-II response; true if it was a positive service 01/22 reply
+    bool parseResponse(uint8_t ecu, uint8_t* data, uint8_t len);
+    
+    // Negative response from ECU ecu
+    void handleNegative(uint8_t ecu, uint8_t service, uint8_t nrc, uint32_t now);
+    
+    // ECU ecu served a request (positive, or a definite refusal)
+    void rateIncrease(uint8_t ecu);
+    
+    bool requestReady(uint8_t index, uint32_t now);
+    
+    // QUERY_LIST index of a request, or OBD_NO_REQUEST
+    uint8_t findRequest(uint8_t service, uint16_t id);
+    
+    const OBDSignal_t* findSignal(uint8_t service, uint16_t id);
     
     // Send OBD-II query
-    bool sendQuery(uint8_t service, uint8_t pid);
+    bool sendQuery(uint8_t service, uint16_t id);
 };
 
 #endif // CAN_HANDLER_H
@@ -11,6 +11,7 @@
  * - Water temperature gauge with warning/critical alerts
  * - Oil pressure gauge (analog sensor) with warning/critical alerts
  * - Audible buzzer for alerts
+ * - LED shift light bar (WS2812B/SK6812)
  * 
  * Hardware:
  * - ESP32 DevKit
@@ -18,6 +19,7 @@
  * - Nextion 7" display
  * - 0-5V oil pressure sender
  * - Piezo buzzer
+ * - WS2812B / SK6812 LED strip (shift light)
  * 
  * Author: VTMS Project
  * Date: 2026
@@ -27,11 +29,18 @@
 #include <mcp_can.h>
 
 #include "config.h"
+#include "clock.h"
 #include "obd_pids.h"
+#include "obd_units.h"
 #include "can_handler.h"
 #include "sensors.h"
 #include "alerts.h"
 #include "display_handler.h"
+#include "shift_light.h"
+#include "gear_estimator.h"
+#include "power_manager.h"
+#include "crash_recorder.h"
+#include "trend_aggregator.h"
 
 // =============================================================================
 // GLOBAL OBJECTS
@@ -49,25 +58,54 @@ AlertHandler alerts;
 // Display handler (using Serial2)
 DisplayHandler display(Serial2);
 
+// LED shift light bar (RMT)
+ShiftLight shiftLight(SHIFT_LIGHT_PIN);
+
+// Gear estimate (for per-gear shift points)
+GearEstimator gearEstimator;
+
+// Engine-off low-power mode
+PowerManager power;
+
+// Pre/post capture of critical alerts to flash
+#if CRASH_RECORDER_ENABLED
+CrashRecorder crashRecorder;
+#endif
+
+// Per-minute trends on the debug serial
+#if AGG_ENABLED
+TrendAggregator trend(Serial);
+#endif
+
 // =============================================================================
 // TIMING VARIABLES
 // =============================================================================
 
 uint32_t lastCANPoll = 0;
 uint32_t lastSensorRead = 0;
-uint32_t lastDisplayUpdate = 0;
+uint32_t lastTraceSample = 0;
+uint32_t lastDiagUpdate = 0;
 uint32_t lastDebugPrint = 0;
+uint32_t lastCrashSample = 0;
 
-uint8_t currentPIDIndex = 0;
+// Page button debounce
+bool     pageButtonPressed = false;
+bool     pageButtonReading = false;
+uint32_t pageButtonChanged = 0;
+uint32_t pageButtonDown = 0;        // Debounced press edge
+bool     pageButtonLong = false;    // This press already toggled short-shift
 
 // =============================================================================
 // CURRENT VALUES
 // =============================================================================
 
 uint16_t currentRPM = 0;
-uint8_t  currentSpeedMph = 0;
-int16_t  currentWaterTempF = 0;
+uint8_t  currentSpeed = 0;         // Display units (SPEED_UNIT_MPH)
+int16_t  currentWaterTemp = 0;     // Display units (TEMP_UNIT_F)
+uint8_t  currentCoolantRaw = 0;    // SAE byte (°C + 40) - alerts use this
 float    currentOilPsi = 0;
+int16_t  currentOilTempC = OIL_MAP_DEFAULT_TEMP_C;  // Oil pressure map axis
+uint8_t  currentGear = GEAR_UNKNOWN;
 
 // =============================================================================
 // SETUP
@@ -77,13 +115,15 @@ void setup() {
     // Initialize debug serial
     #if DEBUG_ENABLED
     Serial.begin(DEBUG_BAUD);
-    while (!Serial && millis() < 3000); // Wait up to 3 seconds for Serial
+    while (!Serial && clockMillis() < 3000); // Wait up to 3 seconds for Serial
     Serial.println();
     Serial.println("=================================");
     Serial.println("  ESP32 CAN Bus Gauge Cluster");
     Serial.println("  2007-2008 Acura TL");
     Serial.println("=================================");
     Serial.println();
+    #elif AGG_ENABLED
+    Serial.begin(DEBUG_BAUD);   // $AGG lines go out without debug output too
     #endif
     
     // Initialize display first (show startup screen)
@@ -115,17 +155,37 @@ void setup() {
     Serial.println("Initializing alerts...");
     alerts.begin();
     
+    // Erases the next capture slot, so before the loop starts
+    #if CRASH_RECORDER_ENABLED
+    Serial.println("Initializing crash recorder...");
+    crashRecorder.begin();
+    #endif
+    
+    #if PAGE_BUTTON_ENABLED
+    pinMode(PAGE_BUTTON_PIN, INPUT_PULLUP);
+    #endif
+    
+    #if SHIFT_LIGHT_ENABLED
+    Serial.println("Initializing shift light...");
+    if (!shiftLight.begin()) {
+        Serial.println("Shift light: FAILED");
+    }
+    #endif
+    
     // Ready!
     Serial.println();
     Serial.println("System ready!");
     Serial.println();
     
     display.showStartup("Ready!");
-    delay(1000);
+    clockDelay(1000);
     
     // Switch to main display
     display.goToPage(NextionID::PAGE_MAIN);
     
+    // Full power until the engine has been off a while
+    power.begin(clockMillis());
+    
     // Print configuration
     #if DEBUG_ENABLED
     printConfig();
@@ -137,10 +197,10 @@ void setup() {
 // =============================================================================
 
 void loop() {
-    uint32_t now = millis();
+    uint32_t now = clockMillis();
     
     // --- Poll CAN bus for OBD data ---
-    if (now - lastCANPoll >= CAN_POLL_MS) {
+    if (now - lastCANPoll >= power.period(canHandler.getPollIntervalMs(), POWER_LOW_CAN_POLL_MS)) {
         lastCANPoll = now;
         pollCANData();
     }
@@ -151,19 +211,71 @@ void loop() {
         updateFromCAN();
     }
     
+    // --- Engine off? (a running engine is back to full rate right here) ---
+    power.update(currentRPM, canHandler.getResponseCount(), now);
+    
     // --- Read analog sensors ---
-    if (now - lastSensorRead >= SENSOR_READ_MS) {
+    if (now - lastSensorRead >= power.period(SENSOR_READ_MS, POWER_LOW_SENSOR_MS)) {
         lastSensorRead = now;
         readSensors();
+        
+        // --- Trend aggregation (engine running, coolant read at least once) ---
+        #if AGG_ENABLED
+        if (currentRPM > 0 && canHandler.getData().coolant_raw != 0) {
+            trend.add(currentRPM, (uint16_t)constrain(currentOilPsi * 10.0f + 0.5f, 0.0f, 65535.0f),
+                      currentWaterTemp, now);
+        }
+        #endif
     }
+    #if AGG_ENABLED
+    trend.service(now);
+    #endif
     
     // --- Update alerts ---
-    alerts.update(currentRPM, currentWaterTempF, currentOilPsi);
+    alerts.update(currentRPM, currentCoolantRaw, currentOilPsi, currentOilTempC);
     
-    // --- Update display ---
-    if (now - lastDisplayUpdate >= DISPLAY_UPDATE_MS) {
-        lastDisplayUpdate = now;
-        updateDisplay();
+    // --- Crash recorder (a new critical alert freezes the last 30 s) ---
+    #if CRASH_RECORDER_ENABLED
+    if (now - lastCrashSample >= power.period(CRASH_SAMPLE_MS, POWER_LOW_SENSOR_MS)) {
+        lastCrashSample = now;
+        recordCrashSample(now);
+    }
+    crashRecorder.service(now, power.isLowPower());
+    #endif
+    
+    // --- Shift light (keeps the redline flash going between RPM samples) ---
+    #if SHIFT_LIGHT_ENABLED
+    shiftLight.update(currentRPM);
+    #endif
+    
+    // --- Page button (flip happens on the next display update) ---
+    #if PAGE_BUTTON_ENABLED
+    readPageButton(now);
+    #endif
+    
+    // --- Diagnostics page values ---
+    if (now - lastDiagUpdate >= DIAG_UPDATE_MS) {
+        lastDiagUpdate = now;
+        updateDiagnostics();
+    }
+    
+    // --- Update display (paced by DisplayHandler flow control) ---
+    display.setBrightness(power.brightness());
+    updateDisplay();
+    
+    // --- Strip chart sample ---
+    if (now - lastTraceSample >= power.period(TRACE_SAMPLE_MS, POWER_LOW_SENSOR_MS)) {
+        lastTraceSample = now;
+        display.pushTrace(currentRPM, currentOilPsi);
+    }
+    
+    // --- Service display responses / bulk transfers ---
+    display.poll();
+    
+    // --- Touches are activity (page flips happen inside DisplayHandler) ---
+    TouchEvent_t touch;
+    while (display.readTouch(touch)) {
+        power.wake(now);
     }
     
     // --- Debug output ---
@@ -173,6 +285,61 @@ void loop() {
         printDebugInfo();
     }
     #endif
+    
+    // --- Engine off: light-sleep to the next deadline ---
+    // Not with replies outstanding (they would be lost) or an alert
+    // sounding (the buzzer PWM stops in light sleep)
+    if (power.isLowPower() && display.isIdle() && !alerts.hasAnyAlert()) {
+        Serial.flush();
+        uint32_t wakeAt = clockMillis();
+        if (power.sleepUntil(nextLoopDeadline(wakeAt), wakeAt)) {
+            display.dropPartialFrame();
+            power.wake(clockMillis());
+        }
+    }
+}
+
+// =============================================================================
+// SCHEDULING
+// =============================================================================
+
+// Earliest time loop() has work to do if no CAN frame, pin change or display
+// reply arrives first. The host simulation (sim/) jumps straight here.
+uint32_t nextLoopDeadline(uint32_t now) {
+    uint32_t next = now + CLOCK_IDLE_MS;
+    
+    clockSooner(next, lastCANPoll + power.period(canHandler.getPollIntervalMs(), POWER_LOW_CAN_POLL_MS), now);
+    clockSooner(next, lastSensorRead + power.period(SENSOR_READ_MS, POWER_LOW_SENSOR_MS), now);
+    clockSooner(next, lastDiagUpdate + DIAG_UPDATE_MS, now);
+    clockSooner(next, lastTraceSample + power.period(TRACE_SAMPLE_MS, POWER_LOW_SENSOR_MS), now);
+    clockSooner(next, power.nextDeadline(now), now);
+    #if CRASH_RECORDER_ENABLED
+    clockSooner(next, lastCrashSample + power.period(CRASH_SAMPLE_MS, POWER_LOW_SENSOR_MS), now);
+    clockSooner(next, crashRecorder.nextDeadline(now), now);
+    #endif
+    #if AGG_ENABLED
+    clockSooner(next, trend.nextDeadline(now), now);
+    #endif
+    #if DEBUG_ENABLED
+    clockSooner(next, lastDebugPrint + 1000, now);
+    #endif
+    
+    #if PAGE_BUTTON_ENABLED
+    if (pageButtonReading != pageButtonPressed) {
+        clockSooner(next, pageButtonChanged + PAGE_BUTTON_DEBOUNCE_MS, now);
+    }
+    if (pageButtonPressed && !pageButtonLong) {
+        clockSooner(next, pageButtonDown + PAGE_BUTTON_LONG_MS, now);
+    }
+    #endif
+    
+    clockSooner(next, alerts.nextDeadline(now), now);
+    clockSooner(next, display.nextDeadline(now), now);
+    #if SHIFT_LIGHT_ENABLED
+    clockSooner(next, shiftLight.nextDeadline(now), now);
+    #endif
+    
+    return next;
 }
 
 // =============================================================================
@@ -180,15 +347,19 @@ void loop() {
 // =============================================================================
 
 void pollCANData() {
-    // Query next PID in sequence
-    if (currentPIDIndex >= NUM_QUERY_PIDS) {
-        currentPIDIndex = 0;
-    }
+    uint32_t now = clockMillis();
     
-    uint8_t pid = QUERY_PIDS[currentPIDIndex];
-    canHandler.queryPID(pid);
+    // Engine off: only RPM matters - it shows the engine cranking
+    if (power.isLowPower()) {
+        if (canHandler.pidReady(PID_ENGINE_RPM, now)) {
+            canHandler.queryPID(PID_ENGINE_RPM);
+        }
+        return;
+    }
     
-    currentPIDIndex++;
+    // PIDs and DIDs by how overdue they are, skipping any the ECU has
+    // refused lately
+    canHandler.pollNext(now);
 }
 
 void updateFromCAN() {
@@ -197,8 +368,33 @@ void updateFromCAN() {
         
         // Update current values
         currentRPM = data.rpm;
-        currentSpeedMph = data.speed_mph;
-        currentWaterTempF = data.coolant_temp_f;
+        currentSpeed = obdSpeed(data.speed_kmh);
+        currentWaterTemp = obdTemp(data.coolant_raw);
+        currentCoolantRaw = data.coolant_raw;
+        
+        // Oil temp picks the oil pressure thresholds; coolant stands in
+        // until the ECM answers DID_OIL_TEMP
+        if (data.oil_raw != 0) {
+            currentOilTempC = rawTempToC(data.oil_raw);
+        } else if (data.coolant_raw != 0) {
+            currentOilTempC = rawTempToC(data.coolant_raw);
+        }
+        
+        // Shift points follow the gear. Only a fresh RPM or speed is a new
+        // sample - a coolant reply must not count a mid-shift pair again.
+        if (canHandler.hasNewMotion()) {
+            uint8_t gear = gearEstimator.update(data.rpm, data.speed_kmh, clockMillis());
+            if (gear != currentGear) {
+                currentGear = gear;
+                alerts.setGear(gear);
+                shiftLight.setShiftRPM(alerts.getShiftRPM(), alerts.getShiftWarningRPM());
+            }
+        }
+        
+        // Straight to the LEDs - not paced by the display
+        #if SHIFT_LIGHT_ENABLED
+        shiftLight.update(currentRPM);
+        #endif
         
         canHandler.clearNewDataFlag();
     }
@@ -220,10 +416,80 @@ void readSensors() {
 // =============================================================================
 
 void updateDisplay() {
-    display.update(currentRPM, currentSpeedMph, currentWaterTempF, 
+    display.update(currentRPM, currentSpeed, currentWaterTemp, 
                    currentOilPsi, alerts);
 }
 
+void readPageButton(uint32_t now) {
+    bool reading = (digitalRead(PAGE_BUTTON_PIN) == LOW);
+    
+    if (reading != pageButtonReading) {
+        pageButtonReading = reading;
+        pageButtonChanged = now;
+        return;
+    }
+    
+    // A long press toggles short-shift as soon as it is long enough
+    if (pageButtonPressed && !pageButtonLong && now - pageButtonDown >= PAGE_BUTTON_LONG_MS) {
+        pageButtonLong = true;
+        toggleShortShift();
+    }
+    
+    // A short one flips the page on the debounced release edge
+    if (reading != pageButtonPressed && now - pageButtonChanged >= PAGE_BUTTON_DEBOUNCE_MS) {
+        pageButtonPressed = reading;
+        if (pageButtonPressed) {
+            pageButtonDown = now;
+            pageButtonLong = false;
+            power.wake(now);
+        } else if (!pageButtonLong) {
+            display.nextPage();
+        }
+    }
+}
+
+void toggleShortShift() {
+    alerts.setShortShift(!alerts.isShortShift());
+    shiftLight.setShiftRPM(alerts.getShiftRPM(), alerts.getShiftWarningRPM());
+    
+    #if DEBUG_ENABLED
+    Serial.printf("Short-shift points %s\n", alerts.isShortShift() ? "on" : "off");
+    #endif
+}
+
+#if CRASH_RECORDER_ENABLED
+void recordCrashSample(uint32_t now) {
+    CrashSample_t sample;
+    sample.rpm = currentRPM;
+    sample.oilTenths = (uint16_t)constrain(currentOilPsi * 10.0f + 0.5f, 0.0f, 65535.0f);
+    sample.coolant = currentWaterTemp;
+    sample.throttle = canHandler.getData().throttle_raw;
+    sample.alerts = (alerts.isOilCritical() ? CRASH_ALERT_OIL_CRITICAL : 0) |
+                    (alerts.isTempCritical() ? CRASH_ALERT_TEMP_CRITICAL : 0) |
+                    (alerts.isOilWarning() ? CRASH_ALERT_OIL_WARNING : 0) |
+                    (alerts.isTempWarning() ? CRASH_ALERT_TEMP_WARNING : 0);
+    crashRecorder.record(sample, now);
+}
+#endif
+
+void updateDiagnostics() {
+    static uint32_t lastResponseCount = 0;
+    
+    uint32_t responses = canHandler.getResponseCount();
+    NextionHealth_t health = display.getHealth();
+    SensorData_t sensorData = sensors.getData();
+    
+    // Called once per DIAG_UPDATE_MS, so the count difference is a rate
+    display.setDiag(DIAG_OBD_RATE, (responses - lastResponseCount) * 1000 / DIAG_UPDATE_MS);
+    lastResponseCount = responses;
+    
+    display.setDiag(DIAG_CAN_ERRORS, canHandler.getErrorCount());
+    display.setDiag(DIAG_LINK_ERRORS, health.rejected + health.overflows + health.ackTimeouts);
+    display.setDiag(DIAG_OIL_MV, (int32_t)(sensorData.oilPressureRaw * 1000));
+    display.setDiag(DIAG_FLIP_MS, health.lastFlipMs);
+    display.setDiag(DIAG_UPTIME, clockMillis() / 1000);
+}
+
 // =============================================================================
 // DEBUG FUNCTIONS
 // =============================================================================
@@ -235,9 +501,10 @@ void printConfig() {
     Serial.printf("Shift RPM: %d (warning at %d)\n", SHIFT_RPM, SHIFT_WARNING_RPM);
     Serial.printf("Water Temp Warning: %d°F, Critical: %d°F\n", 
                   WATER_TEMP_WARNING, WATER_TEMP_CRITICAL);
-    Serial.printf("Oil Pressure Warning: <%d PSI, Critical: <%d PSI\n",
-                  OIL_PRESSURE_WARNING, OIL_PRESSURE_CRITICAL);
+    Serial.printf("Oil Pressure: RPM x oil temp map, alerts above %d RPM\n", OIL_ALERT_MIN_RPM);
     Serial.printf("Buzzer: %s\n", BUZZER_ENABLED ? "Enabled" : "Disabled");
+    Serial.printf("Shift Light: %s (%d LEDs)\n", 
+                  SHIFT_LIGHT_ENABLED ? "Enabled" : "Disabled", SHIFT_LIGHT_LEDS);
     Serial.println("---------------------");
     Serial.println();
 }
@@ -245,13 +512,68 @@ void printConfig() {
 void printDebugInfo() {
     Serial.println("--- Current Values ---");
     Serial.printf("RPM: %d\n", currentRPM);
-    Serial.printf("Speed: %d MPH\n", currentSpeedMph);
-    Serial.printf("Water Temp: %d°F\n", currentWaterTempF);
-    Serial.printf("Oil Pressure: %.1f PSI\n", currentOilPsi);
+    Serial.printf("Speed: %d %s\n", currentSpeed, SPEED_UNIT_MPH ? "MPH" : "km/h");
+    if (currentGear != GEAR_UNKNOWN) {
+        Serial.printf("Gear: %d (%.1f RPM per km/h, shift at %d, warning at %d%s)\n",
+                      currentGear, gearEstimator.getRatioQ8() / 256.0f, alerts.getShiftRPM(),
+                      alerts.getShiftWarningRPM(), alerts.isShortShift() ? ", short-shift" : "");
+    } else {
+        Serial.printf("Gear: -%s\n", alerts.isShortShift() ? " (short-shift)" : "");
+    }
+    Serial.printf("Water Temp: %d°%c\n", currentWaterTemp, TEMP_UNIT_F ? 'F' : 'C');
+    OBDData_t obd = canHandler.getData();
+    if (obd.oil_raw != 0) {
+        Serial.printf("Oil Temp: %d°%c\n", obdTemp(obd.oil_raw), TEMP_UNIT_F ? 'F' : 'C');
+    }
+    Serial.printf("VTEC: %s\n", obd.vtec ? "on" : "off");
+    Serial.printf("Oil Pressure: %.1f PSI (warning <%.1f, critical <%.1f at %d°C oil)\n",
+                  currentOilPsi, alerts.getOilWarningPsi(), alerts.getOilCriticalPsi(),
+                  currentOilTempC);
     Serial.printf("CAN Queries: %lu, Responses: %lu, Errors: %lu\n",
                   canHandler.getQueryCount(),
                   canHandler.getResponseCount(),
                   canHandler.getErrorCount());
+    uint16_t rateQ8 = canHandler.getLearnedRateQ8();
+    Serial.printf("OBD rate: %d.%02d Hz learned, negative: %lu (busy %lu, last NRC 0x%02X)\n",
+                  rateQ8 >> 8, ((rateQ8 & 0xFF) * 100) >> 8,
+                  canHandler.getNegativeCount(),
+                  canHandler.getBusyCount(),
+                  canHandler.getLastNrc());
+    
+    NextionHealth_t health = display.getHealth();
+    Serial.printf("Display acks: %lu, rejected: %lu (last 0x%02X), overflows: %lu, "
+                  "ack timeouts: %lu, window: %d\n",
+                  health.acked, health.rejected, health.lastReject,
+                  health.overflows, health.ackTimeouts, health.window);
+    Serial.printf("Display heartbeat misses: %lu, resyncs: %lu, last page flip: %d ms\n",
+                  health.heartbeatMisses, health.resyncs, health.lastFlipMs);
+    Serial.printf("Trace dropped: %lu, errors: %lu\n",
+                  health.traceDropped, health.traceErrors);
+    
+    PowerStats_t powerStats = power.getStats(clockMillis());
+    Serial.printf("Power: %s, full %lu s (~%d mA), low %lu s (~%d mA, %lu s asleep), avg ~%d mA\n",
+                  powerStats.mode == POWER_LOW ? "LOW" : "FULL",
+                  powerStats.fullMs / 1000, powerStats.fullMa,
+                  powerStats.lowMs / 1000, powerStats.lowMa, powerStats.sleepMs / 1000,
+                  powerStats.averageMa);
+    Serial.printf("Power wakes: timer %lu, CAN/button %lu, touch %lu, not armed %lu (low entries %lu)\n",
+                  powerStats.wakeTimer, powerStats.wakeGpio, powerStats.wakeTouch,
+                  powerStats.wakeErrors, powerStats.lowEntries);
+    
+    #if CRASH_RECORDER_ENABLED
+    CrashStats_t crashStats = crashRecorder.getStats();
+    Serial.printf("Crash recorder: %s, captures %lu (last #%lu), missed %lu, dropped %lu, failed %lu\n",
+                  !crashStats.available ? "no partition" :
+                  crashStats.state == CRASH_IDLE ? "armed" :
+                  crashStats.state == CRASH_ERASING ? "erasing (engine off)" : "capturing",
+                  crashStats.captures, crashStats.lastSeq, crashStats.missed, crashStats.dropped,
+                  crashStats.failed);
+    #endif
+    
+    #if AGG_ENABLED
+    AggStats_t aggStats = trend.getStats();
+    Serial.printf("Trends: %lu periods sent (last #%lu)\n", aggStats.periods, aggStats.seq);
+    #endif
     
     AlertState_t alertState = alerts.getState();
     if (alertState.shiftActive) Serial.println("*** SHIFT LIGHT ACTIVE ***");
@@ -269,11 +591,12 @@ void printDebugInfo() {
 // UTILITY FUNCTIONS
 // =============================================================================
 
-// Can be called from serial commands for testing
+// Can be called from serial commands for testing (temp in the display unit)
 void simulateValues(uint16_t rpm, uint8_t speed, int16_t temp, float oil) {
     currentRPM = rpm;
-    currentSpeedMph = speed;
-    currentWaterTempF = temp;
+    currentSpeed = speed;
+    currentWaterTemp = temp;
+    currentCoolantRaw = constrain(TEMP_UNIT_F ? TEMP_F_TO_RAW(temp) : temp + 40, 0, 255);
     currentOilPsi = oil;
     
     Serial.printf("Simulated: RPM=%d, Speed=%d, Temp=%d, Oil=%.1f\n",
@@ -0,0 +1,20 @@
+/*
+ * clock.cpp - Time source for the gauge
+ */
+
+#include "clock.h"
+
+// millis()/delay() take and return unsigned long on the ESP32 core
+static uint32_t arduinoMillis() {
+    return millis();
+}
+
+static void arduinoDelay(uint32_t ms) {
+    delay(ms);
+}
+
+ClockSource_t clockSource = { arduinoMillis, arduinoDelay };
+
+void setClockSource(ClockSource_t source) {
+    clockSource = source;
+}
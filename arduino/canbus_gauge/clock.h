@@ -0,0 +1,47 @@
+/*
+ * clock.h - Time source for the gauge
+ * 
+ * Everything time-based reads the clock through here instead of calling
+ * millis()/delay() directly, so the host simulation (sim/) can substitute
+ * a virtual clock and jump straight to the next deadline rather than
+ * waiting for it. On the device the source is millis()/delay().
+ */
+
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <Arduino.h>
+
+// Furthest ahead nextDeadline() looks when nothing is scheduled
+#define CLOCK_IDLE_MS   60000
+
+typedef struct {
+    uint32_t (*millis)();
+    void (*delay)(uint32_t ms);
+} ClockSource_t;
+
+extern ClockSource_t clockSource;
+
+// Replace the time source (simulation only - call before setup())
+void setClockSource(ClockSource_t source);
+
+inline uint32_t clockMillis() {
+    return clockSource.millis();
+}
+
+inline void clockDelay(uint32_t ms) {
+    clockSource.delay(ms);
+}
+
+// Fold a deadline into next (wrap-safe). A deadline already reached means
+// the work is overdue and waiting on something - check again next tick.
+inline void clockSooner(uint32_t& next, uint32_t deadline, uint32_t now) {
+    if ((int32_t)(deadline - now) <= 0) {
+        deadline = now + 1;
+    }
+    if ((int32_t)(deadline - next) < 0) {
+        next = deadline;
+    }
+}
+
+#endif // CLOCK_H
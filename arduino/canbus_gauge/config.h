@@ -32,6 +32,12 @@
 // Buzzer Output
 #define BUZZER_PIN      25      // PWM capable pin for buzzer
 
+// Page Button (momentary switch to GND, e.g. a spare steering-wheel button)
+#define PAGE_BUTTON_PIN     27  // Internal pull-up, active low
+
+// Shift Light Bar (WS2812B / SK6812 data in, via RMT)
+#define SHIFT_LIGHT_PIN     26  // 3.3V data usually works; add a level shifter if not
+
 // =============================================================================
 // CAN BUS CONFIGURATION
 // =============================================================================
@@ -41,19 +47,94 @@
 
 // OBD-II CAN IDs
 #define OBD_REQUEST_ID      0x7DF       // Broadcast request ID
+#define UDS_REQUEST_ID      0x7E0       // ECM physical address (service 22 DIDs)
 #define OBD_RESPONSE_ID_MIN 0x7E8       // ECU response range start
 #define OBD_RESPONSE_ID_MAX 0x7EF       // ECU response range end
+#define OBD_RESPONSE_MASK   0x7F8       // MCP2515 acceptance mask for that range
+
+// Poll the manufacturer DIDs in obd_pids.h (VTEC state, oil temp). The DID
+// numbers there are placeholders - set yours from a scan tool log before
+// turning this on. Off, the oil pressure thresholds use coolant temp.
+#define OBD_DIDS_ENABLED    false
 
 // =============================================================================
 // TIMING CONFIGURATION (milliseconds)
 // =============================================================================
 
-#define DISPLAY_UPDATE_MS   100     // Display refresh rate (10 Hz)
 #define CAN_POLL_MS         50      // CAN polling rate (20 Hz)
-#define SENSOR_READ_MS      50      // Analog sensor read rate (20 Hz)
+#define SENSOR_READ_MS      20      // Analog sensor read rate (50 Hz, feeds strip chart)
 #define ALERT_FLASH_MS      250     // Alert flash interval
 #define CAN_TIMEOUT_MS      100     // Timeout waiting for CAN response
 
+// =============================================================================
+// OBD REQUEST PACING
+// =============================================================================
+
+// The poll rate adapts to what the ECU sustains (AIMD): every served reply
+// adds OBD_RATE_STEP_Q8/256 Hz, a busyRepeatRequest (NRC 0x21) halves it -
+// at most once per OBD_RATE_HOLD_MS, so one overload episode counts once.
+// Polling starts at CAN_POLL_MS.
+#define OBD_RATE_MIN_HZ         5       // Never slower than this
+#define OBD_RATE_MAX_HZ         50      // Never faster than this
+#define OBD_RATE_STEP_Q8        16      // +1 Hz per 16 served replies
+#define OBD_RATE_HOLD_MS        250     // Minimum time between decreases
+
+// A PID or DID the ECU refuses is left alone for a while instead of re-asked at
+// the poll rate. Unsupported (NRC 0x11/0x12/0x31) waits the long retry;
+// anything else backs off exponentially and clears on a positive reply.
+#define OBD_PID_BACKOFF_MIN_MS  500
+#define OBD_PID_BACKOFF_MAX_MS  30000
+#define OBD_PID_UNSUPPORTED_MS  60000
+
+// =============================================================================
+// DISPLAY REFRESH (per gauge)
+// =============================================================================
+
+// Each gauge refreshes on its own schedule. It drops to its MIN interval
+// as soon as it moves faster than its FAST_RATE (units per second) or is
+// in an alert zone ("fast attack"), then relaxes by 25% per refresh
+// toward its MAX interval while steady ("slow decay"). Changes smaller
+// than the DEADBAND are not sent at all.
+#define RPM_REFRESH_MIN_MS          25      // 40 Hz under hard acceleration
+#define RPM_REFRESH_MAX_MS          200
+#define RPM_REFRESH_FAST_RATE       1500    // RPM/s
+#define RPM_REFRESH_DEADBAND        10      // RPM
+
+#define SPEED_REFRESH_MIN_MS        50
+#define SPEED_REFRESH_MAX_MS        500
+#define SPEED_REFRESH_FAST_RATE     5       // MPH/s
+#define SPEED_REFRESH_DEADBAND      1       // MPH
+
+#define TEMP_REFRESH_MIN_MS         100
+#define TEMP_REFRESH_MAX_MS         2000    // Coolant moves over minutes
+#define TEMP_REFRESH_FAST_RATE      2       // °F/s
+#define TEMP_REFRESH_DEADBAND       1       // °F
+
+#define OIL_REFRESH_MIN_MS          40
+#define OIL_REFRESH_MAX_MS          500
+#define OIL_REFRESH_FAST_RATE       200     // 0.1 PSI/s (20 PSI/s)
+#define OIL_REFRESH_DEADBAND        5       // 0.1 PSI (0.5 PSI)
+
+// =============================================================================
+// DISPLAY LINK (Nextion flow control)
+// =============================================================================
+
+// The display is put in bkcmd=3 mode so every command is acknowledged.
+// Gauge updates are paced by the number of unacknowledged commands, so
+// we send as fast as the display accepts and back off on overflow.
+#define NEXTION_WINDOW_INIT         8       // Commands in flight at start
+#define NEXTION_WINDOW_MIN          2       // Floor after repeated overflows
+#define NEXTION_WINDOW_MAX          24      // ~500 bytes, half the input buffer
+#define NEXTION_WINDOW_GROW_ACKS    32      // Successful acks per window step
+#define NEXTION_ACK_TIMEOUT_MS      100     // Give up on outstanding acks
+#define NEXTION_OVERFLOW_BACKOFF_MS 50      // Pause after a 0x24 overflow
+#define NEXTION_BOOT_TIMEOUT_MS     2000    // Max wait for startup after reset
+
+// Heartbeat ("sendme") detects a display that rebooted (brownout while
+// cranking) or went silent; either way its state is resent in full.
+#define NEXTION_HEARTBEAT_MS        1000    // Heartbeat interval
+#define NEXTION_HEARTBEAT_TIMEOUT_MS 300    // Reply deadline
+
 // =============================================================================
 // RPM THRESHOLDS & SHIFT LIGHT
 // =============================================================================
@@ -72,10 +153,59 @@
 #define RPM_ZONE_ORANGE     5500    // Orange zone start  
 #define RPM_ZONE_RED        6300    // Red zone start
 
+// LED shift light bar. LEDs light one by one from RPM_ZONE_YELLOW, the last
+// one just below SHIFT_RPM. They are yellow, orange from RPM_ZONE_ORANGE and
+// red from SHIFT_WARNING_RPM. At SHIFT_RPM the whole bar flashes. With a
+// per-gear shift point (below) the whole band moves with it.
+#define SHIFT_LIGHT_ENABLED     true    // Drive the LED bar on SHIFT_LIGHT_PIN
+#define SHIFT_LIGHT_LEDS        8       // LEDs on the bar (max 10)
+#define SHIFT_LIGHT_BRIGHTNESS  64      // 0-255, full white draws ~60mA/LED
+#define SHIFT_LIGHT_HYSTERESIS  50      // RPM below a threshold before an LED goes out
+#define SHIFT_LIGHT_FLASH_MS    50      // Redline flash half-period (10 Hz)
+#define SHIFT_LIGHT_FRAME_MS    5       // Min time between frames (200 Hz max)
+
+// LED colors (RGB888)
+#define SHIFT_LED_YELLOW        0xFFC000
+#define SHIFT_LED_ORANGE        0xFF4000
+#define SHIFT_LED_RED           0xFF0000
+#define SHIFT_LED_FLASH         0x0040FF    // Blue - stands out from the zone colors
+
+// =============================================================================
+// GEAR ESTIMATION & PER-GEAR SHIFT POINTS
+// =============================================================================
+
+// The current gear is estimated from engine RPM per km/h. Ratios below are
+// the TL Type-S 6MT; check them (and the tire size on the door placard)
+// against your car - a wrong tire size shifts every gear's ratio equally.
+#define GEAR_COUNT              6
+#define GEAR_RATIOS             { 3.266, 2.130, 1.517, 1.147, 0.921, 0.738 }
+#define FINAL_DRIVE_RATIO       4.058
+#define TIRE_WIDTH_MM           245     // 245/40R18
+#define TIRE_ASPECT_PCT         40
+#define TIRE_RIM_IN             18
+
+#define GEAR_TOLERANCE_PCT      8       // Max ratio error to accept a gear
+#define GEAR_MIN_SPEED_KMH      15      // Speed is whole km/h - too coarse below this
+#define GEAR_MIN_RPM            1000    // Below this the clutch is likely in
+#define GEAR_DEBOUNCE_SAMPLES   3       // Consistent samples before a gear change
+#define GEAR_HOLD_MS            1500    // Keep the last gear through a clutch-in
+
+// Shift point per gear (1st..6th). The pre-warning starts
+// (SHIFT_RPM - SHIFT_WARNING_RPM) below it. Unknown gear uses SHIFT_RPM.
+#define GEAR_SHIFT_RPM          { 6600, 6500, 6400, 6300, 6300, 6300 }
+
+// Short-shift points for endurance stints (fuel saving). Holding the page
+// button for PAGE_BUTTON_LONG_MS switches between these and the full ones.
+#define SHORT_SHIFT_ENABLED     false   // Start with short-shift points active
+#define GEAR_SHORT_SHIFT_RPM    { 5000, 4800, 4600, 4500, 4500, 4500 }
+
 // =============================================================================
 // WATER TEMPERATURE THRESHOLDS (Fahrenheit)
 // =============================================================================
 
+// Always °F, whatever TEMP_UNIT_F says. Alerts compare the raw coolant byte
+// against them (TEMP_F_TO_RAW); the display converts them to its unit.
+
 #define WATER_TEMP_MIN      100     // Minimum display temp
 #define WATER_TEMP_MAX      260     // Maximum display temp
 #define WATER_TEMP_NORMAL   195     // Normal operating temp
@@ -89,8 +219,25 @@
 #define OIL_PRESSURE_MIN        0       // Minimum display
 #define OIL_PRESSURE_MAX        100     // Maximum display (for 0-100 PSI sender)
 #define OIL_PRESSURE_NORMAL     55      // Normal operating pressure
-#define OIL_PRESSURE_WARNING    45      // Warning threshold (yellow)
-#define OIL_PRESSURE_CRITICAL   25      // Critical threshold (red alert)
+
+// Warning (yellow) and critical (red alert) thresholds follow RPM and oil
+// temperature: ~20 PSI is healthy at hot idle, 40 PSI at 7000 rpm is not.
+// One row per OIL_MAP_TEMP_C breakpoint, one column per OIL_MAP_RPM
+// breakpoint. Between breakpoints the threshold is interpolated, beyond
+// the ends it is held. Oil temp is DID_OIL_TEMP (OBD_DIDS_ENABLED); until
+// the ECM answers, the coolant temp stands in.
+#define OIL_MAP_RPM             {  800, 2000, 3500, 5000, 6500, 7500 }
+#define OIL_MAP_TEMP_C          { 50, 90, 120, 140 }
+#define OIL_MAP_WARNING_PSI     { { 25,   40,   50,   55,   60,   62 }, \
+                                  { 15,   30,   42,   50,   55,   57 }, \
+                                  { 12,   25,   37,   45,   50,   52 }, \
+                                  { 10,   22,   33,   40,   45,   47 } }
+#define OIL_MAP_CRITICAL_PSI    { { 15,   28,   38,   43,   48,   50 }, \
+                                  {  8,   20,   30,   38,   43,   45 }, \
+                                  {  6,   16,   26,   34,   40,   42 }, \
+                                  {  5,   14,   23,   30,   35,   37 } }
+#define OIL_MAP_DEFAULT_TEMP_C  90      // Before any oil or coolant reading
+#define OIL_ALERT_MIN_RPM       500     // No oil alerts below (engine stopped or cranking)
 
 // Oil pressure sensor calibration (0-5V sender to 0-100 PSI)
 // Typical 0-5V sender: 0.5V = 0 PSI, 4.5V = 100 PSI
@@ -99,8 +246,12 @@
 #define OIL_SENSOR_PSI_MAX      100.0   // Max PSI reading
 
 // ESP32 ADC calibration
+// Analog inputs are scanned continuously under DMA by the AdcScan library
+// (arduino/libraries/AdcScan), which applies the chip's eFuse calibration.
+// These two describe the raw ADC for the host simulation.
 #define ADC_RESOLUTION      4095        // 12-bit ADC
 #define ADC_VREF            3.3         // ESP32 ADC reference voltage
+#define OIL_OVERSAMPLE_LOG2     6       // Average 64 conversions per oil reading (~300/s)
 // Note: For 5V sensor, use a voltage divider (e.g., 10k/10k) to scale to 3.3V
 #define VOLTAGE_DIVIDER_RATIO   2.0     // If using voltage divider (5V -> 2.5V max)
 
@@ -113,6 +264,15 @@
 #define SPEED_UNIT_MPH      true    // true = MPH, false = km/h
 #define KMH_TO_MPH          0.621371
 
+// =============================================================================
+// TEMPERATURE UNITS
+// =============================================================================
+
+// Display unit for coolant / oil temps. Only what is shown and logged
+// changes: the WATER_TEMP_* thresholds stay in °F. TEMP_REFRESH_* rates are
+// in this unit.
+#define TEMP_UNIT_F         true    // true = °F, false = °C
+
 // =============================================================================
 // ALERT CONFIGURATION
 // =============================================================================
@@ -156,6 +316,98 @@
 #define COLOR_OIL_WARNING   0xFFE0
 #define COLOR_OIL_CRITICAL  0xF800
 
+// =============================================================================
+// STRIP CHART (Nextion waveform)
+// =============================================================================
+
+// Oil pressure / RPM trend trace. Samples are buffered on the ESP32 and sent
+// in bulk with "addt" (one command + raw bytes per channel) instead of one
+// "add" command per point, so a 50 Hz trace costs ~2% of the UART.
+#define TRACE_ENABLED           true    // Enable the strip chart
+#define TRACE_SAMPLE_MS         20      // Sample rate (50 Hz)
+#define TRACE_FLUSH_MS          200     // Bulk transfer interval (10 samples/channel)
+#define TRACE_BUFFER_SIZE       64      // Samples buffered per channel
+#define TRACE_HEIGHT            140     // Waveform height in pixels (full-scale value)
+// A panel busy redrawing answers addt late; until it does, everything sent
+// would be taken as waveform data, so the gauge holds off. No 0xFE by the
+// timeout means the addt was lost (panel reset, corrupted frame): resync.
+#define TRACE_READY_TIMEOUT_MS  500     // Max wait for 0xFE after addt
+
+// =============================================================================
+// DISPLAY PAGES
+// =============================================================================
+
+// Data pages (main, diag) are cycled with the page button or by touching
+// the page_btn hotspot on the display. Their components use vscope=global,
+// so values survive a page flip and only what changed while the page was
+// hidden is sent when it comes back.
+#define PAGE_BUTTON_ENABLED     true    // Read the page button on PAGE_BUTTON_PIN
+#define PAGE_BUTTON_DEBOUNCE_MS 30      // Button must be stable this long
+#define PAGE_BUTTON_LONG_MS     1000    // Held this long: toggle short-shift, no page flip
+#define DIAG_UPDATE_MS          1000    // Diagnostics page refresh
+
+// =============================================================================
+// ENGINE-OFF POWER SAVING
+// =============================================================================
+
+// With the engine off (RPM 0 or no OBD replies) for POWER_IDLE_ENTER_MS the
+// gauge drops the CPU clock, polls slowly, dims the display and light-sleeps
+// between deadlines. A CAN frame (MCP2515 INT), the page button or display
+// touch traffic wakes it; the first nonzero RPM restores full rate.
+#define POWER_SAVE_ENABLED      true
+#define POWER_IDLE_ENTER_MS     30000   // Engine off this long -> low power
+#define POWER_FULL_CPU_MHZ      240
+#define POWER_LOW_CPU_MHZ       80      // Lowest that keeps APB at 80 MHz (UART/SPI timing)
+#define POWER_LOW_CAN_POLL_MS   200     // RPM query period; cranking shows within one
+#define POWER_LOW_SENSOR_MS     250     // Oil pressure / strip chart period
+#define POWER_FULL_DIM_PCT      100     // Display backlight
+#define POWER_LOW_DIM_PCT       30
+#define POWER_MIN_SLEEP_MS      2       // Shorter waits aren't worth a light sleep
+
+// Current estimates for the report (module datasheet figures - measure
+// yours with a USB meter or INA219 and adjust)
+#define POWER_FULL_MA           50      // ESP32 at 240 MHz, radio off
+#define POWER_LOW_AWAKE_MA      20      // ESP32 at 80 MHz
+#define POWER_SLEEP_MA          1       // ESP32 light sleep
+#define POWER_DISPLAY_MA        450     // Nextion 7" at 100% backlight, scales with dim
+
+// =============================================================================
+// CRASH RECORDER
+// =============================================================================
+
+// RPM, oil pressure, coolant, throttle and alert state are kept at full
+// rate in a delta-encoded RAM ring. When oil or temp goes critical, the
+// last CRASH_PRE_MS is frozen, recording carries on for CRASH_POST_MS, and
+// both go to the "crashlog" partition (partitions.csv) one flash page per
+// CRASH_WRITE_MS. Decode with arduino/tools/crash_decode.py.
+#define CRASH_RECORDER_ENABLED  true
+#define CRASH_SAMPLE_MS         20      // 50 Hz, same as the strip chart
+#define CRASH_PRE_MS            30000   // Kept from before the trigger
+#define CRASH_POST_MS           30000   // Recorded after it
+#define CRASH_RING_BLOCKS       16      // 512-byte blocks in RAM (~60 s typical)
+#define CRASH_WRITE_MS          10      // One 256-byte page write per interval
+#define CRASH_PARTITION_SUBTYPE 0x40    // Custom data subtype in partitions.csv
+#define CRASH_SLOT_BYTES        16384   // One capture; the partition holds several
+#define CRASH_OIL_MIN_RPM       400     // Oil critical only triggers with the engine running,
+#define CRASH_OIL_START_MS      3000    // pressure built up after starting,
+#define CRASH_OIL_HOLD_MS       200     // and low for this long (not a shutdown)
+
+// =============================================================================
+// TREND AGGREGATION
+// =============================================================================
+
+// Per-period min/mean/max of RPM, oil pressure and coolant, and a histogram
+// of oil pressure per RPM bin, sent on the debug serial as $AGG/$AGH lines
+// when each period closes (trend_aggregator.h). Fed at SENSOR_READ_MS while
+// the engine runs. Summarise a log with arduino/tools/agg_report.py.
+#define AGG_ENABLED             true
+#define AGG_PERIOD_MS           60000   // One block per minute
+#define AGG_RPM_BIN_WIDTH       500
+#define AGG_RPM_BINS            16      // 0-7999 RPM, the last bin open-ended
+#define AGG_OIL_BIN_PSI         5
+#define AGG_OIL_BINS            20      // 0-99 PSI, the last bin open-ended
+#define AGG_EMIT_MS             20      // One line per interval (fits the UART FIFO)
+
 // =============================================================================
 // SMOOTHING / FILTERING
 // =============================================================================
@@ -0,0 +1,432 @@
+/*
+ * crash_recorder.cpp - Pre/post trigger telemetry capture implementation
+ */
+
+#include "crash_recorder.h"
+
+static_assert(sizeof(CrashSample_t) == 8, "CrashSample_t layout is read by crash_decode.py");
+static_assert(sizeof(CrashBlock_t) == CRASH_BLOCK_BYTES, "CrashBlock_t must fill a block");
+static_assert(sizeof(CrashHeader_t) == 32, "CrashHeader_t layout is read by crash_decode.py");
+static_assert(CRASH_SLOT_BYTES % SPI_FLASH_SEC_SIZE == 0, "Slots are erased by sector");
+
+static uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static uint8_t putVarint(uint8_t* p, uint32_t v) {
+    uint8_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (v & 0x7F) | 0x80;
+        v >>= 7;
+    }
+    p[n++] = v;
+    return n;
+}
+
+CrashRecorder::CrashRecorder() {
+    _partition = NULL;
+    _slots = 0;
+    _slot = 0;
+    memset(_slotState, CRASH_SLOT_DIRTY, sizeof(_slotState));
+    _eraseSector = 0;
+    
+    _head = 0;
+    _filled = 0;
+    memset(&_last, 0, sizeof(_last));
+    _lastTime = 0;
+    _armed = 0;
+    _stoppedAt = 0;
+    _oilOkAt = 0;
+    _sealed = false;
+    
+    memset(&_header, 0, sizeof(_header));
+    _captureStart = 0;
+    _captureBlocks = 0;
+    _writtenBlocks = 0;
+    _writeOffset = 0;
+    _postEnd = 0;
+    _nextWrite = 0;
+    _engineOff = false;
+    
+    _state = CRASH_IDLE;
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+bool CrashRecorder::begin() {
+    _partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                          (esp_partition_subtype_t)CRASH_PARTITION_SUBTYPE,
+                                          "crashlog");
+    if (_partition == NULL || _partition->size < CRASH_SLOT_BYTES) {
+        #if DEBUG_ENABLED
+        Serial.println("Crash recorder: no crashlog partition");
+        #endif
+        return false;
+    }
+    _slots = min(_partition->size / CRASH_SLOT_BYTES, (uint32_t)CRASH_MAX_SLOTS);
+    
+    // Carry on after the newest capture, overwriting the oldest
+    bool found = false;
+    for (uint8_t slot = 0; slot < _slots; slot++) {
+        CrashHeader_t header;
+        if (esp_partition_read(_partition, slotOffset(slot), &header, sizeof(header)) != ESP_OK ||
+            header.magic != CRASH_MAGIC) {
+            continue;
+        }
+        _slotState[slot] = CRASH_SLOT_CAPTURE;
+        if (!found || (int32_t)(header.seq - _stats.lastSeq) > 0) {
+            _stats.lastSeq = header.seq;
+            _slot = (slot + 1) % _slots;
+            found = true;
+        }
+    }
+    
+    // Free every slot without a capture now, while a stall doesn't matter -
+    // a capture that lost power before its header leaves its slot dirty
+    uint8_t freeSlots = 0;
+    for (uint8_t slot = 0; slot < _slots; slot++) {
+        if (_slotState[slot] == CRASH_SLOT_CAPTURE) {
+            continue;
+        }
+        if (slotBlank(slot) ||
+            esp_partition_erase_range(_partition, slotOffset(slot), CRASH_SLOT_BYTES) == ESP_OK) {
+            _slotState[slot] = CRASH_SLOT_ERASED;
+            freeSlots++;
+        }
+    }
+    
+    // With every slot full, the oldest capture makes room
+    if (freeSlots == 0 &&
+        esp_partition_erase_range(_partition, slotOffset(_slot), CRASH_SLOT_BYTES) == ESP_OK) {
+        _slotState[_slot] = CRASH_SLOT_ERASED;
+        freeSlots++;
+    }
+    nextSlot();
+    _stats.available = (freeSlots > 0);
+    
+    #if DEBUG_ENABLED
+    Serial.printf("Crash recorder: %d slots, %d free, next %d, last capture #%lu\n",
+                  _slots, freeSlots, _slot, _stats.lastSeq);
+    #endif
+    
+    return _stats.available;
+}
+
+void CrashRecorder::record(const CrashSample_t& sample, uint32_t now) {
+    uint8_t armed = sample.alerts & CRASH_ALERT_TRIGGERS;
+    if (sample.rpm < CRASH_OIL_MIN_RPM) {
+        _stoppedAt = now;
+    }
+    if (!(sample.alerts & CRASH_ALERT_OIL_CRITICAL)) {
+        _oilOkAt = now;
+    }
+    if (now - _stoppedAt < CRASH_OIL_START_MS || now - _oilOkAt < CRASH_OIL_HOLD_MS) {
+        armed &= ~CRASH_ALERT_OIL_CRITICAL;
+    }
+    uint8_t rising = armed & ~_armed;
+    _armed = armed;
+    
+    if (_filled == 0 || _sealed) {
+        startBlock(sample, now);
+    } else {
+        append(sample, now);
+    }
+    
+    if (rising) {
+        trigger(rising, now);
+    }
+    
+    if (_state == CRASH_CAPTURING && (int32_t)(now - _postEnd) >= 0) {
+        finishCapture();
+    }
+}
+
+void CrashRecorder::append(const CrashSample_t& sample, uint32_t now) {
+    CrashBlock_t* block = &_ring[_head];
+    if (block->used + CRASH_REC_MAX_BYTES > (int)sizeof(block->data)) {
+        startBlock(sample, now);
+        return;
+    }
+    
+    uint8_t* rec = &block->data[block->used];
+    uint8_t n = 1;
+    uint8_t flags = 0;
+    uint32_t dt = now - _lastTime;
+    
+    if (dt != CRASH_SAMPLE_MS) {
+        flags |= CRASH_REC_DT;
+        n += putVarint(&rec[n], dt);
+    }
+    if (sample.rpm != _last.rpm) {
+        flags |= CRASH_REC_RPM;
+        n += putVarint(&rec[n], zigzag((int32_t)sample.rpm - _last.rpm));
+    }
+    if (sample.oilTenths != _last.oilTenths) {
+        flags |= CRASH_REC_OIL;
+        n += putVarint(&rec[n], zigzag((int32_t)sample.oilTenths - _last.oilTenths));
+    }
+    if (sample.coolant != _last.coolant) {
+        flags |= CRASH_REC_COOLANT;
+        n += putVarint(&rec[n], zigzag((int32_t)sample.coolant - _last.coolant));
+    }
+    if (sample.throttle != _last.throttle) {
+        flags |= CRASH_REC_THROTTLE;
+        n += putVarint(&rec[n], zigzag((int32_t)sample.throttle - _last.throttle));
+    }
+    if (sample.alerts != _last.alerts) {
+        flags |= CRASH_REC_ALERTS;
+        rec[n++] = sample.alerts;
+    }
+    rec[0] = flags;
+    
+    block->used += n;
+    block->samples++;
+    _last = sample;
+    _lastTime = now;
+}
+
+void CrashRecorder::startBlock(const CrashSample_t& sample, uint32_t now) {
+    uint8_t next = (_filled == 0) ? 0 : (_head + 1) % CRASH_RING_BLOCKS;
+    
+    if (_state == CRASH_CAPTURING || _state == CRASH_FLUSHING) {
+        // Never reuse a captured block that isn't in flash yet
+        uint8_t unwritten = (_captureStart + _writtenBlocks) % CRASH_RING_BLOCKS;
+        if (_writtenBlocks < _captureBlocks && next == unwritten && _filled > 0) {
+            _stats.dropped++;
+            return;
+        }
+        if (_state == CRASH_CAPTURING) {
+            if (_captureBlocks == CRASH_SLOT_BLOCKS) {
+                _header.flags |= CRASH_FLAG_TRUNCATED;
+                finishCapture();
+            } else {
+                _captureBlocks++;
+            }
+        }
+    }
+    
+    CrashBlock_t* block = &_ring[next];
+    block->t0 = now;
+    block->used = 0;
+    block->samples = 1;
+    block->key = sample;
+    
+    _head = next;
+    if (_filled < CRASH_RING_BLOCKS) {
+        _filled++;
+    }
+    _sealed = false;
+    _last = sample;
+    _lastTime = now;
+}
+
+void CrashRecorder::trigger(uint8_t alerts, uint32_t now) {
+    if (_state != CRASH_IDLE || _slotState[_slot] != CRASH_SLOT_ERASED) {
+        _stats.missed++;
+        return;
+    }
+    
+    // Back from the head to the block that covers now - CRASH_PRE_MS
+    uint8_t start = _head;
+    uint8_t count = 1;
+    while (count < _filled && count < CRASH_SLOT_BLOCKS &&
+           (int32_t)(now - _ring[start].t0) < CRASH_PRE_MS) {
+        start = (start + CRASH_RING_BLOCKS - 1) % CRASH_RING_BLOCKS;
+        count++;
+    }
+    
+    _captureStart = start;
+    _captureBlocks = count;
+    _writtenBlocks = 0;
+    _writeOffset = 0;
+    _postEnd = now + CRASH_POST_MS;
+    _nextWrite = now;
+    _slotState[_slot] = CRASH_SLOT_DIRTY;
+    
+    memset(&_header, 0, sizeof(_header));
+    _header.magic = CRASH_MAGIC;
+    _header.version = CRASH_VERSION;
+    _header.seq = _stats.lastSeq + 1;
+    _header.triggerMs = now;
+    _header.trigger = alerts;
+    _header.flags = TEMP_UNIT_F ? CRASH_FLAG_TEMP_F : 0;
+    _header.sampleMs = CRASH_SAMPLE_MS;
+    _header.blockBytes = CRASH_BLOCK_BYTES;
+    _header.preMs = CRASH_PRE_MS;
+    _header.postMs = CRASH_POST_MS;
+    
+    _state = CRASH_CAPTURING;
+    
+    #if DEBUG_ENABLED
+    Serial.printf("Crash recorder: capture #%lu (alerts 0x%02X), %d blocks before\n",
+                  _header.seq, alerts, count);
+    #endif
+}
+
+void CrashRecorder::finishCapture() {
+    // The head block is part of the capture - later samples start a new one
+    _sealed = true;
+    _state = CRASH_FLUSHING;
+}
+
+bool CrashRecorder::writePage() {
+    uint32_t base = slotOffset(_slot);
+    
+    if (_writtenBlocks < _captureBlocks) {
+        uint8_t index = (_captureStart + _writtenBlocks) % CRASH_RING_BLOCKS;
+        if (_state == CRASH_CAPTURING && index == _head) {
+            return false; // Still filling
+        }
+        
+        uint32_t offset = base + CRASH_HEADER_BYTES +
+                          (uint32_t)_writtenBlocks * CRASH_BLOCK_BYTES + _writeOffset;
+        if (esp_partition_write(_partition, offset, (const uint8_t*)&_ring[index] + _writeOffset,
+                                CRASH_PAGE_BYTES) != ESP_OK) {
+            abandonCapture();
+            return true;
+        }
+        _writeOffset += CRASH_PAGE_BYTES;
+        if (_writeOffset >= CRASH_BLOCK_BYTES) {
+            _writeOffset = 0;
+            _writtenBlocks++;
+        }
+        return true;
+    }
+    
+    if (_state != CRASH_FLUSHING) {
+        return false;
+    }
+    
+    // Everything is in flash: the header makes the capture valid
+    _header.blockCount = _captureBlocks;
+    if (esp_partition_write(_partition, base, &_header, sizeof(_header)) != ESP_OK) {
+        abandonCapture();
+        return true;
+    }
+    _slotState[_slot] = CRASH_SLOT_CAPTURE;
+    _stats.captures++;
+    _stats.lastSeq = _header.seq;
+    
+    #if DEBUG_ENABLED
+    Serial.printf("Crash recorder: capture #%lu saved to slot %d (%d blocks%s)\n",
+                  _header.seq, _slot, _captureBlocks,
+                  (_header.flags & CRASH_FLAG_TRUNCATED) ? ", truncated" : "");
+    #endif
+    
+    _slot = (_slot + 1) % _slots;
+    nextSlot();
+    return true;
+}
+
+void CrashRecorder::abandonCapture() {
+    // No header, so the slot never decodes as a capture. It stays dirty
+    // until its turn to be erased comes round again.
+    _stats.failed++;
+    _sealed = true;
+    
+    #if DEBUG_ENABLED
+    Serial.printf("Crash recorder: flash write failed, capture #%lu dropped\n", _header.seq);
+    #endif
+    
+    _slot = (_slot + 1) % _slots;
+    nextSlot();
+}
+
+void CrashRecorder::nextSlot() {
+    // The next erased slot in ring order; none left means the one at _slot
+    // (the oldest capture) has to be erased first
+    for (uint8_t i = 0; i < _slots; i++) {
+        uint8_t slot = (_slot + i) % _slots;
+        if (_slotState[slot] == CRASH_SLOT_ERASED) {
+            _slot = slot;
+            _state = CRASH_IDLE;
+            return;
+        }
+    }
+    _eraseSector = 0;
+    _state = CRASH_ERASING;
+}
+
+void CrashRecorder::service(uint32_t now, bool engineOff) {
+    _engineOff = engineOff;
+    if (_partition == NULL || (int32_t)(now - _nextWrite) < 0) {
+        return;
+    }
+    
+    switch (_state) {
+        case CRASH_CAPTURING:
+        case CRASH_FLUSHING:
+            if (writePage()) {
+                _nextWrite = now + CRASH_WRITE_MS;
+            }
+            break;
+        
+        case CRASH_ERASING:
+            // A sector erase blocks for tens of ms - only with the engine off
+            // (a failed erase is tried again next time)
+            if (engineOff) {
+                if (esp_partition_erase_range(_partition,
+                                              slotOffset(_slot) + (uint32_t)_eraseSector * SPI_FLASH_SEC_SIZE,
+                                              SPI_FLASH_SEC_SIZE) == ESP_OK &&
+                    ++_eraseSector == CRASH_SLOT_BYTES / SPI_FLASH_SEC_SIZE) {
+                    _slotState[_slot] = CRASH_SLOT_ERASED;
+                    _state = CRASH_IDLE;
+                }
+                _nextWrite = now + CRASH_WRITE_MS;
+            }
+            break;
+        
+        default:
+            break;
+    }
+}
+
+uint32_t CrashRecorder::nextDeadline(uint32_t now) {
+    switch (_state) {
+        case CRASH_CAPTURING:
+            // Sealed blocks waiting; the head block waits for record()
+            if (_writtenBlocks < _captureBlocks &&
+                (_captureStart + _writtenBlocks) % CRASH_RING_BLOCKS != _head) {
+                return _nextWrite;
+            }
+            break;
+        
+        case CRASH_FLUSHING:
+            return _nextWrite;
+        
+        case CRASH_ERASING:
+            if (_engineOff) {
+                return _nextWrite;
+            }
+            break;
+        
+        default:
+            break;
+    }
+    return now + CLOCK_IDLE_MS;
+}
+
+CrashStats_t CrashRecorder::getStats() {
+    CrashStats_t stats = _stats;
+    stats.state = _state;
+    return stats;
+}
+
+bool CrashRecorder::slotBlank(uint8_t slot) {
+    // Reading is cheap next to an erase
+    uint32_t page[CRASH_PAGE_BYTES / 4];
+    for (uint32_t offset = 0; offset < CRASH_SLOT_BYTES; offset += CRASH_PAGE_BYTES) {
+        if (esp_partition_read(_partition, slotOffset(slot) + offset, page, sizeof(page)) != ESP_OK) {
+            return false;
+        }
+        for (uint8_t i = 0; i < CRASH_PAGE_BYTES / 4; i++) {
+            if (page[i] != 0xFFFFFFFF) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+uint32_t CrashRecorder::slotOffset(uint8_t slot) {
+    return (uint32_t)slot * CRASH_SLOT_BYTES;
+}
@@ -0,0 +1,178 @@
+/*
+ * crash_recorder.h - Pre/post trigger telemetry capture on critical alerts
+ *
+ * Every CRASH_SAMPLE_MS the gauge hands over RPM, oil pressure, coolant,
+ * throttle and the alert bits. Samples go into a RAM ring of fixed-size
+ * blocks: each block starts with one full (key) sample, then one record
+ * per sample - a byte saying which channels changed, then the changes as
+ * zigzag varints. A steady channel costs nothing, so a block holds several
+ * seconds and CRASH_RING_BLOCKS cover well over CRASH_PRE_MS.
+ *
+ * When oil or temp goes critical, the blocks back to CRASH_PRE_MS before
+ * the trigger are frozen and recording carries on for CRASH_POST_MS. The
+ * capture is written to the next slot of the "crashlog" partition, one
+ * 256-byte page per CRASH_WRITE_MS, so the loop never waits on a sector
+ * erase. begin() erases every slot that holds no capture, so a stint can
+ * fill them all. Once the next slot holds an older capture it is erased a
+ * sector at a time, only while the engine is off. The slot header goes
+ * last and only after every page was written, so a capture cut short by a
+ * power loss or a write error never decodes as complete.
+ *
+ * Slot layout (little endian, decoded by arduino/tools/crash_decode.py):
+ *   0     CrashHeader_t
+ *   256   CrashBlock_t x blockCount
+ */
+
+#ifndef CRASH_RECORDER_H
+#define CRASH_RECORDER_H
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include "config.h"
+#include "clock.h"
+
+#define CRASH_MAGIC             0x48535243  // "CRSH"
+#define CRASH_VERSION           1
+#define CRASH_HEADER_BYTES      256
+#define CRASH_BLOCK_BYTES       512
+#define CRASH_PAGE_BYTES        256
+#define CRASH_SLOT_BLOCKS       ((CRASH_SLOT_BYTES - CRASH_HEADER_BYTES) / CRASH_BLOCK_BYTES)
+#define CRASH_MAX_SLOTS         16          // Slots used in a larger partition
+
+// Alert bits in CrashSample_t::alerts
+#define CRASH_ALERT_OIL_CRITICAL    0x01
+#define CRASH_ALERT_TEMP_CRITICAL   0x02
+#define CRASH_ALERT_OIL_WARNING     0x04
+#define CRASH_ALERT_TEMP_WARNING    0x08
+#define CRASH_ALERT_TRIGGERS        (CRASH_ALERT_OIL_CRITICAL | CRASH_ALERT_TEMP_CRITICAL)
+
+// Record flag bits (first byte of each record); channel deltas follow in
+// this order
+#define CRASH_REC_DT            0x01        // Sample spacing != CRASH_SAMPLE_MS
+#define CRASH_REC_RPM           0x02
+#define CRASH_REC_OIL           0x04
+#define CRASH_REC_COOLANT       0x08
+#define CRASH_REC_THROTTLE      0x10
+#define CRASH_REC_ALERTS        0x20        // New alert byte (not a delta)
+#define CRASH_REC_MAX_BYTES     18          // Flags + worst-case varints
+
+// Header flags
+#define CRASH_FLAG_TRUNCATED    0x01        // Post window cut short (slot full)
+#define CRASH_FLAG_TEMP_F       0x02        // Coolant in °F (else °C)
+
+typedef struct {
+    uint16_t rpm;
+    uint16_t oilTenths;         // Oil pressure, 0.1 PSI
+    int16_t coolant;            // Display unit (TEMP_UNIT_F)
+    uint8_t throttle;           // 255 = 100%
+    uint8_t alerts;             // CRASH_ALERT_*
+} CrashSample_t;
+
+typedef struct {
+    uint32_t t0;                // clockMillis() of the key sample
+    uint16_t used;              // Bytes of data[] in use
+    uint16_t samples;           // Including the key sample
+    CrashSample_t key;
+    uint8_t data[CRASH_BLOCK_BYTES - 16];
+} CrashBlock_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t blockCount;
+    uint32_t seq;               // Increments per capture, across slots
+    uint32_t triggerMs;         // clockMillis() at the trigger
+    uint8_t trigger;            // Alert bits that fired
+    uint8_t flags;              // CRASH_FLAG_*
+    uint16_t sampleMs;
+    uint16_t blockBytes;
+    uint16_t reserved;
+    uint32_t preMs;
+    uint32_t postMs;
+} CrashHeader_t;
+
+typedef enum {
+    CRASH_IDLE = 0,             // Recording into the ring
+    CRASH_CAPTURING,            // Post-trigger window, writing frozen blocks
+    CRASH_FLUSHING,             // Window over, writing the rest + header
+    CRASH_ERASING               // Preparing the next slot (engine off only)
+} CrashState_t;
+
+typedef enum {
+    CRASH_SLOT_ERASED = 0,      // Ready for a capture
+    CRASH_SLOT_CAPTURE,         // Holds a complete capture
+    CRASH_SLOT_DIRTY            // Partly written - needs an erase
+} CrashSlot_t;
+
+typedef struct {
+    CrashState_t state;
+    uint32_t captures;          // Written to flash since boot
+    uint32_t missed;            // Triggers while busy or without a free slot
+    uint32_t dropped;           // Samples lost to a full ring
+    uint32_t failed;            // Captures abandoned on a flash write error
+    uint32_t lastSeq;
+    bool available;             // Partition found
+} CrashStats_t;
+
+class CrashRecorder {
+public:
+    CrashRecorder();
+    
+    // Find the partition and erase every slot without a capture, or the
+    // oldest capture if none is free (blocking - call in setup())
+    bool begin();
+    
+    // One sample; a new critical alert bit starts a capture (oil only with
+    // the engine running, so starting or stopping doesn't use up a slot)
+    void record(const CrashSample_t& sample, uint32_t now);
+    
+    // Flash work: a page write, or (when engineOff) a sector erase
+    void service(uint32_t now, bool engineOff);
+    
+    // When service() next has work
+    uint32_t nextDeadline(uint32_t now);
+    
+    CrashStats_t getStats();
+
+private:
+    const esp_partition_t* _partition;
+    uint8_t _slots;
+    uint8_t _slot;              // Slot the next capture goes to
+    uint8_t _slotState[CRASH_MAX_SLOTS];    // CrashSlot_t
+    uint8_t _eraseSector;
+    
+    CrashBlock_t _ring[CRASH_RING_BLOCKS];
+    uint8_t _head;              // Block being filled
+    uint8_t _filled;            // Blocks in use (up to CRASH_RING_BLOCKS)
+    CrashSample_t _last;
+    uint32_t _lastTime;
+    uint8_t _armed;             // Trigger bits in the previous sample
+    uint32_t _stoppedAt;        // Last sample below CRASH_OIL_MIN_RPM
+    uint32_t _oilOkAt;          // Last sample without oil critical
+    bool _sealed;               // Head block is in a finished capture
+    
+    // Capture in progress
+    CrashHeader_t _header;
+    uint8_t _captureStart;      // Ring index of the first captured block
+    uint8_t _captureBlocks;     // Blocks in the capture so far
+    uint8_t _writtenBlocks;     // ... of which fully in flash
+    uint16_t _writeOffset;      // Within the block being written
+    uint32_t _postEnd;
+    uint32_t _nextWrite;
+    bool _engineOff;            // As of the last service()
+    
+    CrashState_t _state;
+    CrashStats_t _stats;
+    
+    void startBlock(const CrashSample_t& sample, uint32_t now);
+    void append(const CrashSample_t& sample, uint32_t now);
+    void trigger(uint8_t alerts, uint32_t now);
+    void finishCapture();
+    bool writePage();
+    void abandonCapture();
+    void nextSlot();
+    bool slotBlank(uint8_t slot);
+    uint32_t slotOffset(uint8_t slot);
+};
+
+#endif // CRASH_RECORDER_H
@@ -4,46 +4,116 @@
 
 #include "display_handler.h"
 
+// Refresh policy per gauge, indexed by Gauge_t
+static const RefreshPolicy_t REFRESH_POLICY[GAUGE_COUNT] = {
+    { RPM_REFRESH_MIN_MS,   RPM_REFRESH_MAX_MS,   RPM_REFRESH_FAST_RATE,   RPM_REFRESH_DEADBAND },
+    { SPEED_REFRESH_MIN_MS, SPEED_REFRESH_MAX_MS, SPEED_REFRESH_FAST_RATE, SPEED_REFRESH_DEADBAND },
+    { TEMP_REFRESH_MIN_MS,  TEMP_REFRESH_MAX_MS,  TEMP_REFRESH_FAST_RATE,  TEMP_REFRESH_DEADBAND },
+    { OIL_REFRESH_MIN_MS,   OIL_REFRESH_MAX_MS,   OIL_REFRESH_FAST_RATE,   OIL_REFRESH_DEADBAND },
+};
+
+// Shadow value meaning "display state unknown - send regardless"
+static const int32_t GAUGE_VALUE_UNKNOWN = INT32_MIN;
+
+// Data pages, indexed by DataPage_t
+static const struct {
+    const char* name;
+    uint8_t id;
+    uint8_t buttonId;       // page_btn hotspot component id
+} DATA_PAGES[DATA_PAGE_COUNT] = {
+    { NextionID::PAGE_MAIN, NextionID::PAGE_MAIN_ID, NextionID::PAGE_BUTTON_MAIN_ID },
+    { NextionID::PAGE_DIAG, NextionID::PAGE_DIAG_ID, NextionID::PAGE_BUTTON_DIAG_ID },
+};
+
+// Diagnostics page components, indexed by DiagField_t
+static const char* const DIAG_COMPONENTS[DIAG_FIELD_COUNT] = {
+    NextionID::DIAG_OBD_RATE,
+    NextionID::DIAG_CAN_ERRORS,
+    NextionID::DIAG_LINK_ERRORS,
+    NextionID::DIAG_OIL_MV,
+    NextionID::DIAG_FLIP_MS,
+    NextionID::DIAG_UPTIME,
+};
+
 DisplayHandler::DisplayHandler(HardwareSerial& serial) : _serial(serial) {
-    _lastUpdate = 0;
-    _shiftVisible = false;
-    _alertVisible = false;
+    // Invalid values to force initial update
+    invalidateShadow();
+    memset(_diagValues, 0, sizeof(_diagValues));
+    
+    _page = DATA_PAGE_NONE;
+    _requestedPage = DATA_PAGE_NONE;
+    _flipPending = false;
+    _flipStart = 0;
+    
+    memset(_traceBuf, 0, sizeof(_traceBuf));
+    _traceTail = 0;
+    _traceCount = 0;
+    _traceBatch = 0;
+    _traceChannel = 0;
+    _traceState = TRACE_IDLE;
+    _traceRequestTime = 0;
+    _lastTraceFlush = 0;
+    
+    _rxLen = 0;
+    _rxTerm = 0;
+    _rxDrop = false;
     
-    _lastRPM = 0xFFFF;  // Invalid value to force initial update
-    _lastSpeed = 0xFF;
-    _lastTemp = -999;
-    _lastOil = -1;
-    _lastRPMColor = 0;
-    _lastTempColor = 0;
-    _lastOilColor = 0;
+    _ackMode = false;
+    _panelReady = false;
+    _inFlight = 0;
+    _window = NEXTION_WINDOW_INIT;
+    _acksSinceGrow = 0;
+    _lastAckTime = 0;
+    _backoffUntil = 0;
+    _deferred = false;
+    memset(&_health, 0, sizeof(NextionHealth_t));
+    
+    _touchHead = 0;
+    _touchCount = 0;
+    
+    _pageName = NULL;
+    _expectedPage = NextionID::PAGE_UNKNOWN_ID;
+    _canConnected = false;
+    _brightness = POWER_FULL_DIM_PCT;
+    _heartbeatPending = false;
+    _lastHeartbeat = 0;
+    _panelLost = false;
+    _resyncPending = false;
 }
 
 void DisplayHandler::begin() {
     _serial.begin(NEXTION_BAUD, SERIAL_8N1, NEXTION_RX_PIN, NEXTION_TX_PIN);
     
-    // Wait for display to initialize
-    delay(500);
+    // Send an empty command to terminate any garbage from power-up
+    endCommand();
     
-    // Send empty commands to clear any garbage
-    for (int i = 0; i < 3; i++) {
-        endCommand();
-        delay(50);
+    // Reset display and wait for its startup event instead of a fixed delay
+    _ackMode = false;
+    _panelReady = false;
+    sendCommand("rest");
+    
+    uint32_t start = clockMillis();
+    while (!_panelReady && clockMillis() - start < NEXTION_BOOT_TIMEOUT_MS) {
+        readResponses();
+        clockDelay(1);
     }
     
-    // Reset display
-    sendCommand("rest");
-    delay(1000);
+    #if DEBUG_ENABLED
+    if (!_panelReady) {
+        Serial.println("Display: no startup event, continuing anyway");
+    }
+    #endif
     
     // Set baud rate (in case display default differs)
     sendCommand("baud=%d", NEXTION_BAUD);
-    delay(100);
     
-    // Go to main page
-    goToPage(NextionID::PAGE_MAIN);
+    // Acknowledge every command from here on - this drives flow control
+    sendCommand("bkcmd=3");
+    _ackMode = true;
+    _inFlight = 0;
     
-    // Initialize default states
-    hideAlert();
-    showShiftLight(false);
+    // Go to main page - overlays start hidden, gauges follow on update()
+    goToPage(NextionID::PAGE_MAIN);
     setCANStatus(false);
     
     #if DEBUG_ENABLED
@@ -51,41 +121,127 @@ void DisplayHandler::begin() {
     #endif
 }
 
-void DisplayHandler::update(uint16_t rpm, uint8_t speedMph, int16_t waterTempF, 
+void DisplayHandler::update(uint16_t rpm, uint8_t speedMph, int16_t waterTemp, 
                             float oilPressurePsi, AlertHandler& alerts) {
-    // Throttle updates to prevent overwhelming the display
-    if (millis() - _lastUpdate < DISPLAY_UPDATE_MS) {
+    uint32_t now = clockMillis();
+    
+    // Commands sent between addt and its raw data would be taken as
+    // waveform samples - hold off until the transfer completes
+    if (_traceState != TRACE_IDLE) {
+        _deferred = true;
+        return;
+    }
+    
+    // Display reported an input buffer overflow - let it drain
+    if ((int32_t)(now - _backoffUntil) < 0) {
+        _deferred = false;
         return;
     }
-    _lastUpdate = millis();
+    
+    // Page flip requested (button or touch) - the page loads from the
+    // HMI, then only what changed while it was hidden is sent
+    if (_requestedPage != _page && _requestedPage != DATA_PAGE_NONE && canSend(1)) {
+        goToPage(DATA_PAGES[_requestedPage].name);
+    }
+    
+    // dim= applies to every page
+    bool dimmed = true;
+    if (_brightness != _shownBrightness) {
+        if (canSend(1)) {
+            sendCommand("dim=%d", _brightness);
+            _shownBrightness = _brightness;
+        } else {
+            dimmed = false;
+        }
+    }
+    
+    bool complete;
+    switch (_page) {
+        case DATA_PAGE_MAIN:
+            complete = updateMainPage(rpm, speedMph, waterTemp, oilPressurePsi, alerts, now);
+            break;
+        case DATA_PAGE_DIAG:
+            complete = updateDiagPage();
+            break;
+        default:
+            return;
+    }
+    
+    complete = complete && dimmed;
+    
+    // Flip is done once every delta has been sent and acknowledged
+    if (_flipPending && complete && _inFlight == 0) {
+        _flipPending = false;
+        _health.lastFlipMs = min(now - _flipStart, (uint32_t)0xFFFF);
+    }
+    
+    _deferred = !complete || _flipPending;
+}
+
+bool DisplayHandler::updateMainPage(uint16_t rpm, uint8_t speedMph, int16_t waterTemp,
+                                    float oilPressurePsi, AlertHandler& alerts, uint32_t now) {
+    bool complete = true;
+    
+    uint16_t canColor = _canConnected ? COLOR_GREEN : COLOR_RED;
+    if (canColor != _main.canColor) {
+        if (canSend(1)) {
+            setColor(NextionID::CAN_STATUS, canColor);
+            _main.canColor = canColor;
+        } else {
+            complete = false;
+        }
+    }
     
     // Get colors from alert handler
     uint16_t rpmColor = alerts.getRPMColor(rpm);
-    uint16_t tempColor = alerts.getTempColor(waterTempF);
+    uint16_t tempColor = alerts.getTempColor(waterTemp);
     uint16_t oilColor = alerts.getOilColor(oilPressurePsi);
+    int32_t oilTenths = (int32_t)(oilPressurePsi * 10);
     
-    // Update values only if changed
-    if (rpm != _lastRPM || rpmColor != _lastRPMColor) {
-        setRPM(rpm, rpmColor);
-        _lastRPM = rpm;
-        _lastRPMColor = rpmColor;
+    // Each gauge is sent when its own refresh policy says so, and only if
+    // the display has room. Anything skipped stays due and goes next call.
+    if (gaugeDue(GAUGE_RPM, rpm, rpmColor,
+                 alerts.isShiftActive() || alerts.isShiftWarning(), now)) {
+        if (canSend(3)) {
+            setRPM(rpm, rpmColor);
+            gaugeSent(GAUGE_RPM, rpm, rpmColor, now);
+        } else {
+            complete = false;
+        }
     }
     
-    if (speedMph != _lastSpeed) {
-        setSpeed(speedMph);
-        _lastSpeed = speedMph;
+    if (gaugeDue(GAUGE_SPEED, speedMph, 0, false, now)) {
+        if (canSend(1)) {
+            setSpeed(speedMph);
+            gaugeSent(GAUGE_SPEED, speedMph, 0, now);
+        } else {
+            complete = false;
+        }
     }
     
-    if (waterTempF != _lastTemp || tempColor != _lastTempColor) {
-        setWaterTemp(waterTempF, tempColor);
-        _lastTemp = waterTempF;
-        _lastTempColor = tempColor;
+    if (gaugeDue(GAUGE_TEMP, waterTemp, tempColor,
+                 alerts.isTempWarning() || alerts.isTempCritical(), now)) {
+        if (canSend(3)) {
+            setWaterTemp(waterTemp, tempColor);
+            gaugeSent(GAUGE_TEMP, waterTemp, tempColor, now);
+        } else {
+            complete = false;
+        }
     }
     
-    if (abs(oilPressurePsi - _lastOil) > 0.5 || oilColor != _lastOilColor) {
-        setOilPressure(oilPressurePsi, oilColor);
-        _lastOil = oilPressurePsi;
-        _lastOilColor = oilColor;
+    if (gaugeDue(GAUGE_OIL, oilTenths, oilColor,
+                 alerts.isOilWarning() || alerts.isOilCritical(), now)) {
+        if (canSend(3)) {
+            setOilPressure(oilPressurePsi, oilColor);
+            gaugeSent(GAUGE_OIL, oilTenths, oilColor, now);
+        } else {
+            complete = false;
+        }
+    }
+    
+    // Overlays need at most 4 commands (shift vis + alert text/color/vis)
+    if (!canSend(4)) {
+        return false;
     }
     
     // Handle shift light
@@ -116,6 +272,22 @@ void DisplayHandler::update(uint16_t rpm, uint8_t speedMph, int16_t waterTempF,
     } else {
         hideAlert();
     }
+    
+    return complete;
+}
+
+bool DisplayHandler::updateDiagPage() {
+    for (uint8_t i = 0; i < DIAG_FIELD_COUNT; i++) {
+        if (_diagValues[i] == _diag.values[i]) {
+            continue;
+        }
+        if (!canSend(1)) {
+            return false;
+        }
+        setText(DIAG_COMPONENTS[i], (int)_diagValues[i]);
+        _diag.values[i] = _diagValues[i];
+    }
+    return true;
 }
 
 void DisplayHandler::setRPM(uint16_t rpm, uint16_t color) {
@@ -136,12 +308,13 @@ void DisplayHandler::setSpeed(uint8_t mph) {
     setText(NextionID::SPEED_VALUE, (int)mph);
 }
 
-void DisplayHandler::setWaterTemp(int16_t tempF, uint16_t color) {
-    setText(NextionID::TEMP_VALUE, (int)tempF);
+void DisplayHandler::setWaterTemp(int16_t temp, uint16_t color) {
+    setText(NextionID::TEMP_VALUE, (int)temp);
     
     // Set progress bar (map WATER_TEMP_MIN-WATER_TEMP_MAX to 0-100)
-    uint8_t progress = map(constrain(tempF, WATER_TEMP_MIN, WATER_TEMP_MAX),
-                          WATER_TEMP_MIN, WATER_TEMP_MAX, 0, 100);
+    const int16_t low = TEMP_F_TO_DISPLAY(WATER_TEMP_MIN);
+    const int16_t high = TEMP_F_TO_DISPLAY(WATER_TEMP_MAX);
+    uint8_t progress = map(constrain(temp, low, high), low, high, 0, 100);
     setProgress(NextionID::TEMP_GAUGE, progress);
     
     // Set gauge color
@@ -161,45 +334,592 @@ void DisplayHandler::setOilPressure(float psi, uint16_t color) {
 }
 
 void DisplayHandler::showShiftLight(bool show) {
-    if (show != _shiftVisible) {
+    OverlayState_t wanted = show ? OVERLAY_SHOWN : OVERLAY_HIDDEN;
+    if (wanted != _main.shiftOverlay) {
         setVisible(NextionID::SHIFT_OVERLAY, show);
-        _shiftVisible = show;
+        _main.shiftOverlay = wanted;
     }
 }
 
 void DisplayHandler::showAlert(const char* message, uint16_t color) {
-    setText(NextionID::ALERT_TEXT, message);
-    setColor(NextionID::ALERT_OVERLAY, color);
+    // Alert messages are string literals, so comparing pointers is enough
+    if (message != _main.alertText) {
+        setText(NextionID::ALERT_TEXT, message);
+        _main.alertText = message;
+    }
+    
+    if (color != _main.alertColor) {
+        setColor(NextionID::ALERT_OVERLAY, color);
+        _main.alertColor = color;
+    }
     
-    if (!_alertVisible) {
+    if (_main.alertOverlay != OVERLAY_SHOWN) {
         setVisible(NextionID::ALERT_OVERLAY, true);
-        _alertVisible = true;
+        _main.alertOverlay = OVERLAY_SHOWN;
     }
 }
 
 void DisplayHandler::hideAlert() {
-    if (_alertVisible) {
+    if (_main.alertOverlay != OVERLAY_HIDDEN) {
         setVisible(NextionID::ALERT_OVERLAY, false);
-        _alertVisible = false;
+        _main.alertOverlay = OVERLAY_HIDDEN;
     }
 }
 
 void DisplayHandler::setCANStatus(bool connected) {
-    setColor(NextionID::CAN_STATUS, connected ? COLOR_GREEN : COLOR_RED);
+    // Sent by update() while the main page is shown
+    _canConnected = connected;
+}
+
+void DisplayHandler::setBrightness(uint8_t percent) {
+    _brightness = percent;
 }
 
 void DisplayHandler::goToPage(const char* pageName) {
+    _pageName = pageName;
+    _expectedPage = pageId(pageName);
+    
     _serial.print("page ");
     _serial.print(pageName);
     endCommand();
+    
+    DataPage_t page = dataPage(_expectedPage);
+    
+    // The waveform is cleared whenever main loads; buffered samples would
+    // only be plotted late (or rejected on another page)
+    if (page != DATA_PAGE_MAIN && _traceState == TRACE_IDLE) {
+        _traceCount = 0;
+    }
+    
+    // Loading a page restores every component's HMI vis setting, so the
+    // overlays are hidden again. Values and colors are vscope=global and
+    // keep whatever we last sent - the shadow stays valid.
+    if (page == DATA_PAGE_MAIN) {
+        _main.shiftOverlay = OVERLAY_HIDDEN;
+        _main.alertOverlay = OVERLAY_HIDDEN;
+    }
+    
+    _page = page;
+    _requestedPage = page;
+    _flipPending = (page != DATA_PAGE_NONE);
+    _flipStart = clockMillis();
+}
+
+void DisplayHandler::showPage(DataPage_t page) {
+    if (page < DATA_PAGE_COUNT) {
+        _requestedPage = page;
+    }
+}
+
+void DisplayHandler::nextPage() {
+    // From the startup page (or unknown) the first data page is main
+    DataPage_t from = (_requestedPage != DATA_PAGE_NONE) ? _requestedPage : _page;
+    if (from == DATA_PAGE_NONE) {
+        _requestedPage = DATA_PAGE_MAIN;
+    } else {
+        _requestedPage = (DataPage_t)((from + 1) % DATA_PAGE_COUNT);
+    }
+}
+
+DataPage_t DisplayHandler::getPage() {
+    return _page;
+}
+
+void DisplayHandler::setDiag(DiagField_t field, int32_t value) {
+    if (field < DIAG_FIELD_COUNT) {
+        _diagValues[field] = value;
+    }
 }
 
 void DisplayHandler::showStartup(const char* message) {
+    // The display executes commands in order, no need to wait for the page
     goToPage(NextionID::PAGE_STARTUP);
-    delay(50);
     setText("startup_txt", message);
 }
 
+void DisplayHandler::pushTrace(uint16_t rpm, float oilPsi) {
+    #if TRACE_ENABLED
+    // The waveform only exists on the main page
+    if (_page != DATA_PAGE_MAIN) {
+        return;
+    }
+    
+    if (_traceCount >= TRACE_BUFFER_SIZE) {
+        // Display is not keeping up - drop the newest sample
+        _health.traceDropped++;
+        return;
+    }
+    
+    // Scale to waveform pixels (0 = bottom, TRACE_HEIGHT = top)
+    uint8_t index = (_traceTail + _traceCount) % TRACE_BUFFER_SIZE;
+    _traceBuf[NextionID::TRACE_CH_OIL][index] = 
+        map(constrain((int)oilPsi, OIL_PRESSURE_MIN, OIL_PRESSURE_MAX),
+            OIL_PRESSURE_MIN, OIL_PRESSURE_MAX, 0, TRACE_HEIGHT);
+    _traceBuf[NextionID::TRACE_CH_RPM][index] = 
+        map(constrain(rpm, RPM_MIN, RPM_MAX), RPM_MIN, RPM_MAX, 0, TRACE_HEIGHT);
+    _traceCount++;
+    #endif
+}
+
+void DisplayHandler::poll() {
+    readResponses();
+    
+    uint32_t now = clockMillis();
+    
+    if (_resyncPending) {
+        resync();
+    }
+    
+    // Acks that never arrive (lost bytes, display busy) must not stall us
+    if (_ackMode && _inFlight > 0 && now - _lastAckTime >= NEXTION_ACK_TIMEOUT_MS) {
+        _health.ackTimeouts++;
+        _inFlight = 0;
+    }
+    
+    // Heartbeat - the reply tells us the display is alive and on our page
+    if (_ackMode) {
+        if (_heartbeatPending && now - _lastHeartbeat >= NEXTION_HEARTBEAT_TIMEOUT_MS) {
+            _heartbeatPending = false;
+            _health.heartbeatMisses++;
+            
+            #if DEBUG_ENABLED
+            if (!_panelLost) {
+                Serial.println("Display not answering heartbeat");
+            }
+            #endif
+            _panelLost = true;
+        }
+        
+        // Not while addt waits for 0xFE - it would be plotted as data
+        if (!_heartbeatPending && _traceState == TRACE_IDLE &&
+            now - _lastHeartbeat >= NEXTION_HEARTBEAT_MS) {
+            sendCommand("sendme");
+            _heartbeatPending = true;
+            _lastHeartbeat = now;
+        }
+    }
+    
+    #if TRACE_ENABLED
+    if (_traceState == TRACE_WAIT_READY) {
+        if (now - _traceRequestTime >= TRACE_READY_TIMEOUT_MS) {
+            // The addt never got through - a panel that still had it
+            // pending would eat the next commands as data, so resend
+            // everything (resync() drops the batch)
+            _health.traceErrors++;
+            _resyncPending = true;
+        }
+        return;
+    }
+    
+    if (_traceCount > 0 && now - _lastTraceFlush >= TRACE_FLUSH_MS && canSend(1)) {
+        _lastTraceFlush = now;
+        _traceBatch = _traceCount;
+        _traceChannel = 0;
+        startTraceTransfer();
+    }
+    #endif
+}
+
+uint32_t DisplayHandler::nextDeadline(uint32_t now) {
+    // Work held back (window full, trace transfer, page flip) goes out as
+    // soon as the blocking reply is read - check again next tick
+    if (_deferred || _resyncPending || _brightness != _shownBrightness ||
+        (_requestedPage != _page && _requestedPage != DATA_PAGE_NONE)) {
+        return now + 1;
+    }
+    
+    uint32_t next = now + CLOCK_IDLE_MS;
+    
+    if ((int32_t)(_backoffUntil - now) > 0) {
+        clockSooner(next, _backoffUntil, now);
+    }
+    
+    // A gauge past its interval is inside its deadband - it waits for a new
+    // value, not for time
+    if (_page == DATA_PAGE_MAIN) {
+        for (uint8_t i = 0; i < GAUGE_COUNT; i++) {
+            const GaugeShadow_t& shadow = _main.gauges[i];
+            uint32_t due = shadow.sentAt + shadow.intervalMs;
+            if (shadow.value != GAUGE_VALUE_UNKNOWN && (int32_t)(due - now) > 0) {
+                clockSooner(next, due, now);
+            }
+        }
+    }
+    
+    if (_ackMode) {
+        if (_inFlight > 0) {
+            clockSooner(next, _lastAckTime + NEXTION_ACK_TIMEOUT_MS, now);
+        }
+        clockSooner(next, _lastHeartbeat + (_heartbeatPending ? 
+                    NEXTION_HEARTBEAT_TIMEOUT_MS : NEXTION_HEARTBEAT_MS), now);
+    }
+    
+    #if TRACE_ENABLED
+    if (_traceState == TRACE_WAIT_READY) {
+        clockSooner(next, _traceRequestTime + TRACE_READY_TIMEOUT_MS, now);
+    } else if (_traceCount > 0) {
+        clockSooner(next, _lastTraceFlush + TRACE_FLUSH_MS, now);
+    }
+    #endif
+    
+    return next;
+}
+
+bool DisplayHandler::isIdle() {
+    return !_deferred && !_resyncPending && _inFlight == 0 && !_heartbeatPending &&
+           _traceState == TRACE_IDLE && _rxLen == 0;
+}
+
+bool DisplayHandler::readTouch(TouchEvent_t& event) {
+    if (_touchCount == 0) {
+        return false;
+    }
+    
+    event = _touchQueue[_touchHead];
+    _touchHead = (_touchHead + 1) % 4;
+    _touchCount--;
+    return true;
+}
+
+NextionHealth_t DisplayHandler::getHealth() {
+    _health.window = _window;
+    return _health;
+}
+
+void DisplayHandler::dropPartialFrame() {
+    _rxLen = 0;
+    _rxTerm = 0;
+    _rxDrop = true;
+}
+
+void DisplayHandler::readResponses() {
+    // Only consumes bytes already received - never waits for more
+    while (_serial.available()) {
+        uint8_t c = _serial.read();
+        
+        if (c == 0xFF) {
+            if (++_rxTerm == 3) {
+                if (!_rxDrop) {
+                    handleResponse(_rxBuf, _rxLen);
+                }
+                _rxDrop = false;
+                _rxLen = 0;
+                _rxTerm = 0;
+            }
+            continue;
+        }
+        
+        // 0xFF bytes that turned out not to be a terminator are data
+        while (_rxTerm > 0 && _rxLen < sizeof(_rxBuf)) {
+            _rxBuf[_rxLen++] = 0xFF;
+            _rxTerm--;
+        }
+        _rxTerm = 0;
+        
+        if (_rxLen < sizeof(_rxBuf)) {
+            _rxBuf[_rxLen++] = c;
+        }
+    }
+}
+
+void DisplayHandler::handleResponse(const uint8_t* frame, uint8_t len) {
+    if (len == 0) {
+        return;
+    }
+    
+    uint8_t code = frame[0];
+    
+    switch (code) {
+        case NextionReturn::SUCCESS:
+            _health.acked++;
+            onAck();
+            break;
+            
+        case NextionReturn::BUFFER_OVERFLOW:
+            onOverflow();
+            break;
+            
+        case NextionReturn::TOUCH_EVENT:
+            if (len >= 4) {
+                // Queue is small - drop the oldest event if full
+                if (_touchCount == 4) {
+                    _touchHead = (_touchHead + 1) % 4;
+                    _touchCount--;
+                }
+                TouchEvent_t& event = _touchQueue[(_touchHead + _touchCount) % 4];
+                event.page = frame[1];
+                event.component = frame[2];
+                event.pressed = (frame[3] == 0x01);
+                _touchCount++;
+                
+                // page_btn hotspot flips pages on release
+                DataPage_t page = dataPage(event.page);
+                if (!event.pressed && page != DATA_PAGE_NONE &&
+                    event.component == DATA_PAGES[page].buttonId) {
+                    nextPage();
+                }
+            }
+            break;
+            
+        case NextionReturn::READY:
+            _panelReady = true;
+            
+            // Outside begin() this means the display rebooted on its own
+            if (_ackMode) {
+                _resyncPending = true;
+            }
+            break;
+            
+        case NextionReturn::CURRENT_PAGE:
+            // Heartbeat reply - completes the sendme command
+            _heartbeatPending = false;
+            onAck();
+            
+            // Back after going silent, or silently reset to its default page
+            if (len >= 2 && (_panelLost || (_expectedPage != NextionID::PAGE_UNKNOWN_ID &&
+                                            frame[1] != _expectedPage))) {
+                _resyncPending = true;
+            }
+            _panelLost = false;
+            break;
+            
+        case NextionReturn::TRANSPARENT_READY:
+            if (_traceState == TRACE_WAIT_READY) {
+                sendTraceData();
+            }
+            break;
+            
+        case NextionReturn::TRANSPARENT_DONE:
+            // Completes the addt command
+            onAck();
+            break;
+            
+        case NextionReturn::AUTO_SLEEP:
+        case NextionReturn::AUTO_WAKE:
+            break;
+            
+        default:
+            if (code == NextionReturn::INVALID_INSTRUCTION && len == 3) {
+                // 00 00 00 is the startup message, not an error
+                _panelReady = true;
+                if (_ackMode) {
+                    _resyncPending = true;
+                }
+            } else if (code < NextionReturn::LAST_ERROR_CODE) {
+                // Command rejected (0x1A invalid variable, 0x1B invalid
+                // operation, ...) - still completes the command
+                _health.rejected++;
+                _health.lastReject = code;
+                
+                // Replies come in order and nothing is sent after addt, so
+                // with one command outstanding this is the addt - the
+                // panel won't take the data, drop the batch
+                if (_traceState == TRACE_WAIT_READY && _inFlight <= 1) {
+                    _health.traceErrors++;
+                    _traceState = TRACE_IDLE;
+                    finishTraceBatch();
+                }
+                onAck();
+                
+                #if DEBUG_ENABLED
+                Serial.printf("Display rejected command: 0x%02X\n", code);
+                #endif
+            }
+            break;
+    }
+}
+
+bool DisplayHandler::canSend(uint8_t commands) {
+    // Before bkcmd=3 nothing is acknowledged, so nothing to pace on
+    return !_ackMode || _inFlight + commands <= _window;
+}
+
+void DisplayHandler::onAck() {
+    if (_inFlight > 0) {
+        _inFlight--;
+    }
+    _lastAckTime = clockMillis();
+    
+    // Additive increase while the display keeps up
+    if (++_acksSinceGrow >= NEXTION_WINDOW_GROW_ACKS) {
+        _acksSinceGrow = 0;
+        if (_window < NEXTION_WINDOW_MAX) {
+            _window++;
+        }
+    }
+}
+
+void DisplayHandler::onOverflow() {
+    _health.overflows++;
+    
+    // Multiplicative decrease, then pause so the display can drain
+    _window = max(_window / 2, NEXTION_WINDOW_MIN);
+    _acksSinceGrow = 0;
+    _backoffUntil = clockMillis() + NEXTION_OVERFLOW_BACKOFF_MS;
+    
+    // Some commands were dropped and will never be acked; we can't tell
+    // which, so forget what the display shows and resend everything
+    _inFlight = 0;
+    invalidateShadow();
+    
+    #if DEBUG_ENABLED
+    Serial.printf("Display buffer overflow, window now %d\n", _window);
+    #endif
+}
+
+void DisplayHandler::resync() {
+    _resyncPending = false;
+    _health.resyncs++;
+    
+    #if DEBUG_ENABLED
+    Serial.println("Display reset detected, resending state");
+    #endif
+    
+    // A strip chart transfer in progress died with the display
+    if (_traceState != TRACE_IDLE) {
+        _traceState = TRACE_IDLE;
+        finishTraceBatch();
+    }
+    
+    // The display came back with bkcmd at its default - re-enable acks.
+    // Nothing sent before the reset will be acknowledged now.
+    _ackMode = false;
+    sendCommand("bkcmd=3");
+    _ackMode = true;
+    _inFlight = 0;
+    _window = NEXTION_WINDOW_INIT;
+    _acksSinceGrow = 0;
+    
+    goToPage(_pageName != NULL ? _pageName : NextionID::PAGE_MAIN);
+    
+    // The reset restored the HMI defaults on every page: overlays hidden,
+    // gauges at their design values. Only what differs needs sending.
+    invalidateShadow();
+    _main.shiftOverlay = OVERLAY_HIDDEN;
+    _main.alertOverlay = OVERLAY_HIDDEN;
+    // Invalidated components are due immediately, so the next update()
+    // completes the frame
+}
+
+bool DisplayHandler::gaugeDue(Gauge_t gauge, int32_t value, uint16_t color, 
+                              bool alert, uint32_t now) {
+    GaugeShadow_t& shadow = _main.gauges[gauge];
+    const RefreshPolicy_t& policy = REFRESH_POLICY[gauge];
+    
+    // Display state unknown, or the color zone changed - send right away
+    if (shadow.value == GAUGE_VALUE_UNKNOWN || color != shadow.color) {
+        return true;
+    }
+    
+    uint32_t delta = abs(value - shadow.value);
+    if (delta < policy.deadband) {
+        return false;
+    }
+    
+    // Fast attack: moving faster than fastRate (measured over at least the
+    // minimum interval), or in alert - refresh at the minimum interval
+    uint32_t elapsed = now - shadow.sentAt;
+    uint32_t window = max(elapsed, (uint32_t)policy.minIntervalMs);
+    if (alert || delta * 1000 >= (uint32_t)policy.fastRate * window) {
+        shadow.intervalMs = policy.minIntervalMs;
+    }
+    
+    return elapsed >= shadow.intervalMs;
+}
+
+void DisplayHandler::gaugeSent(Gauge_t gauge, int32_t value, uint16_t color, uint32_t now) {
+    GaugeShadow_t& shadow = _main.gauges[gauge];
+    
+    shadow.value = value;
+    shadow.color = color;
+    shadow.sentAt = now;
+    
+    // Slow decay: relax 25% per refresh, until the next fast change
+    uint16_t relaxed = shadow.intervalMs + shadow.intervalMs / 4 + 1;
+    shadow.intervalMs = min(relaxed, REFRESH_POLICY[gauge].maxIntervalMs);
+}
+
+uint8_t DisplayHandler::pageId(const char* pageName) {
+    if (strcmp(pageName, NextionID::PAGE_MAIN) == 0) {
+        return NextionID::PAGE_MAIN_ID;
+    }
+    if (strcmp(pageName, NextionID::PAGE_STARTUP) == 0) {
+        return NextionID::PAGE_STARTUP_ID;
+    }
+    if (strcmp(pageName, NextionID::PAGE_DIAG) == 0) {
+        return NextionID::PAGE_DIAG_ID;
+    }
+    return NextionID::PAGE_UNKNOWN_ID;
+}
+
+DataPage_t DisplayHandler::dataPage(uint8_t id) {
+    for (uint8_t i = 0; i < DATA_PAGE_COUNT; i++) {
+        if (DATA_PAGES[i].id == id) {
+            return (DataPage_t)i;
+        }
+    }
+    return DATA_PAGE_NONE;
+}
+
+void DisplayHandler::invalidateShadow() {
+    for (uint8_t i = 0; i < GAUGE_COUNT; i++) {
+        _main.gauges[i].value = GAUGE_VALUE_UNKNOWN;
+        _main.gauges[i].color = 0;
+        _main.gauges[i].sentAt = 0;
+        _main.gauges[i].intervalMs = REFRESH_POLICY[i].minIntervalMs;
+    }
+    
+    _main.alertText = NULL;
+    _main.alertColor = 0;
+    _main.shiftOverlay = OVERLAY_UNKNOWN;
+    _main.alertOverlay = OVERLAY_UNKNOWN;
+    _main.canColor = 0;
+    _shownBrightness = 0xFF;
+    
+    for (uint8_t i = 0; i < DIAG_FIELD_COUNT; i++) {
+        _diag.values[i] = GAUGE_VALUE_UNKNOWN;
+    }
+}
+
+void DisplayHandler::startTraceTransfer() {
+    // addt <id>,<channel>,<count> - display answers 0xFE when ready for
+    // exactly <count> raw bytes
+    _serial.print("addt ");
+    _serial.print(NextionID::OIL_TRACE_ID);
+    _serial.print(",");
+    _serial.print(_traceChannel);
+    _serial.print(",");
+    _serial.print(_traceBatch);
+    endCommand();
+    
+    _traceState = TRACE_WAIT_READY;
+    _traceRequestTime = clockMillis();
+}
+
+void DisplayHandler::sendTraceData() {
+    // Ring may wrap - write in at most two contiguous chunks
+    const uint8_t* row = _traceBuf[_traceChannel];
+    uint8_t first = min((int)_traceBatch, TRACE_BUFFER_SIZE - _traceTail);
+    _serial.write(row + _traceTail, first);
+    if (first < _traceBatch) {
+        _serial.write(row, _traceBatch - first);
+    }
+    
+    _traceChannel++;
+    if (_traceChannel < NextionID::TRACE_CHANNELS) {
+        startTraceTransfer();
+    } else {
+        _traceState = TRACE_IDLE;
+        finishTraceBatch();
+    }
+}
+
+void DisplayHandler::finishTraceBatch() {
+    _traceTail = (_traceTail + _traceBatch) % TRACE_BUFFER_SIZE;
+    _traceCount -= _traceBatch;
+    _traceBatch = 0;
+}
+
 void DisplayHandler::sendCommand(const char* cmd) {
     _serial.print(cmd);
     endCommand();
@@ -224,6 +944,16 @@ void DisplayHandler::endCommand() {
     _serial.write(0xFF);
     _serial.write(0xFF);
     _serial.write(0xFF);
+    
+    // Every command is answered once bkcmd=3 is active
+    if (_ackMode) {
+        if (_inFlight == 0) {
+            _lastAckTime = clockMillis();
+        }
+        if (_inFlight < 0xFF) {
+            _inFlight++;
+        }
+    }
 }
 
 void DisplayHandler::setNumber(const char* component, int32_t value) {
@@ -10,6 +10,7 @@
 #include <Arduino.h>
 #include "config.h"
 #include "alerts.h"
+#include "clock.h"
 
 // Nextion component IDs (must match HMI design)
 // These are the object names in the Nextion Editor
@@ -18,6 +19,18 @@ namespace NextionID {
     const char PAGE_MAIN[] = "main";
     const char PAGE_STARTUP[] = "startup";
     const char PAGE_ALERT[] = "alert";
+    const char PAGE_DIAG[] = "diag";
+    
+    // Page ids (order in the Nextion Editor page list)
+    const uint8_t PAGE_STARTUP_ID = 0;
+    const uint8_t PAGE_MAIN_ID = 1;
+    const uint8_t PAGE_DIAG_ID = 2;
+    const uint8_t PAGE_UNKNOWN_ID = 0xFF;
+    
+    // Hotspot that flips to the next data page (touch release event)
+    const char PAGE_BUTTON[] = "page_btn";
+    const uint8_t PAGE_BUTTON_MAIN_ID = 22;     // Component id on main
+    const uint8_t PAGE_BUTTON_DIAG_ID = 1;      // Component id on diag
     
     // Main page components
     const char RPM_GAUGE[] = "rpm_gauge";       // Progress bar for RPM
@@ -39,8 +52,139 @@ namespace NextionID {
     
     // Status indicators
     const char CAN_STATUS[] = "can_stat";       // CAN connection status
+    
+    // Strip chart (waveform). addt addresses the waveform by its numeric
+    // component id, so OIL_TRACE_ID must match the id shown in the editor.
+    const char OIL_TRACE[] = "oil_trace";       // Waveform: oil/RPM trend
+    const uint8_t OIL_TRACE_ID = 21;            // Waveform component id
+    const uint8_t TRACE_CH_OIL = 0;             // Channel 0: oil pressure
+    const uint8_t TRACE_CH_RPM = 1;             // Channel 1: RPM
+    const uint8_t TRACE_CHANNELS = 2;
+    
+    // Diagnostics page components (text, indexed by DiagField_t)
+    const char DIAG_OBD_RATE[] = "obd_rate";    // OBD responses per second
+    const char DIAG_CAN_ERRORS[] = "can_err";   // CAN errors since boot
+    const char DIAG_LINK_ERRORS[] = "link_err"; // Display rejects + overflows + timeouts
+    const char DIAG_OIL_MV[] = "oil_mv";        // Oil sender voltage (mV)
+    const char DIAG_FLIP_MS[] = "flip_ms";      // Last page flip time
+    const char DIAG_UPTIME[] = "uptime";        // Seconds since boot
 }
 
+// Nextion return data (first byte of each 0xFF 0xFF 0xFF terminated frame)
+namespace NextionReturn {
+    // Command results (with bkcmd=3 every command returns exactly one)
+    const uint8_t INVALID_INSTRUCTION = 0x00;   // Also startup: 00 00 00
+    const uint8_t SUCCESS           = 0x01;
+    const uint8_t INVALID_COMPONENT = 0x02;     // No component with that id
+    const uint8_t INVALID_VARIABLE  = 0x1A;     // Bad name or attribute
+    const uint8_t INVALID_OPERATION = 0x1B;     // Bad variable operation
+    const uint8_t BUFFER_OVERFLOW   = 0x24;     // Input buffer overflowed
+    const uint8_t LAST_ERROR_CODE   = 0x24;     // 0x00-0x24 are results
+    
+    // Events
+    const uint8_t TOUCH_EVENT       = 0x65;     // page, component, press
+    const uint8_t CURRENT_PAGE      = 0x66;     // page (reply to sendme)
+    const uint8_t AUTO_SLEEP        = 0x86;
+    const uint8_t AUTO_WAKE         = 0x87;
+    const uint8_t READY             = 0x88;     // Boot complete
+    const uint8_t TRANSPARENT_DONE  = 0xFD;     // addt data consumed
+    const uint8_t TRANSPARENT_READY = 0xFE;     // addt ready for raw data
+}
+
+// Touch event reported by the display (0x65)
+typedef struct {
+    uint8_t page;           // Page id
+    uint8_t component;      // Component id
+    bool    pressed;        // true = press, false = release
+} TouchEvent_t;
+
+// Display link health
+typedef struct {
+    uint32_t acked;         // Commands acknowledged as successful
+    uint32_t rejected;      // Commands rejected (0x00-0x23 error codes)
+    uint8_t  lastReject;    // Most recent error code
+    uint32_t overflows;     // Input buffer overflow events (0x24)
+    uint32_t ackTimeouts;   // Outstanding acks given up on
+    uint32_t heartbeatMisses; // Heartbeats without a reply
+    uint32_t resyncs;       // Full state resends after a display reset
+    uint8_t  window;        // Current commands-in-flight limit
+    uint32_t traceDropped;  // Strip chart samples dropped (buffer full)
+    uint32_t traceErrors;   // Strip chart transfers lost (addt rejected, or no 0xFE and resynced)
+    uint16_t lastFlipMs;    // Last page flip, page command to final delta acked
+} NextionHealth_t;
+
+// Pages that carry live data, in page button order
+typedef enum {
+    DATA_PAGE_MAIN = 0,
+    DATA_PAGE_DIAG,
+    DATA_PAGE_COUNT,
+    DATA_PAGE_NONE = 0xFF   // Startup page or unknown
+} DataPage_t;
+
+// Values shown on the diagnostics page
+typedef enum {
+    DIAG_OBD_RATE = 0,
+    DIAG_CAN_ERRORS,
+    DIAG_LINK_ERRORS,
+    DIAG_OIL_MV,
+    DIAG_FLIP_MS,
+    DIAG_UPTIME,
+    DIAG_FIELD_COUNT
+} DiagField_t;
+
+// Gauges with independent refresh timing
+typedef enum {
+    GAUGE_RPM = 0,
+    GAUGE_SPEED,
+    GAUGE_TEMP,
+    GAUGE_OIL,
+    GAUGE_COUNT
+} Gauge_t;
+
+// Refresh policy for one gauge (see DISPLAY REFRESH in config.h)
+typedef struct {
+    uint16_t minIntervalMs;     // Interval when moving fast or in alert
+    uint16_t maxIntervalMs;     // Interval when steady
+    uint16_t fastRate;          // Change per second that counts as fast
+    uint16_t deadband;          // Smaller changes are not sent
+} RefreshPolicy_t;
+
+// What the display shows for one gauge, and when it was sent
+typedef struct {
+    int32_t  value;             // Last sent value (oil in 0.1 PSI)
+    uint16_t color;             // Last sent color
+    uint32_t sentAt;            // When it was sent
+    uint16_t intervalMs;        // Current refresh interval
+} GaugeShadow_t;
+
+// Overlay visibility as last sent to the display
+typedef enum {
+    OVERLAY_HIDDEN = 0,
+    OVERLAY_SHOWN,
+    OVERLAY_UNKNOWN         // Display state lost - next call always sends
+} OverlayState_t;
+
+// Main page components as last sent (kept while the page is hidden)
+typedef struct {
+    GaugeShadow_t  gauges[GAUGE_COUNT];
+    OverlayState_t shiftOverlay;
+    OverlayState_t alertOverlay;
+    const char*    alertText;
+    uint16_t       alertColor;
+    uint16_t       canColor;    // CAN status color (0 = unknown)
+} MainShadow_t;
+
+// Diagnostics page components as last sent
+typedef struct {
+    int32_t values[DIAG_FIELD_COUNT];
+} DiagShadow_t;
+
+// Strip chart bulk transfer state
+typedef enum {
+    TRACE_IDLE = 0,         // No transfer in progress
+    TRACE_WAIT_READY        // addt sent, waiting for 0xFE before raw data
+} TraceState_t;
+
 class DisplayHandler {
 public:
     DisplayHandler(HardwareSerial& serial);
@@ -48,14 +192,14 @@ public:
     // Initialize display
     void begin();
     
-    // Update display with current values
-    void update(uint16_t rpm, uint8_t speedMph, int16_t waterTempF, 
+    // Update display with current values (temps in the display unit)
+    void update(uint16_t rpm, uint8_t speedMph, int16_t waterTemp, 
                 float oilPressurePsi, AlertHandler& alerts);
     
     // Set individual values
     void setRPM(uint16_t rpm, uint16_t color);
     void setSpeed(uint8_t mph);
-    void setWaterTemp(int16_t tempF, uint16_t color);
+    void setWaterTemp(int16_t temp, uint16_t color);
     void setOilPressure(float psi, uint16_t color);
     
     // Show/hide overlays
@@ -66,12 +210,47 @@ public:
     // Set CAN status indicator
     void setCANStatus(bool connected);
     
-    // Change page
+    // Backlight in percent (sent by update(), on any page)
+    void setBrightness(uint8_t percent);
+    
+    // Change page immediately (any page, e.g. during setup)
     void goToPage(const char* pageName);
     
+    // Request a data page; the flip happens on the next update()
+    void showPage(DataPage_t page);
+    void nextPage();
+    DataPage_t getPage();
+    
+    // Set a diagnostics page value (sent when the page is shown)
+    void setDiag(DiagField_t field, int32_t value);
+    
     // Show startup screen
     void showStartup(const char* message);
     
+    // Buffer one strip chart sample (call at TRACE_SAMPLE_MS)
+    void pushTrace(uint16_t rpm, float oilPsi);
+    
+    // Service display responses and pending bulk transfers (call every loop)
+    void poll();
+    
+    // Next time update()/poll() have work with the inputs unchanged and no
+    // reply from the display (refresh, heartbeat, timeouts, trace flush)
+    uint32_t nextDeadline(uint32_t now);
+    
+    // Nothing sent is awaiting a reply and no work is held over - safe to
+    // stop the clocks until the next deadline
+    bool isIdle();
+    
+    // Get the next touch event, if any
+    bool readTouch(TouchEvent_t& event);
+    
+    // Discard input up to the next frame end - after a light-sleep wake
+    // the head of the frame that woke us is lost
+    void dropPartialFrame();
+    
+    // Get link health statistics
+    NextionHealth_t getHealth();
+    
     // Raw command sending
     void sendCommand(const char* cmd);
     void sendCommand(const char* format, int value);
@@ -80,18 +259,94 @@ public:
 private:
     HardwareSerial& _serial;
     
-    uint32_t _lastUpdate;
-    bool _shiftVisible;
-    bool _alertVisible;
-    
-    // Last sent values (to avoid redundant updates)
-    uint16_t _lastRPM;
-    uint8_t _lastSpeed;
-    int16_t _lastTemp;
-    float _lastOil;
-    uint16_t _lastRPMColor;
-    uint16_t _lastTempColor;
-    uint16_t _lastOilColor;
+    // Per-page shadow of what the display shows (to avoid redundant updates)
+    MainShadow_t _main;
+    DiagShadow_t _diag;
+    int32_t _diagValues[DIAG_FIELD_COUNT];  // Latest values to show
+    
+    // Page model
+    DataPage_t _page;           // Data page on screen
+    DataPage_t _requestedPage;  // Data page to flip to
+    bool _flipPending;          // Flip deltas not yet all acked
+    uint32_t _flipStart;
+    
+    // Strip chart ring buffer (one row per waveform channel)
+    uint8_t _traceBuf[NextionID::TRACE_CHANNELS][TRACE_BUFFER_SIZE];
+    uint8_t _traceTail;         // Oldest buffered sample
+    uint8_t _traceCount;        // Buffered samples per channel
+    uint8_t _traceBatch;        // Samples in the transfer in progress
+    uint8_t _traceChannel;      // Channel being transferred
+    TraceState_t _traceState;
+    uint32_t _traceRequestTime;
+    uint32_t _lastTraceFlush;
+    
+    // Incoming display data (frames end with three 0xFF bytes)
+    uint8_t _rxBuf[16];
+    uint8_t _rxLen;
+    uint8_t _rxTerm;            // Consecutive 0xFF bytes seen
+    bool _rxDrop;               // Current frame is a truncated one
+    
+    // Flow control - commands are counted until the display acks them
+    bool _ackMode;              // bkcmd=3 active, every command acked
+    bool _panelReady;           // Startup event seen since "rest"
+    uint8_t _inFlight;          // Commands sent but not yet acked
+    uint8_t _window;            // Max commands in flight
+    uint8_t _acksSinceGrow;
+    uint32_t _lastAckTime;
+    uint32_t _backoffUntil;     // No gauge updates before this (overflow)
+    bool _deferred;             // Last update() left work for the next call
+    NextionHealth_t _health;
+    
+    // Display reset detection
+    const char* _pageName;      // Page we last switched to
+    uint8_t _expectedPage;      // Its id, checked against heartbeat replies
+    bool _canConnected;         // Last CAN status sent
+    uint8_t _brightness;        // Backlight wanted
+    uint8_t _shownBrightness;   // Backlight sent (0xFF = unknown)
+    bool _heartbeatPending;
+    uint32_t _lastHeartbeat;
+    bool _panelLost;            // Heartbeat unanswered - display gone
+    bool _resyncPending;        // Display reset - resend everything
+    
+    // Touch events waiting to be read
+    TouchEvent_t _touchQueue[4];
+    uint8_t _touchHead;
+    uint8_t _touchCount;
+    
+    // Read and dispatch any complete response frames (never blocks)
+    void readResponses();
+    void handleResponse(const uint8_t* frame, uint8_t len);
+    
+    // Flow control
+    bool canSend(uint8_t commands);
+    void onAck();
+    void onOverflow();
+    
+    // Forget what the display is showing so everything is resent
+    void invalidateShadow();
+    
+    // Send what changed on the current page; false if the window ran out
+    bool updateMainPage(uint16_t rpm, uint8_t speedMph, int16_t waterTemp,
+                        float oilPressurePsi, AlertHandler& alerts, uint32_t now);
+    bool updateDiagPage();
+    
+    // Refresh policy: is this gauge value worth sending now?
+    bool gaugeDue(Gauge_t gauge, int32_t value, uint16_t color, bool alert, uint32_t now);
+    void gaugeSent(Gauge_t gauge, int32_t value, uint16_t color, uint32_t now);
+    
+    // Restore display state after it reset (brownout, reflash, ...)
+    void resync();
+    
+    // Page id for a page name (PAGE_UNKNOWN_ID if not in the HMI)
+    uint8_t pageId(const char* pageName);
+    
+    // Data page for a page id (DATA_PAGE_NONE if it carries no data)
+    DataPage_t dataPage(uint8_t id);
+    
+    // Strip chart transfer steps
+    void startTraceTransfer();
+    void sendTraceData();
+    void finishTraceBatch();
     
     // End command with Nextion terminator
     void endCommand();
@@ -0,0 +1,101 @@
+/*
+ * gear_estimator.cpp - Current gear estimation implementation
+ */
+
+#include "gear_estimator.h"
+
+static const float GEAR_RATIO_TABLE[GEAR_COUNT] = GEAR_RATIOS;
+
+GearEstimator::GearEstimator() {
+    // Tire circumference from the size code (e.g. 245/40R18)
+    float diameterMm = TIRE_RIM_IN * 25.4f + 2.0f * TIRE_WIDTH_MM * TIRE_ASPECT_PCT / 100.0f;
+    float circumferenceM = diameterMm * PI / 1000.0f;
+    
+    // Engine RPM per km/h = gear * final * (1000 m/km / circumference) / 60 min
+    for (uint8_t i = 0; i < GEAR_COUNT; i++) {
+        float rpmPerKmh = GEAR_RATIO_TABLE[i] * FINAL_DRIVE_RATIO * 1000.0f / 
+                          (60.0f * circumferenceM);
+        _nominalQ8[i] = (uint32_t)(rpmPerKmh * 256.0f + 0.5f);
+    }
+    
+    // Ratios step geometrically, so split adjacent gears at the geometric mean
+    for (uint8_t i = 0; i < GEAR_COUNT; i++) {
+        if (i + 1 < GEAR_COUNT) {
+            _lowerQ8[i] = (uint32_t)(sqrtf((float)_nominalQ8[i] * _nominalQ8[i + 1]) + 0.5f);
+        } else {
+            _lowerQ8[i] = 0;
+        }
+    }
+    
+    _gear = GEAR_UNKNOWN;
+    _candidate = GEAR_UNKNOWN;
+    _candidateCount = 0;
+    _lastMatch = 0;
+    _ratioQ8 = 0;
+}
+
+uint8_t GearEstimator::update(uint16_t rpm, uint8_t speedKmh, uint32_t now) {
+    uint8_t matched = GEAR_UNKNOWN;
+    
+    if (speedKmh >= GEAR_MIN_SPEED_KMH && rpm >= GEAR_MIN_RPM) {
+        _ratioQ8 = ((uint32_t)rpm << 8) / speedKmh;
+        matched = match(_ratioQ8);
+    } else {
+        _ratioQ8 = 0;
+    }
+    
+    // Debounce: a new gear needs GEAR_DEBOUNCE_SAMPLES matching in a row
+    if (matched == _candidate) {
+        if (_candidateCount < 0xFF) {
+            _candidateCount++;
+        }
+    } else {
+        _candidate = matched;
+        _candidateCount = 1;
+    }
+    
+    if (matched != GEAR_UNKNOWN) {
+        if (matched == _gear) {
+            _lastMatch = now;
+        } else if (_candidateCount >= GEAR_DEBOUNCE_SAMPLES) {
+            _gear = matched;
+            _lastMatch = now;
+            
+            #if DEBUG_ENABLED
+            Serial.printf("Gear: %d\n", _gear);
+            #endif
+        }
+    } else if (_gear != GEAR_UNKNOWN && now - _lastMatch >= GEAR_HOLD_MS) {
+        // No match for a while - coasting in neutral or stopped
+        _gear = GEAR_UNKNOWN;
+    }
+    
+    return _gear;
+}
+
+uint8_t GearEstimator::getGear() {
+    return _gear;
+}
+
+uint32_t GearEstimator::getRatioQ8() {
+    return _ratioQ8;
+}
+
+uint8_t GearEstimator::match(uint32_t ratioQ8) {
+    // Gears are ordered 1st (highest ratio) to top; the first boundary the
+    // ratio clears is the closest gear
+    uint8_t i = 0;
+    while (i < GEAR_COUNT - 1 && ratioQ8 < _lowerQ8[i]) {
+        i++;
+    }
+    
+    // Too far from even the closest gear: clutch slipping, wheelspin, or
+    // RPM and speed sampled mid-shift
+    uint32_t nominal = _nominalQ8[i];
+    uint32_t error = (ratioQ8 > nominal) ? ratioQ8 - nominal : nominal - ratioQ8;
+    if (error * 100 > nominal * GEAR_TOLERANCE_PCT) {
+        return GEAR_UNKNOWN;
+    }
+    
+    return i + 1;
+}
@@ -0,0 +1,49 @@
+/*
+ * gear_estimator.h - Current gear from the RPM / speed ratio
+ * 
+ * Each gear has a fixed engine RPM per km/h. The measured ratio is matched
+ * against the configured gear ratios (integer math, fixed GEAR_COUNT loop -
+ * constant time per CAN update) and debounced so clutch-in transients and
+ * RPM/speed samples taken at different moments don't flicker the result.
+ */
+
+#ifndef GEAR_ESTIMATOR_H
+#define GEAR_ESTIMATOR_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#define GEAR_UNKNOWN    0       // Neutral, clutch in, stopped or no match
+
+class GearEstimator {
+public:
+    GearEstimator();
+    
+    // Feed one RPM/speed pair. Returns the current (debounced) gear.
+    uint8_t update(uint16_t rpm, uint8_t speedKmh, uint32_t now);
+    
+    // Current gear, 1..GEAR_COUNT or GEAR_UNKNOWN
+    uint8_t getGear();
+    
+    // Last measured RPM per km/h (Q8 fixed point, 0 if not measurable)
+    uint32_t getRatioQ8();
+
+private:
+    // Nominal RPM per km/h for each gear (Q8), 1st gear first
+    uint32_t _nominalQ8[GEAR_COUNT];
+    
+    // Ratio at or above which a gear is the closest match: the geometric
+    // midpoint to the next gear up (0 for top gear)
+    uint32_t _lowerQ8[GEAR_COUNT];
+    
+    uint8_t _gear;
+    uint8_t _candidate;         // Gear the last samples matched
+    uint8_t _candidateCount;    // How many in a row
+    uint32_t _lastMatch;        // Last sample that matched _gear
+    uint32_t _ratioQ8;
+    
+    // Closest gear for a ratio, GEAR_UNKNOWN if outside the tolerance
+    uint8_t match(uint32_t ratioQ8);
+};
+
+#endif // GEAR_ESTIMATOR_H
@@ -0,0 +1,152 @@
+/*
+ * Arduino.h - Minimal Arduino core for building the gauge on a host PC
+ * 
+ * Only what the gauge sources use, enough to compile and run them natively
+ * for the benchmarks in ../bench and the simulation in ../sim. Not used by
+ * the Arduino IDE build.
+ * 
+ * Time is simulated: millis()/micros() return a counter that only moves
+ * when delay() or hostAdvanceMillis() is called. Peripherals are inert
+ * unless a host* hook is installed to observe or drive them.
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <math.h>
+#include <algorithm>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH            1
+#define LOW             0
+#define INPUT           0x01
+#define OUTPUT          0x03
+#define INPUT_PULLUP    0x05
+#define SERIAL_8N1      0x800001c
+#define ADC_11db        3
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+// arduino-esp32 uses the std templates rather than the AVR macros
+using std::min;
+using std::max;
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// --- Time ---
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void hostAdvanceMillis(uint32_t ms);
+
+// --- GPIO / peripherals (no-ops; digitalRead returns hostSetPin values) ---
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+void hostSetPin(uint8_t pin, int val);
+uint16_t analogRead(uint8_t pin);
+void analogReadResolution(uint8_t bits);
+void analogSetAttenuation(uint8_t attenuation);
+uint32_t ledcSetup(uint8_t channel, uint32_t freq, uint8_t resolution);
+void ledcAttachPin(uint8_t pin, uint8_t channel);
+void ledcWrite(uint8_t channel, uint32_t duty);
+uint32_t ledcChangeFrequency(uint8_t channel, uint32_t freq, uint8_t resolution);
+
+// Host only: drive analogRead(), observe LEDC output changes
+void hostSetAnalog(uint8_t pin, uint16_t value);
+void hostOnLedc(void (*hook)(uint8_t channel, uint32_t freq, uint32_t duty));
+
+// --- RMT (arduino-esp32 2.x API) ---
+typedef struct {
+    union {
+        struct {
+            uint32_t duration0 : 15;
+            uint32_t level0 : 1;
+            uint32_t duration1 : 15;
+            uint32_t level1 : 1;
+        };
+        uint32_t val;
+    };
+} rmt_data_t;
+
+typedef struct rmt_obj_s rmt_obj_t;
+
+typedef enum {
+    RMT_MEM_64 = 1, RMT_MEM_128, RMT_MEM_192, RMT_MEM_256,
+    RMT_MEM_320, RMT_MEM_384, RMT_MEM_448, RMT_MEM_512
+} rmt_reserve_memsize_t;
+
+rmt_obj_t* rmtInit(int pin, bool txNotRx, rmt_reserve_memsize_t memsize);
+float rmtSetTick(rmt_obj_t* rmt, float tick);
+bool rmtWrite(rmt_obj_t* rmt, rmt_data_t* data, size_t size);
+
+// Host only: observe frames handed to the RMT
+void hostOnRmtWrite(void (*hook)(const rmt_data_t* data, size_t size));
+
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+// --- Serial ---
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buf, size_t size);
+    size_t write(const char* str) { return write((const uint8_t*)str, strlen(str)); }
+    
+    size_t print(const char* str) { return write(str); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int n) { return printf("%d", n); }
+    size_t print(unsigned int n) { return printf("%u", n); }
+    size_t print(long n) { return printf("%ld", n); }
+    size_t print(unsigned long n) { return printf("%lu", n); }
+    size_t print(double n, int digits = 2) { return printf("%.*f", digits, n); }
+    
+    size_t println() { return write("\r\n"); }
+    template<typename T> size_t println(T value) { return print(value) + println(); }
+    size_t println(double n, int digits) { return print(n, digits) + println(); }
+    
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+};
+
+// Discards output and never receives, unless a peer is attached (host
+// only) - then writes go to the peer and reads come from it
+class HardwareSerial : public Stream {
+public:
+    HardwareSerial() : _peer(NULL) {}
+    void begin(unsigned long baud, uint32_t config = SERIAL_8N1, 
+               int8_t rxPin = -1, int8_t txPin = -1) {}
+    void end() {}
+    void updateBaudRate(unsigned long baud) {}
+    size_t write(uint8_t c) override { return _peer ? _peer->write(c) : 1; }
+    using Print::write;
+    int available() override { return _peer ? _peer->available() : 0; }
+    int read() override { return _peer ? _peer->read() : -1; }
+    void flush() {}
+    operator bool() const { return true; }
+    
+    void hostAttach(Stream* peer) { _peer = peer; }
+    
+private:
+    Stream* _peer;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial2;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,10 @@
+/*
+ * SPI.h - Host stand-in (the gauge only includes it for MCP_CAN)
+ */
+
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include "Arduino.h"
+
+#endif // HOST_SPI_H
@@ -0,0 +1,53 @@
+/*
+ * esp_partition.h - Host stand-in for the ESP-IDF partition API
+ * 
+ * One data partition of HOST_PARTITION_BYTES held in RAM, found under any
+ * type/subtype/label. It behaves like NOR flash: erase sets bytes to 0xFF
+ * and a write can only clear bits. hostPartitionImage() exposes the bytes
+ * so the simulation can save them for the host tools.
+ */
+
+#ifndef HOST_ESP_PARTITION_H
+#define HOST_ESP_PARTITION_H
+
+#include "Arduino.h"
+
+#define HOST_PARTITION_BYTES    0x10000
+#define SPI_FLASH_SEC_SIZE      4096
+
+typedef int esp_err_t;
+
+#define ESP_OK                  0
+#define ESP_ERR_INVALID_ARG     0x102
+#define ESP_ERR_INVALID_SIZE    0x104
+
+typedef enum {
+    ESP_PARTITION_TYPE_APP = 0x00,
+    ESP_PARTITION_TYPE_DATA = 0x01
+} esp_partition_type_t;
+
+typedef int esp_partition_subtype_t;
+
+typedef struct {
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    uint32_t address;
+    uint32_t size;
+    char label[17];
+    bool encrypted;
+} esp_partition_t;
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype,
+                                                const char* label);
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t offset,
+                             void* dst, size_t size);
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t offset,
+                              const void* src, size_t size);
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset,
+                                    size_t size);
+
+// Host only: the partition contents
+const uint8_t* hostPartitionImage(size_t* size);
+
+#endif // HOST_ESP_PARTITION_H
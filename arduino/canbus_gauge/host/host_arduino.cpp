@@ -0,0 +1,248 @@
+/*
+ * host_arduino.cpp - Minimal Arduino core for building the gauge on a host PC
+ */
+
+#include "Arduino.h"
+#include "mcp_can.h"
+#include "esp_partition.h"
+
+static uint32_t hostMillis = 0;
+static int hostPins[40];
+static bool hostPinsInit = false;
+
+static uint16_t hostAnalog[40];
+static void (*ledcHook)(uint8_t channel, uint32_t freq, uint32_t duty) = NULL;
+static uint32_t ledcFreq[16];
+static void (*rmtHook)(const rmt_data_t* data, size_t size) = NULL;
+static int rmtChannels = 0;
+
+static void (*canSendHook)(unsigned long id, uint8_t len, const uint8_t* data) = NULL;
+static bool canPending = false;
+static unsigned long canId = 0;
+static uint8_t canLen = 0;
+static uint8_t canData[8];
+
+static esp_partition_t hostPartition = {
+    ESP_PARTITION_TYPE_DATA, 0, 0, HOST_PARTITION_BYTES, "host", false
+};
+static uint8_t hostFlash[HOST_PARTITION_BYTES];
+static bool hostFlashInit = false;
+
+HardwareSerial Serial;
+HardwareSerial Serial2;
+
+uint32_t millis() {
+    return hostMillis;
+}
+
+uint32_t micros() {
+    return hostMillis * 1000;
+}
+
+void delay(uint32_t ms) {
+    hostMillis += ms;
+}
+
+void delayMicroseconds(uint32_t us) {
+}
+
+void hostAdvanceMillis(uint32_t ms) {
+    hostMillis += ms;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+}
+
+int digitalRead(uint8_t pin) {
+    // Inputs idle high (pull-ups, inactive interrupt lines)
+    if (!hostPinsInit) {
+        for (uint8_t i = 0; i < 40; i++) {
+            hostPins[i] = HIGH;
+        }
+        hostPinsInit = true;
+    }
+    return (pin < 40) ? hostPins[pin] : HIGH;
+}
+
+void hostSetPin(uint8_t pin, int val) {
+    digitalRead(0);
+    if (pin < 40) {
+        hostPins[pin] = val;
+    }
+}
+
+uint16_t analogRead(uint8_t pin) {
+    return (pin < 40) ? hostAnalog[pin] : 0;
+}
+
+void analogReadResolution(uint8_t bits) {
+}
+
+void analogSetAttenuation(uint8_t attenuation) {
+}
+
+void hostSetAnalog(uint8_t pin, uint16_t value) {
+    if (pin < 40) {
+        hostAnalog[pin] = value;
+    }
+}
+
+uint32_t ledcSetup(uint8_t channel, uint32_t freq, uint8_t resolution) {
+    if (channel < 16) {
+        ledcFreq[channel] = freq;
+    }
+    return freq;
+}
+
+void ledcAttachPin(uint8_t pin, uint8_t channel) {
+}
+
+void ledcWrite(uint8_t channel, uint32_t duty) {
+    if (ledcHook != NULL && channel < 16) {
+        ledcHook(channel, ledcFreq[channel], duty);
+    }
+}
+
+uint32_t ledcChangeFrequency(uint8_t channel, uint32_t freq, uint8_t resolution) {
+    if (channel < 16) {
+        ledcFreq[channel] = freq;
+    }
+    return freq;
+}
+
+void hostOnLedc(void (*hook)(uint8_t channel, uint32_t freq, uint32_t duty)) {
+    ledcHook = hook;
+}
+
+// Any non-NULL handle will do - it is only compared and passed back
+rmt_obj_t* rmtInit(int pin, bool txNotRx, rmt_reserve_memsize_t memsize) {
+    static char channels[8];
+    if (rmtChannels >= 8) {
+        return NULL;
+    }
+    return (rmt_obj_t*)&channels[rmtChannels++];
+}
+
+float rmtSetTick(rmt_obj_t* rmt, float tick) {
+    return tick;
+}
+
+bool rmtWrite(rmt_obj_t* rmt, rmt_data_t* data, size_t size) {
+    if (rmtHook != NULL) {
+        rmtHook(data, size);
+    }
+    return true;
+}
+
+void hostOnRmtWrite(void (*hook)(const rmt_data_t* data, size_t size)) {
+    rmtHook = hook;
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+size_t Print::write(const uint8_t* buf, size_t size) {
+    size_t n = 0;
+    while (size--) {
+        n += write(*buf++);
+    }
+    return n;
+}
+
+size_t Print::printf(const char* format, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (len < 0) {
+        return 0;
+    }
+    return write((const uint8_t*)buf, min((size_t)len, sizeof(buf) - 1));
+}
+
+void hostOnCanSend(void (*hook)(unsigned long id, uint8_t len, const uint8_t* data)) {
+    canSendHook = hook;
+}
+
+void hostCanSent(unsigned long id, uint8_t len, const uint8_t* data) {
+    if (canSendHook != NULL) {
+        canSendHook(id, len, data);
+    }
+}
+
+void hostCanReceive(unsigned long id, uint8_t len, const uint8_t* data) {
+    canId = id;
+    canLen = min(len, (uint8_t)8);
+    memcpy(canData, data, canLen);
+    canPending = true;
+}
+
+bool hostCanPending() {
+    return canPending;
+}
+
+bool hostCanTake(unsigned long* id, uint8_t* len, uint8_t* data) {
+    if (!canPending) {
+        return false;
+    }
+    *id = canId;
+    *len = canLen;
+    memcpy(data, canData, canLen);
+    canPending = false;
+    return true;
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype,
+                                                const char* label) {
+    // Fresh flash reads as erased
+    if (!hostFlashInit) {
+        memset(hostFlash, 0xFF, sizeof(hostFlash));
+        hostFlashInit = true;
+    }
+    return &hostPartition;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t offset,
+                             void* dst, size_t size) {
+    if (offset + size > HOST_PARTITION_BYTES) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(dst, &hostFlash[offset], size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t offset,
+                              const void* src, size_t size) {
+    if (offset + size > HOST_PARTITION_BYTES) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    // NOR flash: programming only clears bits
+    const uint8_t* bytes = (const uint8_t*)src;
+    for (size_t i = 0; i < size; i++) {
+        hostFlash[offset + i] &= bytes[i];
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset,
+                                    size_t size) {
+    if (offset % SPI_FLASH_SEC_SIZE != 0 || size % SPI_FLASH_SEC_SIZE != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (offset + size > HOST_PARTITION_BYTES) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memset(&hostFlash[offset], 0xFF, size);
+    return ESP_OK;
+}
+
+const uint8_t* hostPartitionImage(size_t* size) {
+    *size = HOST_PARTITION_BYTES;
+    return hostFlash;
+}
@@ -0,0 +1,59 @@
+/*
+ * mcp_can.h - Host stand-in for the coryjfowler MCP_CAN library
+ * 
+ * No bus: begin() always succeeds, sent frames go to the hostOnCanSend()
+ * hook (if any), and a frame passed to hostCanReceive() is returned by the
+ * next readMsgBuf().
+ */
+
+#ifndef HOST_MCP_CAN_H
+#define HOST_MCP_CAN_H
+
+#include "Arduino.h"
+
+#define CAN_OK          0
+#define CAN_FAILINIT    1
+#define CAN_MSGAVAIL    3
+#define CAN_NOMSG       4
+
+#define MCP_ANY         0
+#define MCP_STD         1
+#define MCP_STDEXT      3
+#define MCP_NORMAL      0x00
+#define MCP_SLEEP       0x20
+#define MCP_LOOPBACK    0x40
+#define MCP_LISTENONLY  0x60
+
+#define MCP_8MHZ        1
+#define MCP_16MHZ       2
+#define CAN_500KBPS     15
+
+// Host only: make one frame available to the next readMsgBuf() of any
+// MCP_CAN instance (the sketch owns its controller privately)
+void hostOnCanSend(void (*hook)(unsigned long id, uint8_t len, const uint8_t* data));
+void hostCanSent(unsigned long id, uint8_t len, const uint8_t* data);
+void hostCanReceive(unsigned long id, uint8_t len, const uint8_t* data);
+bool hostCanPending();
+bool hostCanTake(unsigned long* id, uint8_t* len, uint8_t* data);
+
+class MCP_CAN {
+public:
+    MCP_CAN(uint8_t csPin) {}
+    
+    uint8_t begin(uint8_t idMode, uint8_t speed, uint8_t clock) { return CAN_OK; }
+    uint8_t setMode(uint8_t mode) { return CAN_OK; }
+    uint8_t init_Mask(uint8_t num, uint8_t ext, unsigned long data) { return CAN_OK; }
+    uint8_t init_Filt(uint8_t num, uint8_t ext, unsigned long data) { return CAN_OK; }
+    uint8_t sendMsgBuf(unsigned long id, uint8_t ext, uint8_t len, uint8_t* buf) {
+        hostCanSent(id, len, buf);
+        return CAN_OK;
+    }
+    
+    uint8_t checkReceive() { return hostCanPending() ? CAN_MSGAVAIL : CAN_NOMSG; }
+    
+    uint8_t readMsgBuf(unsigned long* id, uint8_t* len, uint8_t* buf) {
+        return hostCanTake(id, len, buf) ? CAN_OK : CAN_NOMSG;
+    }
+};
+
+#endif // HOST_MCP_CAN_H
@@ -85,11 +85,11 @@
  * │  │        4500 RPM         │    │        65 MPH           │           │
  * │  └─────────────────────────┘    └─────────────────────────┘           │
  * │                                                                        │
- * │  ┌───────────────┐    ┌───────────────┐                               │
- * │  │  WATER TEMP   │    │  OIL PRESS    │                               │
- * │  │  [Prog Bar]   │    │  [Prog Bar]   │                               │
- * │  │   195°F  ✓    │    │   55 PSI  ✓   │                               │
- * │  └───────────────┘    └───────────────┘                               │
+ * │  ┌───────────────┐    ┌───────────────┐    ┌─────────────────────────┐│
+ * │  │  WATER TEMP   │    │  OIL PRESS    │    │  OIL / RPM TREND        ││
+ * │  │  [Prog Bar]   │    │  [Prog Bar]   │    │  [Waveform]  ~~~~~~     ││
+ * │  │   195°F  ✓    │    │   55 PSI  ✓   │    │              ~~~~~~     ││
+ * │  └───────────────┘    └───────────────┘    └─────────────────────────┘│
  * │                                                                        │
  * │  ╔═══════════════════════════════════════════════════════════════╗    │
  * │  ║                    SHIFT! (overlay)                            ║    │
@@ -274,6 +274,81 @@
  *    - xcen: 1
  *    - ycen: 1
  *    - vis: 0 (hidden by default)
+ * 
+ * ---------- STRIP CHART ----------
+ * 
+ * 20. Trend Label (t13)
+ *    - objname: trace_label
+ *    - x: 430, y: 230
+ *    - w: 350, h: 25
+ *    - txt: "OIL / RPM TREND"
+ *    - pco: White
+ *    - font: Small
+ * 
+ * 21. Trend Waveform (s0)
+ *    - objname: oil_trace
+ *    - Type: Waveform
+ *    - id: 21 (must match NextionID::OIL_TRACE_ID - addt uses the id)
+ *    - x: 430, y: 260
+ *    - w: 350, h: 140 (h must match TRACE_HEIGHT in config.h)
+ *    - ch: 2
+ *    - bco: Black (0x0000)
+ *    - gdc: Dark Gray (0x4208)  - grid
+ *    - gdw: 50, gdh: 35         - grid spacing
+ *    - pco0: Cyan (0x07FF)      - channel 0: oil pressure (0-100 PSI)
+ *    - pco1: Light Gray (0xC618) - channel 1: RPM (0-8000)
+ *    - At 50 Hz the 350px trace shows the last 7 seconds
+ * 
+ * ---------- PAGE BUTTON ----------
+ * 
+ * 22. Page Hotspot (m0)
+ *    - objname: page_btn
+ *    - Type: Hotspot
+ *    - id: 22 (must match NextionID::PAGE_BUTTON_MAIN_ID)
+ *    - x: 700, y: 0
+ *    - w: 100, h: 60
+ *    - Touch Release Event: check "Send Component ID"
+ * 
+ * VSCOPE: set vscope = global on every component the ESP32 writes
+ * (values, progress bars, colors). Global components keep their last
+ * value while another page is shown, so a page flip only resends what
+ * changed. vis is never kept - overlays come back hidden.
+ */
+
+// =============================================================================
+// PAGE 2: DIAGNOSTICS PAGE (page name: "diag")
+// =============================================================================
+/*
+ * Background: Black (0x0000)
+ * 
+ * LAYOUT OVERVIEW (800x480):
+ * ┌────────────────────────────────────────────────────────────────────────┐
+ * │  DIAGNOSTICS                                                  [page]  │
+ * │                                                                        │
+ * │  OBD RATE        12 /s          OIL SENDER      1840 mV               │
+ * │  CAN ERRORS       0             PAGE FLIP         18 ms               │
+ * │  LINK ERRORS      0             UPTIME           935 s                │
+ * └────────────────────────────────────────────────────────────────────────┘
+ * 
+ * COMPONENTS (create in this order so the ids match):
+ * 
+ * 1. Page Hotspot (m0)
+ *    - objname: page_btn
+ *    - id: 1 (must match NextionID::PAGE_BUTTON_DIAG_ID)
+ *    - x: 700, y: 0, w: 100, h: 60
+ *    - Touch Release Event: check "Send Component ID"
+ * 
+ * 2. Title (t0): txt "DIAGNOSTICS", x: 20, y: 10, font: Medium
+ * 
+ * 3-8. Value texts (vscope global, font: Large, pco: White, w: 150, h: 50):
+ *    - obd_rate  x: 220, y: 100   (label "OBD RATE" at x: 20)
+ *    - can_err   x: 220, y: 180   (label "CAN ERRORS")
+ *    - link_err  x: 220, y: 260   (label "LINK ERRORS")
+ *    - oil_mv    x: 620, y: 100   (label "OIL SENDER" at x: 420)
+ *    - flip_ms   x: 620, y: 180   (label "PAGE FLIP")
+ *    - uptime    x: 620, y: 260   (label "UPTIME")
+ *    Labels are plain text components (font: Small, pco: Light Gray)
+ *    added after the value texts.
  */
 
 // =============================================================================
@@ -321,6 +396,10 @@
  *    - Add all components as specified above
  *    - Set vis=0 for shift_box, shift_txt, alert_box, alert_txt
  * 
+ * 5b. Create Page 2 (diag):
+ *    - Add new page, rename to "diag"
+ *    - Add components as specified above (page_btn first)
+ * 
  * 6. Import/Create Fonts:
  *    - Tools -> Font Generator
  *    - Create fonts at various sizes
@@ -383,4 +462,13 @@
  * 
  * Set background color:
  *   alert_box.bco=65504\xFF\xFF\xFF   // 65504 = 0xFFE0 (yellow)
+ * 
+ * Waveform bulk transfer (strip chart):
+ *   addt 21,0,10\xFF\xFF\xFF         // id 21, channel 0, 10 bytes follow
+ *   <- 0xFE 0xFF 0xFF 0xFF            // display ready for raw data
+ *   -> 10 raw bytes (no terminator)   // one byte per point, 0..h
+ *   <- 0xFD 0xFF 0xFF 0xFF            // transfer complete
+ * 
+ *   Nothing else may be sent between addt and its raw data, or it
+ *   will be plotted as samples.
  */
@@ -9,6 +9,8 @@
 #define OBD_PIDS_H
 
 #include <stdint.h>
+#include <stddef.h>
+#include "config.h"
 
 // =============================================================================
 // OBD-II SERVICE MODES
@@ -19,6 +21,24 @@
 #define OBD_SERVICE_STORED_DTC      0x03    // Show stored DTCs
 #define OBD_SERVICE_CLEAR_DTC       0x04    // Clear DTCs
 #define OBD_SERVICE_VEHICLE_INFO    0x09    // Request vehicle information
+#define OBD_SERVICE_READ_DID        0x22    // UDS ReadDataByIdentifier (16-bit DIDs)
+
+#define OBD_POSITIVE_OFFSET         0x40    // Reply service = request + 0x40
+
+// =============================================================================
+// NEGATIVE RESPONSES (ISO 14229-1 / ISO 15765-4)
+// =============================================================================
+
+// A refused request comes back as [03, 7F, service, NRC] - no PID
+#define OBD_NEGATIVE_RESPONSE       0x7F
+
+#define NRC_GENERAL_REJECT          0x10    // Refused, no reason given
+#define NRC_SERVICE_NOT_SUPPORTED   0x11    // Service not supported
+#define NRC_SUBFUNCTION_NOT_SUPP    0x12    // PID not supported
+#define NRC_BUSY_REPEAT_REQUEST     0x21    // ECU busy - ask again, slower
+#define NRC_CONDITIONS_NOT_CORRECT  0x22    // Not available in the current state
+#define NRC_REQUEST_OUT_OF_RANGE    0x31    // PID out of range
+#define NRC_RESPONSE_PENDING        0x78    // Answer follows later
 
 // =============================================================================
 // OBD-II PARAMETER IDs (PIDs) - SERVICE 01
@@ -109,27 +129,46 @@
 #define PID_FUEL_INJECTION_TIMING   0x5D    // Fuel injection timing (°)
 #define PID_FUEL_RATE               0x5E    // Engine fuel rate (L/h)
 
+// =============================================================================
+// MANUFACTURER DIDs - SERVICE 22 (Honda/Acura ECM)
+// =============================================================================
+
+// DIDs are ECU specific and not published. These are placeholders: take
+// yours from a scan tool log of the ECM (request 0x7E0, reply 0x7E8), then
+// set OBD_DIDS_ENABLED in config.h. A DID
+// the ECM doesn't know is answered with requestOutOfRange and left alone
+// for OBD_PID_UNSUPPORTED_MS, so a wrong guess costs one query a minute.
+#define DID_VTEC_STATE              0x1131  // VTEC solenoid state (bit 0)
+#define DID_VTEC_MASK               0x01
+#define DID_OIL_TEMP                0x1135  // Engine oil temperature, °C + 40
+
 // =============================================================================
 // PID DATA STRUCTURES
 // =============================================================================
 
-// Structure to hold decoded OBD-II data
+// Decoded OBD-II data, kept in the SAE encoding (fixed point, no floats).
+// Unit conversion happens when a value is shown - see obd_units.h.
 typedef struct {
     uint16_t rpm;               // Engine RPM
-    uint8_t  speed_kmh;         // Vehicle speed in km/h
-    uint8_t  speed_mph;         // Vehicle speed in MPH
-    int16_t  coolant_temp_c;    // Coolant temp in Celsius
-    int16_t  coolant_temp_f;    // Coolant temp in Fahrenheit
-    uint8_t  throttle_pos;      // Throttle position %
-    uint8_t  engine_load;       // Engine load %
-    int16_t  intake_temp_c;     // Intake air temp Celsius
-    int16_t  oil_temp_c;        // Oil temp Celsius (if supported)
-    int16_t  oil_temp_f;        // Oil temp Fahrenheit
-    float    battery_voltage;   // Control module voltage
-    uint32_t run_time;          // Run time since start (seconds)
+    uint16_t battery_mv;        // Control module voltage, mV
+    uint16_t run_time;          // Run time since start (seconds)
+    uint8_t  speed_kmh;         // Vehicle speed, km/h
+    uint8_t  coolant_raw;       // Coolant temp, °C + 40
+    uint8_t  intake_raw;        // Intake air temp, °C + 40
+    uint8_t  oil_raw;           // Oil temp, °C + 40 (if supported)
+    uint8_t  throttle_raw;      // Throttle position, 255 = 100%
+    uint8_t  load_raw;          // Engine load, 255 = 100%
+    uint8_t  vtec;              // VTEC engaged (DID, 0/1)
     bool     valid;             // Data validity flag
 } OBDData_t;
 
+// A request: service 01 PID or service 22 DID
+typedef struct {
+    uint8_t  service;
+    uint16_t id;
+    uint16_t periodMs;          // Wanted refresh interval (0 = every free slot)
+} OBDRequest_t;
+
 // Structure for PID query/response
 typedef struct {
     uint8_t  pid;               // PID number
@@ -147,76 +186,91 @@ inline uint16_t calculateRPM(uint8_t a, uint8_t b) {
     return ((uint16_t)a * 256 + b) / 4;
 }
 
-// Calculate vehicle speed from OBD response byte A (returns km/h)
-// Formula: A (direct)
-inline uint8_t calculateSpeedKmh(uint8_t a) {
-    return a;
+// Two-byte values: (A * 256) + B
+// Control module voltage (mV), run time (s)
+inline uint16_t calculateWord(uint8_t a, uint8_t b) {
+    return (uint16_t)a * 256 + b;
 }
 
-// Convert km/h to MPH
-inline uint8_t calculateSpeedMph(uint8_t kmh) {
-    return (uint8_t)(kmh * 0.621371);
-}
-
-// Calculate coolant temperature from OBD response byte A (returns °C)
-// Formula: A - 40
-inline int16_t calculateCoolantTempC(uint8_t a) {
+// Temperatures (coolant, intake, oil) are A - 40 °C
+inline int16_t rawTempToC(uint8_t a) {
     return (int16_t)a - 40;
 }
 
-// Convert Celsius to Fahrenheit
-inline int16_t celsiusToFahrenheit(int16_t celsius) {
-    return (celsius * 9 / 5) + 32;
-}
+// Lowest A whose temperature rounds to at least f °F - a fixed °F
+// threshold as a raw byte. For f above freezing.
+#define TEMP_F_TO_RAW(f)        (40 + ((f) * 10 - 308) / 18)
 
-// Calculate throttle position from OBD response byte A (returns %)
-// Formula: A * 100 / 255
-inline uint8_t calculateThrottlePos(uint8_t a) {
-    return (uint8_t)((uint16_t)a * 100 / 255);
+// Percentages (throttle, load) are A * 100 / 255, rounded
+inline uint8_t rawToPercent(uint8_t a) {
+    return (uint8_t)(((uint16_t)a * 100 + 127) / 255);
 }
 
-// Calculate engine load from OBD response byte A (returns %)
-// Formula: A * 100 / 255
-inline uint8_t calculateEngineLoad(uint8_t a) {
-    return (uint8_t)((uint16_t)a * 100 / 255);
-}
+// =============================================================================
+// DECODE REGISTRY
+// =============================================================================
 
-// Calculate intake air temperature from OBD response byte A (returns °C)
-// Formula: A - 40
-inline int16_t calculateIntakeTempC(uint8_t a) {
-    return (int16_t)a - 40;
-}
+// How a reply's data bytes (A, B, ...) become an OBDData_t field
+typedef enum {
+    OBD_DECODE_BYTE = 0,        // uint8_t field = A
+    OBD_DECODE_WORD,            // uint16_t field = (A * 256) + B
+    OBD_DECODE_RPM,             // uint16_t field = ((A * 256) + B) / 4
+    OBD_DECODE_FLAG             // uint8_t field = (A & mask) != 0
+} OBDDecode_t;
 
-// Calculate oil temperature from OBD response byte A (returns °C)
-// Formula: A - 40
-inline int16_t calculateOilTempC(uint8_t a) {
-    return (int16_t)a - 40;
-}
+typedef struct {
+    uint8_t  service;           // Request service (01 or 22)
+    uint16_t id;                // PID or DID
+    uint8_t  decode;            // OBDDecode_t
+    uint8_t  offset;            // offsetof(OBDData_t, field)
+    uint8_t  mask;              // OBD_DECODE_FLAG only
+} OBDSignal_t;
+
+// Every signal the gauge understands. PIDs and DIDs go through the same
+// lookup and the same decoders, so a manufacturer signal costs no more to
+// decode than a standard one.
+static const OBDSignal_t OBD_SIGNALS[] = {
+    { OBD_SERVICE_CURRENT_DATA, PID_ENGINE_RPM,             OBD_DECODE_RPM,  offsetof(OBDData_t, rpm),          0 },
+    { OBD_SERVICE_CURRENT_DATA, PID_VEHICLE_SPEED,          OBD_DECODE_BYTE, offsetof(OBDData_t, speed_kmh),    0 },
+    { OBD_SERVICE_CURRENT_DATA, PID_COOLANT_TEMP,           OBD_DECODE_BYTE, offsetof(OBDData_t, coolant_raw),  0 },
+    { OBD_SERVICE_CURRENT_DATA, PID_THROTTLE_POSITION,      OBD_DECODE_BYTE, offsetof(OBDData_t, throttle_raw), 0 },
+    { OBD_SERVICE_CURRENT_DATA, PID_ENGINE_LOAD,            OBD_DECODE_BYTE, offsetof(OBDData_t, load_raw),     0 },
+    { OBD_SERVICE_CURRENT_DATA, PID_INTAKE_TEMP,            OBD_DECODE_BYTE, offsetof(OBDData_t, intake_raw),   0 },
+    { OBD_SERVICE_CURRENT_DATA, PID_OIL_TEMP,               OBD_DECODE_BYTE, offsetof(OBDData_t, oil_raw),      0 },
+    { OBD_SERVICE_CURRENT_DATA, PID_CONTROL_MODULE_VOLTAGE, OBD_DECODE_WORD, offsetof(OBDData_t, battery_mv),   0 },
+    { OBD_SERVICE_CURRENT_DATA, PID_RUN_TIME,               OBD_DECODE_WORD, offsetof(OBDData_t, run_time),     0 },
+    { OBD_SERVICE_READ_DID,     DID_VTEC_STATE,             OBD_DECODE_FLAG, offsetof(OBDData_t, vtec),         DID_VTEC_MASK },
+    { OBD_SERVICE_READ_DID,     DID_OIL_TEMP,               OBD_DECODE_BYTE, offsetof(OBDData_t, oil_raw),      0 },
+};
 
-// Calculate control module voltage from OBD response bytes A and B (returns V)
-// Formula: ((A * 256) + B) / 1000
-inline float calculateVoltage(uint8_t a, uint8_t b) {
-    return ((float)((uint16_t)a * 256 + b)) / 1000.0;
-}
+static const uint8_t NUM_OBD_SIGNALS = sizeof(OBD_SIGNALS) / sizeof(OBD_SIGNALS[0]);
 
-// Calculate run time from OBD response bytes A and B (returns seconds)
-// Formula: (A * 256) + B
-inline uint32_t calculateRunTime(uint8_t a, uint8_t b) {
-    return (uint32_t)a * 256 + b;
+// Data bytes a decoder reads
+inline uint8_t obdDecodeBytes(uint8_t decode) {
+    return (decode == OBD_DECODE_WORD || decode == OBD_DECODE_RPM) ? 2 : 1;
 }
 
 // =============================================================================
-// PID LIST FOR QUERIES
+// REQUEST SCHEDULE
 // =============================================================================
 
-// PIDs we want to query regularly (in order of priority)
-static const uint8_t QUERY_PIDS[] = {
-    PID_ENGINE_RPM,         // Most important - for shift light
-    PID_VEHICLE_SPEED,      // Speed display
-    PID_COOLANT_TEMP,       // Water temperature
-    // PID_OIL_TEMP,        // Uncomment if your vehicle supports it
+// What to poll and how fresh each value needs to be. Each poll slot (the
+// learned request rate) goes to the most overdue request, so RPM takes
+// every slot the slower values leave free. Add PID_OIL_TEMP here if your
+// vehicle supports it. The DIDs need the ECM to answer service 22 and the
+// right DID numbers - a reply to a wrong one would shift the oil alerts -
+// so they are only polled with OBD_DIDS_ENABLED.
+static const OBDRequest_t QUERY_LIST[] = {
+    { OBD_SERVICE_CURRENT_DATA, PID_ENGINE_RPM,        0    },    // Shift light - every free slot
+    { OBD_SERVICE_CURRENT_DATA, PID_VEHICLE_SPEED,     100  },    // Speed display
+    { OBD_SERVICE_CURRENT_DATA, PID_COOLANT_TEMP,      1000 },    // Water temperature
+    { OBD_SERVICE_CURRENT_DATA, PID_THROTTLE_POSITION, 100  },    // Crash recorder
+#if OBD_DIDS_ENABLED
+    { OBD_SERVICE_READ_DID,     DID_VTEC_STATE,        100  },
+    { OBD_SERVICE_READ_DID,     DID_OIL_TEMP,          1000 },
+#endif
 };
 
-static const uint8_t NUM_QUERY_PIDS = sizeof(QUERY_PIDS) / sizeof(QUERY_PIDS[0]);
+static const uint8_t NUM_QUERY_REQUESTS = sizeof(QUERY_LIST) / sizeof(QUERY_LIST[0]);
 
 #endif // OBD_PIDS_H
@@ -0,0 +1,45 @@
+/*
+ * obd_units.cpp - Display unit conversion tables
+ * 
+ * Generated: round(kmh * 0.621371), round((A - 40) * 9 / 5 + 32)
+ */
+
+#include "obd_units.h"
+
+const uint8_t KMH_TO_MPH_LUT[256] = {
+      0,   1,   1,   2,   2,   3,   4,   4,   5,   6,   6,   7,   7,   8,   9,   9,
+     10,  11,  11,  12,  12,  13,  14,  14,  15,  16,  16,  17,  17,  18,  19,  19,
+     20,  21,  21,  22,  22,  23,  24,  24,  25,  25,  26,  27,  27,  28,  29,  29,
+     30,  30,  31,  32,  32,  33,  34,  34,  35,  35,  36,  37,  37,  38,  39,  39,
+     40,  40,  41,  42,  42,  43,  43,  44,  45,  45,  46,  47,  47,  48,  48,  49,
+     50,  50,  51,  52,  52,  53,  53,  54,  55,  55,  56,  57,  57,  58,  58,  59,
+     60,  60,  61,  62,  62,  63,  63,  64,  65,  65,  66,  66,  67,  68,  68,  69,
+     70,  70,  71,  71,  72,  73,  73,  74,  75,  75,  76,  76,  77,  78,  78,  79,
+     80,  80,  81,  81,  82,  83,  83,  84,  85,  85,  86,  86,  87,  88,  88,  89,
+     89,  90,  91,  91,  92,  93,  93,  94,  94,  95,  96,  96,  97,  98,  98,  99,
+     99, 100, 101, 101, 102, 103, 103, 104, 104, 105, 106, 106, 107, 107, 108, 109,
+    109, 110, 111, 111, 112, 112, 113, 114, 114, 115, 116, 116, 117, 117, 118, 119,
+    119, 120, 121, 121, 122, 122, 123, 124, 124, 125, 126, 126, 127, 127, 128, 129,
+    129, 130, 130, 131, 132, 132, 133, 134, 134, 135, 135, 136, 137, 137, 138, 139,
+    139, 140, 140, 141, 142, 142, 143, 144, 144, 145, 145, 146, 147, 147, 148, 149,
+    149, 150, 150, 151, 152, 152, 153, 153, 154, 155, 155, 156, 157, 157, 158, 158,
+};
+
+const int16_t RAW_TEMP_TO_F_LUT[256] = {
+    -40, -38, -36, -35, -33, -31, -29, -27, -26, -24, -22, -20, -18, -17, -15, -13,
+    -11,  -9,  -8,  -6,  -4,  -2,   0,   1,   3,   5,   7,   9,  10,  12,  14,  16,
+     18,  19,  21,  23,  25,  27,  28,  30,  32,  34,  36,  37,  39,  41,  43,  45,
+     46,  48,  50,  52,  54,  55,  57,  59,  61,  63,  64,  66,  68,  70,  72,  73,
+     75,  77,  79,  81,  82,  84,  86,  88,  90,  91,  93,  95,  97,  99, 100, 102,
+    104, 106, 108, 109, 111, 113, 115, 117, 118, 120, 122, 124, 126, 127, 129, 131,
+    133, 135, 136, 138, 140, 142, 144, 145, 147, 149, 151, 153, 154, 156, 158, 160,
+    162, 163, 165, 167, 169, 171, 172, 174, 176, 178, 180, 181, 183, 185, 187, 189,
+    190, 192, 194, 196, 198, 199, 201, 203, 205, 207, 208, 210, 212, 214, 216, 217,
+    219, 221, 223, 225, 226, 228, 230, 232, 234, 235, 237, 239, 241, 243, 244, 246,
+    248, 250, 252, 253, 255, 257, 259, 261, 262, 264, 266, 268, 270, 271, 273, 275,
+    277, 279, 280, 282, 284, 286, 288, 289, 291, 293, 295, 297, 298, 300, 302, 304,
+    306, 307, 309, 311, 313, 315, 316, 318, 320, 322, 324, 325, 327, 329, 331, 333,
+    334, 336, 338, 340, 342, 343, 345, 347, 349, 351, 352, 354, 356, 358, 360, 361,
+    363, 365, 367, 369, 370, 372, 374, 376, 378, 379, 381, 383, 385, 387, 388, 390,
+    392, 394, 396, 397, 399, 401, 403, 405, 406, 408, 410, 412, 414, 415, 417, 419,
+};
@@ -0,0 +1,49 @@
+/*
+ * obd_units.h - Display unit conversion for decoded OBD-II values
+ * 
+ * OBDData_t keeps the SAE encoding; values are converted only where they
+ * are shown, through 256-entry tables indexed by the raw byte (one load,
+ * no multiply or divide). SPEED_UNIT_MPH and TEMP_UNIT_F pick the tables.
+ */
+
+#ifndef OBD_UNITS_H
+#define OBD_UNITS_H
+
+#include <stdint.h>
+#include "config.h"
+#include "obd_pids.h"
+
+// Rounded to the nearest whole unit
+extern const uint8_t KMH_TO_MPH_LUT[256];       // km/h -> MPH
+extern const int16_t RAW_TEMP_TO_F_LUT[256];    // A (°C + 40) -> °F
+
+// Speed in the display unit
+inline uint8_t obdSpeed(uint8_t kmh) {
+#if SPEED_UNIT_MPH
+    return KMH_TO_MPH_LUT[kmh];
+#else
+    return kmh;
+#endif
+}
+
+// Coolant / intake / oil temp in the display unit
+inline int16_t obdTemp(uint8_t raw) {
+#if TEMP_UNIT_F
+    return RAW_TEMP_TO_F_LUT[raw];
+#else
+    return rawTempToC(raw);
+#endif
+}
+
+// A °F constant (scale end, threshold) in the display unit
+#if TEMP_UNIT_F
+#define TEMP_F_TO_DISPLAY(f)    (f)
+#else
+#define TEMP_F_TO_DISPLAY(f)    (TEMP_F_TO_RAW(f) - 40)
+#endif
+
+inline float obdBatteryVolts(const OBDData_t& data) {
+    return data.battery_mv / 1000.0f;
+}
+
+#endif // OBD_UNITS_H
@@ -0,0 +1,203 @@
+/*
+ * power_manager.cpp - Engine-off low-power mode implementation
+ */
+
+#include "power_manager.h"
+
+#ifdef ESP32
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#include <driver/gpio.h>
+#endif
+
+PowerManager::PowerManager() {
+    _mode = POWER_FULL;
+    _lastActive = 0;
+    _responses = 0;
+    _modeSince = 0;
+    _sleepUs = 0;
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+void PowerManager::begin(uint32_t now) {
+    _lastActive = now;
+    _modeSince = now;
+}
+
+bool PowerManager::update(uint16_t rpm, uint32_t responses, uint32_t now) {
+    // Running = a fresh OBD reply with nonzero RPM. A silent bus brings no
+    // fresh replies, so a stale RPM can't hold full power.
+    if (responses != _responses) {
+        _responses = responses;
+        if (rpm > 0) {
+            _lastActive = now;
+            if (_mode == POWER_LOW) {
+                setMode(POWER_FULL, now);
+                return true;
+            }
+        }
+    }
+    
+    #if POWER_SAVE_ENABLED
+    if (_mode == POWER_FULL && now - _lastActive >= POWER_IDLE_ENTER_MS) {
+        setMode(POWER_LOW, now);
+        return true;
+    }
+    #endif
+    
+    return false;
+}
+
+void PowerManager::wake(uint32_t now) {
+    _lastActive = now;
+    if (_mode == POWER_LOW) {
+        setMode(POWER_FULL, now);
+    }
+}
+
+bool PowerManager::isLowPower() {
+    return _mode == POWER_LOW;
+}
+
+uint32_t PowerManager::period(uint32_t fullMs, uint32_t lowMs) {
+    return (_mode == POWER_LOW) ? lowMs : fullMs;
+}
+
+uint8_t PowerManager::brightness() {
+    return (_mode == POWER_LOW) ? POWER_LOW_DIM_PCT : POWER_FULL_DIM_PCT;
+}
+
+void PowerManager::setMode(PowerMode_t mode, uint32_t now) {
+    if (_mode == POWER_FULL) {
+        _stats.fullMs += now - _modeSince;
+    } else {
+        _stats.lowMs += now - _modeSince;
+    }
+    _mode = mode;
+    _modeSince = now;
+    
+    if (mode == POWER_LOW) {
+        _stats.lowEntries++;
+    }
+    
+    #ifdef ESP32
+    // APB stays at 80 MHz at either speed, so UART baud and SPI clocks hold
+    setCpuFrequencyMhz(mode == POWER_LOW ? POWER_LOW_CPU_MHZ : POWER_FULL_CPU_MHZ);
+    #endif
+    
+    #if DEBUG_ENABLED
+    Serial.printf("Power: %s\n", mode == POWER_LOW ? "engine off, low power" : "full");
+    #endif
+}
+
+bool PowerManager::sleepUntil(uint32_t deadline, uint32_t now) {
+    if (_mode != POWER_LOW || (int32_t)(deadline - now) < POWER_MIN_SLEEP_MS) {
+        return false;
+    }
+    
+    #ifdef ESP32
+    esp_sleep_enable_timer_wakeup((uint64_t)(deadline - now) * 1000);
+    
+    // Level wakeups: an interrupt already pending wakes us straight away.
+    // UART2 can't wake light sleep on the classic ESP32, so a touch wakes
+    // us through the Nextion RX pin instead - it idles high and the start
+    // bit of the touch event pulls it low.
+    esp_err_t err = gpio_wakeup_enable((gpio_num_t)CAN_INT_PIN, GPIO_INTR_LOW_LEVEL);
+    #if PAGE_BUTTON_ENABLED
+    if (err == ESP_OK) {
+        err = gpio_wakeup_enable((gpio_num_t)PAGE_BUTTON_PIN, GPIO_INTR_LOW_LEVEL);
+    }
+    #endif
+    if (err == ESP_OK) {
+        err = gpio_wakeup_enable((gpio_num_t)NEXTION_RX_PIN, GPIO_INTR_LOW_LEVEL);
+    }
+    if (err == ESP_OK) {
+        err = esp_sleep_enable_gpio_wakeup();
+    }
+    if (err != ESP_OK) {
+        // The timer still bounds the sleep; only the early wakes are lost
+        #if DEBUG_ENABLED
+        if (_stats.wakeErrors == 0) {
+            Serial.printf("Power: GPIO wakeup not armed (err 0x%x)\n", err);
+        }
+        #endif
+        _stats.wakeErrors++;
+    }
+    
+    int64_t start = esp_timer_get_time();
+    esp_light_sleep_start();
+    _sleepUs += esp_timer_get_time() - start;
+    
+    // Back to a plain UART input, no wake level type
+    gpio_wakeup_disable((gpio_num_t)NEXTION_RX_PIN);
+    
+    switch (esp_sleep_get_wakeup_cause()) {
+        case ESP_SLEEP_WAKEUP_TIMER:
+            _stats.wakeTimer++;
+            break;
+        case ESP_SLEEP_WAKEUP_GPIO:
+            // One cause for all three pins. The RX start bit is long gone
+            // by now, so it was a touch if the other two are still idle.
+            if (digitalRead(CAN_INT_PIN) == LOW) {
+                _stats.wakeGpio++;
+                break;
+            }
+            #if PAGE_BUTTON_ENABLED
+            if (digitalRead(PAGE_BUTTON_PIN) == LOW) {
+                _stats.wakeGpio++;
+                break;
+            }
+            #endif
+            // The bytes before the wake are lost, so the touch event never
+            // arrives whole - the wake itself counts as the touch
+            _stats.wakeTouch++;
+            return true;
+        default:
+            break;
+    }
+    #endif
+    
+    return false;
+}
+
+uint32_t PowerManager::nextDeadline(uint32_t now) {
+    #if POWER_SAVE_ENABLED
+    if (_mode == POWER_FULL) {
+        return _lastActive + POWER_IDLE_ENTER_MS;
+    }
+    #endif
+    return now + CLOCK_IDLE_MS;
+}
+
+PowerStats_t PowerManager::getStats(uint32_t now) {
+    PowerStats_t stats = _stats;
+    stats.mode = _mode;
+    if (_mode == POWER_FULL) {
+        stats.fullMs += now - _modeSince;
+    } else {
+        stats.lowMs += now - _modeSince;
+    }
+    stats.sleepMs = (uint32_t)(_sleepUs / 1000);
+    
+    uint32_t displayFullMa = (uint32_t)POWER_DISPLAY_MA * POWER_FULL_DIM_PCT / 100;
+    uint32_t displayLowMa = (uint32_t)POWER_DISPLAY_MA * POWER_LOW_DIM_PCT / 100;
+    stats.fullMa = POWER_FULL_MA + displayFullMa;
+    
+    // Low power: awake at the low clock or asleep, in the measured ratio
+    uint32_t asleepMs = min(stats.sleepMs, stats.lowMs);
+    uint32_t lowEsp32Ma = POWER_LOW_AWAKE_MA;
+    if (stats.lowMs > 0) {
+        lowEsp32Ma = (uint32_t)(((uint64_t)POWER_LOW_AWAKE_MA * (stats.lowMs - asleepMs) +
+                                 (uint64_t)POWER_SLEEP_MA * asleepMs) / stats.lowMs);
+    }
+    stats.lowMa = lowEsp32Ma + displayLowMa;
+    
+    uint32_t totalMs = stats.fullMs + stats.lowMs;
+    stats.averageMa = stats.fullMa;
+    if (totalMs > 0) {
+        stats.averageMa = (uint16_t)(((uint64_t)stats.fullMa * stats.fullMs +
+                                      (uint64_t)stats.lowMa * stats.lowMs) / totalMs);
+    }
+    
+    return stats;
+}
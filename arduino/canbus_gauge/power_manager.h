@@ -0,0 +1,97 @@
+/*
+ * power_manager.h - Engine-off low-power mode
+ *
+ * With the ignition on and the engine off (paddock, pit lane) nothing on
+ * the gauge changes, but running the full loop at 240 MHz with the display
+ * at full brightness still drains the battery. Once the engine has been off
+ * for POWER_IDLE_ENTER_MS - RPM 0, or no OBD replies at all - the CPU drops
+ * to POWER_LOW_CPU_MHZ and loop() light-sleeps until its next deadline.
+ *
+ * Wake sources while asleep: the MCP2515 interrupt (an OBD reply), the page
+ * button, and a low level on the Nextion RX pin (a touch - the UART itself
+ * can't wake light sleep on the classic ESP32). A reply with
+ * nonzero RPM returns to full power in the same loop pass, so cranking is
+ * caught within one low-power poll and the next display frame goes out at
+ * full rate. A touch or button press counts as activity and holds full
+ * power for another POWER_IDLE_ENTER_MS.
+ *
+ * On the host (sim/) nothing sleeps - the simulation already jumps from
+ * deadline to deadline - but mode changes and the time accounting behave
+ * the same.
+ */
+
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "clock.h"
+
+typedef enum {
+    POWER_FULL = 0,
+    POWER_LOW
+} PowerMode_t;
+
+// Time per mode and wake causes, for the current draw report
+typedef struct {
+    PowerMode_t mode;
+    uint32_t fullMs;            // Time at full power
+    uint32_t lowMs;             // Time in low power, awake or asleep
+    uint32_t sleepMs;           // Part of lowMs spent in light sleep (device only)
+    uint32_t lowEntries;        // Times low power was entered
+    uint32_t wakeTimer;         // Light sleep ended by the next deadline
+    uint32_t wakeGpio;          // ... by the MCP2515 interrupt or page button
+    uint32_t wakeTouch;         // ... by the Nextion RX pin (CAN and button idle)
+    uint32_t wakeErrors;        // Sleeps with the GPIO wakeups not armed (timer only)
+    
+    // Estimated draw (ESP32 + display, POWER_*_MA): each mode, and the
+    // average so far
+    uint16_t fullMa;
+    uint16_t lowMa;             // From the measured sleep share (awake share on the host)
+    uint16_t averageMa;
+} PowerStats_t;
+
+class PowerManager {
+public:
+    PowerManager();
+    
+    // Start at full power (call in setup())
+    void begin(uint32_t now);
+    
+    // Feed the latest RPM and the OBD response count every loop. Switches
+    // mode when due; returns true if it changed.
+    bool update(uint16_t rpm, uint32_t responses, uint32_t now);
+    
+    // User activity (touch, button): full power, restart the idle timer
+    void wake(uint32_t now);
+    
+    bool isLowPower();
+    
+    // Loop period for the current mode
+    uint32_t period(uint32_t fullMs, uint32_t lowMs);
+    
+    // Display backlight for the current mode (%)
+    uint8_t brightness();
+    
+    // Light-sleep until deadline or a wake source (low power only, device only).
+    // Returns true if the wake was a touch, which counts as activity.
+    bool sleepUntil(uint32_t deadline, uint32_t now);
+    
+    // When low power would be entered if nothing happens
+    uint32_t nextDeadline(uint32_t now);
+    
+    // Time accounting and current estimates up to now
+    PowerStats_t getStats(uint32_t now);
+
+private:
+    PowerMode_t _mode;
+    uint32_t _lastActive;       // Last nonzero RPM reply, wake or boot
+    uint32_t _responses;        // OBD response count last seen
+    uint32_t _modeSince;        // When the current mode started
+    uint64_t _sleepUs;
+    PowerStats_t _stats;
+    
+    void setMode(PowerMode_t mode, uint32_t now);
+};
+
+#endif // POWER_MANAGER_H
@@ -14,17 +14,22 @@ SensorHandler::SensorHandler() {
 }
 
 void SensorHandler::begin() {
-    // Configure ADC
-    analogReadResolution(12);  // 12-bit resolution (0-4095)
-    analogSetAttenuation(ADC_11db);  // Full range: 0-3.3V
-    
     // Configure oil pressure pin
     pinMode(OIL_PRESSURE_PIN, INPUT);
     
+    // Scan the analog inputs in the background (DMA on the ESP32).
+    // The sensor is behind the voltage divider, so scale by its ratio.
+    static const AdcScanChannel_t channels[] = {
+        { OIL_PRESSURE_PIN, OIL_OVERSAMPLE_LOG2, VOLTAGE_DIVIDER_RATIO },
+    };
+    if (!_adc.begin(channels, sizeof(channels) / sizeof(channels[0]))) {
+        Serial.println("ERROR: ADC scan failed to start");
+    }
+    
     // Take a few readings to stabilize
     for (int i = 0; i < 10; i++) {
         readOilPressure();
-        delay(10);
+        clockDelay(10);
     }
     
     #if DEBUG_ENABLED
@@ -47,48 +52,33 @@ void SensorHandler::update() {
     
     #if DEBUG_SENSOR_VALUES
     static uint32_t lastPrint = 0;
-    if (millis() - lastPrint > 1000) {  // Print every second
-        Serial.printf("Oil Pressure: %.1f PSI (%.2fV) %s\n", 
+    if (clockMillis() - lastPrint > 1000) {  // Print every second
+        Serial.printf("Oil Pressure: %.1f PSI (%.2fV) %s, ADC overruns %lu\n", 
                      _sensorData.oilPressurePsi,
                      _sensorData.oilPressureRaw,
-                     _sensorData.oilPressureValid ? "OK" : "INVALID");
-        lastPrint = millis();
+                     _sensorData.oilPressureValid ? "OK" : "INVALID",
+                     (unsigned long)_adc.overruns());
+        lastPrint = clockMillis();
     }
     #endif
 }
 
 float SensorHandler::readOilPressure() {
-    // Read ADC multiple times and average for noise reduction
-    int sum = 0;
-    const int samples = 4;
-    
-    for (int i = 0; i < samples; i++) {
-        sum += analogRead(OIL_PRESSURE_PIN);
+    // Latest oversampled, calibrated reading - no waiting on the ADC.
+    // (poll() only does work on the host, where there is no DMA.)
+    _adc.poll();
+    AdcReading_t reading;
+    if (!_adc.read(ADC_CH_OIL, &reading)) {
+        _sensorData.oilPressureRaw = 0;     // Not ready yet: reads as invalid
+        return 0;
     }
-    int adcValue = sum / samples;
-    
-    // Convert to voltage (accounting for voltage divider)
-    float voltage = adcToVoltage(adcValue);
+    float voltage = reading.volts;
     _sensorData.oilPressureRaw = voltage;
     
     // Convert voltage to PSI
     return voltageToPsi(voltage);
 }
 
-float SensorHandler::adcToVoltage(int adcValue) {
-    // Convert ADC value to voltage
-    // ADC reads 0-3.3V as 0-4095
-    float voltage = (float)adcValue / ADC_RESOLUTION * ADC_VREF;
-    
-    // Account for voltage divider if used
-    // If using a divider to scale 5V to 3.3V, multiply back
-    #if VOLTAGE_DIVIDER_RATIO > 1.0
-    voltage *= VOLTAGE_DIVIDER_RATIO;
-    #endif
-    
-    return voltage;
-}
-
 float SensorHandler::voltageToPsi(float voltage) {
     // Linear interpolation from voltage to PSI
     // Typical 0-5V sender: 0.5V = 0 PSI, 4.5V = 100 PSI
@@ -8,7 +8,9 @@
 #define SENSORS_H
 
 #include <Arduino.h>
+#include <AdcScan.h>
 #include "config.h"
+#include "clock.h"
 
 // Moving average filter template
 template<typename T, int SIZE>
@@ -83,12 +85,13 @@ private:
     // Moving average filters
     MovingAverage<float, OIL_SMOOTHING_SAMPLES> _oilFilter;
     
+    // Background ADC scan; table index of each input
+    AdcScan _adc;
+    static const uint8_t ADC_CH_OIL = 0;
+    
     // Read oil pressure sensor
     float readOilPressure();
     
-    // Convert ADC reading to voltage
-    float adcToVoltage(int adcValue);
-    
     // Convert voltage to PSI
     float voltageToPsi(float voltage);
 };
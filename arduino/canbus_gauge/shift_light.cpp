@@ -0,0 +1,196 @@
+/*
+ * shift_light.cpp - Addressable LED shift light bar implementation
+ */
+
+#include "shift_light.h"
+
+// WS2812B / SK6812 bit timing in 100ns RMT ticks. These values sit inside
+// the tolerance of both parts:
+//   0 bit: 0.4us high, 0.9us low    1 bit: 0.7us high, 0.6us low
+#define LED_TICK_NS     100
+#define LED_T0H         4
+#define LED_T0L         9
+#define LED_T1H         7
+#define LED_T1L         6
+
+// Pattern ids beyond "N LEDs lit"
+#define PATTERN_FLASH_ON    (SHIFT_LIGHT_LEDS + 1)
+#define PATTERN_FLASH_OFF   (SHIFT_LIGHT_LEDS + 2)
+#define PATTERN_NONE        0xFF
+
+ShiftLight::ShiftLight(uint8_t pin) {
+    _pin = pin;
+    _rmt = NULL;
+    memset(_items, 0, sizeof(_items));
+    setShiftRPM(SHIFT_RPM, SHIFT_WARNING_RPM);
+    
+    _lit = 0;
+    _shown = PATTERN_NONE;
+    _pending = false;
+    _lastFrame = 0;
+    _frames = 0;
+}
+
+bool ShiftLight::begin() {
+    // Enough RMT RAM for a whole frame, so the RMT never needs the CPU to
+    // refill it mid-frame
+    _rmt = rmtInit(_pin, true, RMT_MEM_256);
+    if (_rmt == NULL) {
+        #if DEBUG_ENABLED
+        Serial.println("Shift light: no free RMT channel");
+        #endif
+        return false;
+    }
+    
+    rmtSetTick(_rmt, LED_TICK_NS);
+    
+    #if DEBUG_ENABLED
+    Serial.printf("Shift light: %d LEDs on GPIO%d, %d-%d RPM\n",
+                  SHIFT_LIGHT_LEDS, _pin, _thresholds[0], _shiftRpm);
+    #endif
+    
+    clear();
+    return true;
+}
+
+void ShiftLight::update(uint16_t rpm) {
+    if (_rmt == NULL) {
+        return;
+    }
+    
+    uint8_t pattern = patternFor(rpm);
+    if (pattern == _shown && !_pending) {
+        return;
+    }
+    
+    // Keep frames apart so the strip sees the >280us latch gap; a change
+    // inside the gap goes out on the next call
+    uint32_t now = clockMillis();
+    if (_frames > 0 && now - _lastFrame < SHIFT_LIGHT_FRAME_MS) {
+        _pending = (pattern != _shown);
+        return;
+    }
+    
+    _pending = false;
+    if (pattern != _shown) {
+        sendPattern(pattern);
+        _lastFrame = now;
+    }
+}
+
+void ShiftLight::setShiftRPM(uint16_t shiftRpm, uint16_t warnRpm) {
+    _shiftRpm = shiftRpm;
+    _warnRpm = warnRpm;
+    
+    // Spread the LEDs evenly over the band below the shift point (as wide
+    // as RPM_ZONE_YELLOW..SHIFT_RPM). The last LED lights one step below
+    // the shift point; the shift point itself is the flash. Each LED takes
+    // the color of the zone its step leads into.
+    uint16_t span = SHIFT_RPM - RPM_ZONE_YELLOW;
+    uint16_t start = shiftRpm - span;
+    for (uint8_t i = 0; i < SHIFT_LIGHT_LEDS; i++) {
+        _thresholds[i] = start + (uint32_t)span * i / SHIFT_LIGHT_LEDS;
+        _colors[i] = zoneColor(start + (uint32_t)span * (i + 1) / SHIFT_LIGHT_LEDS);
+    }
+}
+
+void ShiftLight::clear() {
+    _lit = 0;
+    _pending = false;
+    if (_rmt != NULL) {
+        sendPattern(0);
+        _lastFrame = clockMillis();
+    }
+}
+
+uint8_t ShiftLight::getLitCount() {
+    return (_shown == PATTERN_FLASH_ON || _shown == PATTERN_FLASH_OFF) ? 
+           SHIFT_LIGHT_LEDS : _lit;
+}
+
+uint32_t ShiftLight::getFrameCount() {
+    return _frames;
+}
+
+uint32_t ShiftLight::nextDeadline(uint32_t now) {
+    uint32_t next = now + CLOCK_IDLE_MS;
+    if (_rmt == NULL) {
+        return next;
+    }
+    
+    if (_pending) {
+        clockSooner(next, _lastFrame + SHIFT_LIGHT_FRAME_MS, now);
+    }
+    if (_shown == PATTERN_FLASH_ON || _shown == PATTERN_FLASH_OFF) {
+        clockSooner(next, (now / SHIFT_LIGHT_FLASH_MS + 1) * SHIFT_LIGHT_FLASH_MS, now);
+    }
+    
+    return next;
+}
+
+uint8_t ShiftLight::patternFor(uint16_t rpm) {
+    if (rpm >= _shiftRpm) {
+        _lit = SHIFT_LIGHT_LEDS;
+        return ((clockMillis() / SHIFT_LIGHT_FLASH_MS) & 1) ? PATTERN_FLASH_OFF : PATTERN_FLASH_ON;
+    }
+    
+    // LEDs come on at their threshold but only go out HYSTERESIS below it,
+    // so RPM hovering at a threshold doesn't flicker the bar
+    uint8_t lit = 0;
+    while (lit < SHIFT_LIGHT_LEDS && rpm >= _thresholds[lit]) {
+        lit++;
+    }
+    while (lit < _lit && rpm + SHIFT_LIGHT_HYSTERESIS >= _thresholds[lit]) {
+        lit++;
+    }
+    
+    _lit = lit;
+    return lit;
+}
+
+void ShiftLight::sendPattern(uint8_t pattern) {
+    for (uint8_t i = 0; i < SHIFT_LIGHT_LEDS; i++) {
+        uint32_t color = 0;
+        if (pattern == PATTERN_FLASH_ON) {
+            color = SHIFT_LED_FLASH;
+        } else if (pattern <= SHIFT_LIGHT_LEDS && i < pattern) {
+            color = _colors[i];
+        }
+        encodeLED(i, color);
+    }
+    
+    // Copies the items into RMT RAM and returns; the RMT clocks them out
+    rmtWrite(_rmt, _items, SHIFT_LIGHT_BITS);
+    _shown = pattern;
+    _frames++;
+}
+
+void ShiftLight::encodeLED(uint8_t index, uint32_t color) {
+    uint8_t r = ((color >> 16) & 0xFF) * SHIFT_LIGHT_BRIGHTNESS / 255;
+    uint8_t g = ((color >> 8) & 0xFF) * SHIFT_LIGHT_BRIGHTNESS / 255;
+    uint8_t b = (color & 0xFF) * SHIFT_LIGHT_BRIGHTNESS / 255;
+    
+    // Strip expects green, red, blue - MSB first
+    uint32_t grb = ((uint32_t)g << 16) | ((uint32_t)r << 8) | b;
+    rmt_data_t* item = &_items[index * 24];
+    
+    for (int8_t bit = 23; bit >= 0; bit--, item++) {
+        bool one = (grb >> bit) & 1;
+        item->level0 = 1;
+        item->duration0 = one ? LED_T1H : LED_T0H;
+        item->level1 = 0;
+        item->duration1 = one ? LED_T1L : LED_T0L;
+    }
+}
+
+uint32_t ShiftLight::zoneColor(uint16_t rpm) {
+    // Red from the pre-warning; orange keeps its distance below the shift
+    // point as it moves
+    if (rpm >= _warnRpm) {
+        return SHIFT_LED_RED;
+    } else if (rpm + (SHIFT_RPM - RPM_ZONE_ORANGE) >= _shiftRpm) {
+        return SHIFT_LED_ORANGE;
+    } else {
+        return SHIFT_LED_YELLOW;
+    }
+}
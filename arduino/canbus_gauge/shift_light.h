@@ -0,0 +1,80 @@
+/*
+ * shift_light.h - Addressable LED shift light bar
+ * 
+ * Drives a WS2812B / SK6812 (RGB, GRB order) strip from the ESP32 RMT
+ * peripheral. A frame is encoded once and handed to the RMT, which clocks
+ * it out of its own RAM - the CPU is free for the ~30us per LED it takes.
+ */
+
+#ifndef SHIFT_LIGHT_H
+#define SHIFT_LIGHT_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "clock.h"
+
+// One RMT item per bit, 24 bits per LED. Items must fit in the RMT RAM
+// reserved in begin() so a frame is sent in one shot without refills.
+#define SHIFT_LIGHT_BITS        (SHIFT_LIGHT_LEDS * 24)
+#define SHIFT_LIGHT_RMT_ITEMS   256     // RMT_MEM_256 (4 blocks)
+
+#if SHIFT_LIGHT_BITS > SHIFT_LIGHT_RMT_ITEMS - 1
+#error "SHIFT_LIGHT_LEDS too large for one-shot RMT transmission"
+#endif
+
+class ShiftLight {
+public:
+    ShiftLight(uint8_t pin);
+    
+    // Claim an RMT channel. Returns false if none is free.
+    bool begin();
+    
+    // Update the bar for this RPM. Cheap when nothing changed - call it on
+    // every decoded RPM and every loop (the loop call keeps the flash going).
+    void update(uint16_t rpm);
+    
+    // Move the bar to a new shift point and pre-warning (per-gear, or
+    // short-shift). LEDs turn red from warnRpm.
+    void setShiftRPM(uint16_t shiftRpm, uint16_t warnRpm);
+    
+    // Turn all LEDs off
+    void clear();
+    
+    // LEDs currently lit (SHIFT_LIGHT_LEDS while flashing)
+    uint8_t getLitCount();
+    
+    // Frames handed to the RMT since boot
+    uint32_t getFrameCount();
+    
+    // Next time update() sends a frame with the RPM unchanged (flash
+    // toggle, or a change held back by the frame rate limit)
+    uint32_t nextDeadline(uint32_t now);
+
+private:
+    uint8_t _pin;
+    rmt_obj_t* _rmt;
+    rmt_data_t _items[SHIFT_LIGHT_BITS];
+    
+    uint16_t _shiftRpm;                         // Flash from here
+    uint16_t _warnRpm;                          // Red from here
+    uint16_t _thresholds[SHIFT_LIGHT_LEDS];     // RPM at which each LED lights
+    uint32_t _colors[SHIFT_LIGHT_LEDS];         // Color per LED
+    
+    uint8_t _lit;               // LEDs lit below redline
+    uint8_t _shown;             // Pattern last sent (see patternFor)
+    bool _pending;              // Pattern changed but frame rate limited
+    uint32_t _lastFrame;
+    uint32_t _frames;
+    
+    // Pattern id: 0..LEDS = LEDs lit, LEDS+1 = flash on, LEDS+2 = flash off
+    uint8_t patternFor(uint16_t rpm);
+    
+    // Encode and start sending one frame
+    void sendPattern(uint8_t pattern);
+    void encodeLED(uint8_t index, uint32_t color);
+    
+    // LED color for an RPM (red within the pre-warning band)
+    uint32_t zoneColor(uint16_t rpm);
+};
+
+#endif // SHIFT_LIGHT_H
@@ -0,0 +1,736 @@
+/*
+ * race_sim.cpp - Time-compressed endurance race simulation of the gauge
+ *
+ * Runs the sketch itself (setup()/loop() from canbus_gauge.ino) on a
+ * virtual clock against models of everything around it: the ECU answers
+ * OBD queries and manufacturer DIDs (OBD_DIDS_ENABLED) from a lap profile (busyRepeatRequest
+ * when asked faster than it can serve), the oil sender follows RPM, the page
+ * button and touch screen are pressed now and then, and the Nextion acks
+ * commands, answers sendme and takes strip chart transfers.
+ *
+ * Rather than calling loop() every millisecond, the clock jumps to the
+ * next deadline - nextLoopDeadline() or the next model event - so a six
+ * hour race runs in seconds. Everything the gauge puts out (Nextion
+ * commands, debug serial, LED frames, buzzer changes, CAN queries) is
+ * hashed with its timestamp; --verify runs the race event-stepped and
+ * stepped every 1 ms like the device loop and fails unless they match.
+ *
+ * Usage:
+ *   race_sim [--hours=6] [--step=<ms>] [--trace=<file>] [--crashlog=<file>] [--verify]
+ *
+ *   --step=<ms>     Fixed stepping instead of jumping to deadlines
+ *   --trace=<file>  Write every output event, one per line
+ *   --crashlog=<file>  Save the crash recorder partition (for crash_decode.py)
+ *   --verify        Run event-stepped and 1 ms stepped, compare outputs
+ */
+
+#include <Arduino.h>
+#include <mcp_can.h>
+#include <esp_partition.h>
+
+#include <time.h>
+
+// The Arduino builder generates these for the sketch
+void printConfig();
+void printDebugInfo();
+void pollCANData();
+void updateFromCAN();
+void readSensors();
+void updateDisplay();
+void readPageButton(uint32_t now);
+void toggleShortShift();
+void updateDiagnostics();
+void recordCrashSample(uint32_t now);
+uint32_t nextLoopDeadline(uint32_t now);
+
+#include "canbus_gauge.ino"
+
+// =============================================================================
+// SIMULATION SETTINGS
+// =============================================================================
+
+#define SIM_ECU_LATENCY_MS      4       // OBD query -> response
+#define SIM_ECU_SERVE_MS        30      // Busy reply to queries closer than this (~33 Hz)
+#define SIM_VTEC_RPM            4700    // VTEC engages above this (DID_VTEC_STATE)
+#define SIM_OIL_OVER_COOLANT_C  10.0f   // Oil runs this much hotter (DID_OIL_TEMP)
+#define SIM_NEXTION_LATENCY_MS  2       // Command -> ack
+#define SIM_NEXTION_BOOT_MS     350     // rest -> startup event
+
+#define SIM_LAP_MS              110000  // One lap
+#define SIM_STINT_MS            3000000 // Pit stop every 50 minutes
+#define SIM_PIT_MS              90000   // Stationary in the pits (engine off for the first 60 s)
+
+#define SIM_BUTTON_PERIOD_MS    1200000 // Page button press every 20 minutes...
+#define SIM_BUTTON_OFFSET_MS    300000  // ...starting 5 minutes in
+#define SIM_BUTTON_HOLD_MS      200
+#define SIM_LONG_OFFSET_MS      600000  // Held long (short-shift toggle) 10 minutes in
+#define SIM_LONG_HOLD_MS        1500
+#define SIM_TOUCH_OFFSET_MS     900000  // Touch the page hotspot 15 minutes in
+
+#define SIM_NEVER               0xFFFFFFFF
+
+// =============================================================================
+// VIRTUAL CLOCK
+// =============================================================================
+
+static uint32_t simNow = 0;
+
+static uint32_t simMillis() {
+    return simNow;
+}
+
+// Only setup() blocks - time just moves on
+static void simDelay(uint32_t ms) {
+    simNow += ms;
+}
+
+// Earlier of two event times; SIM_NEVER if neither
+static uint32_t earliest(uint32_t a, uint32_t b) {
+    return (a < b) ? a : b;
+}
+
+// =============================================================================
+// OUTPUT RECORDING
+// =============================================================================
+
+static uint64_t outputHash = 0xcbf29ce484222325ULL;    // FNV-1a
+static uint64_t outputEvents = 0;
+static FILE* traceFile = NULL;
+
+static void hashBytes(const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    while (len--) {
+        outputHash ^= *p++;
+        outputHash *= 0x100000001b3ULL;
+    }
+}
+
+static void record(char channel, const void* data, size_t len, const char* text) {
+    hashBytes(&simNow, sizeof(simNow));
+    hashBytes(&channel, 1);
+    hashBytes(data, len);
+    outputEvents++;
+
+    if (traceFile != NULL) {
+        fprintf(traceFile, "%10u %c %s\n", simNow, channel, text);
+    }
+}
+
+static void recordText(char channel, const char* text) {
+    record(channel, text, strlen(text), text);
+}
+
+// Debug serial, one event per line
+class LineCapture : public Stream {
+public:
+    LineCapture() : _len(0) {}
+
+    size_t write(uint8_t c) override {
+        if (c == '\n' || _len == sizeof(_line) - 1) {
+            _line[_len] = '\0';
+            recordText('S', _line);
+            _len = 0;
+        } else if (c != '\r') {
+            _line[_len++] = c;
+        }
+        return 1;
+    }
+    using Print::write;
+
+    int available() override { return 0; }
+    int read() override { return -1; }
+
+private:
+    char _line[256];
+    size_t _len;
+};
+
+static void onLedc(uint8_t channel, uint32_t freq, uint32_t duty) {
+    static uint32_t lastFreq = 0;
+    static uint32_t lastDuty = 0xFFFFFFFF;
+
+    // The buzzer is re-written every loop - only changes are output
+    if (duty == lastDuty && (duty == 0 || freq == lastFreq)) {
+        return;
+    }
+    lastFreq = freq;
+    lastDuty = duty;
+
+    char text[32];
+    snprintf(text, sizeof(text), "buzzer %u Hz duty %u", freq, duty);
+    recordText('B', text);
+}
+
+static void onRmtWrite(const rmt_data_t* data, size_t size) {
+    // Summarise the frame for the trace: count of 1 bits per LED
+    char text[8 + SHIFT_LIGHT_LEDS * 3];
+    size_t len = snprintf(text, sizeof(text), "leds");
+    for (size_t led = 0; led * 24 < size && len < sizeof(text) - 3; led++) {
+        int ones = 0;
+        for (size_t bit = 0; bit < 24; bit++) {
+            ones += (data[led * 24 + bit].duration0 > data[led * 24 + bit].duration1);
+        }
+        len += snprintf(text + len, sizeof(text) - len, " %d", ones);
+    }
+    record('L', data, size * sizeof(rmt_data_t), text);
+}
+
+// =============================================================================
+// RACE PROFILE
+// =============================================================================
+
+typedef struct {
+    uint32_t atMs;      // Time into the lap
+    uint16_t kmh;
+} LapPoint_t;
+
+// Speed trace of one lap (piecewise linear)
+static const LapPoint_t LAP[] = {
+    {      0,  95 }, {  12000, 195 }, {  16000,  85 }, {  24000, 140 },
+    {  31000,  70 }, {  40000, 165 }, {  49000, 205 }, {  53000, 100 },
+    {  62000, 135 }, {  70000,  55 }, {  82000, 150 }, {  96000, 215 },
+    { 101000, 110 }, { 110000,  95 },
+};
+static const uint8_t LAP_POINTS = sizeof(LAP) / sizeof(LAP[0]);
+
+static const float SIM_GEAR_RATIOS[GEAR_COUNT] = GEAR_RATIOS;
+
+typedef struct {
+    uint16_t rpm;
+    uint8_t kmh;
+    uint8_t throttle;   // 255 = 100%
+    float coolantC;
+    float oilPsi;
+} CarState_t;
+
+static uint32_t noise(uint32_t t) {
+    // Deterministic per-millisecond noise (integer hash)
+    t ^= t >> 16;
+    t *= 0x7feb352d;
+    t ^= t >> 15;
+    t *= 0x846ca68b;
+    t ^= t >> 16;
+    return t;
+}
+
+static CarState_t carState(uint32_t t) {
+    CarState_t car;
+
+    uint32_t stintTime = t % SIM_STINT_MS;
+    bool inPits = (t >= SIM_STINT_MS && stintTime < SIM_PIT_MS);
+
+    if (inPits) {
+        car.kmh = 0;
+        car.rpm = (stintTime < 60000) ? 0 : 800;
+        car.throttle = 0;
+    } else {
+        // Speed from the lap trace
+        uint32_t lapTime = stintTime % SIM_LAP_MS;
+        uint8_t i = 0;
+        while (i < LAP_POINTS - 2 && lapTime >= LAP[i + 1].atMs) {
+            i++;
+        }
+        const LapPoint_t& a = LAP[i];
+        const LapPoint_t& b = LAP[i + 1];
+        car.kmh = a.kmh + ((int32_t)b.kmh - a.kmh) * (int32_t)(lapTime - a.atMs) /
+                  (int32_t)(b.atMs - a.atMs);
+        car.throttle = (b.kmh > a.kmh) ? 255 : 0;   // Flat out or braking
+
+        // Lowest gear that keeps the engine under 6450 RPM - close enough
+        // to the shift points to light the bar on the long straights
+        float circumferenceM = PI * (TIRE_RIM_IN * 25.4f +
+                               2.0f * TIRE_WIDTH_MM * TIRE_ASPECT_PCT / 100.0f) / 1000.0f;
+        float wheelRpm = car.kmh * 1000.0f / 60.0f / circumferenceM;
+        car.rpm = 0;
+        for (uint8_t g = 0; g < GEAR_COUNT; g++) {
+            float rpm = wheelRpm * SIM_GEAR_RATIOS[g] * FINAL_DRIVE_RATIO;
+            if (rpm <= 6450 || g == GEAR_COUNT - 1) {
+                car.rpm = (uint16_t)rpm;
+                break;
+            }
+        }
+    }
+
+    // Coolant climbs through the race; a blocked radiator in the 4th hour
+    // takes it through warning into critical and back
+    float hours = t / 3600000.0f;
+    car.coolantC = 86.0f + 2.0f * hours + (car.rpm > 5500 ? 1.0f : 0.0f);
+    if (t >= 3 * 3600000UL && t < 3 * 3600000UL + 900000UL) {
+        float minutes = (t - 3 * 3600000UL) / 60000.0f;
+        car.coolantC += (minutes < 7.5f) ? minutes * 2.4f : (15.0f - minutes) * 2.4f;
+    }
+
+    // Oil pressure follows RPM; in the 2nd hour the slow corner starves
+    // the pickup for a moment every lap
+    car.oilPsi = (car.rpm > 0) ? 25.0f + car.rpm / 120.0f : 0.0f;
+    uint32_t lapTime = stintTime % SIM_LAP_MS;
+    if (t >= 3600000UL && t < 2 * 3600000UL && lapTime >= 70000 && lapTime < 71500) {
+        car.oilPsi = 18.0f;
+    }
+    car.oilPsi += ((int32_t)(noise(t) % 61) - 30) / 100.0f;
+
+    return car;
+}
+
+static uint16_t oilSenderAdc(float psi) {
+    float volts = OIL_SENSOR_V_MIN + psi / OIL_SENSOR_PSI_MAX * (OIL_SENSOR_V_MAX - OIL_SENSOR_V_MIN);
+    float adc = volts / VOLTAGE_DIVIDER_RATIO / ADC_VREF * ADC_RESOLUTION;
+    return (uint16_t)constrain(adc, 0.0f, (float)ADC_RESOLUTION);
+}
+
+// =============================================================================
+// ECU MODEL
+// =============================================================================
+
+#define SIM_ECU_QUEUE   8
+
+static struct {
+    uint32_t due[SIM_ECU_QUEUE];
+    uint8_t service[SIM_ECU_QUEUE];
+    uint16_t id[SIM_ECU_QUEUE];
+    bool busy[SIM_ECU_QUEUE];
+    uint8_t head;
+    uint8_t count;
+    uint32_t lastServed;
+    bool served;
+} ecu;
+
+static void onCanSend(unsigned long id, uint8_t len, const uint8_t* data) {
+    char text[40];
+    bool did = (id == UDS_REQUEST_ID && data[1] == OBD_SERVICE_READ_DID);
+    uint16_t request = did ? (data[2] << 8 | data[3]) : data[2];
+    snprintf(text, sizeof(text), did ? "query %03lX did %04X" : "query %03lX pid %02X", id, request);
+    record('C', data, len, text);
+
+    bool pid = (id == OBD_REQUEST_ID && data[1] == OBD_SERVICE_CURRENT_DATA);
+    if ((!pid && !did) || ecu.count == SIM_ECU_QUEUE) {
+        return;
+    }
+    uint8_t slot = (ecu.head + ecu.count++) % SIM_ECU_QUEUE;
+    ecu.due[slot] = simNow + SIM_ECU_LATENCY_MS;
+    ecu.service[slot] = data[1];
+    ecu.id[slot] = request;
+
+    // A busy reply doesn't use up the ECU's time
+    ecu.busy[slot] = ecu.served && simNow - ecu.lastServed < SIM_ECU_SERVE_MS;
+    if (!ecu.busy[slot]) {
+        ecu.lastServed = simNow;
+        ecu.served = true;
+    }
+}
+
+// One response per loop, like the MCP2515 interrupt path
+static void ecuDeliver() {
+    if (ecu.count == 0 || ecu.due[ecu.head] > simNow || hostCanPending()) {
+        return;
+    }
+
+    CarState_t car = carState(simNow);
+    uint8_t service = ecu.service[ecu.head];
+    uint16_t id = ecu.id[ecu.head];
+    uint8_t frame[8] = { 0x03, (uint8_t)(service + OBD_POSITIVE_OFFSET), (uint8_t)id, 0, 0xCC, 0xCC, 0xCC, 0xCC };
+    uint8_t* a = &frame[3];
+
+    if (service == OBD_SERVICE_READ_DID) {
+        frame[0] = 0x04;
+        frame[2] = id >> 8;
+        frame[3] = id & 0xFF;
+        a = &frame[4];
+    }
+
+    if (ecu.busy[ecu.head]) {
+        frame[0] = 0x03;
+        frame[1] = OBD_NEGATIVE_RESPONSE;
+        frame[2] = service;
+        frame[3] = NRC_BUSY_REPEAT_REQUEST;
+    } else if (service == OBD_SERVICE_READ_DID) {
+        switch (id) {
+            case DID_VTEC_STATE:
+                a[0] = (car.rpm > SIM_VTEC_RPM) ? DID_VTEC_MASK : 0;
+                break;
+            case DID_OIL_TEMP:
+                a[0] = (uint8_t)(car.coolantC + SIM_OIL_OVER_COOLANT_C + 40.0f);
+                break;
+            default:
+                frame[0] = 0x03;
+                frame[1] = OBD_NEGATIVE_RESPONSE;
+                frame[2] = service;
+                frame[3] = NRC_REQUEST_OUT_OF_RANGE;
+                break;
+        }
+    } else {
+        switch (id) {
+            case PID_ENGINE_RPM:
+                frame[0] = 0x04;
+                a[0] = (car.rpm * 4) >> 8;
+                a[1] = (car.rpm * 4) & 0xFF;
+                break;
+            case PID_VEHICLE_SPEED:
+                a[0] = car.kmh;
+                break;
+            case PID_COOLANT_TEMP:
+                a[0] = (uint8_t)(car.coolantC + 40.0f);
+                break;
+            case PID_THROTTLE_POSITION:
+                a[0] = car.throttle;
+                break;
+            default:
+                a[0] = 0;
+                break;
+        }
+    }
+
+    hostCanReceive(OBD_RESPONSE_ID_MIN, 8, frame);
+    ecu.head = (ecu.head + 1) % SIM_ECU_QUEUE;
+    ecu.count--;
+}
+
+static uint32_t ecuNextEvent() {
+    if (ecu.count == 0) {
+        return SIM_NEVER;
+    }
+    // Delivered at the next loop once due (and the mailbox is free)
+    return (ecu.due[ecu.head] > simNow) ? ecu.due[ecu.head] : simNow + 1;
+}
+
+// =============================================================================
+// NEXTION MODEL
+// =============================================================================
+
+#define SIM_NEXTION_RX  4096
+
+class NextionModel : public Stream {
+public:
+    NextionModel() : _cmdLen(0), _terms(0), _rawLeft(0), _bkcmd(2),
+                     _page(NextionID::PAGE_STARTUP_ID), _head(0), _count(0), _lastDue(0) {}
+
+    // Bytes from the gauge
+    size_t write(uint8_t c) override {
+        if (_rawLeft > 0) {
+            // addt waveform data
+            if (--_rawLeft == 0) {
+                recordText('T', "addt data");
+                reply(NextionReturn::TRANSPARENT_DONE);
+            }
+            return 1;
+        }
+
+        if (c == 0xFF) {
+            if (++_terms == 3) {
+                _cmd[_cmdLen] = '\0';
+                command(_cmd);
+                _cmdLen = 0;
+                _terms = 0;
+            }
+            return 1;
+        }
+        _terms = 0;
+        if (_cmdLen < sizeof(_cmd) - 1) {
+            _cmd[_cmdLen++] = c;
+        }
+        return 1;
+    }
+    using Print::write;
+
+    // Replies to the gauge, once their time has come
+    int available() override {
+        int ready = 0;
+        while (ready < _count && _rx[(_head + ready) % SIM_NEXTION_RX].due <= simNow) {
+            ready++;
+        }
+        return ready;
+    }
+
+    int read() override {
+        if (available() == 0) {
+            return -1;
+        }
+        uint8_t c = _rx[_head].byte;
+        _head = (_head + 1) % SIM_NEXTION_RX;
+        _count--;
+        return c;
+    }
+
+    // Finger on a component, released 100 ms later
+    void touch(uint8_t component) {
+        uint8_t press[4] = { NextionReturn::TOUCH_EVENT, _page, component, 0x01 };
+        queue(press, 4, simNow);
+        press[3] = 0x00;
+        queue(press, 4, simNow + 100);
+    }
+
+    uint8_t getPage() {
+        return _page;
+    }
+
+    uint32_t nextEvent() {
+        if (_count == 0) {
+            return SIM_NEVER;
+        }
+        return (_rx[_head].due > simNow) ? _rx[_head].due : simNow + 1;
+    }
+
+private:
+    char _cmd[128];
+    uint8_t _cmdLen;
+    uint8_t _terms;
+    uint16_t _rawLeft;
+    uint8_t _bkcmd;
+    uint8_t _page;
+
+    struct {
+        uint32_t due;
+        uint8_t byte;
+    } _rx[SIM_NEXTION_RX];
+    uint16_t _head;
+    uint16_t _count;
+    uint32_t _lastDue;
+
+    void command(const char* cmd) {
+        if (cmd[0] == '\0') {
+            return;
+        }
+        recordText('N', cmd);
+
+        if (strcmp(cmd, "rest") == 0) {
+            _bkcmd = 2;
+            _page = NextionID::PAGE_STARTUP_ID;
+            uint8_t startup[3] = { 0x00, 0x00, 0x00 };
+            uint8_t ready[1] = { NextionReturn::READY };
+            queue(startup, 3, simNow + SIM_NEXTION_BOOT_MS);
+            queue(ready, 1, simNow + SIM_NEXTION_BOOT_MS);
+            return;
+        }
+        if (strncmp(cmd, "bkcmd=", 6) == 0) {
+            _bkcmd = atoi(cmd + 6);
+        } else if (strncmp(cmd, "page ", 5) == 0) {
+            const char* name = cmd + 5;
+            if (strcmp(name, NextionID::PAGE_MAIN) == 0) {
+                _page = NextionID::PAGE_MAIN_ID;
+            } else if (strcmp(name, NextionID::PAGE_DIAG) == 0) {
+                _page = NextionID::PAGE_DIAG_ID;
+            } else {
+                _page = NextionID::PAGE_STARTUP_ID;
+            }
+        } else if (strcmp(cmd, "sendme") == 0) {
+            uint8_t page[2] = { NextionReturn::CURRENT_PAGE, _page };
+            queue(page, 2, simNow + SIM_NEXTION_LATENCY_MS);
+            return;
+        } else if (strncmp(cmd, "addt ", 5) == 0) {
+            // addt <id>,<channel>,<count>: ready, then <count> raw bytes.
+            // Only the waveform takes it.
+            if (atoi(cmd + 5) != NextionID::OIL_TRACE_ID) {
+                reply(NextionReturn::INVALID_COMPONENT);
+                return;
+            }
+            const char* count = strrchr(cmd, ',');
+            _rawLeft = (count != NULL) ? atoi(count + 1) : 0;
+            reply(NextionReturn::TRANSPARENT_READY);
+            return;
+        }
+
+        if (_bkcmd == 3) {
+            reply(NextionReturn::SUCCESS);
+        }
+    }
+
+    void reply(uint8_t code) {
+        queue(&code, 1, simNow + SIM_NEXTION_LATENCY_MS);
+    }
+
+    // Replies leave in order, 0xFF 0xFF 0xFF terminated
+    void queue(const uint8_t* data, uint8_t len, uint32_t due) {
+        due = max(due, _lastDue);
+        _lastDue = due;
+        for (uint8_t i = 0; i < len + 3 && _count < SIM_NEXTION_RX; i++) {
+            uint16_t slot = (_head + _count++) % SIM_NEXTION_RX;
+            _rx[slot].due = due;
+            _rx[slot].byte = (i < len) ? data[i] : 0xFF;
+        }
+    }
+};
+
+static NextionModel nextion;
+static LineCapture debugSerial;
+
+// =============================================================================
+// DRIVER INPUTS
+// =============================================================================
+
+static void applyInputs() {
+    CarState_t car = carState(simNow);
+    hostSetAnalog(OIL_PRESSURE_PIN, oilSenderAdc(car.oilPsi));
+
+    // Page button held for SIM_BUTTON_HOLD_MS once per period, and held
+    // long once, which toggles short-shift
+    uint32_t phase = (simNow + SIM_BUTTON_PERIOD_MS - SIM_BUTTON_OFFSET_MS) % SIM_BUTTON_PERIOD_MS;
+    uint32_t longPhase = (simNow + SIM_BUTTON_PERIOD_MS - SIM_LONG_OFFSET_MS) % SIM_BUTTON_PERIOD_MS;
+    hostSetPin(PAGE_BUTTON_PIN, (phase < SIM_BUTTON_HOLD_MS || longPhase < SIM_LONG_HOLD_MS) ? LOW : HIGH);
+
+    // Touch the page hotspot once per period, off-phase from the button
+    if (simNow % SIM_BUTTON_PERIOD_MS == SIM_TOUCH_OFFSET_MS) {
+        nextion.touch(nextion.getPage() == NextionID::PAGE_DIAG_ID ?
+                      NextionID::PAGE_BUTTON_DIAG_ID : NextionID::PAGE_BUTTON_MAIN_ID);
+    }
+}
+
+// Next time an input changes by itself (button edge, touch)
+static uint32_t inputsNextEvent() {
+    uint32_t next = SIM_NEVER;
+    uint32_t base = simNow - simNow % SIM_BUTTON_PERIOD_MS;
+
+    for (uint8_t period = 0; period < 2; period++) {
+        uint32_t start = base + period * SIM_BUTTON_PERIOD_MS;
+        const uint32_t edges[5] = {
+            start + SIM_BUTTON_OFFSET_MS,
+            start + SIM_BUTTON_OFFSET_MS + SIM_BUTTON_HOLD_MS,
+            start + SIM_LONG_OFFSET_MS,
+            start + SIM_LONG_OFFSET_MS + SIM_LONG_HOLD_MS,
+            start + SIM_TOUCH_OFFSET_MS,
+        };
+        for (uint8_t i = 0; i < 5; i++) {
+            if (edges[i] > simNow) {
+                next = earliest(next, edges[i]);
+            }
+        }
+    }
+    return next;
+}
+
+// =============================================================================
+// MAIN
+// =============================================================================
+
+static int verify(const char* self, float hours) {
+    char command[512];
+    char result[2][256];
+
+    for (int run = 0; run < 2; run++) {
+        snprintf(command, sizeof(command), "%s --hours=%g --step=%d", self, hours, run);
+        FILE* child = popen(command, "r");
+        if (child == NULL) {
+            fprintf(stderr, "verify: can't run %s\n", self);
+            return 1;
+        }
+        result[run][0] = '\0';
+        char line[256];
+        while (fgets(line, sizeof(line), child) != NULL) {
+            fputs(line, stdout);
+            if (strncmp(line, "output ", 7) == 0) {
+                strcpy(result[run], line);
+            }
+        }
+        if (pclose(child) != 0 || result[run][0] == '\0') {
+            fprintf(stderr, "verify: run failed\n");
+            return 1;
+        }
+    }
+
+    if (strcmp(result[0], result[1]) != 0) {
+        printf("FAIL: event-stepped output differs from 1 ms stepping\n");
+        return 1;
+    }
+    printf("OK: event-stepped output identical to 1 ms stepping\n");
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    float hours = 6.0f;
+    int step = 0;
+    bool verifyRuns = false;
+    const char* crashlogPath = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--hours=", 8) == 0) {
+            hours = atof(argv[i] + 8);
+        } else if (strncmp(argv[i], "--step=", 7) == 0) {
+            step = atoi(argv[i] + 7);
+        } else if (strncmp(argv[i], "--trace=", 8) == 0) {
+            traceFile = fopen(argv[i] + 8, "w");
+            if (traceFile == NULL) {
+                perror(argv[i] + 8);
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--crashlog=", 11) == 0) {
+            crashlogPath = argv[i] + 11;
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            verifyRuns = true;
+        } else {
+            fprintf(stderr, "usage: %s [--hours=<h>] [--step=<ms>] [--trace=<file>] "
+                    "[--crashlog=<file>] [--verify]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (verifyRuns) {
+        return verify(argv[0], hours);
+    }
+
+    ClockSource_t virtualClock = { simMillis, simDelay };
+    setClockSource(virtualClock);
+
+    Serial.hostAttach(&debugSerial);
+    Serial2.hostAttach(&nextion);
+    hostOnCanSend(onCanSend);
+    hostOnLedc(onLedc);
+    hostOnRmtWrite(onRmtWrite);
+    applyInputs();
+
+    clock_t started = clock();
+
+    setup();
+
+    uint32_t end = (uint32_t)(hours * 3600000.0f);
+    uint64_t loops = 0;
+
+    while (simNow < end) {
+        applyInputs();
+        ecuDeliver();
+        loop();
+        loops++;
+
+        if (step > 0) {
+            simNow += step;
+        } else {
+            uint32_t next = nextLoopDeadline(simNow);
+            next = earliest(next, ecuNextEvent());
+            next = earliest(next, nextion.nextEvent());
+            next = earliest(next, inputsNextEvent());
+            simNow = max(next, simNow + 1);
+        }
+    }
+
+    // What the crash recorder left in flash is output too
+    size_t flashSize;
+    const uint8_t* flash = hostPartitionImage(&flashSize);
+    hashBytes(flash, flashSize);
+    if (crashlogPath != NULL) {
+        FILE* f = fopen(crashlogPath, "wb");
+        if (f == NULL || fwrite(flash, 1, flashSize, f) != flashSize) {
+            perror(crashlogPath);
+            return 1;
+        }
+        fclose(f);
+    }
+
+    double seconds = (double)(clock() - started) / CLOCKS_PER_SEC;
+    printf("%s: %.2f h simulated in %.2f s (%.0fx real time), %llu loops\n",
+           step > 0 ? "fixed step" : "event step", hours, seconds,
+           hours * 3600.0 / max(seconds, 1e-6), (unsigned long long)loops);
+    printf("output %llu events, hash %016llx\n",
+           (unsigned long long)outputEvents, (unsigned long long)outputHash);
+    printf("obd: %lu queries, %lu busy replies, learned rate %.2f Hz\n",
+           (unsigned long)canHandler.getQueryCount(), (unsigned long)canHandler.getBusyCount(),
+           canHandler.getLearnedRateQ8() / 256.0);
+    CrashStats_t crash = crashRecorder.getStats();
+    printf("crash: %lu captures, %lu missed triggers, %lu dropped samples, %lu failed\n",
+           (unsigned long)crash.captures, (unsigned long)crash.missed, (unsigned long)crash.dropped,
+           (unsigned long)crash.failed);
+    AggStats_t agg = trend.getStats();
+    printf("trend: %lu periods, %lu lines\n", (unsigned long)agg.periods, (unsigned long)agg.lines);
+
+    if (traceFile != NULL) {
+        fclose(traceFile);
+    }
+    return 0;
+}
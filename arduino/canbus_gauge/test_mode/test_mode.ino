@@ -13,7 +13,12 @@
  *   a          - Auto-cycle through demo values
  *   x          - Stop auto-cycle
  *   b          - Toggle buzzer on/off
+ *   i          - Binary injection mode (tools/inject.py)
  *   ?          - Show help
+ * 
+ * Injection mode streams timestamped values at up to 1 kHz from a
+ * scenario file (ramps, noise, dropouts, alert storms) - see
+ * tools/inject.py and test_mode/scenarios/.
  */
 
 #include <Arduino.h>
@@ -43,8 +48,66 @@ int autoCyclePhase = 0;
 char serialBuffer[64];
 int bufferIndex = 0;
 
+// =============================================================================
+// BINARY INJECTION
+// =============================================================================
+
+// 'i' switches the port to INJECT_BAUD and reads fixed-size frames from
+// tools/inject.py (little-endian):
+//   0      0xA5 sync
+//   1-4    timestamp, ms from scenario start
+//   5-6    RPM
+//   7      speed, MPH
+//   8-9    water temp, °F (signed)
+//   10-11  oil pressure, 0.1 PSI
+//   12     flags (INJECT_FLAG_END ends injection)
+//   13     CRC-8 (poly 0x07) of bytes 1-12
+// Frames are played at their timestamp rather than on arrival, so USB
+// latency doesn't smear a 1 kHz ramp. A gap of INJECT_DROPOUT_MS between
+// frames shows as CAN lost, like a real bus dropout.
+
+#define COMMAND_BAUD        115200
+#define INJECT_BAUD         921600
+#define INJECT_SYNC         0xA5
+#define INJECT_FRAME_SIZE   14
+#define INJECT_FLAG_END     0x01
+#define INJECT_QUEUE        64      // Frames buffered ahead of their time
+#define INJECT_LATE_MS      5       // Played this far behind = late
+#define INJECT_DROPOUT_MS   100     // Frame gap shown as CAN lost
+#define INJECT_IDLE_EXIT_MS 5000    // No bytes at all - back to text commands
+
+typedef struct {
+    uint32_t timestamp;
+    uint16_t rpm;
+    uint8_t  speed;
+    int16_t  waterTemp;
+    uint16_t oilTenths;
+    uint8_t  flags;
+} InjectFrame_t;
+
+typedef struct {
+    uint32_t frames;        // Played
+    uint32_t crcErrors;     // Rejected (bad CRC, resynced)
+    uint32_t late;          // Played more than INJECT_LATE_MS behind
+    uint32_t overruns;      // Dropped, queue full
+    uint32_t dropouts;      // Gaps shown as CAN lost
+} InjectStats_t;
+
+bool injecting = false;
+uint8_t injectBuf[INJECT_FRAME_SIZE];
+uint8_t injectLen = 0;
+InjectFrame_t injectQueue[INJECT_QUEUE];
+uint8_t injectHead = 0;
+uint8_t injectCount = 0;
+bool injectAnchored = false;    // injectStart set by the first frame
+uint32_t injectStart = 0;       // millis() at timestamp 0
+uint32_t lastInjectFrame = 0;   // Last frame played
+uint32_t lastInjectByte = 0;
+bool injectDropout = false;
+InjectStats_t injectStats;
+
 void setup() {
-    Serial.begin(115200);
+    Serial.begin(COMMAND_BAUD);
     while (!Serial && millis() < 3000);
     
     Serial.println();
@@ -60,6 +123,7 @@ void setup() {
     Serial.println("  a         - Auto demo cycle");
     Serial.println("  x         - Stop auto cycle");
     Serial.println("  b         - Toggle buzzer");
+    Serial.println("  i         - Binary injection (tools/inject.py)");
     Serial.println("  ?         - Show this help");
     Serial.println();
     
@@ -79,22 +143,33 @@ void setup() {
 
 void loop() {
     // Process serial input
-    processSerial();
+    if (injecting) {
+        processInjection();
+    } else {
+        processSerial();
+    }
     
     // Handle auto-cycle mode
     if (autoCycle) {
         runAutoCycle();
     }
     
-    // Update alerts
-    alerts.update(testRPM, testWaterTemp, testOilPsi);
+    // Update alerts - testWaterTemp is °F, alerts take the raw OBD byte.
+    // Injected temperatures span int16, so pin them to the byte's range
+    // rather than let them wrap (1000°F would read as 30°C).
+    uint8_t coolantRaw = constrain(TEMP_F_TO_RAW((int32_t)testWaterTemp), 0, 255);
+    alerts.update(testRPM, coolantRaw, testOilPsi);
     
-    // Update display
-    static uint32_t lastDisplayUpdate = 0;
-    if (millis() - lastDisplayUpdate >= DISPLAY_UPDATE_MS) {
-        lastDisplayUpdate = millis();
-        display.update(testRPM, testSpeed, testWaterTemp, testOilPsi, alerts);
+    // Update display (paced by DisplayHandler flow control)
+    display.update(testRPM, testSpeed, TEMP_F_TO_DISPLAY(testWaterTemp), testOilPsi, alerts);
+    
+    // Feed the strip chart and service the display
+    static uint32_t lastTraceSample = 0;
+    if (millis() - lastTraceSample >= TRACE_SAMPLE_MS) {
+        lastTraceSample = millis();
+        display.pushTrace(testRPM, testOilPsi);
     }
+    display.poll();
 }
 
 void processSerial() {
@@ -178,8 +253,15 @@ void processCommand(char* cmd) {
             Serial.println("  a         - Auto demo cycle");
             Serial.println("  x         - Stop auto cycle");
             Serial.println("  b         - Toggle buzzer");
+            Serial.println("  i         - Binary injection (tools/inject.py)");
             break;
             
+        case 'i':
+        case 'I':
+            // The port changes speed - nothing more in text
+            startInjection();
+            return;
+            
         default:
             Serial.println("Unknown command. Type ? for help.");
     }
@@ -240,3 +322,150 @@ void runAutoCycle() {
             break;
     }
 }
+
+// =============================================================================
+// BINARY INJECTION
+// =============================================================================
+
+uint8_t crc8(const uint8_t* data, uint8_t len) {
+    uint8_t crc = 0;
+    while (len--) {
+        crc ^= *data++;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+void startInjection() {
+    Serial.printf("INJECT %d\n", INJECT_BAUD);
+    Serial.flush();
+    Serial.updateBaudRate(INJECT_BAUD);
+    
+    autoCycle = false;
+    injecting = true;
+    injectLen = 0;
+    injectHead = 0;
+    injectCount = 0;
+    injectAnchored = false;
+    injectDropout = false;
+    lastInjectByte = millis();
+    memset(&injectStats, 0, sizeof(injectStats));
+}
+
+void stopInjection(const char* reason) {
+    injecting = false;
+    display.setCANStatus(true);
+    
+    // Give the host time to see the END frame through before the switch
+    Serial.flush();
+    delay(50);
+    Serial.updateBaudRate(COMMAND_BAUD);
+    
+    Serial.printf("Injection stopped (%s): %lu frames, %lu CRC errors, "
+                  "%lu late, %lu overruns, %lu dropouts\n", reason,
+                  injectStats.frames, injectStats.crcErrors, injectStats.late,
+                  injectStats.overruns, injectStats.dropouts);
+    Serial.printf("Current: RPM=%d, Speed=%d MPH, Temp=%d°F, Oil=%.0f PSI\n",
+                  testRPM, testSpeed, testWaterTemp, testOilPsi);
+}
+
+void processInjection() {
+    uint32_t now = millis();
+    
+    // --- Receive ---
+    while (Serial.available()) {
+        uint8_t c = Serial.read();
+        lastInjectByte = now;
+        
+        // Hunt for sync, then collect a whole frame
+        if (injectLen == 0 && c != INJECT_SYNC) {
+            continue;
+        }
+        injectBuf[injectLen++] = c;
+        if (injectLen < INJECT_FRAME_SIZE) {
+            continue;
+        }
+        injectLen = 0;
+        
+        if (crc8(&injectBuf[1], INJECT_FRAME_SIZE - 2) != injectBuf[INJECT_FRAME_SIZE - 1]) {
+            injectStats.crcErrors++;
+            
+            // Lost bytes - the next frame may start inside this one
+            for (uint8_t i = 1; i < INJECT_FRAME_SIZE; i++) {
+                if (injectBuf[i] == INJECT_SYNC) {
+                    injectLen = INJECT_FRAME_SIZE - i;
+                    memmove(injectBuf, &injectBuf[i], injectLen);
+                    break;
+                }
+            }
+            continue;
+        }
+        
+        if (injectCount == INJECT_QUEUE) {
+            injectStats.overruns++;
+            continue;
+        }
+        
+        InjectFrame_t& frame = injectQueue[(injectHead + injectCount) % INJECT_QUEUE];
+        frame.timestamp = injectBuf[1] | (injectBuf[2] << 8) | 
+                          ((uint32_t)injectBuf[3] << 16) | ((uint32_t)injectBuf[4] << 24);
+        frame.rpm = injectBuf[5] | (injectBuf[6] << 8);
+        frame.speed = injectBuf[7];
+        frame.waterTemp = (int16_t)(injectBuf[8] | (injectBuf[9] << 8));
+        frame.oilTenths = injectBuf[10] | (injectBuf[11] << 8);
+        frame.flags = injectBuf[12];
+        injectCount++;
+    }
+    
+    // --- Play frames whose time has come ---
+    while (injectCount > 0) {
+        InjectFrame_t& frame = injectQueue[injectHead];
+        
+        // The first frame sets the timeline; later ones keep to it
+        if (!injectAnchored) {
+            injectStart = now - frame.timestamp;
+            injectAnchored = true;
+        }
+        
+        int32_t behind = (int32_t)(now - (injectStart + frame.timestamp));
+        if (behind < 0) {
+            break;
+        }
+        if (behind > INJECT_LATE_MS) {
+            injectStats.late++;
+        }
+        
+        testRPM = constrain(frame.rpm, 0, RPM_MAX);
+        testSpeed = frame.speed;
+        testWaterTemp = frame.waterTemp;
+        testOilPsi = frame.oilTenths / 10.0f;
+        injectStats.frames++;
+        lastInjectFrame = now;
+        
+        injectHead = (injectHead + 1) % INJECT_QUEUE;
+        injectCount--;
+        
+        if (injectDropout) {
+            injectDropout = false;
+            display.setCANStatus(true);
+        }
+        
+        if (frame.flags & INJECT_FLAG_END) {
+            stopInjection("end of scenario");
+            return;
+        }
+    }
+    
+    // --- Dropouts and abandoned streams ---
+    if (injectAnchored && !injectDropout && now - lastInjectFrame >= INJECT_DROPOUT_MS) {
+        injectDropout = true;
+        injectStats.dropouts++;
+        display.setCANStatus(false);
+    }
+    
+    if (now - lastInjectByte >= INJECT_IDLE_EXIT_MS) {
+        stopInjection("no data");
+    }
+}
@@ -0,0 +1,160 @@
+/*
+ * trend_aggregator.cpp - Per-minute statistics and RPM-binned oil pressure
+ */
+
+#include "trend_aggregator.h"
+
+static_assert(AGG_PERIOD_MS / SENSOR_READ_MS < 65535, "Sample counts are 16-bit");
+static_assert((AGG_RPM_BINS + 1) * AGG_EMIT_MS < AGG_PERIOD_MS,
+              "A period must be sent before the next one closes");
+
+static void channelAdd(AggChannel_t& channel, int32_t value, bool first) {
+    if (first || value < channel.min) {
+        channel.min = value;
+    }
+    if (first || value > channel.max) {
+        channel.max = value;
+    }
+    channel.sum += value;
+}
+
+// Rounded to nearest, halves away from zero
+static int32_t meanOf(int32_t sum, uint16_t count) {
+    return (sum >= 0) ? (sum + count / 2) / count : -((-sum + count / 2) / count);
+}
+
+TrendAggregator::TrendAggregator(Print& out) : _out(out) {
+    memset(&_current, 0, sizeof(_current));
+    memset(&_sending, 0, sizeof(_sending));
+    _seq = 0;
+    _sendLine = 0;
+    _sendPending = false;
+    _nextSend = 0;
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+void TrendAggregator::add(uint16_t rpm, uint16_t oilTenths, int16_t coolant, uint32_t now) {
+    if (_current.samples > 0 && (int32_t)(now - _current.start) >= AGG_PERIOD_MS) {
+        close(now);
+    }
+    
+    bool first = (_current.samples == 0);
+    if (first) {
+        _current.start = now;
+    }
+    channelAdd(_current.rpm, rpm, first);
+    channelAdd(_current.oil, oilTenths, first);
+    channelAdd(_current.coolant, coolant, first);
+    
+    uint8_t rpmBin = min(rpm / AGG_RPM_BIN_WIDTH, AGG_RPM_BINS - 1);
+    uint8_t oilBin = min(oilTenths / (AGG_OIL_BIN_PSI * 10), AGG_OIL_BINS - 1);
+    _current.binOilSum[rpmBin] += oilTenths;
+    _current.binSamples[rpmBin]++;
+    _current.hist[rpmBin][oilBin]++;
+    
+    _current.end = now;
+    _current.samples++;
+}
+
+void TrendAggregator::close(uint32_t now) {
+    _sending = _current;
+    memset(&_current, 0, sizeof(_current));
+    
+    _seq++;
+    _sendLine = 0;
+    _sendPending = true;
+    _nextSend = now;
+}
+
+void TrendAggregator::service(uint32_t now) {
+    // With the engine off no samples come in, so close on time here too
+    if (_current.samples > 0 && (int32_t)(now - _current.start) >= AGG_PERIOD_MS) {
+        close(now);
+    }
+    
+    if (_sendPending && (int32_t)(now - _nextSend) >= 0) {
+        sendLine();
+        _nextSend = now + AGG_EMIT_MS;
+    }
+}
+
+void TrendAggregator::sendLine() {
+    char line[AGG_LINE_MAX];
+    int len;
+    
+    if (_sendLine == 0) {
+        const AggPeriod_t& p = _sending;
+        int32_t oilMean = meanOf(p.oil.sum, p.samples);
+        len = snprintf(line, sizeof(line),
+                       "$AGG,%lu,%lu,%lu,%u,%ld,%ld,%ld,%ld.%ld,%ld.%ld,%ld.%ld,%ld,%ld,%ld",
+                       (unsigned long)_seq, (unsigned long)(p.start / 1000),
+                       (unsigned long)((p.end - p.start) / 1000), p.samples,
+                       (long)p.rpm.min, (long)meanOf(p.rpm.sum, p.samples), (long)p.rpm.max,
+                       (long)(p.oil.min / 10), (long)(p.oil.min % 10),
+                       (long)(oilMean / 10), (long)(oilMean % 10),
+                       (long)(p.oil.max / 10), (long)(p.oil.max % 10),
+                       (long)p.coolant.min, (long)meanOf(p.coolant.sum, p.samples),
+                       (long)p.coolant.max);
+        writeLine(line, len);
+        _sendLine = 1;
+        return;
+    }
+    
+    // Next RPM bin with samples
+    uint8_t bin = _sendLine - 1;
+    while (bin < AGG_RPM_BINS && _sending.binSamples[bin] == 0) {
+        bin++;
+    }
+    if (bin == AGG_RPM_BINS) {
+        _sendPending = false;
+        _stats.periods++;
+        _stats.seq = _seq;
+        return;
+    }
+    
+    const uint16_t* counts = _sending.hist[bin];
+    uint8_t first = 0;
+    uint8_t last = AGG_OIL_BINS - 1;
+    while (counts[first] == 0) {
+        first++;
+    }
+    while (counts[last] == 0) {
+        last--;
+    }
+    
+    int32_t oilMean = meanOf(_sending.binOilSum[bin], _sending.binSamples[bin]);
+    len = snprintf(line, sizeof(line), "$AGH,%lu,%u,%u,%ld.%ld,%u,",
+                   (unsigned long)_seq, bin, _sending.binSamples[bin],
+                   (long)(oilMean / 10), (long)(oilMean % 10), first);
+    for (uint8_t i = first; i <= last && len < (int)sizeof(line); i++) {
+        len += snprintf(line + len, sizeof(line) - len, (i == first) ? "%u" : "/%u", counts[i]);
+    }
+    writeLine(line, len);
+    _sendLine = bin + 2;
+}
+
+void TrendAggregator::writeLine(char* line, int len) {
+    uint8_t checksum = 0;
+    for (int i = 1; i < len; i++) {
+        checksum ^= (uint8_t)line[i];
+    }
+    len += snprintf(line + len, AGG_LINE_MAX - len, "*%02X\r\n", checksum);
+    
+    _out.write((const uint8_t*)line, len);
+    _stats.lines++;
+}
+
+uint32_t TrendAggregator::nextDeadline(uint32_t now) {
+    uint32_t next = now + CLOCK_IDLE_MS;
+    if (_current.samples > 0) {
+        clockSooner(next, _current.start + AGG_PERIOD_MS, now);
+    }
+    if (_sendPending) {
+        clockSooner(next, _nextSend, now);
+    }
+    return next;
+}
+
+AggStats_t TrendAggregator::getStats() {
+    return _stats;
+}
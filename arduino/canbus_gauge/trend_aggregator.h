@@ -0,0 +1,91 @@
+/*
+ * trend_aggregator.h - Per-minute statistics and RPM-binned oil pressure
+ *
+ * Whether oil pressure at 6000 rpm is drifting down over a stint shows in
+ * minutes-long trends, not in the last few samples. Each sample updates
+ * the open period in O(1): min, max and sum per channel, one cell of an
+ * RPM x oil pressure histogram, and the oil pressure sum of its RPM bin so
+ * the bin mean is exact. Nothing per sample is kept, so memory is fixed.
+ *
+ * A period closes AGG_PERIOD_MS after its first sample. It is copied out
+ * and sent as NMEA-style lines, one per AGG_EMIT_MS, so each fits the UART
+ * FIFO and printing never blocks the loop:
+ *
+ *   $AGG,<seq>,<start s>,<length s>,<samples>,<rpm min>,<mean>,<max>,
+ *        <oil min>,<mean>,<max>,<coolant min>,<mean>,<max>*<xor>
+ *   $AGH,<seq>,<rpm bin>,<samples>,<oil mean>,<first oil bin>,<n>/<n>/...*<xor>
+ *
+ * There is one $AGH per RPM bin with samples. Its counts run from the
+ * first to the last nonzero oil bin. Oil pressure is in PSI with one
+ * decimal, coolant in the display unit (TEMP_UNIT_F). The checksum is the
+ * XOR of the characters between '$' and '*', as in NMEA.
+ */
+
+#ifndef TREND_AGGREGATOR_H
+#define TREND_AGGREGATOR_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "clock.h"
+
+#define AGG_LINE_MAX            192         // Longest possible $AGH line + checksum
+
+typedef struct {
+    int32_t min;
+    int32_t max;
+    int32_t sum;
+} AggChannel_t;
+
+typedef struct {
+    uint32_t start;             // clockMillis() of the first sample
+    uint32_t end;               // ... of the last
+    uint16_t samples;
+    AggChannel_t rpm;
+    AggChannel_t oil;           // 0.1 PSI
+    AggChannel_t coolant;
+    uint32_t binOilSum[AGG_RPM_BINS];
+    uint16_t binSamples[AGG_RPM_BINS];
+    uint16_t hist[AGG_RPM_BINS][AGG_OIL_BINS];
+} AggPeriod_t;
+
+typedef struct {
+    uint32_t periods;           // Closed and sent
+    uint32_t lines;
+    uint32_t seq;               // Of the last period sent
+} AggStats_t;
+
+class TrendAggregator {
+public:
+    TrendAggregator(Print& out);
+    
+    // One sample (engine running)
+    void add(uint16_t rpm, uint16_t oilTenths, int16_t coolant, uint32_t now);
+    
+    // Close the period when due and send the next pending line
+    void service(uint32_t now);
+    
+    // When service() next has work
+    uint32_t nextDeadline(uint32_t now);
+    
+    AggStats_t getStats();
+
+private:
+    Print& _out;
+    
+    AggPeriod_t _current;
+    AggPeriod_t _sending;
+    uint32_t _seq;
+    
+    // Line of _sending to go next: 0 = $AGG, then RPM bin + 1
+    uint8_t _sendLine;
+    bool _sendPending;
+    uint32_t _nextSend;
+    
+    AggStats_t _stats;
+    
+    void close(uint32_t now);
+    void sendLine();
+    void writeLine(char* line, int len);
+};
+
+#endif // TREND_AGGREGATOR_H
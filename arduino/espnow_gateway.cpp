@@ -0,0 +1,413 @@
+// ESP32 sketch bridging ESP-NOW wheel nodes to MQTT.
+//
+// Corner nodes (wheel.cpp built with WHEEL_TRANSPORT_ESPNOW) send their
+// readings here over ESP-NOW; this is the only device that joins the
+// car-pi hotspot and holds a broker connection. Topics and payloads are
+// the same as wheel.cpp publishes in MQTT mode, plus a gateway status
+// topic with per-node receive and loss counts.
+//
+// The gateway syncs its clock to the car-pi (time_sync.h) and stamps each
+// reading with epoch time: every node's micros() is mapped onto the
+// gateway's clock from the frames' send times (see trackNodeClock).
+//
+// Hardware: any ESP32 within radio range of all four corners and the
+// hotspot. Set wheel.cpp's gateway_mac to the MAC this prints at boot.
+//
+// ESP-NOW frames are received on the hotspot's channel, so the car-pi
+// hostapd channel must equal ESPNOW_CHANNEL (espnow_link.h).
+//
+// This file is intentionally a .cpp so you can add it to an ESP32 Arduino
+// project. If you prefer an .ino, rename accordingly.
+
+#include <WiFi.h>
+#include <PubSubClient.h>
+#include <esp_now.h>
+
+// Frame format shared with wheel.cpp
+#include "espnow_link.h"
+
+// Client id without a heap String
+#include "mqtt_payload.h"
+
+// Epoch timestamps
+#include "time_sync.h"
+
+// --- WiFi credentials ---
+// Legacy sketch — load from arduino_secrets.h (see .env + Makefile)
+#include "arduino_secrets.h"
+const char *ssid = SECRET_WIFI_SSID;
+const char *password = SECRET_WIFI_PASS;
+
+// MQTT Broker
+const char *mqtt_broker = "192.168.50.24";
+const char *mqtt_base_topic = "vtms"; // publishes vtms/<vehicle>/<side>/<position>/... like wheel.cpp
+const char *mqtt_username = "";
+const char *mqtt_password = "";
+const int mqtt_port = 1883;
+
+#define RX_QUEUE          32     // Frames buffered between the WiFi task and loop()
+#define MAX_NODES         8      // Corners tracked for status (2 cars x 4)
+#define STATUS_INTERVAL   10000  // ms between gateway status messages
+#define RECONNECT_MIN_MS  1000   // Broker reconnect backoff
+#define RECONNECT_MAX_MS  30000
+#define NODE_DRIFT_PPM    100    // Worst case node vs gateway crystal (2x +-50 ppm)
+
+WiFiClient espClient;
+PubSubClient mqttClient(espClient);
+TimeSync_t timeSync;
+
+// --- Receive queue (ESP-NOW callback runs on the WiFi task) ---
+typedef struct
+{
+    int64_t rxUs; // timeSyncLocalUs() on arrival
+    uint8_t len;
+    uint8_t data[ESPNOW_MAX_PAYLOAD];
+} RxFrame_t;
+
+RxFrame_t rxQueue[RX_QUEUE];
+volatile uint8_t rxHead = 0; // Next slot to write
+volatile uint8_t rxTail = 0; // Next slot to read
+volatile uint32_t rxOverruns = 0;
+portMUX_TYPE rxMux = portMUX_INITIALIZER_UNLOCKED;
+
+// --- Per-node accounting ---
+typedef struct
+{
+    char vehicle[WHEEL_VEHICLE_LEN + 1];
+    uint8_t corner;
+    uint16_t lastSeq;
+    uint32_t received;
+    uint32_t lost;       // Sequence gaps
+    unsigned long lastSeen;
+
+    // Node clock: gateway local us = node us (unwrapped) + offsetUs
+    bool clocked;
+    int64_t nodeUs;      // Latest send time, node micros() unwrapped to 64 bits
+    int64_t offsetUs;
+    int64_t offsetAtUs;  // Gateway time of the last update
+} Node_t;
+
+Node_t nodes[MAX_NODES];
+int nodeCount = 0;
+uint32_t droppedOffline = 0; // Readings received while the broker was down
+unsigned long lastStatus = 0;
+unsigned long lastReconnect = 0;
+unsigned long reconnectDelay = RECONNECT_MIN_MS;
+
+void onEspnowReceive(const uint8_t *mac, const uint8_t *data, int len)
+{
+    int64_t rxUs = timeSyncLocalUs();
+    if (len <= 0 || len > ESPNOW_MAX_PAYLOAD)
+        return;
+
+    portENTER_CRITICAL(&rxMux);
+    uint8_t next = (rxHead + 1) % RX_QUEUE;
+    if (next == rxTail)
+    {
+        rxOverruns++;
+    }
+    else
+    {
+        rxQueue[rxHead].rxUs = rxUs;
+        rxQueue[rxHead].len = len;
+        memcpy(rxQueue[rxHead].data, data, len);
+        rxHead = next;
+    }
+    portEXIT_CRITICAL(&rxMux);
+}
+
+bool popFrame(RxFrame_t *out)
+{
+    bool ok = false;
+    portENTER_CRITICAL(&rxMux);
+    if (rxTail != rxHead)
+    {
+        memcpy(out, &rxQueue[rxTail], sizeof(RxFrame_t));
+        rxTail = (rxTail + 1) % RX_QUEUE;
+        ok = true;
+    }
+    portEXIT_CRITICAL(&rxMux);
+    return ok;
+}
+
+Node_t *findNode(const WheelHeader_t *h)
+{
+    char vehicle[WHEEL_VEHICLE_LEN + 1];
+    memcpy(vehicle, h->vehicle, WHEEL_VEHICLE_LEN);
+    vehicle[WHEEL_VEHICLE_LEN] = '\0';
+
+    for (int i = 0; i < nodeCount; i++)
+    {
+        if (nodes[i].corner == h->corner && strcmp(nodes[i].vehicle, vehicle) == 0)
+            return &nodes[i];
+    }
+    if (nodeCount == MAX_NODES)
+        return NULL;
+
+    Node_t *node = &nodes[nodeCount++];
+    memset(node, 0, sizeof(Node_t));
+    strcpy(node->vehicle, vehicle);
+    node->corner = h->corner;
+    node->lastSeq = h->seq - 1;
+    Serial.printf("New node %s/%s/%s\n", vehicle, wheelCornerSide(h->corner), wheelCornerPosition(h->corner));
+    return node;
+}
+
+// One-way delay is never shorter than the airtime, so the smallest
+// (arrival - send - airtime) seen is the offset between the two clocks.
+// The estimate rises at NODE_DRIFT_PPM between frames so it can follow a
+// crystal running the other way; fast frames pull it back down.
+void trackNodeClock(Node_t *node, uint32_t sentUs, int64_t rxUs, int len)
+{
+    if (node->clocked)
+        node->nodeUs += (int32_t)(sentUs - (uint32_t)node->nodeUs);
+    else
+        node->nodeUs = sentUs;
+
+    int64_t sample = rxUs - node->nodeUs - wheelAirtimeUs(len);
+    if (node->clocked)
+        node->offsetUs += (rxUs - node->offsetAtUs) * NODE_DRIFT_PPM / 1000000;
+    if (!node->clocked || sample < node->offsetUs)
+        node->offsetUs = sample;
+    node->offsetAtUs = rxUs;
+    node->clocked = true;
+}
+
+// Node micros() near its latest send time -> node us unwrapped
+int64_t nodeLocalUs(const Node_t *node, uint32_t us)
+{
+    return node->nodeUs + (int32_t)(us - (uint32_t)node->nodeUs);
+}
+
+// topic = mqtt_base_topic/vehicle/side/position[/sensor][/suffix]
+void nodeTopic(char *topic, size_t size, const Node_t *node, const WheelHeader_t *h, const char *suffix)
+{
+    char sensor[WHEEL_SENSOR_LEN + 1];
+    memcpy(sensor, h->sensor, WHEEL_SENSOR_LEN);
+    sensor[WHEEL_SENSOR_LEN] = '\0';
+
+    int off = snprintf(topic, size, "%s/%s/%s/%s", mqtt_base_topic, node->vehicle,
+                       wheelCornerSide(node->corner), wheelCornerPosition(node->corner));
+    if (sensor[0]) off += snprintf(topic + off, size - off, "/%s", sensor);
+    if (suffix) snprintf(topic + off, size - off, "/%s", suffix);
+}
+
+// Formats a 0.01 degC value like wheel.cpp's dtostrf(value, 6, 2)
+void formatTemp(char *buf, int16_t raw)
+{
+    float c;
+    if (wheelDecodeTemp(raw, &c))
+        dtostrf(c, 6, 2, buf);
+    else
+        strcpy(buf, "null");
+}
+
+void publishReading(const Node_t *node, const WheelReading_t *msg)
+{
+    static const char *zoneName[3] = {"inside", "middle", "outside"};
+    char topic[128];
+    char value[3][16];
+
+    for (int z = 0; z < 3; z++)
+    {
+        formatTemp(value[z], msg->zone[z]);
+        if (msg->zone[z] != WHEEL_TEMP_INVALID)
+        {
+            nodeTopic(topic, sizeof(topic), node, &msg->header, zoneName[z]);
+            mqttClient.publish(topic, value[z]);
+        }
+    }
+
+    // "ts" stays node ms since boot, as wheel.cpp sends in MQTT mode
+    int64_t sampleUs = nodeLocalUs(node, msg->sampleUs);
+    unsigned long ts = (unsigned long)(sampleUs / 1000);
+    char epoch[48] = "";
+    int64_t epochUs = timeSyncEpochUs(&timeSync, sampleUs + node->offsetUs);
+    if (epochUs)
+    {
+        strcpy(epoch, ",\"epoch_ms\":");
+        timeSyncFormatMs(epoch + strlen(epoch), sizeof(epoch) - strlen(epoch), epochUs);
+    }
+
+    char payload[256];
+    nodeTopic(topic, sizeof(topic), node, &msg->header, NULL);
+    snprintf(payload, sizeof(payload), "{\"ts\":%lu%s,\"inside\":%s,\"middle\":%s,\"outside\":%s}",
+             ts, epoch, value[0], value[1], value[2]);
+    mqttClient.publish(topic, payload);
+
+    // Thermocouples ride along with the primary sensor's readings only
+    int count = msg->thermoCount < WHEEL_MAX_THERMO ? msg->thermoCount : WHEEL_MAX_THERMO;
+    if (count == 0)
+        return;
+
+    // Latest thermocouple values as of the reading
+    int off = snprintf(payload, sizeof(payload), "{\"ts\":%lu%s", ts, epoch);
+    for (int i = 0; i < count; i++)
+    {
+        char s[16];
+        formatTemp(s, msg->thermo[i]);
+        if (msg->thermo[i] != WHEEL_TEMP_INVALID)
+        {
+            char suffix[48];
+            snprintf(suffix, sizeof(suffix), "thermocouple/%s", wheelThermoName[i]);
+            nodeTopic(topic, sizeof(topic), node, &msg->header, suffix);
+            mqttClient.publish(topic, s);
+        }
+        off += snprintf(payload + off, sizeof(payload) - off, ",\"%s\":%s", wheelThermoName[i], s);
+    }
+    snprintf(payload + off, sizeof(payload) - off, "}");
+    nodeTopic(topic, sizeof(topic), node, &msg->header, "thermocouples");
+    mqttClient.publish(topic, payload);
+}
+
+void handleFrame(const RxFrame_t *rx)
+{
+    uint8_t type = wheelCheckFrame(rx->data, rx->len);
+    if (type == 0)
+        return;
+
+    const WheelHeader_t *h = (const WheelHeader_t *)rx->data;
+    Node_t *node = findNode(h);
+    if (node == NULL)
+        return;
+
+    uint16_t gap = h->seq - node->lastSeq - 1;
+    if (gap < 1000) // Larger jumps are a node reboot, not loss
+        node->lost += gap;
+    else
+        node->clocked = false; // and its clock restarted
+    trackNodeClock(node, h->timestamp, rx->rxUs, rx->len);
+    node->lastSeq = h->seq;
+    node->received++;
+    node->lastSeen = millis();
+
+    // Stale readings are useless to the pit wall; don't queue them
+    if (!mqttClient.connected())
+    {
+        droppedOffline++;
+        return;
+    }
+
+    if (type == WHEEL_MSG_READING)
+    {
+        publishReading(node, (const WheelReading_t *)rx->data);
+    }
+    else
+    {
+        char topic[128];
+        nodeTopic(topic, sizeof(topic), node, h, "frame");
+        mqttClient.publish(topic, rx->data + sizeof(WheelHeader_t), rx->len - sizeof(WheelHeader_t));
+    }
+}
+
+void publishStatus()
+{
+    char topic[64];
+    snprintf(topic, sizeof(topic), "%s/gateway/status", mqtt_base_topic);
+
+    char payload[768];
+    int off = snprintf(payload, sizeof(payload),
+                       "{\"ts\":%lu,\"overruns\":%lu,\"offline\":%lu,\"synced\":%s,\"sync_err_us\":%ld,\"nodes\":[",
+                       (unsigned long)millis(), (unsigned long)rxOverruns, (unsigned long)droppedOffline,
+                       timeSync.synced ? "true" : "false", (long)timeSyncErrorUs(&timeSync));
+    for (int i = 0; i < nodeCount; i++)
+    {
+        const Node_t *n = &nodes[i];
+        off += snprintf(payload + off, sizeof(payload) - off,
+                        "%s{\"node\":\"%s/%s/%s\",\"rx\":%lu,\"lost\":%lu,\"age\":%lu}",
+                        i ? "," : "", n->vehicle, wheelCornerSide(n->corner), wheelCornerPosition(n->corner),
+                        (unsigned long)n->received, (unsigned long)n->lost, millis() - n->lastSeen);
+    }
+    snprintf(payload + off, sizeof(payload) - off, "]}");
+    mqttClient.publish(topic, payload);
+}
+
+// Non-blocking: ESP-NOW keeps receiving while the hotspot or broker is away
+void maintainMqtt()
+{
+    // Once the hotspot is up; the socket survives later reconnects
+    if (!timeSync.running && WiFi.status() == WL_CONNECTED)
+        timeSyncBegin(&timeSync, WiFi.gatewayIP());
+    timeSyncPoll(&timeSync);
+
+    if (mqttClient.connected())
+    {
+        mqttClient.loop();
+        return;
+    }
+    if (WiFi.status() != WL_CONNECTED || millis() - lastReconnect < reconnectDelay)
+        return;
+    lastReconnect = millis();
+
+    char client_id[MQTT_CLIENT_ID_MAX];
+    mqttClientId(client_id, sizeof(client_id), "esp32-gateway-");
+    if (mqttClient.connect(client_id, mqtt_username, mqtt_password))
+    {
+        Serial.println("MQTT broker connected");
+        mqttClient.publish(mqtt_base_topic, "ESP-NOW wheel gateway online");
+        reconnectDelay = RECONNECT_MIN_MS;
+    }
+    else
+    {
+        Serial.printf("MQTT connect failed, state %d, retry in %lu ms\n", mqttClient.state(), reconnectDelay);
+        reconnectDelay = min(reconnectDelay * 2, (unsigned long)RECONNECT_MAX_MS);
+    }
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    delay(200);
+    Serial.println("ESP-NOW Wheel Gateway (ESP32)");
+
+    WiFi.mode(WIFI_STA);
+    WiFi.setAutoReconnect(true);
+    WiFi.setSleep(false); // Time sync replies straight away, not at the next beacon
+    // Channel hint: stay on the ESP-NOW channel while looking for the hotspot
+    WiFi.begin(ssid, password, ESPNOW_CHANNEL);
+    Serial.printf("Gateway MAC %s (set as gateway_mac in wheel.cpp)\n", WiFi.macAddress().c_str());
+
+    unsigned long start = millis();
+    while (WiFi.status() != WL_CONNECTED && millis() - start < 15000)
+    {
+        delay(250);
+    }
+    if (WiFi.status() == WL_CONNECTED && WiFi.channel() != ESPNOW_CHANNEL)
+    {
+        Serial.printf("WARNING: hotspot is on channel %d, nodes send on %d\n", WiFi.channel(), ESPNOW_CHANNEL);
+    }
+
+    if (esp_now_init() != ESP_OK)
+    {
+        Serial.println("ESP-NOW init failed");
+        return;
+    }
+    esp_now_register_recv_cb(onEspnowReceive);
+
+    mqttClient.setServer(mqtt_broker, mqtt_port);
+    // Room for the status JSON (8 nodes) and ESPNOW_MAX_PAYLOAD frame packets
+    mqttClient.setBufferSize(1024);
+}
+
+void loop()
+{
+    maintainMqtt();
+
+    RxFrame_t rx;
+    while (popFrame(&rx))
+    {
+        handleFrame(&rx);
+    }
+
+    if (millis() - lastStatus >= STATUS_INTERVAL)
+    {
+        lastStatus = millis();
+        if (mqttClient.connected())
+            publishStatus();
+        Serial.printf("nodes %d, overruns %lu, offline drops %lu, time %s (+-%ld us, %.1f ppm)\n", nodeCount,
+                      (unsigned long)rxOverruns, (unsigned long)droppedOffline,
+                      timeSync.synced ? "synced" : "unsynced", (long)timeSyncErrorUs(&timeSync), timeSync.driftPpm);
+    }
+
+    delay(1);
+}
@@ -0,0 +1,137 @@
+// espnow_link.h - wheel node <-> gateway ESP-NOW frames.
+//
+// Shared by wheel.cpp (WHEEL_TRANSPORT_ESPNOW) and espnow_gateway.cpp.
+// Corner nodes skip WiFi association and the broker: each reading goes out
+// as one ESP-NOW frame (no TCP, no reconnect), and the gateway - the only
+// device on the car-pi hotspot - republishes it on the usual MQTT topics.
+//
+// ESP-NOW transmits on the radio's current channel, and the gateway's
+// channel is set by the hotspot it joins. ESPNOW_CHANNEL must match the
+// car-pi hostapd channel; the gateway warns at boot if it doesn't.
+//
+// Nodes have no network time. Header timestamps are the node's micros()
+// at send; the gateway tracks each node's clock against its own synced
+// one (time_sync.h) and converts sampleUs to epoch time.
+
+#ifndef ESPNOW_LINK_H
+#define ESPNOW_LINK_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define ESPNOW_CHANNEL     6
+#define ESPNOW_MAGIC       0x57 // 'W'
+#define ESPNOW_VERSION     3
+#define ESPNOW_MAX_PAYLOAD 250  // ESP_NOW_MAX_DATA_LEN
+#define ESPNOW_OVERHEAD    43   // 802.11 action frame bytes around the payload
+
+// Message types
+#define WHEEL_MSG_READING  1 // Zone means + thermocouples (fixed size)
+#define WHEEL_MSG_FRAME    2 // thermal_codec.h packet
+
+// Corners: bit 0 = side (0 left, 1 right), bit 1 = position (0 front, 1 rear)
+#define WHEEL_CORNER_RIGHT 0x01
+#define WHEEL_CORNER_REAR  0x02
+
+#define WHEEL_VEHICLE_LEN  8    // Vehicle name, NUL-padded (not terminated at 8)
+#define WHEEL_SENSOR_LEN   8    // MLX sensor name, same; empty = primary sensor
+#define WHEEL_MAX_THERMO   4
+#define WHEEL_TEMP_INVALID INT16_MIN
+
+typedef struct __attribute__((packed))
+{
+    uint8_t magic;
+    uint8_t version;
+    uint8_t type;
+    uint8_t corner;
+    char vehicle[WHEEL_VEHICLE_LEN];
+    char sensor[WHEEL_SENSOR_LEN]; // Topic segment after <position>
+    uint16_t seq;       // Per node, all message types; gaps = lost frames
+    uint32_t timestamp; // Sender micros() just before esp_now_send
+} WheelHeader_t;
+
+typedef struct __attribute__((packed))
+{
+    WheelHeader_t header;
+    uint32_t sampleUs;                // Sender micros() when the frame was ready
+    int16_t zone[3];                  // inside, middle, outside; 0.01 degC
+    uint8_t thermoCount;              // 0 except on the primary sensor
+    int16_t thermo[WHEEL_MAX_THERMO]; // 0.01 degC, names in wheelThermoName
+} WheelReading_t;
+
+typedef struct __attribute__((packed))
+{
+    WheelHeader_t header;
+    uint8_t data[ESPNOW_MAX_PAYLOAD - sizeof(WheelHeader_t)];
+} WheelFrame_t;
+
+// Thermocouple names by index (topic suffixes), same order as wheel.cpp
+static const char *const wheelThermoName[WHEEL_MAX_THERMO] = {"brake", "wheel", "thermo2", "thermo3"};
+
+inline int16_t wheelEncodeTemp(float c)
+{
+    if (c != c || c > 327.0f || c < -327.0f) // NaN or out of int16 range
+        return WHEEL_TEMP_INVALID;
+    return (int16_t)(c * 100.0f + (c < 0 ? -0.5f : 0.5f));
+}
+
+inline bool wheelDecodeTemp(int16_t raw, float *c)
+{
+    if (raw == WHEEL_TEMP_INVALID)
+        return false;
+    *c = raw / 100.0f;
+    return true;
+}
+
+inline uint8_t wheelCorner(const char *side, const char *position)
+{
+    return (strcmp(side, "right") == 0 ? WHEEL_CORNER_RIGHT : 0) |
+           (strcmp(position, "rear") == 0 ? WHEEL_CORNER_REAR : 0);
+}
+
+inline const char *wheelCornerSide(uint8_t corner)
+{
+    return corner & WHEEL_CORNER_RIGHT ? "right" : "left";
+}
+
+inline const char *wheelCornerPosition(uint8_t corner)
+{
+    return corner & WHEEL_CORNER_REAR ? "rear" : "front";
+}
+
+inline void wheelFillHeader(WheelHeader_t *h, uint8_t type, uint8_t corner, const char *vehicle,
+                            const char *sensor, uint16_t seq, uint32_t timestamp)
+{
+    h->magic = ESPNOW_MAGIC;
+    h->version = ESPNOW_VERSION;
+    h->type = type;
+    h->corner = corner;
+    strncpy(h->vehicle, vehicle, WHEEL_VEHICLE_LEN);
+    strncpy(h->sensor, sensor, WHEEL_SENSOR_LEN);
+    h->seq = seq;
+    h->timestamp = timestamp;
+}
+
+// Time on air at ESP-NOW's default 1 Mbps: 192 us long preamble, then
+// 8 us per byte. Delivery can never be faster than this.
+inline uint32_t wheelAirtimeUs(int len)
+{
+    return 192 + (uint32_t)(len + ESPNOW_OVERHEAD) * 8;
+}
+
+// Checks a received frame; returns its message type or 0 if invalid.
+inline uint8_t wheelCheckFrame(const uint8_t *data, int len)
+{
+    if (len < (int)sizeof(WheelHeader_t))
+        return 0;
+    const WheelHeader_t *h = (const WheelHeader_t *)data;
+    if (h->magic != ESPNOW_MAGIC || h->version != ESPNOW_VERSION)
+        return 0;
+    if (h->type == WHEEL_MSG_READING && len == (int)sizeof(WheelReading_t))
+        return WHEEL_MSG_READING;
+    if (h->type == WHEEL_MSG_FRAME && len > (int)sizeof(WheelHeader_t))
+        return WHEEL_MSG_FRAME;
+    return 0;
+}
+
+#endif // ESPNOW_LINK_H
@@ -1,5 +1,6 @@
 #include <WiFi.h>
 #include <PubSubClient.h>
+#include "mqtt_payload.h"
 
 // WiFi credentials — load from arduino_secrets.h (see .env + Makefile)
 #include "arduino_secrets.h"
@@ -38,10 +39,10 @@ void setup() {
     client.setServer(mqtt_broker, mqtt_port);
     client.setCallback(callback);
     while (!client.connected()) {
-        String client_id = "esp32-client-";
-        client_id += String(WiFi.macAddress());
-        Serial.printf("The client %s connects to the public MQTT broker\n", client_id.c_str());
-        if (client.connect(client_id.c_str(), mqtt_username, mqtt_password)) {
+        char client_id[MQTT_CLIENT_ID_MAX];
+        mqttClientId(client_id, sizeof(client_id), "esp32-client-");
+        Serial.printf("The client %s connects to the public MQTT broker\n", client_id);
+        if (client.connect(client_id, mqtt_username, mqtt_password)) {
             Serial.println("MQTT broker connected to The Grid");
         } else {
             Serial.print("failed with state ");
@@ -56,45 +57,40 @@ void setup() {
 }
 
 void callback(char *topic, byte *payload, unsigned int length) {
-    char msg[length + 1];
-    memcpy(msg, payload, length);
-    msg[length] = '\0';
+    MqttPayload_t msg;
+    mqttPayloadView(&msg, payload, length);
     Serial.printf("Message arrived in topic: %s\n", topic);
-    Serial.printf("Message: %s\n", msg);
+    Serial.printf("Message: %s%s\n", msg.text, msg.truncated ? "..." : "");
     Serial.println("-----------------------");
     if (strcmp(topic, "lemons/flag/black") == 0) {
-        // Copy payload to a null-terminated string
-        if (strcmp(msg, "true") == 0) {
+        if (mqttPayloadIs(payload, length, "true")) {
             digitalWrite(black_flag_gpio, HIGH);
         }
-        if (strcmp(msg, "false") == 0) {
+        if (mqttPayloadIs(payload, length, "false")) {
             digitalWrite(black_flag_gpio, LOW);
         }
     }
     if (strcmp(topic, "lemons/flag/red") == 0) {
-        // Copy payload to a null-terminated string
-        if (strcmp(msg, "true") == 0) {
+        if (mqttPayloadIs(payload, length, "true")) {
             digitalWrite(red_flag_gpio, HIGH);
         }
-        if (strcmp(msg, "false") == 0) {
+        if (mqttPayloadIs(payload, length, "false")) {
             digitalWrite(red_flag_gpio, LOW);
         }
     }
     if (strcmp(topic, "lemons/pit") == 0) {
-        // Copy payload to a null-terminated string
-        if (strcmp(msg, "true") == 0) {
+        if (mqttPayloadIs(payload, length, "true")) {
             digitalWrite(pit_soon_gpio, HIGH);
         }
-        if (strcmp(msg, "false") == 0) {
+        if (mqttPayloadIs(payload, length, "false")) {
             digitalWrite(pit_soon_gpio, LOW);
         }
     }
     if (strcmp(topic, "lemons/box") == 0) {
-        // Copy payload to a null-terminated string
-        if (strcmp(msg, "true") == 0) {
+        if (mqttPayloadIs(payload, length, "true")) {
             digitalWrite(box_box_gpio, HIGH);
         }
-        if (strcmp(msg, "false") == 0) {
+        if (mqttPayloadIs(payload, length, "false")) {
             digitalWrite(box_box_gpio, LOW);
         }
     }
@@ -0,0 +1,226 @@
+/*
+ * AdcScan.cpp - Continuous multi-channel ADC scanning implementation
+ */
+
+#include "AdcScan.h"
+
+#ifdef ESP32
+#include <esp_idf_version.h>
+#include <driver/adc.h>
+#include <driver/i2s.h>
+#include <soc/syscon_reg.h>
+
+// The 3.x core's own ADC driver aborts at boot next to the legacy one
+#if ESP_IDF_VERSION_MAJOR >= 5
+#error "AdcScan needs the Arduino-ESP32 2.x core (ESP-IDF 4.4)"
+#endif
+
+#define ADC_SCAN_I2S            I2S_NUM_0   // Only I2S0 can take the ADC
+#define ADC_SCAN_DMA_SAMPLES    128     // Conversions per DMA buffer
+#define ADC_SCAN_DMA_BUFFERS    4
+#define ADC_SCAN_EVENTS         4
+#define ADC_SCAN_TASK_STACK     3072
+#define ADC_SCAN_TASK_PRIORITY  5       // Above loop() (1), below WiFi
+
+static QueueHandle_t adcScanEvents;
+#endif
+
+AdcScan::AdcScan() : _count(0), _overruns(0) {
+    memset(_slotOf, 0xFF, sizeof(_slotOf));
+    memset(_sum, 0, sizeof(_sum));
+    memset(_n, 0, sizeof(_n));
+    memset(_seq, 0, sizeof(_seq));
+    for (int i = 0; i < ADC_SCAN_MAX_CHANNELS; i++) {
+        _latest[i] = 0;
+    }
+}
+
+int8_t AdcScan::adcChannelOf(uint8_t pin) {
+    switch (pin) {
+        case 36: return 0;
+        case 37: return 1;
+        case 38: return 2;
+        case 39: return 3;
+        case 32: return 4;
+        case 33: return 5;
+        case 34: return 6;
+        case 35: return 7;
+        default: return -1;
+    }
+}
+
+bool AdcScan::begin(const AdcScanChannel_t* channels, uint8_t count, uint32_t sampleHz) {
+    if (count == 0 || count > ADC_SCAN_MAX_CHANNELS) {
+        return false;
+    }
+
+    uint32_t mask = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        int8_t ch = adcChannelOf(channels[i].pin);
+        if (ch < 0 || (mask & (1 << ch)) ||
+            channels[i].oversampleLog2 > ADC_SCAN_MAX_OVERSAMPLE) {
+            return false;
+        }
+        mask |= 1 << ch;
+        _channels[i] = channels[i];
+        _slotOf[ch] = i;
+    }
+    _count = count;
+
+#ifdef ESP32
+    // eFuse Vref / two-point values where the chip has them, 1100 mV otherwise
+    esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, 1100, &_cal);
+
+    // On the classic ESP32 the ADC's DMA path is I2S0 in ADC mode (IDF
+    // 4.4 has no adc_digi_* continuous driver for it)
+    i2s_config_t i2s = {};
+    i2s.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_ADC_BUILT_IN);
+    i2s.sample_rate = sampleHz;
+    i2s.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT;
+    i2s.channel_format = I2S_CHANNEL_FMT_ONLY_LEFT;
+    i2s.communication_format = I2S_COMM_FORMAT_STAND_I2S;
+    i2s.dma_buf_count = ADC_SCAN_DMA_BUFFERS;
+    i2s.dma_buf_len = ADC_SCAN_DMA_SAMPLES;
+    if (i2s_driver_install(ADC_SCAN_I2S, &i2s, ADC_SCAN_EVENTS, &adcScanEvents) != ESP_OK) {
+        return false;
+    }
+    if (i2s_set_adc_mode(ADC_UNIT_1, (adc1_channel_t)adcChannelOf(_channels[0].pin)) != ESP_OK ||
+        i2s_adc_enable(ADC_SCAN_I2S) != ESP_OK) {
+        i2s_driver_uninstall(ADC_SCAN_I2S);
+        return false;
+    }
+
+    // i2s_adc_enable() leaves a one-entry pattern table (the channel given
+    // to i2s_set_adc_mode). Load every channel so the controller steps
+    // through them, one conversion per entry. Entries are one byte,
+    // channel << 4 | width << 2 | attenuation (3 = 12 bit, 3 = 11 dB),
+    // four per register with the first in the top byte.
+    uint32_t table[2] = { 0, 0 };
+    for (uint8_t i = 0; i < count; i++) {
+        uint32_t entry = (adcChannelOf(_channels[i].pin) << 4) | (3 << 2) | 3;
+        table[i / 4] |= entry << (24 - 8 * (i % 4));
+    }
+    WRITE_PERI_REG(SYSCON_SARADC_SAR1_PATT_TAB1_REG, table[0]);
+    WRITE_PERI_REG(SYSCON_SARADC_SAR1_PATT_TAB2_REG, table[1]);
+    SET_PERI_REG_BITS(SYSCON_SARADC_CTRL_REG, SYSCON_SARADC_SAR1_PATT_LEN, count - 1,
+                      SYSCON_SARADC_SAR1_PATT_LEN_S);
+
+    // Core 0, with WiFi; loop() runs on core 1
+    if (xTaskCreatePinnedToCore(scanTask, "adcscan", ADC_SCAN_TASK_STACK, this,
+                                ADC_SCAN_TASK_PRIORITY, NULL, 0) != pdPASS) {
+        i2s_adc_disable(ADC_SCAN_I2S);
+        i2s_driver_uninstall(ADC_SCAN_I2S);
+        return false;
+    }
+#else
+    (void)sampleHz;
+#endif
+
+    return true;
+}
+
+#ifdef ESP32
+void AdcScan::scanTask(void* arg) {
+    AdcScan* scan = (AdcScan*)arg;
+    uint16_t buf[ADC_SCAN_DMA_SAMPLES];
+
+    for (;;) {
+        size_t len = 0;
+        if (i2s_read(ADC_SCAN_I2S, buf, sizeof(buf), &len, portMAX_DELAY) != ESP_OK) {
+            continue;
+        }
+
+        // The driver dropped a full DMA buffer because we fell behind
+        i2s_event_t event;
+        while (xQueueReceive(adcScanEvents, &event, 0) == pdTRUE) {
+            if (event.type == I2S_EVENT_RX_Q_OVF) {
+                scan->_overruns++;
+            }
+        }
+
+        // Each conversion is tagged: channel in the top 4 bits, 12-bit code
+        // below (the I2S word order within a pair doesn't matter)
+        for (size_t i = 0; i < len / sizeof(buf[0]); i++) {
+            scan->feed(buf[i] >> 12, buf[i] & 0x0FFF);
+        }
+    }
+}
+#endif
+
+void AdcScan::poll() {
+#ifndef ESP32
+    for (uint8_t i = 0; i < _count; i++) {
+        uint8_t ch = adcChannelOf(_channels[i].pin);
+        for (uint16_t k = 0; k < (1u << _channels[i].oversampleLog2); k++) {
+            feed(ch, analogRead(_channels[i].pin));
+        }
+    }
+#endif
+}
+
+void AdcScan::feed(uint8_t adcChannel, uint16_t raw) {
+    if (adcChannel >= ADC_SCAN_MAX_CHANNELS) {
+        return;
+    }
+    uint8_t i = _slotOf[adcChannel];
+    if (i >= _count) {
+        return;
+    }
+
+    _sum[i] += raw & 0x0FFF;
+    uint8_t shift = _channels[i].oversampleLog2;
+    if (++_n[i] < (1u << shift)) {
+        return;
+    }
+
+    // Keep 4 fractional bits: averaging 2^n conversions resolves finer
+    // than one LSB once there is a little noise to dither it
+    uint32_t code16 = (_sum[i] << 4) >> shift;
+    _sum[i] = 0;
+    _n[i] = 0;
+
+    if (++_seq[i] == 0) {
+        _seq[i] = 1;
+    }
+    uint32_t tenthMv = toTenthMv(code16);
+    if (tenthMv > 0xFFFF) {
+        tenthMv = 0xFFFF;
+    }
+    // One aligned 32-bit store: readers see the old or the new value, never half
+    _latest[i] = ((uint32_t)_seq[i] << 16) | tenthMv;
+}
+
+uint32_t AdcScan::toTenthMv(uint32_t code16) const {
+#ifdef ESP32
+    // The calibration curve is per code; interpolate the fraction
+    uint32_t code = code16 >> 4;
+    uint32_t frac = code16 & 0x0F;
+    uint32_t lo = esp_adc_cal_raw_to_voltage(code, &_cal);
+    uint32_t hi = (code < 4095) ? esp_adc_cal_raw_to_voltage(code + 1, &_cal) : lo;
+    if (hi < lo) {
+        hi = lo;
+    }
+    return lo * 10 + ((hi - lo) * 10 * frac + 8) / 16;
+#else
+    return (code16 * ADC_SCAN_FULL_SCALE_MV * 10 + 4095 * 8) / (4095 * 16);
+#endif
+}
+
+bool AdcScan::read(uint8_t ch, AdcReading_t* out) const {
+    if (ch >= _count) {
+        return false;
+    }
+    uint32_t latest = _latest[ch];
+    if ((latest >> 16) == 0) {
+        return false;
+    }
+    out->seq = latest >> 16;
+    out->pinVolts = (latest & 0xFFFF) / 10000.0f;
+    out->volts = out->pinVolts * _channels[ch].scale;
+    return true;
+}
+
+float AdcScan::volts(uint8_t ch) const {
+    AdcReading_t reading;
+    return read(ch, &reading) ? reading.volts : NAN;
+}
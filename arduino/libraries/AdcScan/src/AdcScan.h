@@ -0,0 +1,102 @@
+/*
+ * AdcScan.h - Continuous multi-channel ADC scanning
+ *
+ * Replaces blocking analogRead() loops. On the ESP32 the ADC digital
+ * controller round-robins the configured ADC1 channels into DMA through
+ * I2S0 (ADC mode) at ADC_SCAN_SAMPLE_HZ, and a small task on core 0
+ * averages each channel's conversions (2^oversampleLog2 per reading),
+ * applies the eFuse calibration and stores the result. loop() code just
+ * reads the latest value - it never waits on the ADC.
+ *
+ * Needs the Arduino-ESP32 2.x core (ESP-IDF 4.4), like the rest of the
+ * tree. I2S0 is taken while the scan runs.
+ *
+ * The latest-value table is one 32-bit word per channel (sequence number +
+ * pin voltage), written by the scan task alone, so readers on either core
+ * get a consistent value without a lock.
+ *
+ * Elsewhere (the host simulation) there is no DMA: poll() takes the
+ * conversions with analogRead() instead, and the rest is the same.
+ *
+ * Only ADC1 pins (GPIO32-39) can be scanned - ADC2 is shared with WiFi.
+ * While the scan runs, analogRead() on ADC1 pins is not available.
+ */
+
+#ifndef ADC_SCAN_H
+#define ADC_SCAN_H
+
+#include <Arduino.h>
+#ifdef ESP32
+#include <esp_adc_cal.h>
+#endif
+
+#define ADC_SCAN_MAX_CHANNELS   8       // ADC1 channels
+#define ADC_SCAN_SAMPLE_HZ      20000   // Conversions/s, all channels
+#define ADC_SCAN_MAX_OVERSAMPLE 10      // Up to 1024 conversions per reading
+#define ADC_SCAN_FULL_SCALE_MV  3300    // Uncalibrated full scale (11 dB attenuation)
+
+typedef struct {
+    uint8_t pin;                // ADC1 pin, GPIO32-39
+    uint8_t oversampleLog2;     // Average 2^n conversions per reading
+    float scale;                // Sensor volts per pin volt (voltage divider ratio)
+} AdcScanChannel_t;
+
+typedef struct {
+    float volts;                // At the sensor: pin volts * scale
+    float pinVolts;             // At the ESP32 pin
+    uint16_t seq;               // Advances with each new reading (never 0)
+} AdcReading_t;
+
+class AdcScan {
+public:
+    AdcScan();
+
+    // Start scanning. Channel i of the table is read back as channel i.
+    // Returns false if a pin isn't on ADC1 or the ADC driver fails.
+    bool begin(const AdcScanChannel_t* channels, uint8_t count,
+               uint32_t sampleHz = ADC_SCAN_SAMPLE_HZ);
+
+    // Without DMA, take one reading of every channel now; no-op on the ESP32
+    void poll();
+
+    // Latest reading of channel ch; false until the first one is ready
+    bool read(uint8_t ch, AdcReading_t* out) const;
+
+    // Latest sensor volts, NAN if none yet
+    float volts(uint8_t ch) const;
+
+    uint8_t channelCount() const { return _count; }
+
+    // Times the DMA pool overflowed because the scan task fell behind
+    uint32_t overruns() const { return _overruns; }
+
+    // Add one 12-bit conversion for ADC1 channel adcChannel (scan task)
+    void feed(uint8_t adcChannel, uint16_t raw);
+
+    // ADC1 channel of a GPIO, -1 if the pin isn't on ADC1
+    static int8_t adcChannelOf(uint8_t pin);
+
+private:
+    AdcScanChannel_t _channels[ADC_SCAN_MAX_CHANNELS];
+    uint8_t _count;
+    uint8_t _slotOf[ADC_SCAN_MAX_CHANNELS];     // ADC1 channel -> table index
+
+    // Decimator state, scan task only
+    uint32_t _sum[ADC_SCAN_MAX_CHANNELS];
+    uint16_t _n[ADC_SCAN_MAX_CHANNELS];
+    uint16_t _seq[ADC_SCAN_MAX_CHANNELS];
+
+    // Latest values: seq << 16 | pin voltage in 0.1 mV
+    volatile uint32_t _latest[ADC_SCAN_MAX_CHANNELS];
+    volatile uint32_t _overruns;
+
+    // Average (in 1/16 LSB) to 0.1 mV at the pin
+    uint32_t toTenthMv(uint32_t code16) const;
+
+#ifdef ESP32
+    esp_adc_cal_characteristics_t _cal;
+    static void scanTask(void* arg);
+#endif
+};
+
+#endif // ADC_SCAN_H
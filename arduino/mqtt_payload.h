@@ -0,0 +1,57 @@
+// mqtt_payload.h - fixed-size MQTT payload and client id buffers.
+//
+// Header-only, shared by the sketches. PubSubClient hands callbacks a
+// pointer into its own buffer; copying it into a char msg[length + 1]
+// stack array sizes the frame from the network, so one large message on
+// a wildcard subscription (lemons/#) can overrun the loop task's stack.
+// MqttPayload_t copies at most MQTT_PAYLOAD_MAX - 1 bytes and records
+// whether the rest was cut off; mqttPayloadIs() compares in place.
+//
+// Client ids are formatted into a char array rather than a heap String.
+//
+// Usage:
+//   MqttPayload_t msg;
+//   mqttPayloadView(&msg, payload, length);
+//   if (mqttPayloadIs(payload, length, "true")) ...
+
+#ifndef MQTT_PAYLOAD_H
+#define MQTT_PAYLOAD_H
+
+#include <string.h>
+#include <WiFi.h>
+
+#define MQTT_PAYLOAD_MAX    64      // Longest payload a callback looks at, + NUL
+#define MQTT_CLIENT_ID_MAX  40      // "<prefix>" + "XX:XX:XX:XX:XX:XX" + NUL
+
+typedef struct
+{
+    char text[MQTT_PAYLOAD_MAX];    // NUL-terminated, truncated if needed
+    unsigned int length;            // Full payload length
+    bool truncated;
+} MqttPayload_t;
+
+inline void mqttPayloadView(MqttPayload_t *p, const uint8_t *payload, unsigned int length)
+{
+    unsigned int n = length < MQTT_PAYLOAD_MAX - 1 ? length : MQTT_PAYLOAD_MAX - 1;
+    memcpy(p->text, payload, n);
+    p->text[n] = '\0';
+    p->length = length;
+    p->truncated = n < length;
+}
+
+// Exact match against a C string, without copying the payload.
+inline bool mqttPayloadIs(const uint8_t *payload, unsigned int length, const char *text)
+{
+    return strlen(text) == length && memcmp(payload, text, length) == 0;
+}
+
+// prefix + the station MAC, e.g. "esp32-client-24:6F:28:AA:BB:CC"
+inline void mqttClientId(char *buf, size_t size, const char *prefix)
+{
+    uint8_t mac[6];
+    WiFi.macAddress(mac);
+    snprintf(buf, size, "%s%02X:%02X:%02X:%02X:%02X:%02X",
+             prefix, mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
+
+#endif // MQTT_PAYLOAD_H
@@ -0,0 +1,109 @@
+// publish_policy.h - decide when a sensor reading is worth publishing.
+//
+// Header-only, shared by temp.cpp and thermoprobe.cpp. Instead of
+// publishing every sample, a reading goes out when:
+// - it moved at least deadband from the last published value,
+// - nothing was published for heartbeatMs (subscribers can tell a quiet
+//   sensor from a dead one), or
+// - the value is moving faster than burstRate per second. The sketch
+//   then samples every burstIntervalMs and publishes every change, until
+//   the value has been calm for burstHoldMs.
+//
+// A reading only counts as published once client.publish() succeeds, so
+// one that fails stays due and goes out with the next sample.
+//
+// Usage:
+//   if (publishPolicyDue(&policy, value, now) && client.publish(...))
+//       publishPolicyMarkSent(&policy, value, now);
+//   delay(publishPolicySampleMs(&policy, millis()));
+
+#ifndef PUBLISH_POLICY_H
+#define PUBLISH_POLICY_H
+
+#include <math.h>
+
+typedef struct
+{
+    float deadband;                // Change that triggers a publish
+    unsigned long heartbeatMs;     // Longest silence
+    unsigned long sampleMs;        // Sample period when calm
+    float burstRate;               // |change| per second that starts a burst
+    unsigned long burstIntervalMs; // Sample / publish period in a burst
+    unsigned long burstHoldMs;     // Stay in burst this long after the last fast sample
+} PublishPolicyConfig_t;
+
+typedef struct
+{
+    PublishPolicyConfig_t cfg;
+    bool published;             // false until the first publish (or after publishPolicyForce)
+    float lastValue;            // Last published
+    unsigned long lastPublish;
+    bool sampled;
+    float lastSample;
+    unsigned long lastSampleAt;
+    unsigned long burstUntil;
+    bool bursting;
+} PublishPolicy_t;
+
+inline void publishPolicyInit(PublishPolicy_t *p, const PublishPolicyConfig_t &cfg)
+{
+    p->cfg = cfg;
+    p->published = false;
+    p->sampled = false;
+    p->bursting = false;
+}
+
+// Publish the next sample regardless. Call after an MQTT reconnect: the
+// last publish() may have succeeded into a connection that then died.
+inline void publishPolicyForce(PublishPolicy_t *p)
+{
+    p->published = false;
+}
+
+inline bool publishPolicyBursting(const PublishPolicy_t *p, unsigned long now)
+{
+    return p->bursting && (long)(p->burstUntil - now) > 0;
+}
+
+// Feed one sample; returns true if it should be published. NaN samples are
+// never published.
+inline bool publishPolicyDue(PublishPolicy_t *p, float value, unsigned long now)
+{
+    if (isnan(value))
+        return false;
+
+    if (p->sampled && now != p->lastSampleAt)
+    {
+        float rate = fabsf(value - p->lastSample) * 1000.0f / (now - p->lastSampleAt);
+        if (rate >= p->cfg.burstRate)
+        {
+            p->bursting = true;
+            p->burstUntil = now + p->cfg.burstHoldMs;
+        }
+    }
+    p->sampled = true;
+    p->lastSample = value;
+    p->lastSampleAt = now;
+
+    if (!p->published || now - p->lastPublish >= p->cfg.heartbeatMs)
+        return true;
+    if (publishPolicyBursting(p, now))
+        return value != p->lastValue && now - p->lastPublish >= p->cfg.burstIntervalMs;
+    return fabsf(value - p->lastValue) >= p->cfg.deadband;
+}
+
+// The sample publishPolicyDue() passed was published.
+inline void publishPolicyMarkSent(PublishPolicy_t *p, float value, unsigned long now)
+{
+    p->published = true;
+    p->lastValue = value;
+    p->lastPublish = now;
+}
+
+// How long to wait before the next sample.
+inline unsigned long publishPolicySampleMs(const PublishPolicy_t *p, unsigned long now)
+{
+    return publishPolicyBursting(p, now) ? p->cfg.burstIntervalMs : p->cfg.sampleMs;
+}
+
+#endif // PUBLISH_POLICY_H
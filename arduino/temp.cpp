@@ -1,5 +1,9 @@
 #include <WiFi.h>
 #include <PubSubClient.h>
+#include <AdcScan.h>
+#include "mqtt_payload.h"
+#include "publish_policy.h"
+#include "time_sync.h"
 // WiFi credentials — load from arduino_secrets.h (see .env + Makefile)
 #include "arduino_secrets.h"
 const char *ssid = SECRET_WIFI_SSID;
@@ -12,11 +16,48 @@ const char *mqtt_username = "";
 const char *mqtt_password = "";
 const int mqtt_port = 1883;
 
-#define REF_VOLTAGE    3.3
-#define ADC_RESOLUTION 4096.0
+// Analog inputs, scanned in the background by the AdcScan library
+// (arduino/libraries/AdcScan). One row per sender, ADC1 pins only
+// (GPIO32-39); each publishes its volts to its topic on change.
+typedef struct {
+    AdcScanChannel_t adc;           // pin, oversampleLog2, divider ratio
+    const char *topic;
+    PublishPolicyConfig_t policy;   // see publish_policy.h
+} AnalogInput_t;
+
+// Publish on change: ADC noise is a few mV, a warming transmission moves
+// hundredths of a volt per minute; heartbeat stays inside the 15 s MQTT keepalive
+const AnalogInput_t inputs[] = {
+    // Transmission temperature sender on GPIO36 (A0), 256 conversions per reading
+    {{36, 8, 1.0}, "lemons/temp/transmission", {0.02, 5000, 500, 0.05, 100, 3000}},
+};
+#define INPUT_COUNT (sizeof(inputs) / sizeof(inputs[0]))
+
+AdcScan adc;
+PublishPolicy_t policy[INPUT_COUNT];
 
 WiFiClient espClient;
 PubSubClient client(espClient);
+TimeSync_t timeSync;
+unsigned long lastMqttAttempt = 0;
+const unsigned long mqttRetryMs = 2000;
+
+// One attempt to reach the broker; announces and subscribes once connected
+bool mqttConnect() {
+    char client_id[MQTT_CLIENT_ID_MAX];
+    mqttClientId(client_id, sizeof(client_id), "esp32-client-");
+    Serial.printf("The client %s connects to the public MQTT broker\n", client_id);
+    if (!client.connect(client_id, mqtt_username, mqtt_password)) {
+        Serial.print("failed with state ");
+        Serial.println(client.state());
+        return false;
+    }
+    Serial.println("MQTT broker connected to The Grid");
+    // Publish and subscribe
+    client.publish(topic, "Hi, I'm VTMS MQTT Sensor");
+    client.subscribe(topic);
+    return true;
+}
 
 void setup() {
     // Set software serial baud to 9600;
@@ -28,46 +69,77 @@ void setup() {
         Serial.println("Connecting to WiFi..");
     }
     Serial.println("Connected to the Wi-Fi network");
+    // Epoch timestamps from the car-pi (the hotspot gateway); replies
+    // need to arrive now, not at the next beacon
+    WiFi.setSleep(false);
+    timeSyncBegin(&timeSync, WiFi.gatewayIP());
     //connecting to a mqtt broker
     client.setServer(mqtt_broker, mqtt_port);
     client.setCallback(callback);
-    while (!client.connected()) {
-        String client_id = "esp32-client-";
-        client_id += String(WiFi.macAddress());
-        Serial.printf("The client %s connects to the public MQTT broker\n", client_id.c_str());
-        if (client.connect(client_id.c_str(), mqtt_username, mqtt_password)) {
-            Serial.println("MQTT broker connected to The Grid");
-        } else {
-            Serial.print("failed with state ");
-            Serial.print(client.state());
-            delay(2000);
-        }
+    while (!mqttConnect()) {
+        delay(mqttRetryMs);
     }
-    // Publish and subscribe
-    client.publish(topic, "Hi, I'm VTMS MQTT Sensor");
-    client.subscribe(topic);
 
+    AdcScanChannel_t channels[INPUT_COUNT];
+    for (size_t i = 0; i < INPUT_COUNT; i++) {
+        channels[i] = inputs[i].adc;
+        publishPolicyInit(&policy[i], inputs[i].policy);
+    }
+    if (!adc.begin(channels, INPUT_COUNT)) {
+        Serial.println("ADC scan failed to start");
+    }
 }
 
 void callback(char *topic, byte *payload, unsigned int length) {
-    char msg[length + 1];
-    memcpy(msg, payload, length);
-    msg[length] = '\0';
+    MqttPayload_t msg;
+    mqttPayloadView(&msg, payload, length);
     Serial.printf("Message arrived in topic: %s\n", topic);
-    Serial.printf("Message: %s\n", msg);
+    Serial.printf("Message: %s%s\n", msg.text, msg.truncated ? "..." : "");
     Serial.println("-----------------------");
 }
 
 void loop() {
-    int sensorValue = analogRead(A0);
-    // Convert the analog reading (which goes from 0 - 1023) to a voltage (0 - 5V):
-    float voltage = ((float)sensorValue * REF_VOLTAGE) / ADC_RESOLUTION;
-    // print out the value you read:
-    Serial.println(voltage);
-    
-    // Convert float to string for MQTT publishing
-    char voltageStr[10];
-    dtostrf(voltage, 6, 3, voltageStr);
-    client.publish("lemons/temp/transmission", voltageStr);
-    delay(500);
-}
\ No newline at end of file
+    timeSyncPoll(&timeSync);
+
+    unsigned long now = millis();
+
+    // Broker lost (WiFi drop, broker restart): retry without stalling the
+    // samples, and republish every input once back
+    if (!client.connected() && now - lastMqttAttempt >= mqttRetryMs) {
+        lastMqttAttempt = now;
+        if (mqttConnect()) {
+            for (size_t i = 0; i < INPUT_COUNT; i++) {
+                publishPolicyForce(&policy[i]);
+            }
+        }
+        now = millis();
+    }
+
+    unsigned long wait = 0;
+    for (size_t i = 0; i < INPUT_COUNT; i++) {
+        // Latest calibrated reading; NAN until the first one (never published)
+        float voltage = adc.volts(i);
+        int64_t epochUs = timeSyncNowUs(&timeSync);
+        // print out the value you read:
+        Serial.println(voltage);
+
+        if (publishPolicyDue(&policy[i], voltage, now)) {
+            // Convert float to string for MQTT publishing
+            char voltageStr[10], payload[64];
+            dtostrf(voltage, 1, 3, voltageStr);
+            // With its epoch time once synced
+            timeSyncStamped(payload, sizeof(payload), epochUs, voltageStr);
+            // Not sent (disconnected): stays due for the next sample
+            if (client.publish(inputs[i].topic, payload)) {
+                publishPolicyMarkSent(&policy[i], voltage, now);
+            }
+        }
+
+        unsigned long sampleMs = publishPolicySampleMs(&policy[i], now);
+        if (i == 0 || sampleMs < wait) {
+            wait = sampleMs;
+        }
+    }
+    client.loop();
+    delay(wait);
+}
@@ -0,0 +1,177 @@
+// thermal_codec.h - compress MLX90641 frames for streaming.
+//
+// Header-only like tire_zones.h, so wheel.cpp and the host benchmarks
+// share it. arduino/tools/thermal_decode.py is the matching decoder.
+//
+// Pixels are quantised to 0.1 degC int16 (THERMAL_INVALID for NaN / inf).
+// Keyframes predict each pixel from its left neighbour (raster order);
+// other frames predict it from the same pixel in the previous frame. The
+// residual is zigzag mapped and Rice coded with one k per frame, chosen
+// to minimise the frame size. A keyframe every THERMAL_KEYFRAME_INTERVAL
+// frames lets a receiver that missed a message resync.
+//
+// Packet layout (multi-byte fields little-endian):
+//   0     THERMAL_CODEC_VERSION
+//   1     flags (THERMAL_FLAG_KEY)
+//   2     width
+//   3     height
+//   4-5   sequence number (a delta frame needs seq - 1 decoded)
+//   6     Rice parameter k
+//   7-    Rice codes, MSB first. Quotient q in unary (q ones, a zero) then
+//         k remainder bits; q >= THERMAL_RICE_ESCAPE is sent as
+//         THERMAL_RICE_ESCAPE ones and the 16-bit zigzag value.
+
+#ifndef THERMAL_CODEC_H
+#define THERMAL_CODEC_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef THERMAL_MAX_PIXELS
+#define THERMAL_MAX_PIXELS 192 // 16x12
+#endif
+
+#define THERMAL_CODEC_VERSION     1
+#define THERMAL_FLAG_KEY          0x01
+#define THERMAL_HEADER_BYTES      7
+#define THERMAL_INVALID           INT16_MIN
+#define THERMAL_KEYFRAME_INTERVAL 16
+#define THERMAL_RICE_ESCAPE       20
+#define THERMAL_RICE_MAX_K        12
+
+// Worst case packet size (every pixel escaped)
+#define THERMAL_MAX_BYTES(pixels) \
+    (THERMAL_HEADER_BYTES + ((pixels) * (THERMAL_RICE_ESCAPE + 16) + 7) / 8)
+
+typedef struct
+{
+    int16_t prev[THERMAL_MAX_PIXELS]; // Last frame sent, quantised
+    bool hasPrev;
+    uint16_t seq;
+    uint16_t sinceKey; // Frames since the last keyframe
+} ThermalEncoder_t;
+
+// Force the next frame to be a keyframe (e.g. after an MQTT reconnect).
+inline void thermalEncoderReset(ThermalEncoder_t *enc)
+{
+    enc->hasPrev = false;
+}
+
+inline int16_t thermalQuantize(float c)
+{
+    if (isnan(c) || !isfinite(c))
+        return THERMAL_INVALID;
+    float q = c * 10.0f;
+    if (q > 32767.0f)
+        return 32767;
+    if (q < -32767.0f)
+        return -32767;
+    return (int16_t)lroundf(q);
+}
+
+// Residual to unsigned: 0, -1, 1, -2 ... -> 0, 1, 2, 3 ...
+inline uint16_t thermalZigzag(int16_t r)
+{
+    return (uint16_t)(((uint16_t)r << 1) ^ (uint16_t)(r >> 15));
+}
+
+inline uint32_t thermalRiceBits(uint16_t u, int k)
+{
+    uint32_t q = u >> k;
+    return q < THERMAL_RICE_ESCAPE ? q + 1 + k : THERMAL_RICE_ESCAPE + 16;
+}
+
+typedef struct
+{
+    uint8_t *out;
+    size_t bits; // Bits written
+} ThermalBitWriter_t;
+
+inline void thermalPutBits(ThermalBitWriter_t *w, uint32_t value, int count)
+{
+    while (count-- > 0)
+    {
+        size_t byte = w->bits >> 3;
+        uint8_t mask = 0x80 >> (w->bits & 7);
+        if ((w->bits & 7) == 0)
+            w->out[byte] = 0;
+        if ((value >> count) & 1)
+            w->out[byte] |= mask;
+        w->bits++;
+    }
+}
+
+// Encode one frame (degC, row-major) into out. Returns the packet length,
+// or 0 if the frame is larger than THERMAL_MAX_PIXELS or out is smaller
+// than THERMAL_MAX_BYTES(width * height).
+inline size_t thermalEncode(ThermalEncoder_t *enc, const float *frame, int width, int height,
+                            uint8_t *out, size_t outSize)
+{
+    int pixels = width * height;
+    if (width <= 0 || width > 255 || height <= 0 || height > 255 || pixels > THERMAL_MAX_PIXELS)
+        return 0;
+    if (outSize < (size_t)THERMAL_MAX_BYTES(pixels))
+        return 0;
+
+    bool key = !enc->hasPrev || enc->sinceKey + 1 >= THERMAL_KEYFRAME_INTERVAL;
+
+    // Quantise and form residuals; keep this frame as the next reference
+    uint16_t residual[THERMAL_MAX_PIXELS];
+    int16_t left = 0;
+    for (int i = 0; i < pixels; i++)
+    {
+        int16_t v = thermalQuantize(frame[i]);
+        int16_t predicted = key ? left : enc->prev[i];
+        residual[i] = thermalZigzag((int16_t)(uint16_t)(v - predicted));
+        enc->prev[i] = v;
+        left = v;
+    }
+
+    // Pick k by exact cost; frames are small enough to try them all
+    int bestK = 0;
+    uint32_t bestBits = UINT32_MAX;
+    for (int k = 0; k <= THERMAL_RICE_MAX_K; k++)
+    {
+        uint32_t bits = 0;
+        for (int i = 0; i < pixels; i++)
+            bits += thermalRiceBits(residual[i], k);
+        if (bits < bestBits)
+        {
+            bestBits = bits;
+            bestK = k;
+        }
+    }
+
+    enc->seq++;
+    enc->hasPrev = true;
+    enc->sinceKey = key ? 0 : enc->sinceKey + 1;
+
+    out[0] = THERMAL_CODEC_VERSION;
+    out[1] = key ? THERMAL_FLAG_KEY : 0;
+    out[2] = (uint8_t)width;
+    out[3] = (uint8_t)height;
+    out[4] = enc->seq & 0xFF;
+    out[5] = enc->seq >> 8;
+    out[6] = (uint8_t)bestK;
+
+    ThermalBitWriter_t w = {out + THERMAL_HEADER_BYTES, 0};
+    for (int i = 0; i < pixels; i++)
+    {
+        uint16_t u = residual[i];
+        uint32_t q = u >> bestK;
+        if (q < THERMAL_RICE_ESCAPE)
+        {
+            thermalPutBits(&w, (1UL << (q + 1)) - 2, q + 1); // q ones, then a zero
+            thermalPutBits(&w, u, bestK);
+        }
+        else
+        {
+            thermalPutBits(&w, (1UL << THERMAL_RICE_ESCAPE) - 1, THERMAL_RICE_ESCAPE);
+            thermalPutBits(&w, u, 16);
+        }
+    }
+    return THERMAL_HEADER_BYTES + (w.bits + 7) / 8;
+}
+
+#endif // THERMAL_CODEC_H
@@ -1,6 +1,9 @@
 #include <WiFi.h>
 #include <PubSubClient.h>
 #include "max6675.h"
+#include "mqtt_payload.h"
+#include "publish_policy.h"
+#include "time_sync.h"
 // WiFi credentials — load from arduino_secrets.h (see .env + Makefile)
 #include "arduino_secrets.h"
 const char *ssid = SECRET_WIFI_SSID;
@@ -17,13 +20,45 @@ int thermoDO = 12;
 int thermoCS = 15;
 int thermoCLK = 14;
 
-long temp_C, temp_F;
+float temp_C, temp_F;
 char buf[16];
 
+// Publish on change: the topic carries whole degrees F, so a 1 F deadband
+// publishes every visible change; heartbeat stays inside the 15 s MQTT keepalive
+PublishPolicy_t policy;
+const PublishPolicyConfig_t policyConfig = {
+    1.0,    // deadband, F
+    5000,   // heartbeatMs
+    500,    // sampleMs
+    2.0,    // burstRate, F/s
+    250,    // burstIntervalMs - the MAX6675 needs 250 ms per conversion
+    3000,   // burstHoldMs
+};
+
 MAX6675 thermocouple(thermoCLK, thermoCS, thermoDO);
 
 WiFiClient espClient;
 PubSubClient client(espClient);
+TimeSync_t timeSync;
+unsigned long lastMqttAttempt = 0;
+const unsigned long mqttRetryMs = 3000;
+
+// One attempt to reach the broker; announces and subscribes once connected
+bool mqttConnect() {
+    char client_id[MQTT_CLIENT_ID_MAX];
+    mqttClientId(client_id, sizeof(client_id), "esp32-client-");
+    Serial.printf("The client %s connects to the public MQTT broker\n", client_id);
+    if (!client.connect(client_id, mqtt_username, mqtt_password)) {
+        Serial.print("failed with state ");
+        Serial.println(client.state());
+        return false;
+    }
+    Serial.println("MQTT broker connected to The Grid");
+    // Publish and subscribe
+    client.publish(topic, "Hi, I'm VTMS MQTT Sensor");
+    client.subscribe(topic);
+    return true;
+}
 
 void setup() {
     // initialize serial communication at 115200 bits per second:
@@ -36,32 +71,25 @@ void setup() {
         Serial.println("Connecting to WiFi..");
     }
     Serial.println("Connected to the Wi-Fi network");
+    // Epoch timestamps from the car-pi (the hotspot gateway); replies
+    // need to arrive now, not at the next beacon
+    WiFi.setSleep(false);
+    timeSyncBegin(&timeSync, WiFi.gatewayIP());
     //connecting to a mqtt broker
     client.setServer(mqtt_broker, mqtt_port);
     client.setCallback(callback);
-    while (!client.connected()) {
-        String client_id = "esp32-client-";
-        client_id += String(WiFi.macAddress());
-        Serial.printf("The client %s connects to the public MQTT broker\n", client_id.c_str());
-        if (client.connect(client_id.c_str(), mqtt_username, mqtt_password)) {
-            Serial.println("MQTT broker connected to The Grid");
-        } else {
-            Serial.print("failed with state ");
-            Serial.print(client.state());
-            delay(3000);
-        }
+    while (!mqttConnect()) {
+        delay(mqttRetryMs);
     }
-    // Publish and subscribe
-    client.publish(topic, "Hi, I'm VTMS MQTT Sensor");
-    client.subscribe(topic);
+
+    publishPolicyInit(&policy, policyConfig);
 }
 
 void callback(char *topic, byte *payload, unsigned int length) {
-    char msg[length + 1];
-    memcpy(msg, payload, length);
-    msg[length] = '\0';
+    MqttPayload_t msg;
+    mqttPayloadView(&msg, payload, length);
     Serial.printf("Message arrived in topic: %s\n", topic);
-    Serial.printf("Message: %s\n", msg);
+    Serial.printf("Message: %s%s\n", msg.text, msg.truncated ? "..." : "");
     Serial.println("-----------------------");
 }
 
@@ -69,12 +97,35 @@ void loop() {
      // For the MAX6675 to update, you must delay AT LEAST 250ms between reads!
     temp_C = thermocouple.readCelsius();    /*Read Temperature on °C*/
     temp_F = thermocouple.readFahrenheit(); 
+    int64_t epochUs = timeSyncNowUs(&timeSync);
 
     // print out the values you read:
-    Serial.printf("temp_C = %dC\n", temp_C);
-    Serial.printf("temp_F = %dF\n", temp_F);
-    ltoa(temp_F,buf,10);
-    client.publish("lemons/temp/oil_F", buf);
+    Serial.printf("temp_C = %.2fC\n", temp_C);
+    Serial.printf("temp_F = %.2fF\n", temp_F);
+
+    // Broker lost (WiFi drop, broker restart): retry every few seconds and
+    // republish once back
+    if (!client.connected() && millis() - lastMqttAttempt >= mqttRetryMs) {
+        lastMqttAttempt = millis();
+        if (mqttConnect()) {
+            publishPolicyForce(&policy);
+        }
+    }
+
+    // NAN (open thermocouple) is never published; a failed publish stays due
+    unsigned long now = millis();
+    if (publishPolicyDue(&policy, temp_F, now)) {
+        ltoa(lroundf(temp_F),buf,10);
+        // With its epoch time once synced
+        char payload[64];
+        timeSyncStamped(payload, sizeof(payload), epochUs, buf);
+        if (client.publish("lemons/temp/oil_F", payload)) {
+            publishPolicyMarkSent(&policy, temp_F, now);
+        }
+    }
+    client.loop();
+    timeSyncPoll(&timeSync);
 
-    delay(500);  // delay in between reads for clear read from serial
+    // Never below 250 ms - see above
+    delay(publishPolicySampleMs(&policy, millis()));
 }
\ No newline at end of file
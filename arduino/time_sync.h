@@ -0,0 +1,319 @@
+// time_sync.h - epoch timestamps for sensor nodes, synced to the car-pi.
+//
+// Header-only, shared by wheel.cpp, espnow_gateway.cpp, temp.cpp and
+// thermoprobe.cpp. An SNTP client for chrony on the car-pi (see
+// deploy/roles/car_pi), tuned for sub-millisecond stamps:
+// - each sync is a burst of TIME_SYNC_BURST requests and only the fastest
+//   round trip is used - WiFi queueing only ever adds delay,
+// - replies are timestamped on the lwIP task as they arrive (AsyncUDP),
+//   not whenever loop() gets round to them,
+// - the crystal's frequency error (10-40 ppm: up to 1 ms every 25 s) is
+//   measured over a window of several minutes and corrected between syncs.
+//
+// The local clock is esp_timer_get_time(), microseconds since boot. Until
+// the first sync timeSyncEpochUs() returns 0; callers leave the stamp out.
+//
+// Usage (after WiFi connects; the hotspot gateway is the car-pi):
+//   timeSyncBegin(&timeSync, WiFi.gatewayIP());
+//   timeSyncPoll(&timeSync);                        // every loop()
+//   int64_t us = timeSyncEpochUs(&timeSync, timeSyncLocalUs());
+//
+// Modem sleep holds replies until the next beacon; turn it off
+// (WiFi.setSleep(false)) on nodes that need sub-millisecond stamps.
+
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef ESP32
+#include <AsyncUDP.h>
+#include <esp_timer.h>
+#endif
+
+#define TIME_SYNC_PORT          123
+#define TIME_SYNC_BURST         8          // Requests per sync; the fastest round trip wins
+#define TIME_SYNC_GAP_US        20000      // Between requests in a burst
+#define TIME_SYNC_WAIT_US       100000     // For the last reply of a burst
+#define TIME_SYNC_INTERVAL_US   16000000LL // Between syncs
+#define TIME_SYNC_RETRY_US      2000000LL  // Between syncs until the first one succeeds
+#define TIME_SYNC_MAX_DELAY_US  20000      // Slower round trips are discarded
+#define TIME_SYNC_DELAY_SLACK_US 500       // Accept up to 1.5x the best recent round trip + this
+#define TIME_SYNC_STEP_US       100000     // Bigger error: the server's clock stepped, start over
+#define TIME_SYNC_DRIFT_SPAN_US 8000000LL  // Shortest span to measure drift over
+#define TIME_SYNC_ANCHOR_US     256000000LL // Drift window: between 1x and 2x this once warm
+#define TIME_SYNC_MAX_PPM       500.0f
+
+#define TIME_SYNC_NTP_UNIX      2208988800UL // Seconds from 1900 (NTP) to 1970
+
+typedef struct
+{
+    int64_t localUs; // Midpoint of the exchange, local clock
+    int64_t epochUs; // Server time at that moment
+    int32_t delayUs; // Round trip minus time spent in the server
+} TimeSyncSample_t;
+
+typedef struct
+{
+    // Model: epoch = baseEpochUs + d + d * driftPpm / 1e6, d = local - baseLocalUs
+    bool synced;
+    int64_t baseLocalUs;
+    int64_t baseEpochUs;
+    float driftPpm;
+
+    // Drift is measured against an older sample; nextAnchor replaces it
+    // once the window is 2x TIME_SYNC_ANCHOR_US
+    TimeSyncSample_t anchor, nextAnchor;
+    bool hasNextAnchor;
+
+    int32_t minDelayUs; // Best recent round trip; creeps up while samples are rejected
+    int32_t lastDelayUs;
+    uint32_t syncs;
+    uint32_t failures; // Bursts with no usable reply
+
+#ifdef ESP32
+    AsyncUDP udp;
+    bool running;
+    uint8_t sent;             // Requests sent in the current burst
+    int64_t burstStartUs;
+    int64_t lastSendUs;
+    int64_t nextBurstUs;
+    TimeSyncSample_t best;    // Fastest reply of the burst (UDP task writes)
+    bool haveBest;
+    portMUX_TYPE mux;
+#endif
+} TimeSync_t;
+
+// 64-bit NTP timestamp (big-endian seconds since 1900 + 2^-32 fraction) to
+// Unix microseconds. Wraps correctly through the 2036 NTP era rollover.
+inline int64_t timeSyncNtpToUs(const uint8_t *p)
+{
+    uint32_t sec = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+    uint32_t frac = (uint32_t)p[4] << 24 | (uint32_t)p[5] << 16 | (uint32_t)p[6] << 8 | p[7];
+    return (int64_t)(uint32_t)(sec - TIME_SYNC_NTP_UNIX) * 1000000 +
+           (int64_t)(((uint64_t)frac * 1000000) >> 32);
+}
+
+// t1/t4: local send/receive; t2/t3: server receive/transmit
+inline void timeSyncSampleFrom(int64_t t1, int64_t t2, int64_t t3, int64_t t4, TimeSyncSample_t *s)
+{
+    s->delayUs = (int32_t)((t4 - t1) - (t3 - t2));
+    s->localUs = t1 + (t4 - t1) / 2;
+    s->epochUs = t2 + (t3 - t2) / 2;
+}
+
+inline void timeSyncReset(TimeSync_t *ts)
+{
+    ts->synced = false;
+    ts->driftPpm = 0;
+    ts->hasNextAnchor = false;
+    ts->minDelayUs = TIME_SYNC_MAX_DELAY_US;
+    ts->lastDelayUs = 0;
+}
+
+// Epoch microseconds at local time localUs, 0 if not synced yet
+inline int64_t timeSyncEpochUs(const TimeSync_t *ts, int64_t localUs)
+{
+    if (!ts->synced)
+        return 0;
+    int64_t d = localUs - ts->baseLocalUs;
+    return ts->baseEpochUs + d + (int64_t)((float)d * ts->driftPpm * 1e-6f);
+}
+
+// Feeds the best sample of a burst into the model; false if discarded
+inline bool timeSyncApply(TimeSync_t *ts, const TimeSyncSample_t *s)
+{
+    if (s->delayUs < 0 || s->delayUs > TIME_SYNC_MAX_DELAY_US)
+        return false;
+
+    // A burst where every reply was queued is worse than the drift model:
+    // skip it, but loosen the gate so a lasting change in latency gets in
+    if (ts->synced && s->delayUs > ts->minDelayUs + ts->minDelayUs / 2 + TIME_SYNC_DELAY_SLACK_US)
+    {
+        ts->minDelayUs += ts->minDelayUs / 4;
+        return false;
+    }
+    if (s->delayUs < ts->minDelayUs)
+        ts->minDelayUs = s->delayUs;
+
+    if (ts->synced)
+    {
+        int64_t err = s->epochUs - timeSyncEpochUs(ts, s->localUs);
+        if (err > TIME_SYNC_STEP_US || err < -TIME_SYNC_STEP_US)
+            timeSyncReset(ts); // Server stepped (e.g. chrony found GPS/internet)
+    }
+
+    if (!ts->synced)
+    {
+        ts->anchor = *s;
+    }
+    else
+    {
+        // Frequency error over the whole window; sample noise (a few
+        // hundred us) is diluted by the span instead of by filtering
+        int64_t span = s->localUs - ts->anchor.localUs;
+        if (span >= TIME_SYNC_DRIFT_SPAN_US)
+        {
+            float ppm = (float)((s->epochUs - ts->anchor.epochUs) - span) * 1e6f / (float)span;
+            if (ppm > TIME_SYNC_MAX_PPM) ppm = TIME_SYNC_MAX_PPM;
+            if (ppm < -TIME_SYNC_MAX_PPM) ppm = -TIME_SYNC_MAX_PPM;
+            ts->driftPpm = ppm;
+        }
+        if (!ts->hasNextAnchor && span >= TIME_SYNC_ANCHOR_US)
+        {
+            ts->nextAnchor = *s;
+            ts->hasNextAnchor = true;
+        }
+        else if (ts->hasNextAnchor && span >= 2 * TIME_SYNC_ANCHOR_US)
+        {
+            ts->anchor = ts->nextAnchor;
+            ts->hasNextAnchor = false;
+        }
+    }
+
+    ts->baseLocalUs = s->localUs;
+    ts->baseEpochUs = s->epochUs;
+    ts->lastDelayUs = s->delayUs;
+    ts->synced = true;
+    ts->syncs++;
+    return true;
+}
+
+// Worst-case error of the last sync: the whole round trip on one leg
+inline int32_t timeSyncErrorUs(const TimeSync_t *ts)
+{
+    return ts->lastDelayUs / 2;
+}
+
+// "1760000000123.456": epoch milliseconds with microseconds, for JSON
+inline void timeSyncFormatMs(char *buf, size_t size, int64_t epochUs)
+{
+    uint32_t sec = (uint32_t)(epochUs / 1000000);
+    uint32_t us = (uint32_t)(epochUs % 1000000);
+    snprintf(buf, size, "%lu%03lu.%03lu", (unsigned long)sec, (unsigned long)(us / 1000),
+             (unsigned long)(us % 1000));
+}
+
+// Sensor topic payload: {"epoch_ms":1760000000123.456,"value":<value>},
+// or {"value":<value>} until the first sync (epochUs 0)
+inline void timeSyncStamped(char *buf, size_t size, int64_t epochUs, const char *value)
+{
+    if (!epochUs)
+    {
+        snprintf(buf, size, "{\"value\":%s}", value);
+        return;
+    }
+    char ms[24];
+    timeSyncFormatMs(ms, sizeof(ms), epochUs);
+    snprintf(buf, size, "{\"epoch_ms\":%s,\"value\":%s}", ms, value);
+}
+
+#ifdef ESP32
+inline int64_t timeSyncLocalUs()
+{
+    return esp_timer_get_time();
+}
+
+inline int64_t timeSyncNowUs(const TimeSync_t *ts)
+{
+    return timeSyncEpochUs(ts, timeSyncLocalUs());
+}
+
+// Runs on the AsyncUDP task
+inline void timeSyncOnPacket(TimeSync_t *ts, AsyncUDPPacket &packet)
+{
+    int64_t t4 = timeSyncLocalUs();
+    const uint8_t *p = packet.data();
+    // Server mode, not "unsynchronised", not a kiss-o'-death
+    if (packet.length() < 48 || (p[0] & 0x07) != 4 || (p[0] >> 6) == 3 || p[1] == 0 || p[1] > 15)
+        return;
+
+    // Our transmit time comes back as the originate timestamp
+    int64_t t1;
+    memcpy(&t1, p + 24, sizeof(t1));
+
+    TimeSyncSample_t s;
+    timeSyncSampleFrom(t1, timeSyncNtpToUs(p + 32), timeSyncNtpToUs(p + 40), t4, &s);
+
+    portENTER_CRITICAL(&ts->mux);
+    if (t1 >= ts->burstStartUs && t1 <= t4 && (!ts->haveBest || s.delayUs < ts->best.delayUs))
+    {
+        ts->best = s;
+        ts->haveBest = true;
+    }
+    portEXIT_CRITICAL(&ts->mux);
+}
+
+inline void timeSyncSend(TimeSync_t *ts)
+{
+    uint8_t req[48];
+    memset(req, 0, sizeof(req));
+    req[0] = 0x23; // LI 0, version 4, mode 3 (client)
+    // Transmit timestamp: our local clock, opaque to the server
+    int64_t t1 = timeSyncLocalUs();
+    memcpy(req + 40, &t1, sizeof(t1));
+    ts->udp.write(req, sizeof(req));
+    ts->lastSendUs = t1;
+    ts->sent++;
+}
+
+inline bool timeSyncBegin(TimeSync_t *ts, const IPAddress &server)
+{
+    portMUX_TYPE unlocked = portMUX_INITIALIZER_UNLOCKED;
+    ts->mux = unlocked;
+    ts->udp.close();
+    timeSyncReset(ts);
+    ts->syncs = 0;
+    ts->failures = 0;
+    ts->sent = 0;
+    ts->burstStartUs = 0;
+    ts->haveBest = false;
+    ts->nextBurstUs = timeSyncLocalUs();
+
+    ts->running = ts->udp.connect(server, TIME_SYNC_PORT);
+    if (ts->running)
+        ts->udp.onPacket([ts](AsyncUDPPacket &packet) { timeSyncOnPacket(ts, packet); });
+    return ts->running;
+}
+
+// Call every loop(); never blocks
+inline void timeSyncPoll(TimeSync_t *ts)
+{
+    if (!ts->running)
+        return;
+    int64_t now = timeSyncLocalUs();
+
+    if (ts->sent == 0)
+    {
+        if (now < ts->nextBurstUs)
+            return;
+        portENTER_CRITICAL(&ts->mux);
+        ts->burstStartUs = now;
+        ts->haveBest = false;
+        portEXIT_CRITICAL(&ts->mux);
+        timeSyncSend(ts);
+    }
+    else if (ts->sent < TIME_SYNC_BURST)
+    {
+        if (now - ts->lastSendUs >= TIME_SYNC_GAP_US)
+            timeSyncSend(ts);
+    }
+    else if (now - ts->lastSendUs >= TIME_SYNC_WAIT_US)
+    {
+        portENTER_CRITICAL(&ts->mux);
+        TimeSyncSample_t best = ts->best;
+        bool have = ts->haveBest;
+        ts->haveBest = false;
+        ts->burstStartUs = INT64_MAX; // Late replies are ignored
+        portEXIT_CRITICAL(&ts->mux);
+
+        if (!have || !timeSyncApply(ts, &best))
+            ts->failures++;
+        ts->sent = 0;
+        ts->nextBurstUs = now + (ts->synced ? TIME_SYNC_INTERVAL_US : TIME_SYNC_RETRY_US);
+    }
+}
+#endif
+
+#endif // TIME_SYNC_H
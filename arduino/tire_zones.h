@@ -0,0 +1,157 @@
+// tire_zones.h - reduce an MLX90641 frame to tire zone temperatures.
+//
+// Header-only so wheel.cpp and the host benchmarks (canbus_gauge/bench)
+// share the same code. Frames are row-major, WIDTH columns by HEIGHT rows,
+// in degC; NaN / inf pixels are skipped. tireFilterZones() additionally
+// filters each pixel over time.
+
+#ifndef TIRE_ZONES_H
+#define TIRE_ZONES_H
+
+#include <math.h>
+#include <stdint.h>
+
+// Mean temperature of the columns colStart..colEnd (inclusive), all rows.
+// Returns NAN if no pixel in the region is valid.
+inline float tireZoneAverage(const float *frame, int width, int height, int colStart, int colEnd)
+{
+    float sum = 0.0;
+    int count = 0;
+    for (int r = 0; r < height; r++)
+    {
+        for (int c = colStart; c <= colEnd; c++)
+        {
+            int idx = r * width + c; // row-major index
+            float t = frame[idx];
+            if (!isnan(t) && isfinite(t))
+            {
+                sum += t;
+                count++;
+            }
+        }
+    }
+    if (count == 0)
+        return NAN;
+    return sum / count;
+}
+
+// --- Temporal filter -------------------------------------------------------
+//
+// Per-pixel first-order IIR in Q8 fixed point (1/256 degC), fused with the
+// zone reduction so a frame is walked once. Each pixel moves 2^-shift of
+// the way to its new sample. A sample more than gate away from the
+// estimate is treated as an outlier and dropped, unless gateLimit samples
+// in a row disagree - then it's a real step and the estimate jumps to it.
+// Pixels in the bad-pixel mask never contribute.
+
+#ifndef TIRE_MAX_PIXELS
+#define TIRE_MAX_PIXELS 192 // 16x12
+#endif
+#define TIRE_MAX_ZONES      8
+#define TIRE_FILTER_FRAC    8
+#define TIRE_FILTER_NONE    INT32_MIN // No estimate yet
+
+typedef struct
+{
+    int32_t state[TIRE_MAX_PIXELS];               // Filtered degC, Q8
+    uint8_t gated[TIRE_MAX_PIXELS];               // Consecutive samples rejected
+    uint32_t badMask[(TIRE_MAX_PIXELS + 31) / 32];
+    uint8_t shift;
+    uint8_t gateLimit;
+    int32_t gate;                                 // Q8
+} TireFilter_t;
+
+inline void tireFilterInit(TireFilter_t *f, uint8_t shift, float gateC, uint8_t gateLimit)
+{
+    for (int i = 0; i < TIRE_MAX_PIXELS; i++)
+    {
+        f->state[i] = TIRE_FILTER_NONE;
+        f->gated[i] = 0;
+    }
+    for (int i = 0; i < (TIRE_MAX_PIXELS + 31) / 32; i++)
+        f->badMask[i] = 0;
+    f->shift = shift;
+    f->gateLimit = gateLimit;
+    f->gate = (int32_t)(gateC * (1 << TIRE_FILTER_FRAC));
+}
+
+inline void tireFilterMaskPixel(TireFilter_t *f, int idx)
+{
+    if (idx >= 0 && idx < TIRE_MAX_PIXELS)
+        f->badMask[idx >> 5] |= 1UL << (idx & 31);
+}
+
+// Filters frame in place (bad pixels and pixels with no estimate yet come
+// out NAN) and writes the mean of each zone to zoneOut. Zone z covers the
+// columns after zoneEnd[z - 1] up to zoneEnd[z] inclusive, all rows.
+// A zone with no usable pixel is NAN. Invalid samples (NaN / inf) keep
+// the pixel's previous estimate.
+inline void tireFilterZones(TireFilter_t *f, float *frame, int width, int height,
+                            const int *zoneEnd, int zones, float *zoneOut)
+{
+    if (zones > TIRE_MAX_ZONES)
+        zones = TIRE_MAX_ZONES;
+    int32_t sum[TIRE_MAX_ZONES] = {0};
+    int count[TIRE_MAX_ZONES] = {0};
+    const int32_t round = f->shift ? 1 << (f->shift - 1) : 0;
+    const float toQ = (float)(1 << TIRE_FILTER_FRAC);
+    const float fromQ = 1.0f / (1 << TIRE_FILTER_FRAC);
+
+    for (int r = 0; r < height; r++)
+    {
+        int z = 0;
+        for (int c = 0; c < width; c++)
+        {
+            while (z < zones - 1 && c > zoneEnd[z])
+                z++;
+            int idx = r * width + c; // row-major index
+            if (f->badMask[idx >> 5] & (1UL << (idx & 31)))
+            {
+                frame[idx] = NAN;
+                continue;
+            }
+
+            int32_t *est = &f->state[idx];
+            float t = frame[idx];
+            if (!isnan(t) && isfinite(t))
+            {
+                int32_t x = (int32_t)(t * toQ + (t < 0 ? -0.5f : 0.5f));
+                int32_t d = *est == TIRE_FILTER_NONE ? 0 : x - *est;
+                if (*est == TIRE_FILTER_NONE)
+                {
+                    *est = x;
+                }
+                else if (d > f->gate || d < -f->gate)
+                {
+                    if (++f->gated[idx] >= f->gateLimit)
+                    {
+                        *est = x;
+                        f->gated[idx] = 0;
+                    }
+                }
+                else
+                {
+                    *est += (d + round) >> f->shift;
+                    f->gated[idx] = 0;
+                }
+            }
+
+            if (*est == TIRE_FILTER_NONE)
+            {
+                frame[idx] = NAN;
+                continue;
+            }
+            frame[idx] = *est * fromQ;
+            if (c <= zoneEnd[z])
+            {
+                sum[z] += *est;
+                count[z]++;
+            }
+        }
+    }
+
+    for (int z = 0; z < zones; z++)
+        zoneOut[z] = count[z] ? (float)sum[z] / count[z] * fromQ : NAN;
+}
+
+#endif // TIRE_ZONES_H
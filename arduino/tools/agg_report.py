@@ -0,0 +1,160 @@
+"""Summarise the gauge's per-minute $AGG/$AGH trend blocks.
+
+canbus_gauge sends one block per minute on its USB serial while the engine
+runs (see trend_aggregator.h): ``$AGG`` with min/mean/max of RPM, oil
+pressure and coolant, then one ``$AGH`` per RPM bin with that bin's mean
+oil pressure and oil pressure histogram. Log the port, e.g.::
+
+    python -m serial.tools.miniterm /dev/ttyUSB0 115200 > gauge.log
+
+then::
+
+    python agg_report.py gauge.log                  # oil pressure trend per RPM bin
+    python agg_report.py gauge.log --csv bins.csv   # one row per period and bin
+
+Lines may carry a prefix (timestamps, ``race_sim --trace`` columns); other
+lines and lines failing their checksum are skipped. The trend is a
+least-squares fit of each bin's per-minute mean, weighted by samples, so a
+minute with a handful of samples at 6000 rpm counts for little.
+"""
+
+import argparse
+import csv
+import re
+import sys
+from collections import namedtuple
+
+RPM_BIN_WIDTH = 500
+OIL_BIN_PSI = 5
+
+LINE = re.compile(r"\$(AG[GH]),([^*$]*)\*([0-9A-Fa-f]{2})")
+
+Period = namedtuple("Period", "seq start length samples rpm oil coolant")
+Bin = namedtuple("Bin", "seq rpm_bin samples oil_mean first_oil_bin counts")
+
+
+def checksum(body):
+    value = 0
+    for c in body.encode():
+        value ^= c
+    return value
+
+
+def _triple(fields, convert):
+    return tuple(convert(f) for f in fields)
+
+
+def parse_line(line):
+    """Return a Period, a Bin, or None (not a block line, or corrupt)."""
+    match = LINE.search(line)
+    if not match:
+        return None
+    kind, fields, sent = match.groups()
+    if checksum(f"{kind},{fields}") != int(sent, 16):
+        return None
+    f = fields.split(",")
+    try:
+        if kind == "AGG" and len(f) == 13:
+            return Period(int(f[0]), int(f[1]), int(f[2]), int(f[3]),
+                          _triple(f[4:7], int), _triple(f[7:10], float),
+                          _triple(f[10:13], int))
+        if kind == "AGH" and len(f) == 6:
+            return Bin(int(f[0]), int(f[1]), int(f[2]), float(f[3]), int(f[4]),
+                       [int(n) for n in f[5].split("/")])
+    except ValueError:
+        pass
+    return None
+
+
+def read_log(lines):
+    """Periods in order, each as (Period, [Bin, ...])."""
+    periods = []
+    for line in lines:
+        item = parse_line(line)
+        if isinstance(item, Period):
+            periods.append((item, []))
+        elif isinstance(item, Bin) and periods and periods[-1][0].seq == item.seq:
+            periods[-1][1].append(item)
+    return periods
+
+
+def fit(points):
+    """Weighted least squares (t, y, w) -> (slope, intercept), or None."""
+    sw = sum(w for _, _, w in points)
+    if sw == 0:
+        return None
+    mt = sum(t * w for t, _, w in points) / sw
+    my = sum(y * w for _, y, w in points) / sw
+    stt = sum(w * (t - mt) ** 2 for t, _, w in points)
+    if stt == 0:
+        return None
+    slope = sum(w * (t - mt) * (y - my) for t, y, w in points) / stt
+    return slope, my - slope * mt
+
+
+def bin_trends(periods, min_samples=50):
+    """Per RPM bin: (periods used, samples, first mean, last mean, PSI/hour)."""
+    points = {}
+    for period, bins in periods:
+        hours = period.start / 3600.0
+        for b in bins:
+            if b.samples >= min_samples:
+                points.setdefault(b.rpm_bin, []).append((hours, b.oil_mean, b.samples))
+
+    trends = {}
+    for rpm_bin, pts in sorted(points.items()):
+        line = fit(pts)
+        trends[rpm_bin] = (len(pts), sum(w for _, _, w in pts), pts[0][1], pts[-1][1],
+                           line[0] if line else None)
+    return trends
+
+
+def report(periods, min_samples=50):
+    if not periods:
+        return "no trend blocks found"
+    first, last = periods[0][0], periods[-1][0]
+    lines = [
+        f"{len(periods)} periods, #{first.seq} at {first.start} s to #{last.seq} at {last.start} s",
+        f"{'rpm':>11}  {'minutes':>7}  {'first':>6}  {'last':>6}  {'PSI/hour':>8}",
+    ]
+    for rpm_bin, (count, _, first_mean, last_mean, slope) in bin_trends(periods, min_samples).items():
+        low = rpm_bin * RPM_BIN_WIDTH
+        label = f"{low}-{low + RPM_BIN_WIDTH - 1}"
+        trend = f"{slope:+8.2f}" if slope is not None else f"{'-':>8}"
+        lines.append(f"{label:>11}  {count:>7}  {first_mean:6.1f}  {last_mean:6.1f}  {trend}")
+    return "\n".join(lines)
+
+
+def write_csv(out, periods):
+    writer = csv.writer(out)
+    writer.writerow(["seq", "start_s", "rpm_bin_low", "samples", "oil_mean_psi", "oil_hist"])
+    for period, bins in periods:
+        for b in bins:
+            hist = {(b.first_oil_bin + i) * OIL_BIN_PSI: n for i, n in enumerate(b.counts) if n}
+            writer.writerow([period.seq, period.start, b.rpm_bin * RPM_BIN_WIDTH, b.samples,
+                             b.oil_mean, " ".join(f"{psi}:{n}" for psi, n in hist.items())])
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("log", help="serial log with $AGG/$AGH lines")
+    parser.add_argument("--csv", help="write one row per period and RPM bin")
+    parser.add_argument("--min-samples", type=int, default=50,
+                        help="ignore a bin in a period with fewer samples (default 50 = 1 s)")
+    args = parser.parse_args(argv)
+
+    with open(args.log, errors="replace") as f:
+        periods = read_log(f)
+    if not periods:
+        print(f"{args.log}: no trend blocks found", file=sys.stderr)
+        return 1
+
+    if args.csv:
+        with open(args.csv, "w", newline="") as out:
+            write_csv(out, periods)
+    print(report(periods, args.min_samples))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,284 @@
+"""Decode crash recorder captures from the gauge's crashlog partition.
+
+When oil pressure or coolant goes critical, canbus_gauge saves the
+telemetry from CRASH_PRE_MS before to CRASH_POST_MS after the alert to
+the next slot of the ``crashlog`` partition (see crash_recorder.h). Read
+the partition off the device with::
+
+    esptool.py read_flash 0x3E0000 0x10000 crash.bin
+
+(offset and size from canbus_gauge/partitions.csv), or save the simulated
+one with ``race_sim --crashlog=crash.bin``, then::
+
+    python crash_decode.py crash.bin                    # list captures
+    python crash_decode.py crash.bin --csv out.csv      # newest capture
+    python crash_decode.py crash.bin --seq 3 --csv -    # capture #3 to stdout
+
+CSV columns are seconds from the trigger, rpm, oil (PSI), coolant (in the
+unit the gauge displayed), throttle (%) and the active alerts.
+"""
+
+import argparse
+import csv
+import struct
+import sys
+from collections import namedtuple
+
+MAGIC = 0x48535243
+VERSION = 1
+SLOT_BYTES = 16384
+HEADER_BYTES = 256
+BLOCK_BYTES = 512
+
+HEADER_FORMAT = "<IHHIIBBHHHII"
+SAMPLE_FORMAT = "<HHhBB"
+BLOCK_FORMAT = "<IHH" + SAMPLE_FORMAT[1:]
+BLOCK_HEAD_BYTES = struct.calcsize(BLOCK_FORMAT)
+
+REC_DT = 0x01
+REC_RPM = 0x02
+REC_OIL = 0x04
+REC_COOLANT = 0x08
+REC_THROTTLE = 0x10
+REC_ALERTS = 0x20
+
+FLAG_TRUNCATED = 0x01
+FLAG_TEMP_F = 0x02
+
+# Delta-coded channels in record order, with their CrashSample_t field
+CHANNELS = ((REC_RPM, "rpm"), (REC_OIL, "oil"), (REC_COOLANT, "coolant"),
+            (REC_THROTTLE, "throttle"))
+
+ALERT_NAMES = ((0x01, "oil_critical"), (0x02, "temp_critical"),
+               (0x04, "oil_warning"), (0x08, "temp_warning"))
+
+Header = namedtuple("Header", "magic version block_count seq trigger_ms trigger flags "
+                              "sample_ms block_bytes reserved pre_ms post_ms")
+Sample = namedtuple("Sample", "t rpm oil coolant throttle alerts")
+
+
+class CrashLogError(ValueError):
+    """Malformed capture."""
+
+
+def zigzag(v):
+    return ((v << 1) ^ (v >> 31)) & 0xFFFFFFFF
+
+
+def unzigzag(u):
+    return (u >> 1) ^ -(u & 1)
+
+
+def put_varint(v):
+    out = bytearray()
+    while v >= 0x80:
+        out.append((v & 0x7F) | 0x80)
+        v >>= 7
+    out.append(v)
+    return bytes(out)
+
+
+def _get_varint(data, pos):
+    value = 0
+    shift = 0
+    while True:
+        if pos >= len(data):
+            raise CrashLogError("record runs past the block")
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, pos
+        shift += 7
+        if shift > 35:
+            raise CrashLogError("varint too long")
+
+
+def alert_names(alerts):
+    return "+".join(name for bit, name in ALERT_NAMES if alerts & bit)
+
+
+def parse_header(slot):
+    header = Header(*struct.unpack_from(HEADER_FORMAT, slot))
+    if header.magic != MAGIC:
+        return None
+    if header.version != VERSION:
+        raise CrashLogError(f"capture #{header.seq}: unsupported version {header.version}")
+    if header.block_bytes != BLOCK_BYTES:
+        raise CrashLogError(f"capture #{header.seq}: {header.block_bytes}-byte blocks")
+    if HEADER_BYTES + header.block_count * BLOCK_BYTES > len(slot):
+        raise CrashLogError(f"capture #{header.seq}: {header.block_count} blocks overrun the slot")
+    return header
+
+
+def decode_block(block, sample_ms):
+    """Samples of one CrashBlock_t, times in clockMillis()."""
+    t0, used, count, rpm, oil, coolant, throttle, alerts = struct.unpack_from(BLOCK_FORMAT, block)
+    if used > BLOCK_BYTES - BLOCK_HEAD_BYTES:
+        raise CrashLogError(f"block claims {used} bytes")
+    current = {"rpm": rpm, "oil": oil, "coolant": coolant, "throttle": throttle}
+    t = t0
+    samples = [(t, dict(current), alerts)]
+
+    data = block[BLOCK_HEAD_BYTES:BLOCK_HEAD_BYTES + used]
+    pos = 0
+    while pos < len(data):
+        flags = data[pos]
+        pos += 1
+        dt = sample_ms
+        if flags & REC_DT:
+            dt, pos = _get_varint(data, pos)
+        for bit, name in CHANNELS:
+            if flags & bit:
+                u, pos = _get_varint(data, pos)
+                current[name] += unzigzag(u)
+        if flags & REC_ALERTS:
+            if pos >= len(data):
+                raise CrashLogError("record runs past the block")
+            alerts = data[pos]
+            pos += 1
+        t = (t + dt) & 0xFFFFFFFF
+        samples.append((t, dict(current), alerts))
+
+    if len(samples) != count:
+        raise CrashLogError(f"block holds {len(samples)} samples, header says {count}")
+    return samples
+
+
+def decode_capture(slot, header):
+    """Samples of a capture, t in seconds relative to the trigger."""
+    samples = []
+    for i in range(header.block_count):
+        offset = HEADER_BYTES + i * BLOCK_BYTES
+        for t, values, alerts in decode_block(slot[offset:offset + BLOCK_BYTES], header.sample_ms):
+            rel = ((t - header.trigger_ms + 0x80000000) & 0xFFFFFFFF) - 0x80000000
+            samples.append(Sample(rel / 1000.0, values["rpm"], values["oil"] / 10.0,
+                                  values["coolant"], round(values["throttle"] * 100 / 255, 1),
+                                  alerts))
+    return samples
+
+
+def read_captures(image):
+    """(header, slot bytes) for every complete capture, oldest first."""
+    captures = []
+    for offset in range(0, len(image) - SLOT_BYTES + 1, SLOT_BYTES):
+        slot = image[offset:offset + SLOT_BYTES]
+        header = parse_header(slot)
+        if header is not None:
+            captures.append((header, slot))
+    captures.sort(key=lambda c: c[0].seq)
+    return captures
+
+
+class Encoder:
+    """Python twin of CrashRecorder's block format; used by the tests."""
+
+    def __init__(self, sample_ms=20):
+        self.sample_ms = sample_ms
+        self.blocks = []
+        self._data = None
+
+    def add(self, t, rpm, oil_tenths, coolant, throttle, alerts):
+        values = {"rpm": rpm, "oil": oil_tenths, "coolant": coolant, "throttle": throttle}
+        if self._data is not None:
+            rec = bytearray([0])
+            dt = (t - self._t) & 0xFFFFFFFF
+            if dt != self.sample_ms:
+                rec[0] |= REC_DT
+                rec += put_varint(dt)
+            for bit, name in CHANNELS:
+                if values[name] != self._values[name]:
+                    rec[0] |= bit
+                    rec += put_varint(zigzag(values[name] - self._values[name]))
+            if alerts != self._alerts:
+                rec[0] |= REC_ALERTS
+                rec.append(alerts)
+            if len(self._data) + len(rec) <= BLOCK_BYTES - BLOCK_HEAD_BYTES:
+                self._data += rec
+                self._count += 1
+                self._t, self._values, self._alerts = t, values, alerts
+                return
+            self._seal()
+
+        self._key = struct.pack(SAMPLE_FORMAT, rpm, oil_tenths, coolant, throttle, alerts)
+        self._t0 = t
+        self._data = bytearray()
+        self._count = 1
+        self._t, self._values, self._alerts = t, values, alerts
+
+    def _seal(self):
+        head = struct.pack("<IHH", self._t0, len(self._data), self._count) + self._key
+        block = head + bytes(self._data)
+        self.blocks.append(block + b"\xFF" * (BLOCK_BYTES - len(block)))
+        self._data = None
+
+    def slot(self, seq, trigger_ms, trigger, flags=0, pre_ms=30000, post_ms=30000):
+        if self._data is not None:
+            self._seal()
+        header = struct.pack(HEADER_FORMAT, MAGIC, VERSION, len(self.blocks), seq, trigger_ms,
+                             trigger, flags, self.sample_ms, BLOCK_BYTES, 0, pre_ms, post_ms)
+        slot = header.ljust(HEADER_BYTES, b"\xFF") + b"".join(self.blocks)
+        return slot.ljust(SLOT_BYTES, b"\xFF")
+
+
+def describe(header, samples):
+    unit = "F" if header.flags & FLAG_TEMP_F else "C"
+    line = (f"#{header.seq}: {alert_names(header.trigger)} at {header.trigger_ms / 1000.0:.1f} s, "
+            f"{len(samples)} samples")
+    if samples:
+        line += (f" ({samples[0].t:+.1f} to {samples[-1].t:+.1f} s), "
+                 f"min oil {min(s.oil for s in samples):.1f} PSI, "
+                 f"max coolant {max(s.coolant for s in samples)} {unit}")
+    if header.flags & FLAG_TRUNCATED:
+        line += ", truncated"
+    return line
+
+
+def write_csv(out, header, samples):
+    unit = "f" if header.flags & FLAG_TEMP_F else "c"
+    writer = csv.writer(out)
+    writer.writerow(["t", "rpm", "oil_psi", f"coolant_{unit}", "throttle_pct", "alerts"])
+    for s in samples:
+        writer.writerow([f"{s.t:.3f}", s.rpm, f"{s.oil:.1f}", s.coolant, s.throttle,
+                         alert_names(s.alerts)])
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("image", help="crashlog partition image")
+    parser.add_argument("--seq", type=int, help="capture to export (default newest)")
+    parser.add_argument("--csv", help="write the capture's samples ('-' for stdout)")
+    args = parser.parse_args(argv)
+
+    try:
+        with open(args.image, "rb") as f:
+            captures = read_captures(f.read())
+        if not captures:
+            print(f"{args.image}: no captures", file=sys.stderr)
+            return 1
+
+        if args.csv is None:
+            for header, slot in captures:
+                print(describe(header, decode_capture(slot, header)))
+            return 0
+
+        matching = [c for c in captures if args.seq is None or c[0].seq == args.seq]
+        if not matching:
+            print(f"{args.image}: no capture #{args.seq}", file=sys.stderr)
+            return 1
+        header, slot = matching[-1]
+        samples = decode_capture(slot, header)
+    except CrashLogError as e:
+        print(f"{args.image}: {e}", file=sys.stderr)
+        return 1
+
+    if args.csv == "-":
+        write_csv(sys.stdout, header, samples)
+    else:
+        with open(args.csv, "w", newline="") as out:
+            write_csv(out, header, samples)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
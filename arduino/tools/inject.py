@@ -0,0 +1,352 @@
+"""Stream scripted gauge scenarios into test_mode over USB serial.
+
+The gauge's test_mode sketch switches to a binary protocol on the ``i``
+command: fixed 14-byte frames of timestamped values, played back on the
+device at their timestamp. This script compiles a scenario file into
+frames and streams them at up to 1 kHz, so the display and alert paths
+see real-world rates (a pull climbs ~3000 rpm/s).
+
+Scenario files are one step per line; ``#`` starts a comment. Fields are
+``rpm``, ``speed`` (MPH), ``temp`` (water, F) and ``oil`` (PSI)::
+
+    rate 1000                       # frames per second (default 1000)
+    seed 7                          # noise seed (default 0)
+    set rpm 3000 speed 55 temp 190 oil 55
+    ramp 2.0 rpm 7000 oil 72        # linear to targets over 2 s
+    ramp 0.5 rpm 7000..4500         # explicit start..end
+    hold 1.5                        # keep values for 1.5 s
+    noise rpm 40 oil 1.5            # add uniform +/- noise from here on (0 = off)
+    dropout 0.3                     # no frames for 0.3 s (CAN loss)
+    storm 3.0 0.2 temp 200..220     # square wave, 0.2 s period, for 3 s
+    repeat 5                        # repeat the block up to "end"
+      ramp 1.0 rpm 6500
+      ramp 0.3 rpm 4200
+    end
+
+Usage:
+    python inject.py scenario.scn --port /dev/ttyUSB0
+    python inject.py scenario.scn                 # dry run: summary only
+    python inject.py scenario.scn --out frames.bin
+"""
+
+import argparse
+import random
+import struct
+import sys
+import time
+from collections import namedtuple
+
+SYNC = 0xA5
+FRAME_SIZE = 14
+FLAG_END = 0x01
+COMMAND_BAUD = 115200
+INJECT_BAUD = 921600
+
+FIELDS = ("rpm", "speed", "temp", "oil")
+
+# (min, max) each field is clamped to before encoding
+FIELD_RANGE = {
+    "rpm": (0, 65535),
+    "speed": (0, 255),
+    "temp": (-32768, 32767),
+    "oil": (0.0, 6553.5),
+}
+
+Frame = namedtuple("Frame", "ts rpm speed temp oil flags")
+
+
+class ScenarioError(ValueError):
+    """Invalid scenario file (message includes the line number)."""
+
+
+def crc8(data):
+    """CRC-8, polynomial 0x07, initial value 0 (matches test_mode.ino)."""
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def encode_frame(frame):
+    """Pack a Frame into the 14-byte wire format."""
+    body = struct.pack(
+        "<IHBhHB",
+        frame.ts & 0xFFFFFFFF,
+        frame.rpm,
+        frame.speed,
+        frame.temp,
+        int(round(frame.oil * 10)),
+        frame.flags,
+    )
+    return bytes([SYNC]) + body + bytes([crc8(body)])
+
+
+def decode_frame(data):
+    """Unpack one wire frame. Raises ValueError on bad sync, size or CRC."""
+    if len(data) != FRAME_SIZE or data[0] != SYNC:
+        raise ValueError("not a frame")
+    body = bytes(data[1:-1])
+    if crc8(body) != data[-1]:
+        raise ValueError("CRC mismatch")
+    ts, rpm, speed, temp, oil, flags = struct.unpack("<IHBhHB", body)
+    return Frame(ts, rpm, speed, temp, oil / 10.0, flags)
+
+
+# --- Scenario parsing --------------------------------------------------------
+
+
+def _number(token, lineno):
+    try:
+        return float(token)
+    except ValueError:
+        raise ScenarioError(f"line {lineno}: expected a number, got {token!r}")
+
+
+def _field_targets(tokens, lineno):
+    """Parse ``field value`` / ``field from..to`` pairs."""
+    if len(tokens) % 2:
+        raise ScenarioError(f"line {lineno}: expected field/value pairs")
+    targets = {}
+    for name, value in zip(tokens[::2], tokens[1::2]):
+        if name not in FIELDS:
+            raise ScenarioError(f"line {lineno}: unknown field {name!r}")
+        if ".." in value:
+            start, end = value.split("..", 1)
+            targets[name] = (_number(start, lineno), _number(end, lineno))
+        else:
+            targets[name] = (None, _number(value, lineno))
+    return targets
+
+
+def parse_scenario(text):
+    """Parse scenario text into a flat list of (command, args) steps.
+
+    ``repeat`` blocks are expanded here, so the result has no nesting.
+    """
+    root = []
+    stack = [(root, 1, 0)]  # (steps, repeat count, line of "repeat")
+
+    for lineno, line in enumerate(text.splitlines(), 1):
+        tokens = line.split("#", 1)[0].split()
+        if not tokens:
+            continue
+        command, args = tokens[0].lower(), tokens[1:]
+        steps = stack[-1][0]
+
+        if command == "repeat":
+            if len(args) != 1:
+                raise ScenarioError(f"line {lineno}: repeat takes a count")
+            stack.append(([], int(_number(args[0], lineno)), lineno))
+        elif command == "end":
+            if len(stack) == 1:
+                raise ScenarioError(f"line {lineno}: end without repeat")
+            block, count, _ = stack.pop()
+            stack[-1][0].extend(block * count)
+        elif command in ("rate", "seed"):
+            if len(args) != 1:
+                raise ScenarioError(f"line {lineno}: {command} takes one value")
+            value = _number(args[0], lineno)
+            if command == "rate" and not 1 <= value <= 1000:
+                raise ScenarioError(f"line {lineno}: rate must be 1-1000 Hz")
+            steps.append((command, value))
+        elif command == "set":
+            targets = _field_targets(args, lineno)
+            steps.append(("set", {k: v[1] for k, v in targets.items()}))
+        elif command in ("hold", "dropout"):
+            if len(args) != 1:
+                raise ScenarioError(f"line {lineno}: {command} takes a duration")
+            steps.append((command, _number(args[0], lineno)))
+        elif command == "ramp":
+            if len(args) < 3:
+                raise ScenarioError(f"line {lineno}: ramp <seconds> <field> <target> ...")
+            steps.append(("ramp", (_number(args[0], lineno), _field_targets(args[1:], lineno))))
+        elif command == "noise":
+            targets = _field_targets(args, lineno)
+            steps.append(("noise", {k: v[1] for k, v in targets.items()}))
+        elif command == "storm":
+            if len(args) < 4:
+                raise ScenarioError(f"line {lineno}: storm <seconds> <period> <field> <a>..<b> ...")
+            targets = _field_targets(args[2:], lineno)
+            if any(start is None for start, _ in targets.values()):
+                raise ScenarioError(f"line {lineno}: storm values must be <a>..<b>")
+            steps.append(
+                ("storm", (_number(args[0], lineno), _number(args[1], lineno), targets))
+            )
+        else:
+            raise ScenarioError(f"line {lineno}: unknown command {command!r}")
+
+    if len(stack) > 1:
+        raise ScenarioError(f"line {stack[-1][2]}: repeat without end")
+    return root
+
+
+# --- Frame generation --------------------------------------------------------
+
+
+def _clamp(name, value):
+    low, high = FIELD_RANGE[name]
+    return max(low, min(high, value))
+
+
+def generate(steps):
+    """Yield Frames for parsed steps, ending with a FLAG_END frame."""
+    rate = 1000.0
+    rng = random.Random(0)
+    values = {"rpm": 800.0, "speed": 0.0, "temp": 180.0, "oil": 40.0}
+    noise = {}
+    t = 0.0  # ms, time of the next frame
+
+    def frame(flags=0):
+        out = {}
+        for name in FIELDS:
+            value = values[name]
+            if noise.get(name):
+                value += rng.uniform(-noise[name], noise[name])
+            value = _clamp(name, value)
+            out[name] = round(value, 1) if name == "oil" else int(round(value))
+        return Frame(int(round(t)), out["rpm"], out["speed"], out["temp"], out["oil"], flags)
+
+    for command, args in steps:
+        period = 1000.0 / rate
+
+        if command == "rate":
+            rate = args
+        elif command == "seed":
+            rng = random.Random(int(args))
+        elif command == "set":
+            values.update(args)
+        elif command == "noise":
+            noise.update(args)
+        elif command == "dropout":
+            t += args * 1000.0
+        elif command == "hold":
+            for _ in range(int(round(args * rate))):
+                yield frame()
+                t += period
+        elif command == "ramp":
+            seconds, targets = args
+            starts = {
+                name: values[name] if start is None else start
+                for name, (start, _) in targets.items()
+            }
+            count = int(round(seconds * rate))
+            for i in range(1, count + 1):
+                for name, (_, end) in targets.items():
+                    values[name] = starts[name] + (end - starts[name]) * i / count
+                yield frame()
+                t += period
+        elif command == "storm":
+            seconds, storm_period, targets = args
+            half = storm_period * 1000.0 / 2
+            begin = t
+            for _ in range(int(round(seconds * rate))):
+                high = int((t - begin) // half) % 2 if half > 0 else 0
+                for name, (low_value, high_value) in targets.items():
+                    values[name] = high_value if high else low_value
+                yield frame()
+                t += period
+
+    yield frame(FLAG_END)
+
+
+def load_scenario(path):
+    with open(path) as f:
+        return list(generate(parse_scenario(f.read())))
+
+
+def summarize(frames):
+    """One-line-per-field summary for dry runs."""
+    lines = [
+        f"{len(frames)} frames over {frames[-1].ts / 1000.0:.3f} s",
+    ]
+    for name in FIELDS:
+        series = [getattr(frame, name) for frame in frames]
+        lines.append(f"  {name:6s} {min(series):>8} .. {max(series):<8}")
+    gaps = [b.ts - a.ts for a, b in zip(frames, frames[1:])]
+    if gaps:
+        lines.append(f"  longest gap {max(gaps)} ms")
+    return "\n".join(lines)
+
+
+# --- Streaming ---------------------------------------------------------------
+
+
+def stream(frames, port, baud=INJECT_BAUD, lead_ms=20):
+    """Switch test_mode into injection and play frames in real time.
+
+    Frames are sent up to ``lead_ms`` ahead of their timestamp; the device
+    queues them and plays each at its own time.
+    """
+    import serial  # pyserial - only needed when talking to a device
+
+    with serial.Serial(port, COMMAND_BAUD, timeout=0.1) as ser:
+        ser.reset_input_buffer()
+        ser.write(b"i\n")
+
+        deadline = time.monotonic() + 3.0
+        while True:
+            line = ser.readline().decode(errors="replace").strip()
+            if line.startswith("INJECT"):
+                break
+            if time.monotonic() > deadline:
+                raise RuntimeError("test_mode did not enter injection mode")
+
+        ser.baudrate = baud
+        start = time.monotonic()
+        index = 0
+        while index < len(frames):
+            now_ms = (time.monotonic() - start) * 1000.0
+            batch = bytearray()
+            while index < len(frames) and frames[index].ts <= now_ms + lead_ms:
+                batch += encode_frame(frames[index])
+                index += 1
+            if batch:
+                ser.write(batch)
+            else:
+                time.sleep(0.001)
+        ser.flush()
+
+        # The device reports its counters back at the command baud rate
+        time.sleep(0.05)
+        ser.baudrate = COMMAND_BAUD
+        deadline = time.monotonic() + 2.0
+        while time.monotonic() < deadline:
+            line = ser.readline().decode(errors="replace").strip()
+            if line:
+                print(line)
+                if line.startswith("Current:"):
+                    break
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("scenario", help="scenario file")
+    parser.add_argument("--port", help="test_mode serial port (omit for a dry run)")
+    parser.add_argument("--baud", type=int, default=INJECT_BAUD)
+    parser.add_argument("--lead-ms", type=int, default=20,
+                        help="send frames this far ahead (device queue is 64)")
+    parser.add_argument("--out", help="also write the binary frames to a file")
+    args = parser.parse_args(argv)
+
+    try:
+        frames = load_scenario(args.scenario)
+    except ScenarioError as e:
+        print(f"{args.scenario}: {e}", file=sys.stderr)
+        return 1
+
+    print(summarize(frames))
+
+    if args.out:
+        with open(args.out, "wb") as f:
+            for frame in frames:
+                f.write(encode_frame(frame))
+
+    if args.port:
+        stream(frames, args.port, args.baud, args.lead_ms)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,192 @@
+"""Report static RAM and stack frames per subsystem from a firmware build.
+
+Reads the GNU ld map file (``.data``/``.bss`` input sections, attributed to
+the object file or archive that contributed them) and the ``.su`` files
+written by ``-fstack-usage`` (one line per function: frame bytes and
+whether the frame is static, bounded or dynamic). A subsystem is a source
+file (``can_handler.cpp.o`` -> ``can_handler``) or a library archive
+(``libcore.a(...)`` -> ``core``).
+
+ESP32, via arduino-cli (the platform already writes a map file)::
+
+    arduino-cli compile --build-path build \\
+        --build-property compiler.cpp.extra_flags=-fstack-usage ...
+    python mem_report.py --map build/wheel.cpp.map --su build
+
+Host gauge simulation::
+
+    make -C arduino/canbus_gauge/sim mem-report
+
+Exits 1 if a subsystem is over its ``--budget``, a frame is larger than
+``--frame-limit``, or any frame is dynamic (a VLA or alloca: its size
+depends on the data, so no budget holds).
+"""
+
+import argparse
+import os
+import re
+import sys
+from collections import namedtuple
+
+RAM_SECTIONS = (".data", ".bss", ".sdata", ".sbss", ".dram0.data", ".dram0.bss", "COMMON")
+
+Frame = namedtuple("Frame", "subsystem location function size qualifiers")
+
+_SECTION_LINE = re.compile(r"^ (\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+_WRAPPED_NAME = re.compile(r"^ (\S+)$")
+_WRAPPED_REST = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+_ARCHIVE_MEMBER = re.compile(r"^(.*)\((.*)\)$")
+
+
+def subsystem_of(path):
+    """Subsystem name for an object file, archive member or .su file."""
+    path = path.strip()
+    m = _ARCHIVE_MEMBER.match(path)
+    if m:
+        name = os.path.basename(m.group(1))
+        if name.startswith("lib"):
+            name = name[3:]
+        return name[:-2] if name.endswith(".a") else name
+    name = os.path.basename(path)
+    for ext in (".su", ".o", ".cpp", ".ino", ".cc", ".c", ".S"):
+        if name.endswith(ext):
+            name = name[: -len(ext)]
+    return name
+
+
+def is_ram_section(name):
+    return any(name == s or name.startswith(s + ".") for s in RAM_SECTIONS)
+
+
+def parse_map(lines):
+    """Static RAM bytes per subsystem from a GNU ld map file."""
+    ram = {}
+    in_map = False
+    pending = None
+    for line in lines:
+        line = line.rstrip("\n")
+        if not in_map:
+            in_map = line.startswith("Linker script and memory map")
+            continue
+        if pending is not None:
+            m = _WRAPPED_REST.match(line)
+            name, pending = pending, None
+            if m:
+                _add(ram, name, int(m.group(2), 16), m.group(3))
+                continue
+        m = _SECTION_LINE.match(line)
+        if m:
+            _add(ram, m.group(1), int(m.group(3), 16), m.group(4))
+            continue
+        m = _WRAPPED_NAME.match(line)
+        if m:
+            pending = m.group(1)
+    return ram
+
+
+def _add(ram, section, size, obj):
+    if size and is_ram_section(section):
+        sub = subsystem_of(obj)
+        ram[sub] = ram.get(sub, 0) + size
+
+
+def parse_su(lines, subsystem):
+    """Frames from one -fstack-usage file."""
+    frames = []
+    for line in lines:
+        parts = line.rstrip("\n").split("\t")
+        if len(parts) != 3:
+            continue
+        where, size, qualifiers = parts
+        fields = where.split(":", 3)
+        location = ":".join(fields[:2])
+        function = fields[3] if len(fields) == 4 else where
+        frames.append(Frame(subsystem, location, function, int(size), qualifiers))
+    return frames
+
+
+def load_su(path):
+    """All frames from .su files under path (a file or directory)."""
+    paths = []
+    if os.path.isdir(path):
+        for root, _dirs, files in os.walk(path):
+            paths.extend(os.path.join(root, f) for f in files if f.endswith(".su"))
+    else:
+        paths.append(path)
+    frames = []
+    for p in sorted(paths):
+        with open(p) as f:
+            frames.extend(parse_su(f, subsystem_of(p)))
+    return frames
+
+
+def parse_budgets(items):
+    budgets = {}
+    for item in items or []:
+        name, _, size = item.partition("=")
+        if not name or not size:
+            raise ValueError("budget must be NAME=BYTES: %r" % item)
+        budgets[name] = int(size, 0)
+    return budgets
+
+
+def report(ram, frames, budgets=None, frame_limit=None, out=sys.stdout):
+    """Print the table; returns the list of problems found."""
+    budgets = budgets or {}
+    largest = {}
+    for fr in frames:
+        if fr.subsystem not in largest or fr.size > largest[fr.subsystem].size:
+            largest[fr.subsystem] = fr
+
+    problems = []
+    names = sorted(set(ram) | set(largest) | set(budgets), key=lambda n: (-ram.get(n, 0), n))
+    out.write("%-24s %10s %10s %10s  %s\n" % ("subsystem", "RAM", "budget", "max frame", "function"))
+    for name in names:
+        used = ram.get(name, 0)
+        budget = budgets.get(name)
+        fr = largest.get(name)
+        out.write("%-24s %10d %10s %10s  %s\n" % (
+            name, used, budget if budget is not None else "-",
+            fr.size if fr else "-", fr.function if fr else ""))
+        if budget is not None and used > budget:
+            problems.append("%s: %d bytes static RAM, budget %d" % (name, used, budget))
+    out.write("%-24s %10d\n" % ("total", sum(ram.values())))
+
+    for fr in frames:
+        if "dynamic" in fr.qualifiers and "bounded" not in fr.qualifiers:
+            problems.append("%s %s: dynamic stack frame (VLA/alloca)" % (fr.location, fr.function))
+        elif frame_limit is not None and fr.size > frame_limit:
+            problems.append("%s %s: %d-byte frame, limit %d" % (fr.location, fr.function, fr.size, frame_limit))
+
+    for p in problems:
+        out.write("OVER: %s\n" % p)
+    return problems
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("--map", help="linker map file")
+    parser.add_argument("--su", action="append", default=[], help=".su file or directory (repeatable)")
+    parser.add_argument("--budget", action="append", metavar="NAME=BYTES",
+                        help="static RAM budget for a subsystem (repeatable)")
+    parser.add_argument("--frame-limit", type=int, metavar="BYTES",
+                        help="largest acceptable single stack frame")
+    args = parser.parse_args(argv)
+
+    ram = {}
+    if args.map:
+        with open(args.map) as f:
+            ram = parse_map(f)
+    frames = []
+    for path in args.su:
+        frames.extend(load_su(path))
+    try:
+        budgets = parse_budgets(args.budget)
+    except ValueError as e:
+        parser.error(str(e))
+
+    return 1 if report(ram, frames, budgets, args.frame_limit) else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
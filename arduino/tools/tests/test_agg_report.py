@@ -0,0 +1,168 @@
+"""Tests for the trend block report (format from trend_aggregator.h).
+
+Run on host with CPython/pytest.
+"""
+
+import sys
+import os
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), ".."))
+
+import pytest
+
+
+def sentence(body):
+    """Frame a block line the way TrendAggregator::writeLine() does."""
+    from agg_report import checksum
+
+    return f"${body}*{checksum(body):02X}\r\n"
+
+
+def stint(minutes, oil_at_6000, seq0=1):
+    """Log lines for a stint whose 6000 rpm oil pressure follows oil_at_6000(minute)."""
+    lines = []
+    for m in range(minutes):
+        seq = seq0 + m
+        oil = oil_at_6000(m)
+        lines.append(sentence(f"AGG,{seq},{60 * m + 1},59,3000,4212,5600,6449,"
+                              f"60.1,71.5,{oil + 2:.1f},188,190,191"))
+        lines.append(sentence(f"AGH,{seq},9,1200,65.8,12,300/880/20"))
+        lines.append(sentence(f"AGH,{seq},12,800,{oil:.1f},14,40/760"))
+    return lines
+
+
+class TestParse:
+    """Test line parsing and checksums."""
+
+    def test_device_line(self):
+        from agg_report import parse_line
+
+        # Verbatim from race_sim --trace
+        period = parse_line("     61571 S $AGG,1,1,59,3000,4599,5633,6449,63.3,71.9,78.9,187,188,189*41")
+        assert period.seq == 1
+        assert period.rpm == (4599, 5633, 6449)
+        assert period.oil == (63.3, 71.9, 78.9)
+        assert period.coolant == (187, 188, 189)
+
+        b = parse_line("     61591 S $AGH,1,9,309,65.9,12,76/225/6/2*74")
+        assert (b.rpm_bin, b.samples, b.oil_mean, b.first_oil_bin) == (9, 309, 65.9, 12)
+        assert b.counts == [76, 225, 6, 2]
+
+    def test_bad_checksum(self):
+        from agg_report import parse_line
+
+        assert parse_line("$AGH,1,9,309,65.9,12,76/225/6/2*75") is None
+
+    def test_not_a_block(self):
+        from agg_report import parse_line
+
+        assert parse_line("RPM: 6000") is None
+        assert parse_line("$GPGGA,1*00") is None
+
+    def test_negative_coolant(self):
+        from agg_report import parse_line
+
+        period = parse_line(sentence("AGG,3,1,59,10,800,800,800,20.0,20.0,20.0,-12,-10,-9"))
+        assert period.coolant == (-12, -10, -9)
+
+    def test_wrong_field_count(self):
+        from agg_report import parse_line
+
+        assert parse_line(sentence("AGH,1,9,309,65.9")) is None
+
+
+class TestReadLog:
+    """Test grouping bins under their period."""
+
+    def test_groups_by_seq(self):
+        from agg_report import read_log
+
+        periods = read_log(stint(3, lambda m: 76.0))
+        assert [p.seq for p, _ in periods] == [1, 2, 3]
+        assert [b.rpm_bin for b in periods[1][1]] == [9, 12]
+
+    def test_orphan_bins_dropped(self):
+        from agg_report import read_log
+
+        lines = [sentence("AGH,7,12,800,76.0,14,40/760")] + stint(1, lambda m: 76.0, seq0=8)
+        # Bin from a period whose $AGG was lost
+        lines.insert(2, sentence("AGH,7,9,100,60.0,12,100"))
+        periods = read_log(lines)
+        assert [(p.seq, len(bins)) for p, bins in periods] == [(8, 2)]
+
+    def test_debug_output_interleaved(self):
+        from agg_report import read_log
+
+        lines = stint(2, lambda m: 76.0)
+        lines.insert(1, "--- Current Values ---\n")
+        assert len(read_log(lines)[0][1]) == 2
+
+
+class TestTrend:
+    """Test the per-bin oil pressure trend."""
+
+    def test_drift_detected(self):
+        from agg_report import read_log, bin_trends
+
+        # 6000 rpm bin loses 3 PSI per hour; 4500 rpm bin is steady
+        periods = read_log(stint(60, lambda m: 76.0 - 3.0 * m / 60))
+        trends = bin_trends(periods)
+        assert trends[12][4] == pytest.approx(-3.0, abs=0.01)
+        assert trends[9][4] == pytest.approx(0.0, abs=1e-9)
+        assert trends[12][2:4] == (76.0, pytest.approx(73.05, abs=0.1))
+
+    def test_sparse_bins_ignored(self):
+        from agg_report import read_log, bin_trends
+
+        lines = stint(5, lambda m: 76.0)
+        lines.append(sentence("AGG,6,301,59,3000,4212,5600,6449,60.1,71.5,78.0,188,190,191"))
+        lines.append(sentence("AGH,6,12,10,20.0,4,10"))
+        trends = bin_trends(read_log(lines), min_samples=50)
+        assert trends[12][0] == 5
+        assert trends[12][4] == pytest.approx(0.0, abs=1e-9)
+
+    def test_single_period_has_no_slope(self):
+        from agg_report import read_log, bin_trends
+
+        assert bin_trends(read_log(stint(1, lambda m: 76.0)))[12][4] is None
+
+    def test_fit_weighted(self):
+        from agg_report import fit
+
+        slope, intercept = fit([(0, 10, 1), (1, 20, 1), (2, 30, 1)])
+        assert (slope, intercept) == (pytest.approx(10), pytest.approx(10))
+        assert fit([(1, 10, 5)]) is None
+
+
+class TestCli:
+    """Test the report and CSV export."""
+
+    def test_report(self, tmp_path, capsys):
+        from agg_report import main
+
+        log = tmp_path / "gauge.log"
+        log.write_text("".join(stint(30, lambda m: 76.0 - m / 10)))
+        assert main([str(log)]) == 0
+        out = capsys.readouterr().out.splitlines()
+        assert out[0] == "30 periods, #1 at 1 s to #30 at 1741 s"
+        assert out[-1].split() == ["6000-6499", "30", "76.0", "73.1", "-6.00"]
+
+    def test_csv(self, tmp_path):
+        from agg_report import main
+
+        log = tmp_path / "gauge.log"
+        log.write_text("".join(stint(2, lambda m: 76.0)))
+        out = tmp_path / "bins.csv"
+        assert main([str(log), "--csv", str(out)]) == 0
+        rows = out.read_text().splitlines()
+        assert rows[0] == "seq,start_s,rpm_bin_low,samples,oil_mean_psi,oil_hist"
+        assert rows[1] == "1,1,4500,1200,65.8,60:300 65:880 70:20"
+        assert rows[2] == "1,1,6000,800,76.0,70:40 75:760"
+        assert len(rows) == 5
+
+    def test_empty_log(self, tmp_path):
+        from agg_report import main
+
+        log = tmp_path / "empty.log"
+        log.write_text("System ready!\n")
+        assert main([str(log)]) == 1
@@ -0,0 +1,203 @@
+"""Tests for the crash recorder decoder (format from crash_recorder.h).
+
+Run on host with CPython/pytest.
+"""
+
+import sys
+import os
+import struct
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), ".."))
+
+import pytest
+
+
+def starvation(encoder, start=100000, count=3000, trigger_at=1500):
+    """Steady lap with an oil dip at trigger_at; returns the samples fed."""
+    fed = []
+    for n in range(count):
+        t = start + n * encoder.sample_ms
+        rpm = 6000 + (n % 50) * 20
+        oil = 180 if trigger_at <= n < trigger_at + 75 else 650 + n % 3
+        coolant = 92 + n // 1000
+        alerts = 0x01 if oil < 250 else 0
+        encoder.add(t, rpm, oil, coolant, 255, alerts)
+        fed.append((t, rpm, oil, coolant, 255, alerts))
+    return fed
+
+
+class TestVarint:
+    """Test the zigzag varints records are made of."""
+
+    def test_zigzag(self):
+        from crash_decode import zigzag, unzigzag
+
+        assert [zigzag(v) for v in (0, -1, 1, -2, 2)] == [0, 1, 2, 3, 4]
+        for v in (-70000, -1, 0, 1, 65535):
+            assert unzigzag(zigzag(v)) == v
+
+    def test_varint_roundtrip(self):
+        from crash_decode import put_varint, _get_varint
+
+        for v in (0, 1, 127, 128, 300, 0xFFFFFFFF):
+            data = put_varint(v)
+            assert _get_varint(data, 0) == (v, len(data))
+
+    def test_truncated_varint(self):
+        from crash_decode import _get_varint, CrashLogError
+
+        with pytest.raises(CrashLogError):
+            _get_varint(b"\x80\x80", 0)
+
+
+class TestRoundtrip:
+    """Encoder twin -> decoder reproduces every sample."""
+
+    def test_samples(self):
+        from crash_decode import Encoder, read_captures, decode_capture
+
+        encoder = Encoder()
+        fed = starvation(encoder)
+        trigger_ms = fed[1500][0]
+        image = encoder.slot(seq=1, trigger_ms=trigger_ms, trigger=0x01)
+
+        (header, slot), = read_captures(image)
+        samples = decode_capture(slot, header)
+
+        assert len(samples) == len(fed)
+        for s, (t, rpm, oil, coolant, throttle, alerts) in zip(samples, fed):
+            assert s.t == pytest.approx((t - trigger_ms) / 1000.0)
+            assert (s.rpm, s.oil, s.coolant, s.alerts) == (rpm, oil / 10.0, coolant, alerts)
+            assert s.throttle == 100.0
+
+    def test_steady_channels_compress(self):
+        from crash_decode import Encoder, BLOCK_BYTES
+
+        encoder = Encoder()
+        for n in range(2000):
+            encoder.add(n * 20, 3000, 500, 90, 128, 0)
+        encoder.slot(seq=1, trigger_ms=0, trigger=0x01)
+        # One flag byte per sample
+        assert len(encoder.blocks) <= 2000 // (BLOCK_BYTES - 16) + 1
+
+    def test_irregular_spacing(self):
+        from crash_decode import Encoder, read_captures, decode_capture
+
+        encoder = Encoder()
+        times = [0, 20, 40, 1040, 1060, 6060]
+        for t in times:
+            encoder.add(t, 800, 300, 85, 0, 0)
+        (header, slot), = read_captures(encoder.slot(seq=1, trigger_ms=1040, trigger=0x02))
+        assert [s.t for s in decode_capture(slot, header)] == [-1.04, -1.02, -1.0, 0.0, 0.02, 5.02]
+
+    def test_clock_wrap(self):
+        from crash_decode import Encoder, read_captures, decode_capture
+
+        encoder = Encoder()
+        for n in range(10):
+            encoder.add((0xFFFFFFC0 + n * 20) & 0xFFFFFFFF, 800, 300, 85, 0, 0)
+        (header, slot), = read_captures(encoder.slot(seq=1, trigger_ms=0xFFFFFFC0, trigger=0x02))
+        samples = decode_capture(slot, header)
+        assert [s.t for s in samples] == pytest.approx([n * 0.02 for n in range(10)])
+
+
+class TestImage:
+    """Test slot scanning across the partition."""
+
+    def test_blank_and_partial_slots_skipped(self):
+        from crash_decode import Encoder, read_captures, SLOT_BYTES
+
+        encoder = Encoder()
+        starvation(encoder, count=200, trigger_at=100)
+        complete = encoder.slot(seq=7, trigger_ms=102000, trigger=0x01)
+        # Blocks written but the header not yet (power lost mid-capture)
+        partial = b"\xFF" * 256 + complete[256:]
+        image = b"\xFF" * SLOT_BYTES + partial + complete + b"\xFF" * SLOT_BYTES
+
+        captures = read_captures(image)
+        assert [h.seq for h, _ in captures] == [7]
+
+    def test_ordered_by_seq(self):
+        from crash_decode import Encoder, read_captures
+
+        slots = []
+        for seq in (5, 6, 3, 4):
+            encoder = Encoder()
+            starvation(encoder, count=100, trigger_at=50)
+            slots.append(encoder.slot(seq=seq, trigger_ms=101000, trigger=0x01))
+        assert [h.seq for h, _ in read_captures(b"".join(slots))] == [3, 4, 5, 6]
+
+    def test_bad_version(self):
+        from crash_decode import Encoder, read_captures, CrashLogError
+
+        encoder = Encoder()
+        encoder.add(0, 800, 300, 85, 0, 0)
+        slot = bytearray(encoder.slot(seq=1, trigger_ms=0, trigger=0x01))
+        struct.pack_into("<H", slot, 4, 9)
+        with pytest.raises(CrashLogError):
+            read_captures(bytes(slot))
+
+    def test_sample_count_mismatch(self):
+        from crash_decode import Encoder, read_captures, decode_capture, CrashLogError
+
+        encoder = Encoder()
+        for n in range(10):
+            encoder.add(n * 20, 800 + n, 300, 85, 0, 0)
+        slot = bytearray(encoder.slot(seq=1, trigger_ms=0, trigger=0x01))
+        struct.pack_into("<H", slot, 256 + 6, 11)
+        (header, data), = read_captures(bytes(slot))
+        with pytest.raises(CrashLogError):
+            decode_capture(data, header)
+
+
+class TestCli:
+    """Test listing and CSV export."""
+
+    def _image(self, tmp_path):
+        from crash_decode import Encoder, FLAG_TEMP_F
+
+        slots = []
+        for seq in (1, 2):
+            encoder = Encoder()
+            fed = starvation(encoder, count=300, trigger_at=150)
+            slots.append(encoder.slot(seq=seq, trigger_ms=fed[150][0], trigger=0x01,
+                                      flags=FLAG_TEMP_F if seq == 2 else 0))
+        path = tmp_path / "crash.bin"
+        path.write_bytes(b"".join(slots))
+        return path
+
+    def test_list(self, tmp_path, capsys):
+        from crash_decode import main
+
+        assert main([str(self._image(tmp_path))]) == 0
+        out = capsys.readouterr().out.splitlines()
+        assert out[0].startswith("#1: oil_critical at 103.0 s, 300 samples (-3.0 to +3.0 s)")
+        assert "min oil 18.0 PSI" in out[1]
+
+    def test_csv_newest(self, tmp_path):
+        from crash_decode import main
+
+        out = tmp_path / "out.csv"
+        assert main([str(self._image(tmp_path)), "--csv", str(out)]) == 0
+        lines = out.read_text().splitlines()
+        assert lines[0] == "t,rpm,oil_psi,coolant_f,throttle_pct,alerts"
+        assert lines[151] == "0.000,6000,18.0,92,100.0,oil_critical"
+        assert len(lines) == 301
+
+    def test_csv_by_seq(self, tmp_path, capsys):
+        from crash_decode import main
+
+        assert main([str(self._image(tmp_path)), "--seq", "1", "--csv", "-"]) == 0
+        assert capsys.readouterr().out.splitlines()[0].endswith("coolant_c,throttle_pct,alerts")
+
+    def test_missing_seq(self, tmp_path):
+        from crash_decode import main
+
+        assert main([str(self._image(tmp_path)), "--seq", "9", "--csv", "-"]) == 1
+
+    def test_empty_image(self, tmp_path):
+        from crash_decode import main
+
+        path = tmp_path / "blank.bin"
+        path.write_bytes(b"\xFF" * 65536)
+        assert main([str(path)]) == 1
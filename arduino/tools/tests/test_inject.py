@@ -0,0 +1,217 @@
+"""Tests for the test_mode injection protocol and scenario engine.
+
+Run on host with CPython/pytest. No device or pyserial needed.
+"""
+
+import sys
+import os
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), ".."))
+
+import pytest
+
+
+class TestCrc8:
+    """CRC-8 must match crc8() in test_mode.ino."""
+
+    def test_empty(self):
+        from inject import crc8
+
+        assert crc8(b"") == 0
+
+    def test_check_value(self):
+        from inject import crc8
+
+        # Standard CRC-8 (poly 0x07, init 0) check value
+        assert crc8(b"123456789") == 0xF4
+
+
+class TestFrames:
+    """Test the 14-byte wire format."""
+
+    def test_roundtrip(self):
+        from inject import Frame, encode_frame, decode_frame
+
+        frame = Frame(123456, 6500, 88, -12, 54.3, 0)
+        assert decode_frame(encode_frame(frame)) == frame
+
+    def test_layout(self):
+        from inject import Frame, encode_frame, FRAME_SIZE, SYNC
+
+        data = encode_frame(Frame(0x01020304, 0x1B58, 55, 190, 45.0, 1))
+        assert len(data) == FRAME_SIZE
+        assert data[0] == SYNC
+        assert data[1:5] == bytes([0x04, 0x03, 0x02, 0x01])  # little-endian ts
+        assert data[5:7] == bytes([0x58, 0x1B])
+        assert data[10:12] == (450).to_bytes(2, "little")
+        assert data[12] == 1
+
+    def test_crc_mismatch(self):
+        from inject import Frame, encode_frame, decode_frame
+
+        data = bytearray(encode_frame(Frame(0, 3000, 0, 180, 40.0, 0)))
+        data[6] ^= 0x01
+        with pytest.raises(ValueError):
+            decode_frame(bytes(data))
+
+    def test_bad_sync(self):
+        from inject import Frame, encode_frame, decode_frame
+
+        data = bytearray(encode_frame(Frame(0, 3000, 0, 180, 40.0, 0)))
+        data[0] = 0x00
+        with pytest.raises(ValueError):
+            decode_frame(bytes(data))
+
+
+class TestParseScenario:
+    """Test scenario text parsing."""
+
+    def test_comments_and_blank_lines(self):
+        from inject import parse_scenario
+
+        steps = parse_scenario("# header\n\nhold 1  # one second\n")
+        assert steps == [("hold", 1.0)]
+
+    def test_repeat_expands(self):
+        from inject import parse_scenario
+
+        steps = parse_scenario("repeat 3\n  hold 0.1\n  dropout 0.2\nend\n")
+        assert steps == [("hold", 0.1), ("dropout", 0.2)] * 3
+
+    def test_nested_repeat(self):
+        from inject import parse_scenario
+
+        steps = parse_scenario("repeat 2\nrepeat 2\nhold 1\nend\nend\n")
+        assert steps == [("hold", 1.0)] * 4
+
+    def test_ramp_range(self):
+        from inject import parse_scenario
+
+        steps = parse_scenario("ramp 0.5 rpm 7000..4500 oil 60\n")
+        assert steps == [("ramp", (0.5, {"rpm": (7000.0, 4500.0), "oil": (None, 60.0)}))]
+
+    def test_unknown_command_reports_line(self):
+        from inject import parse_scenario, ScenarioError
+
+        with pytest.raises(ScenarioError, match="line 2"):
+            parse_scenario("hold 1\nwobble 3\n")
+
+    def test_unknown_field(self):
+        from inject import parse_scenario, ScenarioError
+
+        with pytest.raises(ScenarioError, match="unknown field"):
+            parse_scenario("set boost 20\n")
+
+    def test_end_without_repeat(self):
+        from inject import parse_scenario, ScenarioError
+
+        with pytest.raises(ScenarioError, match="end without repeat"):
+            parse_scenario("end\n")
+
+    def test_repeat_without_end(self):
+        from inject import parse_scenario, ScenarioError
+
+        with pytest.raises(ScenarioError, match="line 1"):
+            parse_scenario("repeat 2\nhold 1\n")
+
+    def test_storm_needs_range(self):
+        from inject import parse_scenario, ScenarioError
+
+        with pytest.raises(ScenarioError):
+            parse_scenario("storm 1 0.2 temp 210\n")
+
+    def test_rate_limit(self):
+        from inject import parse_scenario, ScenarioError
+
+        with pytest.raises(ScenarioError):
+            parse_scenario("rate 5000\n")
+
+
+class TestGenerate:
+    """Test frame generation from parsed steps."""
+
+    def _frames(self, text):
+        from inject import generate, parse_scenario
+
+        return list(generate(parse_scenario(text)))
+
+    def test_ends_with_end_flag(self):
+        from inject import FLAG_END
+
+        frames = self._frames("hold 0.01\n")
+        assert frames[-1].flags == FLAG_END
+        assert all(f.flags == 0 for f in frames[:-1])
+
+    def test_rate_sets_spacing(self):
+        frames = self._frames("rate 100\nhold 0.1\n")
+        assert len(frames) == 11  # 10 + end frame
+        assert [f.ts for f in frames[:3]] == [0, 10, 20]
+
+    def test_ramp_reaches_target(self):
+        frames = self._frames("set rpm 1000\nramp 1.0 rpm 7000\n")
+        rpms = [f.rpm for f in frames[:-1]]
+        assert len(rpms) == 1000
+        assert rpms[-1] == 7000
+        assert rpms == sorted(rpms)
+
+    def test_dropout_leaves_gap(self):
+        frames = self._frames("hold 0.01\ndropout 0.3\nhold 0.01\n")
+        gaps = [b.ts - a.ts for a, b in zip(frames, frames[1:])]
+        assert max(gaps) == 301
+
+    def test_storm_alternates(self):
+        frames = self._frames("storm 0.4 0.2 temp 200..220\n")
+        temps = [f.temp for f in frames[:-1]]
+        assert temps[0] == 200
+        assert temps[100] == 220
+        assert temps[200] == 200
+        assert set(temps) == {200, 220}
+
+    def test_noise_is_seeded(self):
+        text = "seed 3\nset rpm 4000\nnoise rpm 50\nhold 0.2\n"
+        first = self._frames(text)
+        assert first == self._frames(text)
+        rpms = {f.rpm for f in first}
+        assert len(rpms) > 1
+        assert all(3950 <= r <= 4050 for r in rpms)
+
+    def test_values_clamped(self):
+        frames = self._frames("set rpm -100 speed 400\nhold 0.01\n")
+        assert frames[0].rpm == 0
+        assert frames[0].speed == 255
+
+
+class TestMain:
+    """Test the command line without a device."""
+
+    def test_dry_run_writes_frames(self, tmp_path):
+        from inject import main, FRAME_SIZE, decode_frame
+
+        scenario = tmp_path / "s.scn"
+        scenario.write_text("set rpm 3000\nhold 0.05\n")
+        out = tmp_path / "frames.bin"
+        assert main([str(scenario), "--out", str(out)]) == 0
+
+        data = out.read_bytes()
+        assert len(data) == 51 * FRAME_SIZE
+        assert decode_frame(data[:FRAME_SIZE]).rpm == 3000
+
+    def test_bad_scenario_returns_error(self, tmp_path, capsys):
+        from inject import main
+
+        scenario = tmp_path / "bad.scn"
+        scenario.write_text("hold\n")
+        assert main([str(scenario)]) == 1
+        assert "line 1" in capsys.readouterr().err
+
+    def test_shipped_scenarios_parse(self):
+        from inject import load_scenario
+
+        folder = os.path.join(
+            os.path.dirname(__file__), "..", "..", "canbus_gauge", "test_mode", "scenarios"
+        )
+        names = sorted(n for n in os.listdir(folder) if n.endswith(".scn"))
+        assert names
+        for name in names:
+            frames = load_scenario(os.path.join(folder, name))
+            assert len(frames) > 1
@@ -0,0 +1,153 @@
+"""Tests for the per-subsystem memory report (map and .su parsing).
+
+Run on host with CPython/pytest.
+"""
+
+import sys
+import os
+import io
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), ".."))
+
+import pytest
+
+MAP = """\
+Archive member included to satisfy reference by file (symbol)
+
+Discarded input sections
+
+ .bss.unused    0x0000000000000000       0x40 build/sketch/wheel.cpp.o
+
+Memory Configuration
+
+Linker script and memory map
+
+.dram0.bss      0x3ffc0000     0x1234
+ .bss.thermos   0x3ffc0000       0x10 build/sketch/wheel.cpp.o
+ .bss._ZL14frameLocalUs
+                0x3ffc0010        0x8 build/sketch/wheel.cpp.o
+ *fill*         0x3ffc0018        0x8
+ .bss           0x3ffc0020       0x20 build/libraries/AdcScan/AdcScan.cpp.o
+ COMMON         0x3ffc0040        0x4 build/core/core.a(main.cpp.o)
+.dram0.data     0x3ffd0000      0x100
+ .data.gateway_mac
+                0x3ffd0000        0x6 build/sketch/wheel.cpp.o
+ .data          0x3ffd0008       0x10 /sdk/lib/libnet80211.a(ieee80211.o)
+.flash.rodata   0x3f400000      0x800
+ .rodata.KMH_TO_MPH_LUT
+                0x3f400000      0x100 build/sketch/obd_units.cpp.o
+"""
+
+SU = """\
+wheel.cpp:92:6:void mqttCallback(char*, byte*, unsigned int)\t112\tstatic
+wheel.cpp:610:6:void readThermocouples()\t48\tstatic
+led.cpp:58:6:void callback(char*, byte*, unsigned int)\t64\tdynamic
+x.cpp:1:1:void f()\t32\tdynamic,bounded
+"""
+
+
+class TestSubsystem:
+    """Object / archive / .su path to subsystem name."""
+
+    def test_sketch_object(self):
+        from mem_report import subsystem_of
+        assert subsystem_of("build/sketch/wheel.cpp.o") == "wheel"
+
+    def test_host_object(self):
+        from mem_report import subsystem_of
+        assert subsystem_of("build/mem/can_handler.o") == "can_handler"
+
+    def test_archive_member(self):
+        from mem_report import subsystem_of
+        assert subsystem_of("/sdk/lib/libnet80211.a(ieee80211.o)") == "net80211"
+        assert subsystem_of("build/core/core.a(main.cpp.o)") == "core"
+
+    def test_su_file(self):
+        from mem_report import subsystem_of
+        assert subsystem_of("build/sketch/wheel.cpp.su") == "wheel"
+
+
+class TestParseMap:
+    """Static RAM from .data/.bss input sections."""
+
+    def test_ram_per_subsystem(self):
+        from mem_report import parse_map
+        ram = parse_map(io.StringIO(MAP))
+        assert ram["wheel"] == 0x10 + 0x8 + 0x6
+        assert ram["AdcScan"] == 0x20
+        assert ram["core"] == 0x4
+        assert ram["net80211"] == 0x10
+
+    def test_rodata_is_not_ram(self):
+        from mem_report import parse_map
+        assert "obd_units" not in parse_map(io.StringIO(MAP))
+
+    def test_discarded_sections_ignored(self):
+        from mem_report import parse_map
+        # The 0x40 .bss.unused above the memory map was dropped by the linker
+        assert parse_map(io.StringIO(MAP))["wheel"] < 0x40
+
+
+class TestParseSu:
+    """-fstack-usage lines."""
+
+    def test_fields(self):
+        from mem_report import parse_su
+        frames = parse_su(io.StringIO(SU), "wheel")
+        assert frames[0].location == "wheel.cpp:92"
+        assert frames[0].function == "void mqttCallback(char*, byte*, unsigned int)"
+        assert frames[0].size == 112
+        assert frames[2].qualifiers == "dynamic"
+
+    def test_load_directory(self, tmp_path):
+        from mem_report import load_su
+        (tmp_path / "wheel.cpp.su").write_text(SU)
+        (tmp_path / "wheel.cpp.o").write_text("")
+        frames = load_su(str(tmp_path))
+        assert len(frames) == 4
+        assert all(f.subsystem == "wheel" for f in frames)
+
+
+class TestReport:
+    """Budgets and limits."""
+
+    def frames(self):
+        from mem_report import parse_su
+        return parse_su(io.StringIO(SU), "wheel")
+
+    def test_unbounded_dynamic_frame_is_a_problem(self):
+        from mem_report import report
+        problems = report({}, self.frames(), out=io.StringIO())
+        assert len(problems) == 1
+        assert "led.cpp:58" in problems[0]
+
+    def test_within_budget(self):
+        from mem_report import parse_su, report
+        frames = parse_su(io.StringIO(SU.splitlines()[0] + "\n"), "wheel")
+        out = io.StringIO()
+        assert report({"wheel": 100}, frames, {"wheel": 128}, 256, out) == []
+        assert "wheel" in out.getvalue()
+
+    def test_over_budget(self):
+        from mem_report import report
+        problems = report({"wheel": 200}, [], {"wheel": 128}, out=io.StringIO())
+        assert problems == ["wheel: 200 bytes static RAM, budget 128"]
+
+    def test_frame_limit(self):
+        from mem_report import parse_su, report
+        frames = parse_su(io.StringIO(SU.splitlines()[0] + "\n"), "wheel")
+        problems = report({}, frames, frame_limit=100, out=io.StringIO())
+        assert "112-byte frame" in problems[0]
+
+    def test_parse_budgets(self):
+        from mem_report import parse_budgets
+        assert parse_budgets(["wheel=4096", "core=0x100"]) == {"wheel": 4096, "core": 256}
+        with pytest.raises(ValueError):
+            parse_budgets(["wheel"])
+
+    def test_main_exit_status(self, tmp_path):
+        from mem_report import main
+        map_path = tmp_path / "fw.map"
+        map_path.write_text(MAP)
+        assert main(["--map", str(map_path)]) == 0
+        assert main(["--map", str(map_path), "--budget", "wheel=8"]) == 1
@@ -0,0 +1,230 @@
+"""Tests for the thermal frame codec (Python twin of thermal_codec.h).
+
+Run on host with CPython/pytest.
+"""
+
+import sys
+import os
+import math
+import random
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), ".."))
+
+import pytest
+
+WIDTH = 16
+HEIGHT = 12
+
+
+def tire_frames(count, seed=1):
+    """Warm tire across the frame, cooler edges, slow drift and sensor noise."""
+    rng = random.Random(seed)
+    frames = []
+    for n in range(count):
+        frame = []
+        for i in range(WIDTH * HEIGHT):
+            col, row = i % WIDTH, i // WIDTH
+            t = 70 + 15 * col / WIDTH + 5 * math.sin(n * 0.05)
+            if row in (0, HEIGHT - 1):
+                t -= 10
+            frame.append(t + rng.uniform(-0.2, 0.2))
+        frames.append(frame)
+    return frames
+
+
+class TestQuantize:
+    """Test 0.1 degC quantisation."""
+
+    def test_tenths(self):
+        from thermal_decode import quantize
+
+        assert quantize(71.26) == 713
+        assert quantize(-4.04) == -40
+
+    def test_half_rounds_away_from_zero(self):
+        from thermal_decode import quantize
+
+        assert quantize(0.25) == 3
+        assert quantize(-0.25) == -3
+
+    def test_invalid(self):
+        from thermal_decode import quantize, INVALID
+
+        assert quantize(float("nan")) == INVALID
+        assert quantize(float("inf")) == INVALID
+
+    def test_clamped(self):
+        from thermal_decode import quantize
+
+        assert quantize(1e9) == 32767
+        assert quantize(-1e9) == -32767
+
+
+class TestZigzag:
+    """Test the signed/unsigned residual mapping."""
+
+    def test_small_values(self):
+        from thermal_decode import zigzag
+
+        assert [zigzag(r) for r in (0, -1, 1, -2, 2)] == [0, 1, 2, 3, 4]
+
+    def test_roundtrip_extremes(self):
+        from thermal_decode import zigzag, unzigzag
+
+        for r in (-32768, -1, 0, 1, 32767):
+            assert unzigzag(zigzag(r)) == r
+
+
+class TestRoundtrip:
+    """Encoder -> decoder is lossless after quantisation."""
+
+    def test_sequence(self):
+        from thermal_decode import Encoder, Decoder
+
+        encoder, decoder = Encoder(), Decoder()
+        for frame in tire_frames(40):
+            _, values = decoder.decode(encoder.encode(frame, WIDTH, HEIGHT))
+            assert values == encoder.prev
+
+    def test_error_within_quantisation(self):
+        from thermal_decode import Encoder, Decoder, to_celsius
+
+        encoder, decoder = Encoder(), Decoder()
+        frame = tire_frames(1)[0]
+        _, values = decoder.decode(encoder.encode(frame, WIDTH, HEIGHT))
+        for original, decoded in zip(frame, to_celsius(values)):
+            assert abs(original - decoded) <= 0.05 + 1e-6
+
+    def test_invalid_pixels_survive(self):
+        from thermal_decode import Encoder, Decoder, to_celsius
+
+        encoder, decoder = Encoder(), Decoder()
+        frames = tire_frames(3)
+        frames[1][7] = float("nan")
+        frames[2][0] = float("inf")
+        decoded = [to_celsius(decoder.decode(encoder.encode(f, WIDTH, HEIGHT))[1]) for f in frames]
+        assert decoded[1][7] is None
+        assert decoded[2][0] is None
+        assert decoded[2][7] is not None
+
+    def test_large_jump_escapes(self):
+        from thermal_decode import Encoder, Decoder
+
+        encoder, decoder = Encoder(), Decoder()
+        frames = tire_frames(2)
+        frames[1][50] = -40.0  # far outside the Rice range for this frame's k
+        for frame in frames:
+            _, values = decoder.decode(encoder.encode(frame, WIDTH, HEIGHT))
+            assert values == encoder.prev
+
+
+class TestKeyframes:
+    """Test keyframe cadence and resync after a lost packet."""
+
+    def test_interval(self):
+        from thermal_decode import Encoder, parse_header, KEYFRAME_INTERVAL
+
+        encoder = Encoder()
+        keys = [parse_header(encoder.encode(f, WIDTH, HEIGHT)).key for f in tire_frames(40)]
+        assert [i for i, key in enumerate(keys) if key] == [0, KEYFRAME_INTERVAL, 2 * KEYFRAME_INTERVAL]
+
+    def test_reset_forces_keyframe(self):
+        from thermal_decode import Encoder, parse_header
+
+        encoder = Encoder()
+        frames = tire_frames(3)
+        encoder.encode(frames[0], WIDTH, HEIGHT)
+        assert not parse_header(encoder.encode(frames[1], WIDTH, HEIGHT)).key
+        encoder.reset()
+        assert parse_header(encoder.encode(frames[2], WIDTH, HEIGHT)).key
+
+    def test_lost_packet_waits_for_keyframe(self):
+        from thermal_decode import Encoder, Decoder, KEYFRAME_INTERVAL
+
+        encoder, decoder = Encoder(), Decoder()
+        packets = [encoder.encode(f, WIDTH, HEIGHT) for f in tire_frames(KEYFRAME_INTERVAL + 1)]
+        del packets[3]
+        results = [decoder.decode(p)[1] for p in packets]
+        assert all(r is not None for r in results[:3])
+        assert all(r is None for r in results[3:-1])
+        assert results[-1] is not None
+
+
+class TestCompression:
+    """The point of the codec: far smaller than raw floats."""
+
+    def test_ratio_on_tire_frames(self):
+        from thermal_decode import Encoder
+
+        encoder = Encoder()
+        sizes = [len(encoder.encode(f, WIDTH, HEIGHT)) for f in tire_frames(64)]
+        raw = WIDTH * HEIGHT * 4
+        assert raw * len(sizes) / sum(sizes) > 5
+
+    def test_static_frame_is_tiny(self):
+        from thermal_decode import Encoder, HEADER_BYTES
+
+        encoder = Encoder()
+        frame = tire_frames(1)[0]
+        encoder.encode(frame, WIDTH, HEIGHT)
+        # Every residual is zero: one bit per pixel at k = 0
+        assert len(encoder.encode(frame, WIDTH, HEIGHT)) == HEADER_BYTES + WIDTH * HEIGHT // 8
+
+
+class TestDecodeErrors:
+    """Test malformed packets."""
+
+    def test_bad_version(self):
+        from thermal_decode import Encoder, Decoder, CodecError
+
+        packet = bytearray(Encoder().encode(tire_frames(1)[0], WIDTH, HEIGHT))
+        packet[0] = 9
+        with pytest.raises(CodecError, match="version"):
+            Decoder().decode(bytes(packet))
+
+    def test_truncated(self):
+        from thermal_decode import Encoder, Decoder, CodecError
+
+        packet = Encoder().encode(tire_frames(1)[0], WIDTH, HEIGHT)
+        with pytest.raises(CodecError, match="truncated"):
+            Decoder().decode(packet[:20])
+
+
+class TestMain:
+    """Test the command line."""
+
+    def test_capture_report_and_csv(self, tmp_path, capsys):
+        from thermal_decode import Encoder, main
+
+        encoder = Encoder()
+        lines = [
+            "vtms/car1/left/front/frame " + encoder.encode(f, WIDTH, HEIGHT).hex()
+            for f in tire_frames(20)
+        ]
+        capture = tmp_path / "frames.hex"
+        capture.write_text("\n".join(lines) + "\n")
+        out = tmp_path / "frames.csv"
+
+        assert main([str(capture), "--csv", str(out)]) == 0
+        report = capsys.readouterr().out
+        assert "20 frames (2 key)" in report
+        assert "vs float32" in report
+
+        rows = out.read_text().splitlines()
+        assert len(rows) == 20
+        assert len(rows[0].split(",")) == 2 + WIDTH * HEIGHT
+
+    def test_raw_mode(self, tmp_path, capsys):
+        from thermal_decode import main
+
+        raw = tmp_path / "raw.csv"
+        raw.write_text("\n".join(",".join(f"{t:.3f}" for t in f) for f in tire_frames(5)) + "\n")
+        assert main([str(raw), "--raw"]) == 0
+        assert "5 frames" in capsys.readouterr().out
+
+    def test_bad_hex(self, tmp_path):
+        from thermal_decode import main
+
+        capture = tmp_path / "bad.hex"
+        capture.write_text("topic zz\n")
+        assert main([str(capture)]) == 1
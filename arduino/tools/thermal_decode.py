@@ -0,0 +1,311 @@
+"""Decode compressed MLX90641 frames from wheel.cpp and report compression.
+
+wheel.cpp publishes each thermal frame to ``<base>/<vehicle>/<side>/<position>/frame``
+as a binary packet from ``arduino/thermal_codec.h``. Capture them with::
+
+    mosquitto_sub -h car-pi -t 'vtms/+/+/+/frame' -F '%t %x' > frames.hex
+
+then::
+
+    python thermal_decode.py frames.hex                 # compression report
+    python thermal_decode.py frames.hex --csv out.csv   # decoded frames, degC
+
+Each input line is a hex payload, optionally preceded by its topic; topics
+are decoded independently. ``--raw`` instead reads frames already in degC
+(one frame per line, comma-separated, row-major), encodes them with the
+same codec and reports what they would compress to.
+"""
+
+import argparse
+import csv
+import math
+import struct
+import sys
+from collections import namedtuple
+
+VERSION = 1
+FLAG_KEY = 0x01
+HEADER_BYTES = 7
+INVALID = -32768
+KEYFRAME_INTERVAL = 16
+RICE_ESCAPE = 20
+RICE_MAX_K = 12
+
+Packet = namedtuple("Packet", "key width height seq k")
+
+
+class CodecError(ValueError):
+    """Malformed packet."""
+
+
+def _wrap16(value):
+    """Two's complement wrap to int16."""
+    return (value + 0x8000) % 0x10000 - 0x8000
+
+
+def _f32(value):
+    return struct.unpack("<f", struct.pack("<f", value))[0]
+
+
+def quantize(celsius):
+    """thermalQuantize(): float32 arithmetic, so results match the device."""
+    if celsius is None or math.isnan(celsius) or math.isinf(celsius):
+        return INVALID
+    if abs(celsius) > 3.4e38:
+        return 32767 if celsius > 0 else -32767
+    q = _f32(_f32(celsius) * _f32(10.0))
+    if q > 32767:
+        return 32767
+    if q < -32767:
+        return -32767
+    # lroundf: halves away from zero
+    return int(math.floor(abs(q) + 0.5)) * (1 if q >= 0 else -1)
+
+
+def zigzag(r):
+    return ((r << 1) ^ (r >> 15)) & 0xFFFF
+
+
+def unzigzag(u):
+    return (u >> 1) ^ -(u & 1)
+
+
+def _rice_bits(u, k):
+    q = u >> k
+    return q + 1 + k if q < RICE_ESCAPE else RICE_ESCAPE + 16
+
+
+class _BitWriter:
+    def __init__(self):
+        self.data = bytearray()
+        self.bits = 0
+
+    def put(self, value, count):
+        for shift in range(count - 1, -1, -1):
+            if self.bits % 8 == 0:
+                self.data.append(0)
+            if (value >> shift) & 1:
+                self.data[-1] |= 0x80 >> (self.bits % 8)
+            self.bits += 1
+
+
+class _BitReader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def bit(self):
+        byte = self.pos >> 3
+        if byte >= len(self.data):
+            raise CodecError("packet truncated")
+        value = (self.data[byte] >> (7 - (self.pos & 7))) & 1
+        self.pos += 1
+        return value
+
+    def get(self, count):
+        value = 0
+        for _ in range(count):
+            value = (value << 1) | self.bit()
+        return value
+
+
+class Encoder:
+    """Python twin of thermalEncode(); used for --raw and the tests."""
+
+    def __init__(self):
+        self.prev = None
+        self.seq = 0
+        self.since_key = 0
+
+    def reset(self):
+        self.prev = None
+
+    def encode(self, frame, width, height):
+        pixels = width * height
+        if len(frame) != pixels:
+            raise ValueError(f"expected {pixels} pixels, got {len(frame)}")
+        key = self.prev is None or self.since_key + 1 >= KEYFRAME_INTERVAL
+
+        values = [quantize(t) for t in frame]
+        residuals = []
+        left = 0
+        for i, v in enumerate(values):
+            predicted = left if key else self.prev[i]
+            residuals.append(zigzag(_wrap16(v - predicted)))
+            left = v
+        self.prev = values
+
+        k = min(range(RICE_MAX_K + 1), key=lambda k: sum(_rice_bits(u, k) for u in residuals))
+
+        self.seq = (self.seq + 1) & 0xFFFF
+        self.since_key = 0 if key else self.since_key + 1
+
+        w = _BitWriter()
+        for u in residuals:
+            q = u >> k
+            if q < RICE_ESCAPE:
+                w.put((1 << (q + 1)) - 2, q + 1)
+                w.put(u, k)
+            else:
+                w.put((1 << RICE_ESCAPE) - 1, RICE_ESCAPE)
+                w.put(u, 16)
+
+        header = bytes([VERSION, FLAG_KEY if key else 0, width, height,
+                        self.seq & 0xFF, self.seq >> 8, k])
+        return header + bytes(w.data)
+
+
+def parse_header(packet):
+    if len(packet) < HEADER_BYTES:
+        raise CodecError("packet shorter than header")
+    if packet[0] != VERSION:
+        raise CodecError(f"unsupported codec version {packet[0]}")
+    return Packet(bool(packet[1] & FLAG_KEY), packet[2], packet[3],
+                  packet[4] | (packet[5] << 8), packet[6])
+
+
+class Decoder:
+    """Tracks one stream; delta frames need the previous frame decoded."""
+
+    def __init__(self):
+        self.prev = None
+        self.seq = None
+
+    def decode(self, packet):
+        """Return (header, values) with values as int16 tenths of a degree,
+        or (header, None) if the packet can't be decoded until a keyframe."""
+        header = parse_header(packet)
+        pixels = header.width * header.height
+
+        if not header.key:
+            if (self.prev is None or len(self.prev) != pixels
+                    or header.seq != (self.seq + 1) & 0xFFFF):
+                self.prev = None
+                return header, None
+
+        r = _BitReader(packet[HEADER_BYTES:])
+        values = []
+        left = 0
+        for i in range(pixels):
+            q = 0
+            while q < RICE_ESCAPE and r.bit():
+                q += 1
+            u = r.get(16) if q == RICE_ESCAPE else (q << header.k) | r.get(header.k)
+            predicted = left if header.key else self.prev[i]
+            v = _wrap16(predicted + unzigzag(u))
+            values.append(v)
+            left = v
+
+        self.prev = values
+        self.seq = header.seq
+        return header, values
+
+
+def to_celsius(values):
+    return [None if v == INVALID else v / 10.0 for v in values]
+
+
+# --- Reports -----------------------------------------------------------------
+
+
+class Stats:
+    def __init__(self):
+        self.frames = 0
+        self.keyframes = 0
+        self.skipped = 0
+        self.bytes = 0
+        self.pixels = 0
+
+    def add(self, header, size, decoded):
+        if not decoded:
+            self.skipped += 1
+            return
+        self.frames += 1
+        self.keyframes += header.key
+        self.bytes += size
+        self.pixels += header.width * header.height
+
+    def report(self, name):
+        if not self.frames:
+            return f"{name}: no frames decoded ({self.skipped} skipped)"
+        raw_float = self.pixels * 4
+        raw_int16 = self.pixels * 2
+        return "\n".join([
+            f"{name}: {self.frames} frames ({self.keyframes} key), {self.skipped} skipped",
+            f"  mean packet      {self.bytes / self.frames:8.1f} bytes",
+            f"  vs float32       {raw_float / self.bytes:8.2f}x ({raw_float / self.frames:.0f} bytes)",
+            f"  vs int16         {raw_int16 / self.bytes:8.2f}x ({raw_int16 / self.frames:.0f} bytes)",
+        ])
+
+
+def _read_hex_lines(f):
+    for lineno, line in enumerate(f, 1):
+        tokens = line.split()
+        if not tokens:
+            continue
+        topic = tokens[0] if len(tokens) > 1 else "frame"
+        try:
+            yield topic, bytes.fromhex(tokens[-1])
+        except ValueError:
+            raise CodecError(f"line {lineno}: not a hex payload")
+
+
+def decode_capture(f, writer=None):
+    decoders = {}
+    stats = {}
+    for topic, packet in _read_hex_lines(f):
+        decoder = decoders.setdefault(topic, Decoder())
+        header, values = decoder.decode(packet)
+        stats.setdefault(topic, Stats()).add(header, len(packet), values is not None)
+        if writer and values is not None:
+            writer.writerow([topic, header.seq] + [
+                "" if t is None else t for t in to_celsius(values)
+            ])
+    return stats
+
+
+def encode_raw(f, width, height):
+    encoder = Encoder()
+    decoder = Decoder()
+    stats = Stats()
+    for line in f:
+        if not line.strip():
+            continue
+        frame = [float(t) if t.strip() else float("nan") for t in line.split(",")]
+        packet = encoder.encode(frame, width, height)
+        header, values = decoder.decode(packet)
+        if values != encoder.prev:
+            raise CodecError(f"frame {encoder.seq} did not round-trip")
+        stats.add(header, len(packet), True)
+    return {"raw": stats}
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("capture", help="hex payload capture (or degC CSV with --raw)")
+    parser.add_argument("--csv", help="write decoded frames (topic, seq, pixels in degC)")
+    parser.add_argument("--raw", action="store_true", help="input is degC frames to encode")
+    parser.add_argument("--width", type=int, default=16)
+    parser.add_argument("--height", type=int, default=12)
+    args = parser.parse_args(argv)
+
+    try:
+        with open(args.capture) as f:
+            if args.raw:
+                stats = encode_raw(f, args.width, args.height)
+            elif args.csv:
+                with open(args.csv, "w", newline="") as out:
+                    stats = decode_capture(f, csv.writer(out))
+            else:
+                stats = decode_capture(f)
+    except CodecError as e:
+        print(f"{args.capture}: {e}", file=sys.stderr)
+        return 1
+
+    for name in sorted(stats):
+        print(stats[name].report(name))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
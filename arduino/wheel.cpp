@@ -6,6 +6,10 @@
 // - MLX90641_I2C_Driver.h
 // Installable from: https://github.com/Melexis/MLX90641-library (Arduino)
 //
+// Several MLX90641s per corner (tire edges, brake rotor) are supported:
+// give each its own I2C address (EEPROM-programmable) or put them behind a
+// TCA9548A mux; see the mlx[] table.
+//
 // Hardware:
 // - Connect sensor VCC to 3.3V (or as required)
 // - GND to GND
@@ -13,6 +17,12 @@
 // - SCL to SCL (ESP32 default: GPIO22)
 // - I2C address typically 0x33 for MLX90641
 //
+// Transport (WHEEL_TRANSPORT below):
+// - MQTT: join the car-pi hotspot and publish to the broker directly
+// - ESPNOW: send binary frames to espnow_gateway.cpp, which publishes the
+//   same topics. No association or TCP connection per corner, so readings
+//   reach the gateway in a few ms and a hotspot restart costs nothing here.
+//
 // This file is intentionally a .cpp so you can add it to an ESP32 Arduino
 // project. If you prefer an .ino, rename accordingly.
 
@@ -23,10 +33,32 @@
 // MQTT / WiFi (based on examples in repo)
 #include <WiFi.h>
 #include <PubSubClient.h>
+#include "mqtt_payload.h"
+
+#define WHEEL_TRANSPORT_MQTT   0
+#define WHEEL_TRANSPORT_ESPNOW 1
+#ifndef WHEEL_TRANSPORT
+#define WHEEL_TRANSPORT WHEEL_TRANSPORT_MQTT
+#endif
+
+#if WHEEL_TRANSPORT == WHEEL_TRANSPORT_ESPNOW
+#include <esp_now.h>
+#include <esp_wifi.h>
+#include "espnow_link.h" // Frame format shared with espnow_gateway.cpp
+#endif
 
 // MAX6675 thermocouple support
 #include "max6675.h"
 
+// Frame -> tire zone reduction (shared with the host benchmarks)
+#include "tire_zones.h"
+
+// Full-frame compression for the <position>/frame topic
+#include "thermal_codec.h"
+
+// Epoch timestamps (MQTT transport; the ESP-NOW gateway stamps for us)
+#include "time_sync.h"
+
 // --- WiFi credentials ---
 // Legacy sketch — load from arduino_secrets.h (see .env + Makefile)
 #include "arduino_secrets.h"
@@ -45,16 +77,22 @@ const char *mqtt_vehicle = "car1";   // e.g. car1, truck2
 const char *mqtt_side = "left";      // left or right
 const char *mqtt_position = "front"; // front or rear
 
+#if WHEEL_TRANSPORT == WHEEL_TRANSPORT_ESPNOW
+// Gateway MAC (printed by espnow_gateway.cpp at boot). Unicast gets link
+// layer acks and retries; broadcast works without pairing but is best-effort.
+uint8_t gateway_mac[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+#endif
+
 WiFiClient espClient;
 PubSubClient mqttClient(espClient);
+TimeSync_t timeSync;
 
 void mqttCallback(char *topic, byte *payload, unsigned int length)
 {
     // simple echo debug callback
-    char msg[length + 1];
-    memcpy(msg, payload, length);
-    msg[length] = '\0';
-    Serial.printf("MQTT message arrived topic=%s payload=%s\n", topic, msg);
+    MqttPayload_t msg;
+    mqttPayloadView(&msg, payload, length);
+    Serial.printf("MQTT message arrived topic=%s payload=%s%s\n", topic, msg.text, msg.truncated ? "..." : "");
 }
 
 // --- MAX6675 configuration ---
@@ -68,8 +106,13 @@ int thermoCS[NUM_THERMO] = {15, 13};
 // Logical names for each thermocouple (used in topic names)
 const char *thermo_name[NUM_THERMO] = {"brake", "wheel"};
 
-// MAX6675 objects (created in setup)
-MAX6675 *thermos[NUM_THERMO];
+// MAX6675 objects, one per thermoCS pin
+MAX6675 thermos[NUM_THERMO] = {
+    MAX6675(thermoCLK, thermoCS[0], thermoDO),
+    MAX6675(thermoCLK, thermoCS[1], thermoDO),
+};
+float thermoC[NUM_THERMO]; // Latest readings, NAN until read
+int64_t thermoLocalUs;     // timeSyncLocalUs() of the latest reading
 
 // Assumed MLX90641 geometry. MLX90641 can come in different resolutions.
 // A common variant is 16x12 (width=16, height=12). If your part differs,
@@ -78,45 +121,191 @@ MAX6675 *thermos[NUM_THERMO];
 #define HEIGHT 12
 #define PIXELS (WIDTH * HEIGHT)
 
-// MLX90641 I2C address (common default)
-#define MLX_I2C_ADDR 0x33
-
-// Change emissivity and any per-sensor offset here.
-float emissivity = 0.98; // typical rubber/leather; tune as needed
-float global_offset_c = 0.0; // global calibration offset in degC
+#define MLX_FRAME_WORDS  242     // MLX90641_GetFrameData output: pixels + aux + control/status
+#define MLX_STATUS_REG   0x8000
+#define MLX_DATA_READY   0x0008   // Status register: new subpage available
+#define MLX_MUX_ADDR     0x70     // TCA9548A
+#define MLX_NO_MUX       -1
+#define I2C_CLOCK_DIRECT 1000000  // MLX90641 supports Fast-mode Plus
+#define I2C_CLOCK_MUX    400000   // TCA9548A tops out at 400 kHz
+#define MLX_STATS_MS     10000
+#define MLX_DEVIATING    2        // Broken / outlier pixel slots in paramsMLX90641
+
+// Per-pixel temporal filter (tire_zones.h): IIR alpha = 2^-shift, samples
+// more than GATE_C off the estimate are dropped unless GATE_FRAMES in a row
+// agree (a real step, e.g. the car leaving the pits)
+#define FILTER_SHIFT       2      // alpha 1/4: ~4 frame time constant
+#define FILTER_GATE_C      8.0f
+#define FILTER_GATE_FRAMES 3
+
+typedef struct
+{
+    const char *name;     // Topic segment; "" = the legacy <position>/... topics
+    uint8_t address;      // I2C address (default 0x33, EEPROM-programmable)
+    int8_t muxChannel;    // TCA9548A channel, MLX_NO_MUX if directly on the bus
+    uint8_t refreshRate;  // MLX90641_SetRefreshRate code: 2 = 2 Hz, 4 = 8 Hz, 5 = 16 Hz
+    float emissivity;     // typical rubber 0.95-0.98, cast iron rotor ~0.9
+    float offset;         // calibration offset in degC
+
+    // Runtime
+    bool ready;
+    paramsMLX90641 params;    // Calibration from this sensor's own EEPROM (~5 KB each)
+    ThermalEncoder_t encoder; // Compressed full frames (tools/thermal_decode.py)
+    TireFilter_t filter;      // Per-pixel state and bad-pixel mask
+    uint32_t frames;
+    uint32_t busyUs;          // I2C time spent reading frames since the last stats line
+} MlxSensor_t;
+
+// One entry per sensor. Frames are read as each sensor reports data ready,
+// so the aggregate rate scales with the sensors' refresh rates until the
+// bus is full (a frame read is ~5 ms at 1 MHz, ~12 ms at 400 kHz).
+MlxSensor_t mlx[] = {
+    // name    addr  mux         rate  emiss  offset
+    {"",       0x33, MLX_NO_MUX, 0x02, 0.98f, 0.0f},
+    // {"edge",  0x34, MLX_NO_MUX, 0x04, 0.98f, 0.0f}, // second tire view, reprogrammed address
+    // {"rotor", 0x33, 2,          0x05, 0.90f, 0.0f}, // brake rotor on mux channel 2
+};
+#define NUM_MLX ((int)(sizeof(mlx) / sizeof(mlx[0])))
+
+bool mlxMuxUsed = false;
+int8_t mlxMuxChannel = MLX_NO_MUX - 1; // Unknown until first select
+int mlxNext = 0;                       // Round-robin position
+unsigned long lastMlxStats = 0;
 
-paramsMLX90641 mlx90641;
 float frameTo[PIXELS];
-uint16_t frameData[PIXELS];
+uint16_t frameData[MLX_FRAME_WORDS];
 uint8_t eeMLX90641[832]; // size used by library for EEPROM dump (safe large buffer)
 
 // region definitions: split width into three vertical zones (inside, middle, outside)
 int col_split1, col_split2;
 
-void setupSensor()
+uint8_t thermalPacket[THERMAL_MAX_BYTES(PIXELS)];
+
+bool selectMux(int8_t channel)
 {
-    // Initialize I2C
-    Wire.begin();
+    if (!mlxMuxUsed || channel == mlxMuxChannel) return true;
+    Wire.beginTransmission(MLX_MUX_ADDR);
+    Wire.write(channel == MLX_NO_MUX ? 0 : 1 << channel);
+    bool ok = Wire.endTransmission() == 0;
+    mlxMuxChannel = ok ? channel : MLX_NO_MUX - 1;
+    return ok;
+}
+
+void setupSensor(MlxSensor_t *s)
+{
+    if (!selectMux(s->muxChannel))
+    {
+        Serial.println("TCA9548A not answering");
+        return;
+    }
 
     // Try to dump EEPROM and extract parameters
-    int status = MLX90641_DumpEE(MLX_I2C_ADDR, eeMLX90641);
+    int status = MLX90641_DumpEE(s->address, eeMLX90641);
     if (status != 0)
     {
-        Serial.print("MLX90641_DumpEE failed: ");
-        Serial.println(status);
+        Serial.printf("MLX90641 0x%02x: DumpEE failed: %d\n", s->address, status);
         return;
     }
 
-    status = MLX90641_ExtractParameters(eeMLX90641, &mlx90641);
+    status = MLX90641_ExtractParameters(eeMLX90641, &s->params);
     if (status != 0)
     {
-        Serial.print("MLX90641_ExtractParameters failed: ");
-        Serial.println(status);
+        Serial.printf("MLX90641 0x%02x: ExtractParameters failed: %d\n", s->address, status);
         return;
     }
 
-    // Optionally set refresh rate: valid values are 0..8 (see library); choose 2 or 4
-    MLX90641_SetRefreshRate(MLX_I2C_ADDR, 0x02); // example: 2 -> ~2Hz (tune as needed)
+    // Mask the pixels the library found broken or out of spec in the EEPROM
+    tireFilterInit(&s->filter, FILTER_SHIFT, FILTER_GATE_C, FILTER_GATE_FRAMES);
+    for (int i = 0; i < MLX_DEVIATING; i++)
+    {
+        if (s->params.brokenPixels[i] < PIXELS) tireFilterMaskPixel(&s->filter, s->params.brokenPixels[i]);
+        if (s->params.outlierPixels[i] < PIXELS) tireFilterMaskPixel(&s->filter, s->params.outlierPixels[i]);
+    }
+
+    MLX90641_SetRefreshRate(s->address, s->refreshRate);
+    s->ready = true;
+    Serial.printf("MLX90641 '%s' at 0x%02x, mux %d ready\n", s->name, s->address, s->muxChannel);
+}
+
+void setupSensors()
+{
+    for (int i = 0; i < NUM_MLX; i++)
+    {
+        if (mlx[i].muxChannel != MLX_NO_MUX) mlxMuxUsed = true;
+    }
+
+    // Initialize I2C; the mux limits the whole bus to 400 kHz
+    Wire.begin();
+    Wire.setClock(mlxMuxUsed ? I2C_CLOCK_MUX : I2C_CLOCK_DIRECT);
+
+    for (int i = 0; i < NUM_MLX; i++)
+    {
+        setupSensor(&mlx[i]);
+    }
+}
+
+bool mlxDataReady(MlxSensor_t *s)
+{
+    uint16_t status;
+    if (MLX90641_I2CRead(s->address, MLX_STATUS_REG, 1, &status) != 0) return false;
+    return status & MLX_DATA_READY;
+}
+
+// Reads the next sensor with a frame waiting into frameTo (degC, offset
+// applied). Round-robin, one frame per call, and never waits for data -
+// MLX90641_GetFrameData would spin until the sensor is ready.
+// frameLocalUs is when the frame was seen ready (timeSyncLocalUs()).
+int64_t frameLocalUs;
+
+MlxSensor_t *readNextFrame()
+{
+    for (int n = 0; n < NUM_MLX; n++)
+    {
+        MlxSensor_t *s = &mlx[(mlxNext + n) % NUM_MLX];
+        if (!s->ready || !selectMux(s->muxChannel) || !mlxDataReady(s)) continue;
+        mlxNext = (mlxNext + n + 1) % NUM_MLX;
+        frameLocalUs = timeSyncLocalUs();
+
+        unsigned long start = micros();
+        int stat = MLX90641_GetFrameData(s->address, frameData);
+        s->busyUs += micros() - start;
+        if (stat < 0)
+        {
+            Serial.printf("MLX90641 '%s': GetFrameData failed: %d\n", s->name, stat);
+            return NULL;
+        }
+
+        // Convert to temperatures (degC) using library helper
+        // last parameter is the ambient temperature placeholder (we pass 0 and library computes internally)
+        MLX90641_CalculateTo(frameData, &s->params, s->emissivity, frameTo);
+
+        // Apply per-sensor offset
+        for (int i = 0; i < PIXELS; i++)
+        {
+            frameTo[i] += s->offset;
+        }
+        s->frames++;
+        return s;
+    }
+    return NULL;
+}
+
+void printMlxStats()
+{
+    unsigned long elapsed = millis() - lastMlxStats;
+    if (elapsed < MLX_STATS_MS) return;
+    lastMlxStats = millis();
+
+    uint32_t busyUs = 0;
+    Serial.print("MLX fps:");
+    for (int i = 0; i < NUM_MLX; i++)
+    {
+        Serial.printf(" '%s' %.1f", mlx[i].name, mlx[i].frames * 1000.0f / elapsed);
+        busyUs += mlx[i].busyUs;
+        mlx[i].frames = 0;
+        mlx[i].busyUs = 0;
+    }
+    Serial.printf(", bus busy %.0f%%\n", busyUs / (elapsed * 10.0f));
 }
 
 void connectWiFiAndMQTT()
@@ -130,14 +319,23 @@ void connectWiFiAndMQTT()
     }
     Serial.println("Connected to the Wi-Fi network");
 
+    // Sub-ms stamps need replies delivered now, not at the next beacon
+    WiFi.setSleep(false);
+    if (!timeSync.running && !timeSyncBegin(&timeSync, WiFi.gatewayIP()))
+    {
+        Serial.println("Time sync: no UDP socket");
+    }
+
     mqttClient.setServer(mqtt_broker, mqtt_port);
     mqttClient.setCallback(mqttCallback);
+    // Default 256-byte buffer is too small for a worst-case frame packet
+    mqttClient.setBufferSize(sizeof(thermalPacket) + 128);
     while (!mqttClient.connected())
     {
-        String client_id = "esp32-client-";
-        client_id += String(WiFi.macAddress());
-        Serial.printf("The client %s connects to MQTT broker %s:%d\n", client_id.c_str(), mqtt_broker, mqtt_port);
-        if (mqttClient.connect(client_id.c_str(), mqtt_username, mqtt_password))
+        char client_id[MQTT_CLIENT_ID_MAX];
+        mqttClientId(client_id, sizeof(client_id), "esp32-client-");
+        Serial.printf("The client %s connects to MQTT broker %s:%d\n", client_id, mqtt_broker, mqtt_port);
+        if (mqttClient.connect(client_id, mqtt_username, mqtt_password))
         {
             Serial.println("MQTT broker connected");
         }
@@ -151,28 +349,144 @@ void connectWiFiAndMQTT()
 
     // Announce
     mqttClient.publish(mqtt_base_topic, "MLX90641 Tire sensor online");
+
+    // Subscribers joining now need a keyframe before deltas make sense
+    for (int i = 0; i < NUM_MLX; i++)
+    {
+        thermalEncoderReset(&mlx[i].encoder);
+    }
+}
+
+#if WHEEL_TRANSPORT == WHEEL_TRANSPORT_ESPNOW
+uint16_t espnowSeq = 0;
+uint8_t espnowCorner;
+
+// Send results arrive on the WiFi task
+volatile uint32_t espnowSentAt = 0; // micros() of the frame in flight
+volatile uint32_t espnowSent = 0, espnowFailed = 0;
+volatile uint32_t espnowAckTotalUs = 0, espnowAckMaxUs = 0;
+unsigned long lastEspnowStats = 0;
+
+void onEspnowSent(const uint8_t *mac, esp_now_send_status_t status)
+{
+    uint32_t us = micros() - espnowSentAt;
+    if (status != ESP_NOW_SEND_SUCCESS)
+    {
+        espnowFailed++;
+        return;
+    }
+    espnowSent++;
+    espnowAckTotalUs += us;
+    if (us > espnowAckMaxUs) espnowAckMaxUs = us;
 }
 
+void setupEspnow()
+{
+    // Station mode without associating; the radio stays on ESPNOW_CHANNEL
+    WiFi.mode(WIFI_STA);
+    WiFi.disconnect();
+    esp_wifi_set_channel(ESPNOW_CHANNEL, WIFI_SECOND_CHAN_NONE);
+
+    if (esp_now_init() != ESP_OK)
+    {
+        Serial.println("ESP-NOW init failed");
+        return;
+    }
+    esp_now_register_send_cb(onEspnowSent);
+
+    esp_now_peer_info_t peer = {};
+    memcpy(peer.peer_addr, gateway_mac, sizeof(gateway_mac));
+    peer.channel = ESPNOW_CHANNEL;
+    peer.encrypt = false;
+    if (esp_now_add_peer(&peer) != ESP_OK)
+    {
+        Serial.println("ESP-NOW add gateway peer failed");
+        return;
+    }
+
+    espnowCorner = wheelCorner(mqtt_side, mqtt_position);
+    Serial.printf("ESP-NOW on channel %d, node MAC %s\n", ESPNOW_CHANNEL, WiFi.macAddress().c_str());
+}
+
+void sendEspnow(void *frame, size_t len)
+{
+    // The gateway maps our clock onto its synced one from send times
+    espnowSentAt = micros();
+    ((WheelHeader_t *)frame)->timestamp = espnowSentAt;
+    if (esp_now_send(gateway_mac, (const uint8_t *)frame, len) != ESP_OK)
+    {
+        espnowFailed++;
+    }
+}
+
+// thermoC is NULL for sensors that don't carry the thermocouples
+void sendReading(const MlxSensor_t *s, float inside, float middle, float outside, const float *thermoC)
+{
+    WheelReading_t msg;
+    memset(&msg, 0, sizeof(msg));
+    wheelFillHeader(&msg.header, WHEEL_MSG_READING, espnowCorner, mqtt_vehicle, s->name, espnowSeq++, 0);
+    msg.sampleUs = (uint32_t)frameLocalUs;
+    msg.zone[0] = wheelEncodeTemp(inside);
+    msg.zone[1] = wheelEncodeTemp(middle);
+    msg.zone[2] = wheelEncodeTemp(outside);
+    msg.thermoCount = thermoC == NULL ? 0 : NUM_THERMO < WHEEL_MAX_THERMO ? NUM_THERMO : WHEEL_MAX_THERMO;
+    for (int i = 0; i < WHEEL_MAX_THERMO; i++)
+    {
+        msg.thermo[i] = i < msg.thermoCount ? wheelEncodeTemp(thermoC[i]) : WHEEL_TEMP_INVALID;
+    }
+    sendEspnow(&msg, sizeof(msg));
+}
+
+void sendFrame(MlxSensor_t *s)
+{
+    size_t len = thermalEncode(&s->encoder, frameTo, WIDTH, HEIGHT, thermalPacket, sizeof(thermalPacket));
+    WheelFrame_t msg;
+    if (len == 0 || len > sizeof(msg.data))
+    {
+        // Too noisy to fit one ESP-NOW frame; the gateway resyncs on the next keyframe
+        thermalEncoderReset(&s->encoder);
+        return;
+    }
+    wheelFillHeader(&msg.header, WHEEL_MSG_FRAME, espnowCorner, mqtt_vehicle, s->name, espnowSeq++, 0);
+    memcpy(msg.data, thermalPacket, len);
+    sendEspnow(&msg, sizeof(msg.header) + len);
+}
+
+void printEspnowStats()
+{
+    if (millis() - lastEspnowStats < 10000) return;
+    lastEspnowStats = millis();
+    uint32_t sent = espnowSent;
+    Serial.printf("ESP-NOW: %lu sent, %lu failed, ack avg %lu us, max %lu us\n",
+                  (unsigned long)sent, (unsigned long)espnowFailed,
+                  (unsigned long)(sent ? espnowAckTotalUs / sent : 0), (unsigned long)espnowAckMaxUs);
+}
+#endif
+
 void setup()
 {
     Serial.begin(115200);
     delay(200);
     Serial.println("MLX90641 Tire Temperature Monitor (ESP32)");
 
+#if WHEEL_TRANSPORT == WHEEL_TRANSPORT_ESPNOW
+    setupEspnow();
+#else
     // WiFi and MQTT
     connectWiFiAndMQTT();
+#endif
 
-    // Initialize MAX6675 thermocouple objects
+    // MAX6675 chip selects idle high
     for (int i = 0; i < NUM_THERMO; i++)
     {
         // Ensure CS pin is set as output and high by default
         pinMode(thermoCS[i], OUTPUT);
         digitalWrite(thermoCS[i], HIGH);
-        thermos[i] = new MAX6675(thermoCLK, thermoCS[i], thermoDO);
+        thermoC[i] = NAN;
         delay(50); // small settle
     }
 
-    setupSensor();
+    setupSensors();
 
     col_split1 = WIDTH / 3; // inside: cols [0 .. col_split1-1]
     col_split2 = 2 * (WIDTH / 3); // middle: [col_split1 .. col_split2-1], outside: [col_split2 .. WIDTH-1]
@@ -181,49 +495,33 @@ void setup()
     delay(500);
 }
 
-// Compute mean temperature of a rectangular region given column range
-float regionAverage(int colStart, int colEnd)
+// topic = mqtt_base_topic/vehicle/side/position[/sensor][/suffix]
+void sensorTopic(char *topic, size_t size, const MlxSensor_t *s, const char *suffix)
 {
-    float sum = 0.0;
-    int count = 0;
-    for (int r = 0; r < HEIGHT; r++)
-    {
-        for (int c = colStart; c <= colEnd; c++)
-        {
-            int idx = r * WIDTH + c; // row-major index
-            float t = frameTo[idx];
-            if (!isnan(t) && isfinite(t))
-            {
-                sum += t;
-                count++;
-            }
-        }
-    }
-    if (count == 0)
-        return NAN;
-    return sum / count;
+    int off = snprintf(topic, size, "%s/%s/%s/%s", mqtt_base_topic, mqtt_vehicle, mqtt_side, mqtt_position);
+    if (s->name[0]) off += snprintf(topic + off, size - off, "/%s", s->name);
+    if (suffix) snprintf(topic + off, size - off, "/%s", suffix);
 }
 
-void publishRegion(const char *zone, float value)
+void publishRegion(const MlxSensor_t *s, const char *zone, float value)
 {
     if (!isfinite(value)) return;
     char buf[32];
     // Format with two decimals
     dtostrf(value, 6, 2, buf);
-    // topic = mqtt_base_topic/vehicle/side/position/zone
     char topic[128];
-    snprintf(topic, sizeof(topic), "%s/%s/%s/%s/%s", mqtt_base_topic, mqtt_vehicle, mqtt_side, mqtt_position, zone);
+    sensorTopic(topic, sizeof(topic), s, zone);
     mqttClient.publish(topic, buf);
 }
 
-void publishCombined(float inside, float middle, float outside)
+void publishCombined(const MlxSensor_t *s, float inside, float middle, float outside)
 {
-    // publish a compact JSON object to mqtt_base_topic/vehicle/side/position
+    // publish a compact JSON object to mqtt_base_topic/vehicle/side/position[/sensor]
     char topic[128];
-    snprintf(topic, sizeof(topic), "%s/%s/%s/%s", mqtt_base_topic, mqtt_vehicle, mqtt_side, mqtt_position);
+    sensorTopic(topic, sizeof(topic), s, NULL);
 
     // Prepare string values
-    char s_inside[16], s_middle[16], s_outside[16], s_ts[32];
+    char s_inside[16], s_middle[16], s_outside[16], s_ts[32], s_epoch[48] = "";
     if (isfinite(inside)) dtostrf(inside, 6, 2, s_inside); else strcpy(s_inside, "null");
     if (isfinite(middle)) dtostrf(middle, 6, 2, s_middle); else strcpy(s_middle, "null");
     if (isfinite(outside)) dtostrf(outside, 6, 2, s_outside); else strcpy(s_outside, "null");
@@ -232,17 +530,36 @@ void publishCombined(float inside, float middle, float outside)
     unsigned long ts = millis();
     snprintf(s_ts, sizeof(s_ts), "%lu", ts);
 
-    // Build JSON payload: {"ts":123,"inside":31.12,"middle":30.01,"outside":29.99}
+    // epoch time the frame was ready, once synced to the car-pi
+    int64_t epochUs = timeSyncEpochUs(&timeSync, frameLocalUs);
+    if (epochUs)
+    {
+        strcpy(s_epoch, ",\"epoch_ms\":");
+        timeSyncFormatMs(s_epoch + strlen(s_epoch), sizeof(s_epoch) - strlen(s_epoch), epochUs);
+    }
+
+    // Build JSON payload: {"ts":123,"epoch_ms":1760000000123.456,"inside":31.12,"middle":30.01,"outside":29.99}
     char payload[256];
     // Use numeric values in JSON; if null we add literal null
     const char *inside_val = (strcmp(s_inside, "null") == 0) ? "null" : s_inside;
     const char *middle_val = (strcmp(s_middle, "null") == 0) ? "null" : s_middle;
     const char *outside_val = (strcmp(s_outside, "null") == 0) ? "null" : s_outside;
-    snprintf(payload, sizeof(payload), "{\"ts\":%s,\"inside\":%s,\"middle\":%s,\"outside\":%s}", s_ts, inside_val, middle_val, outside_val);
+    snprintf(payload, sizeof(payload), "{\"ts\":%s%s,\"inside\":%s,\"middle\":%s,\"outside\":%s}", s_ts, s_epoch, inside_val, middle_val, outside_val);
 
     mqttClient.publish(topic, payload);
 }
 
+void publishFrame(MlxSensor_t *s)
+{
+    // Binary packet at mqtt_base_topic/vehicle/side/position[/sensor]/frame
+    // (~100 bytes for a typical frame vs 768 as floats)
+    size_t len = thermalEncode(&s->encoder, frameTo, WIDTH, HEIGHT, thermalPacket, sizeof(thermalPacket));
+    if (len == 0) return;
+    char topic[128];
+    sensorTopic(topic, sizeof(topic), s, "frame");
+    mqttClient.publish(topic, thermalPacket, len);
+}
+
 void publishThermo(const char *name, float value)
 {
     if (!isfinite(value)) return;
@@ -253,7 +570,7 @@ void publishThermo(const char *name, float value)
     mqttClient.publish(topic, buf);
 }
 
-void publishThermoCombined()
+void publishThermoCombined(const float *thermoC)
 {
     // publish JSON with all thermocouple readings at mqtt_base_topic/vehicle/side/position/thermocouples
     char topic[128];
@@ -267,9 +584,17 @@ void publishThermoCombined()
     char payload[512];
     int off = 0;
     off += snprintf(payload + off, sizeof(payload) - off, "{\"ts\":%s", s_ts);
+    // When the last of this round was read - the values current at that moment
+    int64_t epochUs = timeSyncEpochUs(&timeSync, thermoLocalUs);
+    if (epochUs)
+    {
+        off += snprintf(payload + off, sizeof(payload) - off, ",\"epoch_ms\":");
+        timeSyncFormatMs(payload + off, sizeof(payload) - off, epochUs);
+        off += strlen(payload + off);
+    }
     for (int i = 0; i < NUM_THERMO; i++)
     {
-        float t = thermos[i]->readCelsius();
+        float t = thermoC[i];
         if (isfinite(t))
         {
             char s[32]; dtostrf(t, 6, 2, s);
@@ -285,71 +610,48 @@ void publishThermoCombined()
     mqttClient.publish(topic, payload);
 }
 
-void loop()
+// Thermocouples are read one per THERMO_INTERVAL_MS (MAX6675 needs ~220 ms
+// per conversion) so they never hold up the thermal sensors.
+#define THERMO_INTERVAL_MS  250
+#define HEATMAP_INTERVAL_MS 1000
+
+int thermoNext = 0;
+unsigned long lastThermoRead = 0;
+unsigned long lastHeatmap = 0;
+
+void serviceThermocouples()
 {
-    // Keep MQTT client running
-    if (!mqttClient.connected())
-    {
-        // Try reconnecting
-        connectWiFiAndMQTT();
-    }
-    mqttClient.loop();
+    if (millis() - lastThermoRead < THERMO_INTERVAL_MS) return;
+    lastThermoRead = millis();
 
-    // Get raw frame (packed uint16_t values)
-    int stat = MLX90641_GetFrameData(MLX_I2C_ADDR, frameData);
-    if (stat != 0)
+    int i = thermoNext;
+    thermoC[i] = thermos[i].readCelsius();
+    thermoLocalUs = timeSyncLocalUs();
+    if (isfinite(thermoC[i]))
     {
-        Serial.print("GetFrameData failed: ");
-        Serial.println(stat);
-        delay(200);
-        return;
+        Serial.printf("thermo %s = %.2f C\n", thermo_name[i], thermoC[i]);
     }
-
-    // Convert to temperatures (degC) using library helper
-    // last parameter is the ambient temperature placeholder (we pass 0 and library computes internally)
-    MLX90641_CalculateTo(frameData, &mlx90641, emissivity, frameTo);
-
-    // Apply global offset
-    for (int i = 0; i < PIXELS; i++)
+    else
     {
-        frameTo[i] += global_offset_c;
+        Serial.printf("thermo %s = (error)\n", thermo_name[i]);
     }
+    thermoNext = (thermoNext + 1) % NUM_THERMO;
 
-    // Compute region averages
-    float inside_temp = regionAverage(0, col_split1 - 1);
-    float middle_temp = regionAverage(col_split1, col_split2 - 1);
-    float outside_temp = regionAverage(col_split2, WIDTH - 1);
-
-    // Print a compact single-line CSV-friendly output with timestamp (millis)
-    Serial.print(millis());
-    Serial.print(", inside:"); Serial.print(inside_temp, 2);
-    Serial.print(", middle:"); Serial.print(middle_temp, 2);
-    Serial.print(", outside:"); Serial.println(outside_temp, 2);
-
-    // Publish to MQTT
-    publishRegion("inside", inside_temp);
-    publishRegion("middle", middle_temp);
-    publishRegion("outside", outside_temp);
-    publishCombined(inside_temp, middle_temp, outside_temp);
-
-    // Read and publish thermocouples
-    for (int i = 0; i < NUM_THERMO; i++)
+#if WHEEL_TRANSPORT == WHEEL_TRANSPORT_MQTT
+    // Publish once per full round; ESP-NOW sends them with the primary sensor's readings
+    if (thermoNext == 0)
     {
-        float t = thermos[i]->readCelsius();
-        if (isfinite(t))
-        {
-            Serial.printf("thermo %s = %.2f C\n", thermo_name[i], t);
-            publishThermo(thermo_name[i], t);
-        }
-        else
+        for (int t = 0; t < NUM_THERMO; t++)
         {
-            Serial.printf("thermo %s = (error)\n", thermo_name[i]);
+            publishThermo(thermo_name[t], thermoC[t]);
         }
-        delay(50); // small gap between CS toggles
+        publishThermoCombined(thermoC);
     }
-    publishThermoCombined();
+#endif
+}
 
-    // Also print a small heatmap (optional, very simple)
+void printHeatmap()
+{
     for (int r = 0; r < HEIGHT; r++)
     {
         for (int c = 0; c < WIDTH; c++)
@@ -357,7 +659,8 @@ void loop()
             float t = frameTo[r * WIDTH + c];
             // Visual map: map temperature to an ASCII char
             char ch;
-            if (t < 20) ch = '.';
+            if (isnan(t)) ch = ' '; // masked pixel
+            else if (t < 20) ch = '.';
             else if (t < 30) ch = '-';
             else if (t < 40) ch = '*';
             else if (t < 60) ch = 'o';
@@ -366,7 +669,70 @@ void loop()
         }
         Serial.println();
     }
+}
 
-    // Sleep/delay between frames. Refresh rate is set on device; respect that and add a small delay.
-    delay(500);
+void processFrame(MlxSensor_t *s)
+{
+    // Filter frameTo in place and compute region averages in one pass
+    const int zoneEnd[3] = {col_split1 - 1, col_split2 - 1, WIDTH - 1};
+    float zone[3];
+    tireFilterZones(&s->filter, frameTo, WIDTH, HEIGHT, zoneEnd, 3, zone);
+    float inside_temp = zone[0];
+    float middle_temp = zone[1];
+    float outside_temp = zone[2];
+
+    // Print a compact single-line CSV-friendly output with timestamp (millis)
+    Serial.print(millis());
+    if (s->name[0]) { Serial.print(", "); Serial.print(s->name); }
+    Serial.print(", inside:"); Serial.print(inside_temp, 2);
+    Serial.print(", middle:"); Serial.print(middle_temp, 2);
+    Serial.print(", outside:"); Serial.println(outside_temp, 2);
+
+#if WHEEL_TRANSPORT == WHEEL_TRANSPORT_ESPNOW
+    // The gateway republishes these on the MQTT topics below
+    sendReading(s, inside_temp, middle_temp, outside_temp, s == &mlx[0] ? thermoC : NULL);
+    sendFrame(s);
+#else
+    // Publish to MQTT
+    publishRegion(s, "inside", inside_temp);
+    publishRegion(s, "middle", middle_temp);
+    publishRegion(s, "outside", outside_temp);
+    publishCombined(s, inside_temp, middle_temp, outside_temp);
+    publishFrame(s);
+#endif
+
+    // Also print a small heatmap of the primary sensor (optional, very simple)
+    if (s == &mlx[0] && millis() - lastHeatmap >= HEATMAP_INTERVAL_MS)
+    {
+        lastHeatmap = millis();
+        printHeatmap();
+    }
+}
+
+void loop()
+{
+#if WHEEL_TRANSPORT == WHEEL_TRANSPORT_ESPNOW
+    printEspnowStats();
+#else
+    // Keep MQTT client running
+    if (!mqttClient.connected())
+    {
+        // Try reconnecting
+        connectWiFiAndMQTT();
+    }
+    mqttClient.loop();
+    timeSyncPoll(&timeSync);
+#endif
+
+    serviceThermocouples();
+
+    // Each sensor's refresh rate paces its frames; poll whichever is ready
+    MlxSensor_t *s = readNextFrame();
+    if (s != NULL)
+    {
+        processFrame(s);
+    }
+    printMlxStats();
+
+    delay(1);
 }
@@ -10,12 +10,21 @@ import { useMqtt } from "./useMqtt";
 const TRAIL_MAX_LENGTH = 500;
 
 /**
- * Parse a numeric value from an OBD string payload.
+ * Parse a numeric value from a metric payload.
  *
  * python-obd sends values like "3500 revolutions_per_minute" or "85 degC".
- * We extract the leading number.
+ * We extract the leading number. The C++ sensor nodes send
+ * {"epoch_ms":1760000000123.456,"value":1.234}; we take "value".
  */
 function parseOBDValue(raw: string): number {
+  if (raw.startsWith("{")) {
+    try {
+      const value = JSON.parse(raw).value;
+      return typeof value === "number" ? value : NaN;
+    } catch {
+      return NaN;
+    }
+  }
   const match = raw.match(/^-?[\d.]+/);
   return match ? parseFloat(match[0]) : NaN;
 }